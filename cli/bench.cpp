@@ -0,0 +1,150 @@
+//
+//  bench.cpp
+//  cli
+//
+//  Created by agent on 19/10/2026.
+//
+
+#include "bench.hpp"
+
+// C++
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+
+// Cubzh Core
+#include "box.h"
+#include "rigidBody.h"
+#include "scene.h"
+#include "transform.h"
+
+#if defined(__GLIBC__)
+#define CLI_COUNT_ALLOCATIONS 1
+#else
+#define CLI_COUNT_ALLOCATIONS 0
+#endif
+
+#if CLI_COUNT_ALLOCATIONS
+
+// glibc allocator entry points, used by the counting overrides below
+extern "C" void *__libc_malloc(size_t size);
+extern "C" void *__libc_calloc(size_t count, size_t size);
+extern "C" void *__libc_realloc(void *ptr, size_t size);
+
+namespace {
+std::atomic<uint64_t> allocations(0);
+}
+
+// Overrides take precedence over glibc's for the whole executable, including Cubzh Core.
+extern "C" void *malloc(size_t size) noexcept {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_malloc(size);
+}
+
+extern "C" void *calloc(size_t count, size_t size) noexcept {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_calloc(count, size);
+}
+
+extern "C" void *realloc(void *ptr, size_t size) noexcept {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_realloc(ptr, size);
+}
+
+#endif
+
+namespace {
+
+constexpr int GROUPS = 100;
+constexpr int CHILDREN_PER_GROUP = 20;
+constexpr int LEAVES_PER_CHILD = 2;
+constexpr int BODIES = 500;
+constexpr int WARMUP_FRAMES = 10;
+constexpr int FRAMES = 200;
+constexpr TICK_DELTA_SEC_T DT = 1.0 / 60.0;
+
+uint64_t allocationCount() {
+#if CLI_COUNT_ALLOCATIONS
+    return allocations.load(std::memory_order_relaxed);
+#else
+    return 0;
+#endif
+}
+
+void addRigidbody(Scene *sc, float x, float y, float z, uint8_t mode) {
+    Transform *t = transform_new(PointTransform);
+    RigidBody *rb = nullptr;
+    transform_ensure_rigidbody(t, mode, PHYSICS_GROUP_ALL_API, PHYSICS_GROUP_ALL_API, &rb);
+    const Box collider = {{0.0f, 0.0f, 0.0f}, {1.0f, 1.0f, 1.0f}};
+    rigidbody_set_collider(rb, &collider, true);
+    transform_set_local_position(t, x, y, z);
+    transform_set_parent(t, scene_get_root(sc), false);
+    transform_release(t); // owned by hierarchy
+}
+
+} // namespace
+
+bool command_bench(cxxopts::ParseResult parseResult, std::string& err) {
+    (void)parseResult;
+    (void)err;
+
+    Scene *sc = scene_new(nullptr);
+    const float gravity = -30.0f;
+    scene_set_constant_acceleration(sc, nullptr, &gravity, nullptr);
+
+    // transform hierarchy, only traversed
+    for (int i = 0; i < GROUPS; ++i) {
+        Transform *group = transform_new(PointTransform);
+        transform_set_parent(group, scene_get_root(sc), false);
+        for (int j = 0; j < CHILDREN_PER_GROUP; ++j) {
+            Transform *child = transform_new(PointTransform);
+            transform_set_parent(child, group, false);
+            for (int k = 0; k < LEAVES_PER_CHILD; ++k) {
+                Transform *leaf = transform_new(PointTransform);
+                transform_set_parent(leaf, child, false);
+                transform_release(leaf);
+            }
+            transform_release(child);
+        }
+        transform_release(group);
+    }
+
+    // dynamic bodies falling on static ones, spread on a grid, most of them land during the
+    // benchmark
+    for (int i = 0; i < BODIES; ++i) {
+        const float x = static_cast<float>(i % 25) * 3.0f;
+        const float z = static_cast<float>(i / 25) * 3.0f;
+        addRigidbody(sc, x, 0.0f, z, RigidbodyMode_Static);
+        addRigidbody(sc, x, 100.0f + static_cast<float>(i % 7) * 10.0f, z, RigidbodyMode_Dynamic);
+    }
+
+    std::cout << "* Benchmarking scene_refresh: "
+              << GROUPS * CHILDREN_PER_GROUP * (LEAVES_PER_CHILD + 1) + GROUPS << " transforms, "
+              << BODIES * 2 << " rigidbodies, " << FRAMES << " frames..." << std::endl;
+
+    for (int i = 0; i < WARMUP_FRAMES; ++i) {
+        scene_refresh(sc, DT, nullptr);
+    }
+
+    const uint64_t allocationsBefore = allocationCount();
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < FRAMES; ++i) {
+        scene_refresh(sc, DT, nullptr);
+    }
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    const uint64_t frameAllocations = allocationCount() - allocationsBefore;
+
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << "  time: " << seconds * 1000.0 / FRAMES << " ms/frame" << std::endl;
+#if CLI_COUNT_ALLOCATIONS
+    std::cout << "  allocations: " << frameAllocations / FRAMES << " per frame" << std::endl;
+#else
+    (void)frameAllocations;
+    std::cout << "  allocations: not counted on this platform" << std::endl;
+#endif
+
+    scene_free(sc);
+    return true;
+}
@@ -0,0 +1,20 @@
+//
+//  bench.hpp
+//  cli
+//
+//  Created by agent on 19/10/2026.
+//
+
+#pragma once
+
+// C++
+#include <string>
+
+// cxxopts
+#include <cxxopts.hpp>
+
+/// Runs `scene_refresh` on a generated scene (transform hierarchy + falling rigidbodies) and
+/// reports time and heap allocations per frame. Allocations are only counted with glibc.
+/// Returns true on success, false otherwise.
+/// When an error occured, the `err` argument is filled with an error message.
+bool command_bench(cxxopts::ParseResult parseResult, std::string& err);
@@ -8,7 +8,10 @@
 #include "combine.hpp"
 
 // C++
+#include <algorithm>
+#include <atomic>
 #include <iostream>
+#include <thread>
 #include <vector>
 
 // Cubzh Core
@@ -38,6 +41,12 @@ bool command_combine(cxxopts::ParseResult parseResult, std::string& err) {
 
     std::vector<std::string> input_paths = parseResult["input"].as<std::vector<std::string>>();
     std::string output_path = parseResult["output"].as<std::string>();
+    const bool merge = parseResult.count("merge") == 1 && parseResult["merge"].as<bool>();
+
+    unsigned int nbJobs = std::max(std::thread::hardware_concurrency(), 1u);
+    if (parseResult.count("jobs") == 1) {
+        nbJobs = std::max(parseResult["jobs"].as<unsigned int>(), 1u);
+    }
 
     std::cout << "* Combining voxel files..." << std::endl;
     for (std::string input_path : input_paths) {
@@ -80,6 +89,39 @@ bool command_combine(cxxopts::ParseResult parseResult, std::string& err) {
         }
     }
     
+    if (err.empty() && index > 0 && merge) {
+
+        // destination chunks are built in parallel, then assembled
+        ShapeCombine *combine = shape_combine_new(shapes, nullptr, static_cast<size_t>(index));
+        if (combine == nullptr) {
+            err = std::string("can't merge shapes");
+        } else {
+            const size_t nbChunks = shape_combine_get_nb_jobs(combine);
+            std::atomic<size_t> next(0);
+            auto worker = [&]() {
+                size_t i;
+                while ((i = next.fetch_add(1)) < nbChunks) {
+                    shape_combine_process(combine, i);
+                }
+            };
+            std::vector<std::thread> threads;
+            for (unsigned int i = 1; i < std::min(nbJobs, static_cast<unsigned int>(nbChunks)); ++i) {
+                threads.emplace_back(worker);
+            }
+            worker();
+            for (std::thread& t : threads) {
+                t.join();
+            }
+
+            Shape *merged = shape_combine_end(combine);
+            for (int i = 0; i < index; ++i) {
+                shape_release(shapes[i]);
+            }
+            shapes[0] = merged;
+            index = 1;
+        }
+    }
+
     if (err.empty() && index > 0) {
         
         FILE *dst = fopen(output_path.c_str(), "wb");
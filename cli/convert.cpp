@@ -0,0 +1,300 @@
+//
+//  convert.cpp
+//  cli
+//
+//  Created by agent on 19/10/2026.
+//
+
+#include "convert.hpp"
+
+// C++
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+// Cubzh Core
+#include "shape.h"
+#include "stream.h"
+#include "transform.h"
+#include "serialization.h"
+#include "serialization_vox.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+struct ConvertJob {
+    fs::path input;
+    fs::path output;
+};
+
+std::string lowercaseExtension(const fs::path& path) {
+    std::string ext = path.extension().string();
+    std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) {
+        return static_cast<char>(std::tolower(c));
+    });
+    return ext;
+}
+
+bool isSupported(const fs::path& path) {
+    const std::string ext = lowercaseExtension(path);
+    return ext == ".vox" || ext == ".3zh" || ext == ".pcubes";
+}
+
+/// Output is written next to the input when no output directory is given.
+fs::path outputPath(const fs::path& input, const fs::path& root, const fs::path& outputDir) {
+    fs::path output;
+    if (outputDir.empty()) {
+        output = input;
+    } else if (root.empty()) {
+        output = outputDir / input.filename();
+    } else {
+        output = outputDir / input.lexically_relative(root);
+    }
+    output.replace_extension(".3zh");
+    return output;
+}
+
+/// Loads the input with the matching serializer and saves it in the latest format.
+/// Written to a temporary file first, so that in-place conversions can't lose the original.
+bool convertFile(const ConvertJob& job, uint64_t& bytesOut, std::string& err) {
+    const std::string ext = lowercaseExtension(job.input);
+
+    FILE *fd = fopen(job.input.string().c_str(), "rb");
+    if (fd == nullptr) {
+        err = "can't open";
+        return false;
+    }
+    Stream *stream = stream_new_file_read(fd); // Stream is responsible for fclose-ing the file descriptor
+
+    Shape *shape = nullptr;
+    if (ext == ".vox") {
+        const enum serialization_vox_error error = serialization_vox_load(stream,
+                                                                          &shape,
+                                                                          false,
+                                                                          nullptr);
+        stream_free(stream);
+        if (error != no_error && shape != nullptr) {
+            shape_release(shape);
+            shape = nullptr;
+        }
+    } else {
+        // keep baked lighting if present
+        ShapeSettings settings;
+        settings.lighting = true;
+        settings.isMutable = false;
+        shape = serialization_load_shape(stream, // frees stream, closing fd
+                                         "",
+                                         nullptr,
+                                         &settings,
+                                         true); // allowLegacy
+    }
+    if (shape == nullptr) {
+        err = "can't parse";
+        return false;
+    }
+
+    void *imageData = nullptr;
+    uint32_t imageDataSize = 0;
+    if (ext != ".vox") {
+        get_preview_data(job.input.string().c_str(), &imageData, &imageDataSize);
+    }
+
+    std::error_code ec;
+    if (job.output.has_parent_path()) {
+        fs::create_directories(job.output.parent_path(), ec);
+    }
+
+    fs::path tmpPath = job.output;
+    tmpPath += ".tmp";
+    FILE *outfd = fopen(tmpPath.string().c_str(), "wb");
+    bool success = false;
+    if (outfd == nullptr) {
+        err = "can't create " + tmpPath.string();
+    } else if (serialization_save_shape(shape, imageData, imageDataSize, outfd) == false) { // closes outfd
+        err = "can't save";
+        fs::remove(tmpPath, ec);
+    } else {
+        fs::rename(tmpPath, job.output, ec);
+        if (ec) {
+            err = "can't write " + job.output.string();
+            fs::remove(tmpPath, ec);
+        } else {
+            bytesOut = static_cast<uint64_t>(fs::file_size(job.output, ec));
+            success = true;
+        }
+    }
+
+    free_preview_data(&imageData);
+    shape_release(shape);
+    return success;
+}
+
+} // namespace
+
+bool command_convert(cxxopts::ParseResult parseResult, std::string& err) {
+
+    // validation
+
+    if (parseResult.count("input") <= 0) {
+        err.assign("no input files");
+        return false;
+    }
+
+    if (parseResult.count("output") > 1) {
+        err.assign("only 1 output directory is allowed");
+        return false;
+    }
+
+    fs::path outputDir;
+    if (parseResult.count("output") == 1) {
+        outputDir = parseResult["output"].as<std::string>();
+    }
+
+    unsigned int nbJobs = std::max(std::thread::hardware_concurrency(), 1u);
+    if (parseResult.count("jobs") == 1) {
+        nbJobs = std::max(parseResult["jobs"].as<unsigned int>(), 1u);
+    }
+
+    // list files
+
+    std::vector<ConvertJob> jobs;
+    std::error_code ec;
+    for (const std::string& input : parseResult["input"].as<std::vector<std::string>>()) {
+        const fs::path inputPath(input);
+        if (fs::is_directory(inputPath, ec)) {
+            for (const fs::directory_entry& entry : fs::recursive_directory_iterator(inputPath, ec)) {
+                if (entry.is_regular_file(ec) && isSupported(entry.path())) {
+                    jobs.push_back({entry.path(), outputPath(entry.path(), inputPath, outputDir)});
+                }
+            }
+        } else if (fs::is_regular_file(inputPath, ec) && isSupported(inputPath)) {
+            jobs.push_back({inputPath, outputPath(inputPath, fs::path(), outputDir)});
+        } else {
+            err = std::string("can't convert ") + input;
+            return false;
+        }
+    }
+
+    if (jobs.empty()) {
+        err.assign("no .vox, .3zh or .pcubes files found");
+        return false;
+    }
+
+    // refuse jobs writing over another input (foo.vox next to foo.3zh) or sharing their output
+    // (foo.vox and foo.pcubes), re-encoding a .3zh file in place is fine
+    std::vector<std::string> failures;
+    {
+        std::set<fs::path> inputs;
+        std::map<fs::path, size_t> outputs;
+        std::vector<bool> refused(jobs.size(), false);
+        for (const ConvertJob& job : jobs) {
+            inputs.insert(fs::weakly_canonical(job.input, ec));
+        }
+        for (size_t i = 0; i < jobs.size(); ++i) {
+            const fs::path input = fs::weakly_canonical(jobs[i].input, ec);
+            const fs::path output = fs::weakly_canonical(jobs[i].output, ec);
+            if (output != input && inputs.count(output) > 0) {
+                refused[i] = true;
+                failures.push_back(jobs[i].input.string() + ": would overwrite input " +
+                                   jobs[i].output.string());
+                continue;
+            }
+            const auto inserted = outputs.emplace(output, i);
+            if (inserted.second == false) {
+                refused[i] = true;
+                failures.push_back(jobs[i].input.string() + ": same output as " +
+                                   jobs[inserted.first->second].input.string());
+                if (refused[inserted.first->second] == false) {
+                    refused[inserted.first->second] = true;
+                    failures.push_back(jobs[inserted.first->second].input.string() +
+                                       ": same output as " + jobs[i].input.string());
+                }
+            }
+        }
+        std::vector<ConvertJob> accepted;
+        for (size_t i = 0; i < jobs.size(); ++i) {
+            if (refused[i] == false) {
+                accepted.push_back(jobs[i]);
+            }
+        }
+        jobs.swap(accepted);
+    }
+    nbJobs = std::max(std::min(nbJobs, static_cast<unsigned int>(jobs.size())), 1u);
+
+    // processing
+
+    std::cout << "* Converting " << jobs.size() << " files with " << nbJobs << " jobs..." << std::endl;
+
+    // shapes are created from several threads
+    transform_init_ID_thread_safety();
+
+    std::atomic<size_t> next(0);
+    std::atomic<size_t> converted(0);
+    std::atomic<uint64_t> bytesIn(0);
+    std::atomic<uint64_t> bytesOut(0);
+    std::mutex failuresMutex;
+
+    const auto start = std::chrono::steady_clock::now();
+
+    auto worker = [&]() {
+        size_t i;
+        while ((i = next.fetch_add(1)) < jobs.size()) {
+            const ConvertJob& job = jobs[i];
+            std::error_code sizeError;
+            const uintmax_t inSize = fs::file_size(job.input, sizeError);
+
+            uint64_t outSize = 0;
+            std::string jobErr;
+            if (convertFile(job, outSize, jobErr)) {
+                converted.fetch_add(1);
+                bytesIn.fetch_add(sizeError ? 0 : static_cast<uint64_t>(inSize));
+                bytesOut.fetch_add(outSize);
+            } else {
+                std::lock_guard<std::mutex> lock(failuresMutex);
+                failures.push_back(job.input.string() + ": " + jobErr);
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (unsigned int i = 1; i < nbJobs; ++i) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (std::thread& t : threads) {
+        t.join();
+    }
+
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    const double mbIn = static_cast<double>(bytesIn.load()) / (1024.0 * 1024.0);
+    const double mbOut = static_cast<double>(bytesOut.load()) / (1024.0 * 1024.0);
+
+    // stats
+
+    for (const std::string& failure : failures) {
+        std::cout << "    - failed: " << failure << std::endl;
+    }
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "  converted: " << converted.load() << ", failed: " << failures.size() << std::endl;
+    std::cout << "  read: " << mbIn << " MB, written: " << mbOut << " MB" << std::endl;
+    std::cout << "  time: " << seconds << "s, "
+              << (seconds > 0.0 ? static_cast<double>(converted.load()) / seconds : 0.0) << " files/s, "
+              << (seconds > 0.0 ? mbIn / seconds : 0.0) << " MB/s" << std::endl;
+
+    if (failures.empty() == false) {
+        err = std::to_string(failures.size()) + " files could not be converted";
+        return false;
+    }
+
+    return true;
+}
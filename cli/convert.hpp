@@ -0,0 +1,22 @@
+//
+//  convert.hpp
+//  cli
+//
+//  Created by agent on 19/10/2026.
+//
+
+#pragma once
+
+// C++
+#include <string>
+
+// cxxopts
+#include <cxxopts.hpp>
+
+/// Converts .vox, .3zh and .pcubes files (or directories containing them) to the latest .3zh
+/// format. Files are processed in parallel, one worker per core unless `jobs` is provided.
+/// Inputs whose output would overwrite another input, or share its output with another input,
+/// are not converted and reported as failures.
+/// Returns true on success, false otherwise.
+/// When an error occured, the `err` argument is filled with an error message.
+bool command_convert(cxxopts::ParseResult parseResult, std::string& err);
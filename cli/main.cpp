@@ -11,9 +11,14 @@
 // cxxopts
 #include <cxxopts.hpp>
 
+// Cubzh Core
+#include "chunk.h"
+
 // cli
+#include "bench.hpp"
 #include "blocks.hpp"
 #include "combine.hpp"
+#include "convert.hpp"
 #include "shape_point.hpp"
 
 int main(int argc, const char * argv[]) {
@@ -21,10 +26,12 @@ int main(int argc, const char * argv[]) {
     cxxopts::Options options("Cubzh", "Tools for voxels.");
 
     options.add_options()
-    ("command", "command to use: blocks,combine,setpoint", cxxopts::value<std::string>())
-    ("i,input", "input files", cxxopts::value<std::vector<std::string>>())
+    ("command", "command to use: bench,blocks,combine,convert,setpoint", cxxopts::value<std::string>())
+    ("i,input", "input files (or directories for convert)", cxxopts::value<std::vector<std::string>>())
     // ("n,name", "input file name", cxxopts::value<std::vector<std::string>>())
-    ("o,output", "output file", cxxopts::value<std::string>())
+    ("o,output", "output file (or directory for convert)", cxxopts::value<std::string>())
+    ("j,jobs", "number of parallel jobs for convert and combine --merge (default: number of cores)", cxxopts::value<unsigned int>())
+    ("m,merge", "merge combined files into a single shape", cxxopts::value<bool>())
     ;
 
     options.parse_positional({"command"});
@@ -36,15 +43,22 @@ int main(int argc, const char * argv[]) {
         exit(0);
     }
 
+    // shared by all chunks created w/ lighting, allocated before any worker thread starts
+    chunk_alloc_default_light();
+
     // ---------------------------------------------------------------
     const std::string command = result["command"].as<std::string>();
     bool success = false;
     std::string err = "";
 
-    if (command == "blocks") {
+    if (command == "bench") {
+        success = command_bench(result, err);
+    } else if (command == "blocks") {
         success = count_blocks(result, err);
     } else if (command == "combine") {
         success = command_combine(result, err);
+    } else if (command == "convert") {
+        success = command_convert(result, err);
     } else if (command == "setpoint") {
         success = commandSetPoint(result, err);
     } else {
@@ -65,11 +65,11 @@ bool block_is_opaque(const Block *block, const ColorPalette *palette) {
            color_palette_is_transparent(palette, block->colorIndex) == false;
 }
 
-bool block_is_transparent(Block *block, const ColorPalette *palette) {
+bool block_is_transparent(const Block *block, const ColorPalette *palette) {
     return block_is_solid(block) && color_palette_is_transparent(palette, block->colorIndex);
 }
 
-void block_is_ao_and_light_caster(Block *block,
+void block_is_ao_and_light_caster(const Block *block,
                                   const ColorPalette *palette,
                                   bool *ao,
                                   bool *light) {
@@ -82,7 +82,7 @@ void block_is_ao_and_light_caster(Block *block,
 #endif
 }
 
-void block_is_any(Block *block,
+void block_is_any(const Block *block,
                   const ColorPalette *palette,
                   bool *solid,
                   bool *opaque,
@@ -49,15 +49,18 @@ bool block_is_solid(const Block *const block);
 bool block_is_opaque(const Block *block, const ColorPalette *palette);
 
 // a solid block w/ alpha < 255 is a transparent block
-bool block_is_transparent(Block *block, const ColorPalette *palette);
+bool block_is_transparent(const Block *block, const ColorPalette *palette);
 
 // a block can be a light and/or AO caster when it comes to sampling vertex light values
 // - AO caster means that adjacent vertices will consider this block in the final AO value
 // - light caster means adjacent vertices will consider this block in the final light value
-void block_is_ao_and_light_caster(Block *block, const ColorPalette *palette, bool *ao, bool *light);
+void block_is_ao_and_light_caster(const Block *block,
+                                  const ColorPalette *palette,
+                                  bool *ao,
+                                  bool *light);
 
 // helper function that efficiently gathers all lighting properties for a block
-void block_is_any(Block *block,
+void block_is_any(const Block *block,
                   const ColorPalette *palette,
                   bool *solid,
                   bool *opaque,
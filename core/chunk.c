@@ -26,13 +26,20 @@ struct _Chunk {
     Octree *octree; /* 8 bytes */
     // NULL if chunk does not use lighting
     VERTEX_LIGHT_STRUCT_T *lightingData; /* 8 bytes */
+    // number of chunk copies sharing octree & lightingData, NULL if not shared
+    uint32_t *sharedCount; /* 8 bytes */
     // reference to shape chunks rtree leaf node, used for removal
     void *rtreeLeaf; /* 8 bytes */
     // first opaque/transparent vbma reserved for that chunk, this can be chained across several vb
     VertexBufferMemArea *vbma_opaque;      /* 8 bytes */
     VertexBufferMemArea *vbma_transparent; /* 8 bytes */
+    // solid blocks occupancy, one row per (y, z) indexed z * CHUNK_SIZE + y, bit x set if solid.
+    // Not shared between copies, used for fast collision tests
+    CHUNK_ROW_MASK_T solidRows[CHUNK_SIZE_SQR]; /* 512 bytes */
     // number of blocks in that chunk
     int nbBlocks; /* 4 bytes */
+    // set by the owning shape when blocks are added or removed, see shape_blocks_changed_in_box
+    uint32_t stamp; /* 4 bytes */
     // position of chunk in shape's model
     SHAPE_COORDS_INT3_T origin; /* 3 x 2 bytes */
     // model axis-aligned bounding box (bbMax - 1 is the max block)
@@ -40,12 +47,15 @@ struct _Chunk {
     // whether vertices need to be refreshed
     bool dirty; /* 1 byte */
 
-    char pad[7];
+    char pad[3];
 };
 
 // MARK: private functions prototypes
 
 Octree *_chunk_new_octree(void);
+/// clones shared octree & lighting data, to be called before modifying any of them. Returns
+/// false if they can't be cloned, chunk still sharing them
+bool _chunk_make_unique(Chunk *chunk);
 
 void _chunk_hello_neighbor(Chunk *newcomer,
                            Neighbor newcomerLocation,
@@ -55,7 +65,7 @@ void _chunk_good_bye_neighbor(Chunk *chunk, Neighbor location);
 
 /// used to gather vertex lighting values & properties in chunk_write_vertices
 void _vertex_light_get(Chunk *chunk,
-                       Block *block,
+                       const Block *block,
                        const ColorPalette *palette,
                        CHUNK_COORDS_INT3_T coords,
                        VERTEX_LIGHT_STRUCT_T *vlight,
@@ -70,6 +80,12 @@ void _vertex_light_smoothing(VERTEX_LIGHT_STRUCT_T *base,
                              VERTEX_LIGHT_STRUCT_T vlight2,
                              VERTEX_LIGHT_STRUCT_T vlight3);
 
+void _chunk_set_solid(Chunk *chunk,
+                      const CHUNK_COORDS_INT_T x,
+                      const CHUNK_COORDS_INT_T y,
+                      const CHUNK_COORDS_INT_T z,
+                      const bool solid);
+
 bool _chunk_is_bounding_box_empty(const Chunk *chunk);
 void _chunk_update_bounding_box(Chunk *chunk,
                                 const CHUNK_COORDS_INT3_T coords,
@@ -94,12 +110,15 @@ Chunk *chunk_new(const SHAPE_COORDS_INT3_T origin) {
     }
     chunk->octree = _chunk_new_octree();
     chunk->lightingData = NULL;
+    chunk->sharedCount = NULL;
     chunk->rtreeLeaf = NULL;
     chunk->dirty = false;
     chunk->origin = origin;
     chunk->bbMin = (CHUNK_COORDS_INT3_T){0, 0, 0};
     chunk->bbMax = (CHUNK_COORDS_INT3_T){0, 0, 0};
     chunk->nbBlocks = 0;
+    chunk->stamp = 0;
+    memset(chunk->solidRows, 0, sizeof(chunk->solidRows));
 
     for (int i = 0; i < CHUNK_NEIGHBORS_COUNT; i++) {
         chunk->neighbors[i] = NULL;
@@ -111,26 +130,33 @@ Chunk *chunk_new(const SHAPE_COORDS_INT3_T origin) {
     return chunk;
 }
 
-Chunk *chunk_new_copy(const Chunk *c) {
+Chunk *chunk_new_copy(Chunk *c) {
     Chunk *copy = (Chunk *)malloc(sizeof(Chunk));
     if (copy == NULL) {
         return NULL;
     }
-    copy->octree = octree_new_copy(c->octree);
-    if (c->lightingData != NULL) {
-        const size_t lightingSize = (size_t)CHUNK_SIZE_SQR * (size_t)CHUNK_SIZE *
-                                    (size_t)sizeof(VERTEX_LIGHT_STRUCT_T);
-        copy->lightingData = malloc(lightingSize);
-        memcpy(copy->lightingData, c->lightingData, lightingSize);
-    } else {
-        copy->lightingData = NULL;
+
+    // octree & lighting data are shared until one of the chunks gets modified
+    if (c->sharedCount == NULL) {
+        c->sharedCount = (uint32_t *)malloc(sizeof(uint32_t));
+        if (c->sharedCount == NULL) {
+            free(copy);
+            return NULL;
+        }
+        *c->sharedCount = 1;
     }
+    ++(*c->sharedCount);
+    copy->octree = c->octree;
+    copy->lightingData = c->lightingData;
+    copy->sharedCount = c->sharedCount;
     copy->rtreeLeaf = NULL;
     copy->dirty = false;
     copy->origin = c->origin;
     copy->bbMin = c->bbMin;
     copy->bbMax = c->bbMax;
     copy->nbBlocks = c->nbBlocks;
+    copy->stamp = c->stamp;
+    memcpy(copy->solidRows, c->solidRows, sizeof(c->solidRows));
 
     for (int i = 0; i < CHUNK_NEIGHBORS_COUNT; i++) {
         copy->neighbors[i] = NULL;
@@ -147,9 +173,14 @@ void chunk_free(Chunk *chunk, bool updateNeighbors) {
         chunk_leave_neighborhood(chunk);
     }
 
-    octree_free(chunk->octree);
-    if (chunk->lightingData != NULL) {
-        free(chunk->lightingData);
+    if (chunk->sharedCount != NULL && *chunk->sharedCount > 1) {
+        --(*chunk->sharedCount);
+    } else {
+        free(chunk->sharedCount);
+        octree_free(chunk->octree);
+        if (chunk->lightingData != NULL) {
+            free(chunk->lightingData);
+        }
     }
 
     if (chunk->vbma_opaque != NULL) {
@@ -185,7 +216,15 @@ int chunk_get_nb_blocks(const Chunk *chunk) {
     return chunk->nbBlocks;
 }
 
-Octree *chunk_get_octree(const Chunk *c) {
+void chunk_set_stamp(Chunk *c, const uint32_t stamp) {
+    c->stamp = stamp;
+}
+
+uint32_t chunk_get_stamp(const Chunk *c) {
+    return c->stamp;
+}
+
+const Octree *chunk_get_octree(const Chunk *c) {
     return c->octree;
 }
 
@@ -216,6 +255,11 @@ void chunk_set_light(Chunk *c,
 
     if (c->lightingData == NULL) {
         chunk_reset_lighting_data(c, initEmpty);
+        if (c->lightingData == NULL) {
+            return;
+        }
+    } else if (_chunk_make_unique(c) == false) {
+        return;
     }
 
     c->lightingData[coords.x * CHUNK_SIZE_SQR + coords.y * CHUNK_SIZE + coords.z] = light;
@@ -246,6 +290,9 @@ VERTEX_LIGHT_STRUCT_T chunk_get_light_or_default(Chunk *c,
 
 void chunk_clear_lighting_data(Chunk *c) {
     if (c->lightingData != NULL) {
+        if (_chunk_make_unique(c) == false) {
+            return;
+        }
         free(c->lightingData);
         c->lightingData = NULL;
     }
@@ -253,8 +300,14 @@ void chunk_clear_lighting_data(Chunk *c) {
 
 void chunk_reset_lighting_data(Chunk *c, const bool emptyOrDefault) {
     const size_t lightingSize = (size_t)CHUNK_SIZE_CUBE * (size_t)sizeof(VERTEX_LIGHT_STRUCT_T);
+    if (_chunk_make_unique(c) == false) {
+        return;
+    }
     if (c->lightingData == NULL) {
         c->lightingData = malloc(lightingSize);
+        if (c->lightingData == NULL) {
+            return;
+        }
     }
     if (emptyOrDefault) {
         memset(c->lightingData, 0, lightingSize);
@@ -265,13 +318,17 @@ void chunk_reset_lighting_data(Chunk *c, const bool emptyOrDefault) {
 }
 
 void chunk_set_lighting_data(Chunk *c, VERTEX_LIGHT_STRUCT_T *data) {
+    if (_chunk_make_unique(c) == false) {
+        free(data);
+        return;
+    }
     if (c->lightingData != NULL) {
         free(c->lightingData);
     }
     c->lightingData = data;
 }
 
-VERTEX_LIGHT_STRUCT_T *chunk_get_lighting_data(Chunk *c) {
+const VERTEX_LIGHT_STRUCT_T *chunk_get_lighting_data(const Chunk *c) {
     return c->lightingData;
 }
 
@@ -289,14 +346,125 @@ bool chunk_add_block(Chunk *chunk,
         octree_get_element_without_checking(chunk->octree, (size_t)x, (size_t)y, (size_t)z);
     if (block_is_solid(b)) {
         return false;
+    } else if (_chunk_make_unique(chunk) == false) {
+        return false;
     } else {
         octree_set_element(chunk->octree, &block, (size_t)x, (size_t)y, (size_t)z);
+        _chunk_set_solid(chunk, x, y, z, true);
         chunk->nbBlocks++;
         _chunk_update_bounding_box(chunk, (CHUNK_COORDS_INT3_T){x, y, z}, true);
         return true;
     }
 }
 
+uint32_t chunk_add_blocks(Chunk *chunk,
+                          const uint16_t *coords,
+                          const SHAPE_COLOR_INDEX_INT_T *colors,
+                          const uint32_t count,
+                          uint32_t *colorsCount) {
+
+    CHUNK_COORDS_INT3_T min = {CHUNK_SIZE, CHUNK_SIZE, CHUNK_SIZE};
+    CHUNK_COORDS_INT3_T max = {-1, -1, -1};
+    uint32_t added = 0;
+
+    Block block;
+    Block *b;
+    CHUNK_COORDS_INT_T x, y, z;
+    for (uint32_t i = 0; i < count; ++i) {
+        block.colorIndex = colors[i];
+        if (block_is_solid(&block) == false) {
+            continue;
+        }
+
+        x = (CHUNK_COORDS_INT_T)(coords[i] / CHUNK_SIZE_SQR);
+        y = (CHUNK_COORDS_INT_T)(coords[i] / CHUNK_SIZE % CHUNK_SIZE);
+        z = (CHUNK_COORDS_INT_T)(coords[i] % CHUNK_SIZE);
+
+        b = (Block *)
+            octree_get_element_without_checking(chunk->octree, (size_t)x, (size_t)y, (size_t)z);
+        if (block_is_solid(b)) {
+            continue;
+        }
+        if (_chunk_make_unique(chunk) == false) {
+            break;
+        }
+        octree_set_element(chunk->octree, &block, (size_t)x, (size_t)y, (size_t)z);
+        _chunk_set_solid(chunk, x, y, z, true);
+
+        min.x = minimum(min.x, x);
+        min.y = minimum(min.y, y);
+        min.z = minimum(min.z, z);
+        max.x = maximum(max.x, x);
+        max.y = maximum(max.y, y);
+        max.z = maximum(max.z, z);
+
+        if (colorsCount != NULL) {
+            ++colorsCount[block.colorIndex];
+        }
+        ++added;
+    }
+
+    if (added > 0) {
+        chunk->nbBlocks += (int)added;
+        _chunk_update_bounding_box(chunk, min, true);
+        _chunk_update_bounding_box(chunk, max, true);
+    }
+
+    return added;
+}
+
+uint32_t chunk_set_blocks(Chunk *chunk, const Block *blocks, uint32_t *colorsCount) {
+    vx_assert(octree_get_dimension(chunk->octree) == CHUNK_SIZE);
+
+    if (_chunk_make_unique(chunk) == false) {
+        return 0;
+    }
+    const Block air = {SHAPE_COLOR_INDEX_AIR_BLOCK};
+    octree_set_elements(chunk->octree, blocks, &air);
+
+    CHUNK_COORDS_INT3_T min = {CHUNK_SIZE, CHUNK_SIZE, CHUNK_SIZE};
+    CHUNK_COORDS_INT3_T max = {-1, -1, -1};
+    uint32_t count = 0;
+    const Block *b = blocks;
+    CHUNK_ROW_MASK_T *row = chunk->solidRows;
+    for (CHUNK_COORDS_INT_T z = 0; z < CHUNK_SIZE; ++z) {
+        for (CHUNK_COORDS_INT_T y = 0; y < CHUNK_SIZE; ++y, ++row) {
+            *row = 0;
+            for (CHUNK_COORDS_INT_T x = 0; x < CHUNK_SIZE; ++x, ++b) {
+                if (block_is_solid(b) == false) {
+                    continue;
+                }
+                *row |= (CHUNK_ROW_MASK_T)(1u << x);
+                min.x = minimum(min.x, x);
+                min.y = minimum(min.y, y);
+                min.z = minimum(min.z, z);
+                max.x = maximum(max.x, x);
+                max.y = maximum(max.y, y);
+                max.z = maximum(max.z, z);
+                if (colorsCount != NULL) {
+                    ++colorsCount[b->colorIndex];
+                }
+                ++count;
+            }
+        }
+    }
+
+    chunk->nbBlocks = (int)count;
+    if (count > 0) {
+        chunk->bbMin = min;
+        chunk->bbMax = (CHUNK_COORDS_INT3_T){max.x + 1, max.y + 1, max.z + 1};
+    } else {
+        chunk->bbMin = (CHUNK_COORDS_INT3_T){0, 0, 0};
+        chunk->bbMax = (CHUNK_COORDS_INT3_T){0, 0, 0};
+    }
+
+    return count;
+}
+
+const Block *chunk_get_blocks(const Chunk *chunk) {
+    return (const Block *)octree_get_elements(chunk->octree);
+}
+
 bool chunk_remove_block(Chunk *chunk,
                         const CHUNK_COORDS_INT_T x,
                         const CHUNK_COORDS_INT_T y,
@@ -309,8 +477,18 @@ bool chunk_remove_block(Chunk *chunk,
         if (prevColorIndex != NULL) {
             *prevColorIndex = block_get_color_index(b);
         }
+        if (chunk->sharedCount != NULL) {
+            if (_chunk_make_unique(chunk) == false) {
+                return false;
+            }
+            b = (Block *)octree_get_element_without_checking(chunk->octree,
+                                                             (size_t)x,
+                                                             (size_t)y,
+                                                             (size_t)z);
+        }
         block_set_color_index(b, SHAPE_COLOR_INDEX_AIR_BLOCK);
         octree_remove_element(chunk->octree, (size_t)x, (size_t)y, (size_t)z, NULL);
+        _chunk_set_solid(chunk, x, y, z, false);
         chunk->nbBlocks--;
         _chunk_update_bounding_box(chunk, (CHUNK_COORDS_INT3_T){x, y, z}, false);
         return true;
@@ -332,6 +510,15 @@ bool chunk_paint_block(Chunk *chunk,
         if (prevColorIndex != NULL) {
             *prevColorIndex = block_get_color_index(b);
         }
+        if (chunk->sharedCount != NULL) {
+            if (_chunk_make_unique(chunk) == false) {
+                return false;
+            }
+            b = (Block *)octree_get_element_without_checking(chunk->octree,
+                                                             (size_t)x,
+                                                             (size_t)y,
+                                                             (size_t)z);
+        }
         block_set_color_index(b, colorIndex);
         return true;
     } else {
@@ -339,10 +526,47 @@ bool chunk_paint_block(Chunk *chunk,
     }
 }
 
-Block *chunk_get_block(const Chunk *chunk,
-                       const CHUNK_COORDS_INT_T x,
-                       const CHUNK_COORDS_INT_T y,
-                       const CHUNK_COORDS_INT_T z) {
+CHUNK_ROW_MASK_T chunk_get_solid_row(const Chunk *chunk,
+                                     const CHUNK_COORDS_INT_T y,
+                                     const CHUNK_COORDS_INT_T z) {
+    return chunk->solidRows[z * CHUNK_SIZE + y];
+}
+
+bool chunk_get_first_solid_block_in_range(const Chunk *chunk,
+                                          const CHUNK_COORDS_INT3_T min,
+                                          const CHUNK_COORDS_INT3_T max,
+                                          CHUNK_COORDS_INT3_T *coords) {
+    if (min.x > max.x || min.y > max.y || min.z > max.z) {
+        return false;
+    }
+    vx_assert(min.x >= 0 && min.y >= 0 && min.z >= 0);
+    vx_assert(max.x < CHUNK_SIZE && max.y < CHUNK_SIZE && max.z < CHUNK_SIZE);
+
+    const CHUNK_ROW_MASK_T xMask = chunk_utils_get_row_mask(min.x, max.x);
+    CHUNK_ROW_MASK_T row;
+    for (CHUNK_COORDS_INT_T z = min.z; z <= max.z; ++z) {
+        for (CHUNK_COORDS_INT_T y = min.y; y <= max.y; ++y) {
+            row = chunk->solidRows[z * CHUNK_SIZE + y] & xMask;
+            if (row == 0) {
+                continue;
+            }
+            if (coords != NULL) {
+                CHUNK_COORDS_INT_T x = min.x;
+                while ((row & (1u << x)) == 0) {
+                    ++x;
+                }
+                *coords = (CHUNK_COORDS_INT3_T){x, y, z};
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+const Block *chunk_get_block(const Chunk *chunk,
+                             const CHUNK_COORDS_INT_T x,
+                             const CHUNK_COORDS_INT_T y,
+                             const CHUNK_COORDS_INT_T z) {
     if (chunk == NULL) {
         return NULL;
     }
@@ -354,20 +578,20 @@ Block *chunk_get_block(const Chunk *chunk,
     if (z < 0 || z > CHUNK_SIZE_MINUS_ONE)
         return NULL;
 
-    return (
-        Block *)octree_get_element_without_checking(chunk->octree, (size_t)x, (size_t)y, (size_t)z);
+    return (const Block *)
+        octree_get_element_without_checking(chunk->octree, (size_t)x, (size_t)y, (size_t)z);
 }
 
-Block *chunk_get_block_2(const Chunk *chunk, CHUNK_COORDS_INT3_T coords) {
+const Block *chunk_get_block_2(const Chunk *chunk, CHUNK_COORDS_INT3_T coords) {
     return chunk_get_block(chunk, coords.x, coords.y, coords.z);
 }
 
-Block *chunk_get_block_including_neighbors(Chunk *chunk,
-                                           const CHUNK_COORDS_INT_T x,
-                                           const CHUNK_COORDS_INT_T y,
-                                           const CHUNK_COORDS_INT_T z,
-                                           Chunk **out_chunk,
-                                           CHUNK_COORDS_INT3_T *out_coords) {
+const Block *chunk_get_block_including_neighbors(Chunk *chunk,
+                                                 const CHUNK_COORDS_INT_T x,
+                                                 const CHUNK_COORDS_INT_T y,
+                                                 const CHUNK_COORDS_INT_T z,
+                                                 Chunk **out_chunk,
+                                                 CHUNK_COORDS_INT3_T *out_coords) {
     if (chunk == NULL) {
         *out_chunk = NULL;
         *out_coords = (CHUNK_COORDS_INT3_T){x, y, z};
@@ -492,10 +716,10 @@ Block *chunk_get_block_including_neighbors(Chunk *chunk,
     if (_chunk == NULL) {
         return NULL;
     } else {
-        return (Block *)octree_get_element_without_checking(_chunk->octree,
-                                                            (size_t)_coords.x,
-                                                            (size_t)_coords.y,
-                                                            (size_t)_coords.z);
+        return (const Block *)octree_get_element_without_checking(_chunk->octree,
+                                                                  (size_t)_coords.x,
+                                                                  (size_t)_coords.y,
+                                                                  (size_t)_coords.z);
     }
 }
 
@@ -521,6 +745,13 @@ SHAPE_COORDS_INT3_T chunk_utils_get_coords(const SHAPE_COORDS_INT3_T coords_in_s
 #endif
 }
 
+CHUNK_ROW_MASK_T chunk_utils_get_row_mask(const CHUNK_COORDS_INT_T min,
+                                          const CHUNK_COORDS_INT_T max) {
+    vx_assert(min >= 0 && max < CHUNK_SIZE && min <= max);
+    // computed on 32 bits, enough for CHUNK_SIZE up to 31
+    return (CHUNK_ROW_MASK_T)(((1u << (max + 1)) - 1u) & ~((1u << min) - 1u));
+}
+
 CHUNK_COORDS_INT3_T chunk_utils_get_coords_in_chunk(const SHAPE_COORDS_INT3_T coords_in_shape) {
 #if CHUNK_SIZE_IS_PERFECT_SQRT
     return (CHUNK_COORDS_INT3_T){(CHUNK_COORDS_INT_T)(coords_in_shape.x & CHUNK_SIZE_MINUS_ONE),
@@ -536,6 +767,71 @@ CHUNK_COORDS_INT3_T chunk_utils_get_coords_in_chunk(const SHAPE_COORDS_INT3_T co
 #endif
 }
 
+uint32_t chunk_downsample(const Chunk *chunk, const uint8_t level, SHAPE_COLOR_INDEX_INT_T *colors) {
+    const int cellSize = 1 << level;
+    const int size = CHUNK_SIZE >> level;
+    vx_assert(size > 0);
+
+    memset(colors, SHAPE_COLOR_INDEX_AIR_BLOCK, (size_t)(size * size * size));
+    if (chunk->nbBlocks == 0) {
+        return 0;
+    }
+
+    // only cells overlapping chunk bounding box can be solid
+    const int min[3] = {chunk->bbMin.x / cellSize, chunk->bbMin.y / cellSize, chunk->bbMin.z / cellSize};
+    const int max[3] = {(chunk->bbMax.x + cellSize - 1) / cellSize,
+                        (chunk->bbMax.y + cellSize - 1) / cellSize,
+                        (chunk->bbMax.z + cellSize - 1) / cellSize};
+
+    uint16_t counts[SHAPE_COLOR_INDEX_MAX_COUNT] = {0};
+    SHAPE_COLOR_INDEX_INT_T used[SHAPE_COLOR_INDEX_MAX_COUNT];
+    int nbUsed;
+    uint32_t solid = 0;
+    const Block *b;
+    for (int cx = min[0]; cx < max[0]; ++cx) {
+        for (int cy = min[1]; cy < max[1]; ++cy) {
+            for (int cz = min[2]; cz < max[2]; ++cz) {
+                nbUsed = 0;
+                for (int x = cx * cellSize; x < (cx + 1) * cellSize; ++x) {
+                    for (int y = cy * cellSize; y < (cy + 1) * cellSize; ++y) {
+                        for (int z = cz * cellSize; z < (cz + 1) * cellSize; ++z) {
+                            b = (const Block *)octree_get_element_without_checking(chunk->octree,
+                                                                                   (size_t)x,
+                                                                                   (size_t)y,
+                                                                                   (size_t)z);
+                            if (block_is_solid(b)) {
+                                if (counts[b->colorIndex]++ == 0) {
+                                    used[nbUsed++] = b->colorIndex;
+                                }
+                            }
+                        }
+                    }
+                }
+                if (nbUsed == 0) {
+                    continue;
+                }
+
+                // most used color, lowest index on ties
+                SHAPE_COLOR_INDEX_INT_T color = used[0];
+                for (int i = 0; i < nbUsed; ++i) {
+                    if (counts[used[i]] > counts[color] ||
+                        (counts[used[i]] == counts[color] && used[i] < color)) {
+                        color = used[i];
+                    }
+                }
+                for (int i = 0; i < nbUsed; ++i) {
+                    counts[used[i]] = 0;
+                }
+
+                colors[(cx * size + cy) * size + cz] = color;
+                ++solid;
+            }
+        }
+    }
+
+    return solid;
+}
+
 void chunk_get_bounding_box(const Chunk *chunk, float3 *min, float3 *max) {
     if (min != NULL) {
         min->x = (float)chunk->bbMin.x;
@@ -567,38 +863,16 @@ Chunk *chunk_get_neighbor(const Chunk *chunk, Neighbor location) {
 }
 
 void chunk_move_in_neighborhood(Index3D *chunks, Chunk *chunk, SHAPE_COORDS_INT3_T coords) {
-    void **batchedNode_X = NULL, **batchedNode_Y = NULL;
-
-    // Batch Index3D search for all neighbors on the right (x+1)
-    Chunk *x = NULL, *x_y = NULL, *x_y_z = NULL, *x_y_nz = NULL, *x_ny = NULL, *x_ny_z = NULL,
-          *x_ny_nz = NULL, *x_z = NULL, *x_nz = NULL;
-
-    index3d_batch_get_reset(chunks, &batchedNode_X);
-    if (index3d_batch_get_advance(coords.x + 1, &batchedNode_X)) {
-        // y batch
-        batchedNode_Y = batchedNode_X;
-        if (index3d_batch_get_advance(coords.y, &batchedNode_Y)) {
-            x = index3d_batch_get(coords.z, batchedNode_Y);
-            x_z = index3d_batch_get(coords.z + 1, batchedNode_Y);
-            x_nz = index3d_batch_get(coords.z - 1, batchedNode_Y);
-        }
-
-        // y+1 batch
-        batchedNode_Y = batchedNode_X;
-        if (index3d_batch_get_advance(coords.y + 1, &batchedNode_Y)) {
-            x_y = index3d_batch_get(coords.z, batchedNode_Y);
-            x_y_z = index3d_batch_get(coords.z + 1, batchedNode_Y);
-            x_y_nz = index3d_batch_get(coords.z - 1, batchedNode_Y);
-        }
+    // single Index3D lookup for the whole 3x3x3 neighborhood
+    void *n[INDEX3D_NEIGHBORHOOD_SIZE];
+    index3d_get_neighborhood(chunks, coords.x, coords.y, coords.z, n);
 
-        // y-1 batch
-        batchedNode_Y = batchedNode_X;
-        if (index3d_batch_get_advance(coords.y - 1, &batchedNode_Y)) {
-            x_ny = index3d_batch_get(coords.z, batchedNode_Y);
-            x_ny_z = index3d_batch_get(coords.z + 1, batchedNode_Y);
-            x_ny_nz = index3d_batch_get(coords.z - 1, batchedNode_Y);
-        }
-    }
+    // neighbors on the right (x+1)
+    Chunk *x = n[INDEX3D_NEIGHBOR(1, 0, 0)], *x_z = n[INDEX3D_NEIGHBOR(1, 0, 1)],
+          *x_nz = n[INDEX3D_NEIGHBOR(1, 0, -1)], *x_y = n[INDEX3D_NEIGHBOR(1, 1, 0)],
+          *x_y_z = n[INDEX3D_NEIGHBOR(1, 1, 1)], *x_y_nz = n[INDEX3D_NEIGHBOR(1, 1, -1)],
+          *x_ny = n[INDEX3D_NEIGHBOR(1, -1, 0)], *x_ny_z = n[INDEX3D_NEIGHBOR(1, -1, 1)],
+          *x_ny_nz = n[INDEX3D_NEIGHBOR(1, -1, -1)];
 
     _chunk_hello_neighbor(chunk, NX, x, X);
     _chunk_hello_neighbor(chunk, NX_NZ, x_z, X_Z);
@@ -612,36 +886,12 @@ void chunk_move_in_neighborhood(Index3D *chunks, Chunk *chunk, SHAPE_COORDS_INT3
     _chunk_hello_neighbor(chunk, NX_Y_NZ, x_ny_z, X_NY_Z);
     _chunk_hello_neighbor(chunk, NX_Y_Z, x_ny_nz, X_NY_NZ);
 
-    // Batch Index3D search for all neighbors on the left (x-1)
-    Chunk *nx = NULL, *nx_y = NULL, *nx_y_z = NULL, *nx_y_nz = NULL, *nx_ny = NULL, *nx_ny_z = NULL,
-          *nx_ny_nz = NULL, *nx_z = NULL, *nx_nz = NULL;
-
-    index3d_batch_get_reset(chunks, &batchedNode_X);
-    if (index3d_batch_get_advance(coords.x - 1, &batchedNode_X)) {
-        // y batch
-        batchedNode_Y = batchedNode_X;
-        if (index3d_batch_get_advance(coords.y, &batchedNode_Y)) {
-            nx = index3d_batch_get(coords.z, batchedNode_Y);
-            nx_z = index3d_batch_get(coords.z + 1, batchedNode_Y);
-            nx_nz = index3d_batch_get(coords.z - 1, batchedNode_Y);
-        }
-
-        // y+1 batch
-        batchedNode_Y = batchedNode_X;
-        if (index3d_batch_get_advance(coords.y + 1, &batchedNode_Y)) {
-            nx_y = index3d_batch_get(coords.z, batchedNode_Y);
-            nx_y_z = index3d_batch_get(coords.z + 1, batchedNode_Y);
-            nx_y_nz = index3d_batch_get(coords.z - 1, batchedNode_Y);
-        }
-
-        // y-1 batch
-        batchedNode_Y = batchedNode_X;
-        if (index3d_batch_get_advance(coords.y - 1, &batchedNode_Y)) {
-            nx_ny = index3d_batch_get(coords.z, batchedNode_Y);
-            nx_ny_z = index3d_batch_get(coords.z + 1, batchedNode_Y);
-            nx_ny_nz = index3d_batch_get(coords.z - 1, batchedNode_Y);
-        }
-    }
+    // neighbors on the left (x-1)
+    Chunk *nx = n[INDEX3D_NEIGHBOR(-1, 0, 0)], *nx_z = n[INDEX3D_NEIGHBOR(-1, 0, 1)],
+          *nx_nz = n[INDEX3D_NEIGHBOR(-1, 0, -1)], *nx_y = n[INDEX3D_NEIGHBOR(-1, 1, 0)],
+          *nx_y_z = n[INDEX3D_NEIGHBOR(-1, 1, 1)], *nx_y_nz = n[INDEX3D_NEIGHBOR(-1, 1, -1)],
+          *nx_ny = n[INDEX3D_NEIGHBOR(-1, -1, 0)], *nx_ny_z = n[INDEX3D_NEIGHBOR(-1, -1, 1)],
+          *nx_ny_nz = n[INDEX3D_NEIGHBOR(-1, -1, -1)];
 
     _chunk_hello_neighbor(chunk, X, nx, NX);
     _chunk_hello_neighbor(chunk, X_NZ, nx_z, NX_Z);
@@ -655,35 +905,11 @@ void chunk_move_in_neighborhood(Index3D *chunks, Chunk *chunk, SHAPE_COORDS_INT3
     _chunk_hello_neighbor(chunk, X_Y_NZ, nx_ny_z, NX_NY_Z);
     _chunk_hello_neighbor(chunk, X_Y_Z, nx_ny_nz, NX_NY_NZ);
 
-    // Batch Index3D search for remaining neighbors (same x)
-    Chunk *y = NULL, *y_z = NULL, *y_nz = NULL, *ny = NULL, *ny_z = NULL, *ny_nz = NULL, *z = NULL,
-          *nz = NULL;
-
-    index3d_batch_get_reset(chunks, &batchedNode_X);
-    if (index3d_batch_get_advance(coords.x, &batchedNode_X)) {
-        // y batch
-        batchedNode_Y = batchedNode_X;
-        if (index3d_batch_get_advance(coords.y, &batchedNode_Y)) {
-            z = index3d_batch_get(coords.z + 1, batchedNode_Y);
-            nz = index3d_batch_get(coords.z - 1, batchedNode_Y);
-        }
-
-        // y+1 batch
-        batchedNode_Y = batchedNode_X;
-        if (index3d_batch_get_advance(coords.y + 1, &batchedNode_Y)) {
-            y = index3d_batch_get(coords.z, batchedNode_Y);
-            y_z = index3d_batch_get(coords.z + 1, batchedNode_Y);
-            y_nz = index3d_batch_get(coords.z - 1, batchedNode_Y);
-        }
-
-        // y-1 batch
-        batchedNode_Y = batchedNode_X;
-        if (index3d_batch_get_advance(coords.y - 1, &batchedNode_Y)) {
-            ny = index3d_batch_get(coords.z, batchedNode_Y);
-            ny_z = index3d_batch_get(coords.z + 1, batchedNode_Y);
-            ny_nz = index3d_batch_get(coords.z - 1, batchedNode_Y);
-        }
-    }
+    // remaining neighbors (same x)
+    Chunk *z = n[INDEX3D_NEIGHBOR(0, 0, 1)], *nz = n[INDEX3D_NEIGHBOR(0, 0, -1)],
+          *y = n[INDEX3D_NEIGHBOR(0, 1, 0)], *y_z = n[INDEX3D_NEIGHBOR(0, 1, 1)],
+          *y_nz = n[INDEX3D_NEIGHBOR(0, 1, -1)], *ny = n[INDEX3D_NEIGHBOR(0, -1, 0)],
+          *ny_z = n[INDEX3D_NEIGHBOR(0, -1, 1)], *ny_nz = n[INDEX3D_NEIGHBOR(0, -1, -1)];
 
     _chunk_hello_neighbor(chunk, NZ, z, Z);
     _chunk_hello_neighbor(chunk, Z, nz, NZ);
@@ -768,7 +994,7 @@ void chunk_write_vertices(Shape *shape, Chunk *chunk) {
     VertexBufferMemAreaWriter *transparentWriter = opaqueWriter;
 #endif
 
-    Block *b;
+    const Block *b;
     SHAPE_COORDS_INT3_T coords_in_shape;
     SHAPE_COLOR_INDEX_INT_T shapeColorIdx;
     ATLAS_COLOR_INDEX_INT_T atlasColorIdx;
@@ -781,7 +1007,7 @@ void chunk_write_vertices(Shape *shape, Chunk *chunk) {
 
     // neighbors block information
     typedef struct {
-        Block *block;
+        const Block *block;
         Chunk *chunk;
         CHUNK_COORDS_INT3_T coords;
         VERTEX_LIGHT_STRUCT_T vlight;
@@ -2342,8 +2568,98 @@ void chunk_write_vertices(Shape *shape, Chunk *chunk) {
 #endif
 }
 
+void chunk_write_cached_vertices(Shape *shape,
+                                 Chunk *chunk,
+                                 const void *opaque,
+                                 uint32_t opaqueCount,
+                                 const void *transparent,
+                                 uint32_t transparentCount) {
+
+    VertexBufferMemAreaWriter *opaqueWriter = vertex_buffer_mem_area_writer_new(shape,
+                                                                                chunk,
+                                                                                chunk->vbma_opaque,
+                                                                                false);
+#if ENABLE_TRANSPARENCY
+    VertexBufferMemAreaWriter *transparentWriter = vertex_buffer_mem_area_writer_new(
+        shape,
+        chunk,
+        chunk->vbma_transparent,
+        true);
+#else
+    VertexBufferMemAreaWriter *transparentWriter = opaqueWriter;
+#endif
+
+    const VertexAttributes *v = (const VertexAttributes *)opaque;
+    for (uint32_t i = 0; i < opaqueCount; i += DRAWBUFFER_VERTICES_PER_FACE) {
+        vertex_buffer_mem_area_writer_write_face(opaqueWriter, v + i);
+    }
+    v = (const VertexAttributes *)transparent;
+    for (uint32_t i = 0; i < transparentCount; i += DRAWBUFFER_VERTICES_PER_FACE) {
+        vertex_buffer_mem_area_writer_write_face(transparentWriter, v + i);
+    }
+
+    vertex_buffer_mem_area_writer_done(opaqueWriter);
+    vertex_buffer_mem_area_writer_free(opaqueWriter);
+#if ENABLE_TRANSPARENCY
+    vertex_buffer_mem_area_writer_done(transparentWriter);
+    vertex_buffer_mem_area_writer_free(transparentWriter);
+#endif
+}
+
+uint32_t chunk_read_vertices(const Chunk *chunk, bool transparent, void *out) {
+    VertexAttributes *cursor = (VertexAttributes *)out;
+    uint32_t count = 0, areaCount;
+
+    VertexBufferMemArea *vbma = transparent ? chunk->vbma_transparent : chunk->vbma_opaque;
+    while (vbma != NULL) {
+        areaCount = vertex_buffer_mem_area_get_count(vbma);
+        if (cursor != NULL && areaCount > 0) {
+            vertex_buffer_read_vertices(vertex_buffer_mem_area_get_vb(vbma),
+                                        vertex_buffer_mem_area_get_start_idx(vbma),
+                                        areaCount,
+                                        cursor + count);
+        }
+        count += areaCount;
+        vbma = vertex_buffer_mem_area_get_group_next(vbma);
+    }
+    return count;
+}
+
 // MARK: private functions
 
+bool _chunk_make_unique(Chunk *chunk) {
+    if (chunk->sharedCount == NULL) {
+        return true;
+    }
+    if (*chunk->sharedCount > 1) {
+        Octree *octree = octree_new_copy(chunk->octree);
+        VERTEX_LIGHT_STRUCT_T *lightingData = NULL;
+        const size_t lightingSize = (size_t)CHUNK_SIZE_CUBE *
+                                    (size_t)sizeof(VERTEX_LIGHT_STRUCT_T);
+        if (chunk->lightingData != NULL) {
+            lightingData = malloc(lightingSize);
+            if (lightingData != NULL) {
+                memcpy(lightingData, chunk->lightingData, lightingSize);
+            }
+        }
+        if (octree == NULL || (chunk->lightingData != NULL && lightingData == NULL)) {
+            cclog_error("chunk: can't copy shared blocks");
+            octree_free(octree);
+            free(lightingData);
+            return false;
+        }
+
+        // shared data only released once both copies exist
+        --(*chunk->sharedCount);
+        chunk->octree = octree;
+        chunk->lightingData = lightingData;
+    } else {
+        free(chunk->sharedCount);
+    }
+    chunk->sharedCount = NULL;
+    return true;
+}
+
 Octree *_chunk_new_octree(void) {
     unsigned long upPow2Size = upper_power_of_two(CHUNK_SIZE);
     Block *defaultBlock = block_new_air();
@@ -2411,7 +2727,7 @@ void _chunk_good_bye_neighbor(Chunk *chunk, Neighbor location) {
 }
 
 void _vertex_light_get(Chunk *chunk,
-                       Block *block,
+                       const Block *block,
                        const ColorPalette *palette,
                        CHUNK_COORDS_INT3_T coords,
                        VERTEX_LIGHT_STRUCT_T *vlight,
@@ -2497,6 +2813,18 @@ void _vertex_light_smoothing(VERTEX_LIGHT_STRUCT_T *base,
 #endif /* GLOBAL_LIGHTING_SMOOTHING_ENABLED */
 }
 
+void _chunk_set_solid(Chunk *chunk,
+                      const CHUNK_COORDS_INT_T x,
+                      const CHUNK_COORDS_INT_T y,
+                      const CHUNK_COORDS_INT_T z,
+                      const bool solid) {
+    if (solid) {
+        chunk->solidRows[z * CHUNK_SIZE + y] |= (CHUNK_ROW_MASK_T)(1u << x);
+    } else {
+        chunk->solidRows[z * CHUNK_SIZE + y] &= (CHUNK_ROW_MASK_T) ~(1u << x);
+    }
+}
+
 bool _chunk_is_bounding_box_empty(const Chunk *chunk) {
     return chunk->bbMin.x == chunk->bbMax.x || chunk->bbMin.y == chunk->bbMax.y ||
            chunk->bbMin.z == chunk->bbMax.z;
@@ -2520,7 +2848,7 @@ void _chunk_update_bounding_box(Chunk *chunk,
     } else if (_chunk_is_bounding_box_empty(chunk) == false) {
         // for each BB side the removed block was in, check if that side can be moved in
         if (coords.x == chunk->bbMax.x - 1) {
-            Block *b;
+            const Block *b;
             bool isEmpty = true;
             for (CHUNK_COORDS_INT_T x = chunk->bbMax.x - 1; isEmpty && x >= chunk->bbMin.x; --x) {
                 for (CHUNK_COORDS_INT_T z = chunk->bbMin.z; z < chunk->bbMax.z; ++z) {
@@ -2543,7 +2871,7 @@ void _chunk_update_bounding_box(Chunk *chunk,
                 }
             }
         } else if (coords.x == chunk->bbMin.x) {
-            Block *b;
+            const Block *b;
             bool isEmpty = true;
             for (CHUNK_COORDS_INT_T x = chunk->bbMin.x; isEmpty && x < chunk->bbMax.x; ++x) {
                 for (CHUNK_COORDS_INT_T z = chunk->bbMin.z; z < chunk->bbMax.z; ++z) {
@@ -2567,7 +2895,7 @@ void _chunk_update_bounding_box(Chunk *chunk,
             }
         }
         if (coords.y == chunk->bbMax.y - 1) {
-            Block *b;
+            const Block *b;
             bool isEmpty = true;
             for (CHUNK_COORDS_INT_T y = chunk->bbMax.y - 1; isEmpty && y >= chunk->bbMin.y; --y) {
                 for (CHUNK_COORDS_INT_T z = chunk->bbMin.z; z < chunk->bbMax.z; ++z) {
@@ -2590,7 +2918,7 @@ void _chunk_update_bounding_box(Chunk *chunk,
                 }
             }
         } else if (coords.y == chunk->bbMin.y) {
-            Block *b;
+            const Block *b;
             bool isEmpty = true;
             for (CHUNK_COORDS_INT_T y = chunk->bbMin.y; isEmpty && y < chunk->bbMax.y; ++y) {
                 for (CHUNK_COORDS_INT_T z = chunk->bbMin.z; z < chunk->bbMax.z; ++z) {
@@ -2614,7 +2942,7 @@ void _chunk_update_bounding_box(Chunk *chunk,
             }
         }
         if (coords.z == chunk->bbMax.z - 1) {
-            Block *b;
+            const Block *b;
             bool isEmpty = true;
             for (CHUNK_COORDS_INT_T z = chunk->bbMax.z - 1; isEmpty && z >= chunk->bbMin.z; --z) {
                 for (CHUNK_COORDS_INT_T x = chunk->bbMin.x; x < chunk->bbMax.x; ++x) {
@@ -2637,7 +2965,7 @@ void _chunk_update_bounding_box(Chunk *chunk,
                 }
             }
         } else if (coords.z == chunk->bbMin.z) {
-            Block *b;
+            const Block *b;
             bool isEmpty = true;
             for (CHUNK_COORDS_INT_T z = chunk->bbMin.z; isEmpty && z < chunk->bbMax.z; ++z) {
                 for (CHUNK_COORDS_INT_T x = chunk->bbMin.x; x < chunk->bbMax.x; ++x) {
@@ -58,14 +58,18 @@ typedef enum {
 void chunk_alloc_default_light(void);
 
 Chunk *chunk_new(const SHAPE_COORDS_INT3_T origin);
-Chunk *chunk_new_copy(const Chunk *c);
+/// Copies share octree & lighting data with the original chunk, cloned on first modification.
+/// Sharing isn't thread-safe, chunks sharing data must be modified from the same thread.
+Chunk *chunk_new_copy(Chunk *c);
 void chunk_free(Chunk *chunk, bool updateNeighbors);
 void chunk_free_func(void *c);
 void chunk_set_dirty(Chunk *chunk, bool b);
 bool chunk_is_dirty(const Chunk *chunk);
 SHAPE_COORDS_INT3_T chunk_get_origin(const Chunk *chunk);
 int chunk_get_nb_blocks(const Chunk *chunk);
-Octree *chunk_get_octree(const Chunk *c);
+void chunk_set_stamp(Chunk *c, const uint32_t stamp);
+uint32_t chunk_get_stamp(const Chunk *c);
+const Octree *chunk_get_octree(const Chunk *c);
 void chunk_set_rtree_leaf(Chunk *c, void *ptr);
 void *chunk_get_rtree_leaf(const Chunk *c);
 uint64_t chunk_get_hash(const Chunk *c, uint64_t crc);
@@ -80,8 +84,9 @@ VERTEX_LIGHT_STRUCT_T chunk_get_light_or_default(Chunk *c,
                                                  bool isDefault);
 void chunk_clear_lighting_data(Chunk *c);
 void chunk_reset_lighting_data(Chunk *c, const bool emptyOrDefault);
+/// takes ownership of `data`, freed if it can't be set
 void chunk_set_lighting_data(Chunk *c, VERTEX_LIGHT_STRUCT_T *data);
-VERTEX_LIGHT_STRUCT_T *chunk_get_lighting_data(Chunk *c);
+const VERTEX_LIGHT_STRUCT_T *chunk_get_lighting_data(const Chunk *c);
 
 bool chunk_add_block(Chunk *chunk,
                      const Block block,
@@ -89,6 +94,26 @@ bool chunk_add_block(Chunk *chunk,
                      const CHUNK_COORDS_INT_T y,
                      const CHUNK_COORDS_INT_T z);
 
+/// Adds several blocks at once, `coords` being in-chunk indexes
+/// (x * CHUNK_SIZE_SQR + y * CHUNK_SIZE + z) matching `colors`. Positions already holding a block
+/// are skipped, bounding box is updated once. If provided, `colorsCount` (of size
+/// SHAPE_COLOR_INDEX_MAX_COUNT) is incremented for each added block.
+/// Returns the number of blocks added.
+uint32_t chunk_add_blocks(Chunk *chunk,
+                          const uint16_t *coords,
+                          const SHAPE_COLOR_INDEX_INT_T *colors,
+                          const uint32_t count,
+                          uint32_t *colorsCount);
+
+/// Replaces all blocks at once w/ `blocks`, CHUNK_SIZE_CUBE blocks indexed
+/// (z * CHUNK_SIZE + y) * CHUNK_SIZE + x, building the octree in one pass. If provided,
+/// `colorsCount` (of size SHAPE_COLOR_INDEX_MAX_COUNT) is incremented for each solid block.
+/// Returns the number of solid blocks, 0 if blocks shared w/ a copy can't be made unique.
+uint32_t chunk_set_blocks(Chunk *chunk, const Block *blocks, uint32_t *colorsCount);
+
+/// Read-only access to all blocks, same layout as in chunk_set_blocks
+const Block *chunk_get_blocks(const Chunk *chunk);
+
 bool chunk_remove_block(Chunk *chunk,
                         const CHUNK_COORDS_INT_T x,
                         const CHUNK_COORDS_INT_T y,
@@ -102,19 +127,32 @@ bool chunk_paint_block(Chunk *chunk,
                        const SHAPE_COLOR_INDEX_INT_T colorIndex,
                        SHAPE_COLOR_INDEX_INT_T *prevColorIndex);
 
-Block *chunk_get_block(const Chunk *chunk,
-                       const CHUNK_COORDS_INT_T x,
-                       const CHUNK_COORDS_INT_T y,
-                       const CHUNK_COORDS_INT_T z);
-
-Block *chunk_get_block_2(const Chunk *chunk, CHUNK_COORDS_INT3_T coords);
-
-Block *chunk_get_block_including_neighbors(Chunk *chunk,
-                                           const CHUNK_COORDS_INT_T x,
-                                           const CHUNK_COORDS_INT_T y,
-                                           const CHUNK_COORDS_INT_T z,
-                                           Chunk **out_chunk,
-                                           CHUNK_COORDS_INT3_T *out_coords);
+/// Solid blocks occupancy of the row (y, z), bit x is set if block (x, y, z) is solid
+CHUNK_ROW_MASK_T chunk_get_solid_row(const Chunk *chunk,
+                                     const CHUNK_COORDS_INT_T y,
+                                     const CHUNK_COORDS_INT_T z);
+
+/// Looks for a solid block within [min, max] (inclusive, in chunk coordinates), testing whole
+/// rows at once. If found, `coords` is filled w/ the first one in z, y, x order.
+bool chunk_get_first_solid_block_in_range(const Chunk *chunk,
+                                          const CHUNK_COORDS_INT3_T min,
+                                          const CHUNK_COORDS_INT3_T max,
+                                          CHUNK_COORDS_INT3_T *coords);
+
+/// Blocks may be shared w/ copies of this chunk, they are modified through chunk functions only
+const Block *chunk_get_block(const Chunk *chunk,
+                             const CHUNK_COORDS_INT_T x,
+                             const CHUNK_COORDS_INT_T y,
+                             const CHUNK_COORDS_INT_T z);
+
+const Block *chunk_get_block_2(const Chunk *chunk, CHUNK_COORDS_INT3_T coords);
+
+const Block *chunk_get_block_including_neighbors(Chunk *chunk,
+                                                 const CHUNK_COORDS_INT_T x,
+                                                 const CHUNK_COORDS_INT_T y,
+                                                 const CHUNK_COORDS_INT_T z,
+                                                 Chunk **out_chunk,
+                                                 CHUNK_COORDS_INT3_T *out_coords);
 
 SHAPE_COORDS_INT3_T chunk_get_block_coords_in_shape(const Chunk *chunk,
                                                     const CHUNK_COORDS_INT_T x,
@@ -122,6 +160,15 @@ SHAPE_COORDS_INT3_T chunk_get_block_coords_in_shape(const Chunk *chunk,
                                                     const CHUNK_COORDS_INT_T z);
 SHAPE_COORDS_INT3_T chunk_utils_get_coords(const SHAPE_COORDS_INT3_T coords_in_shape);
 CHUNK_COORDS_INT3_T chunk_utils_get_coords_in_chunk(const SHAPE_COORDS_INT3_T coords_in_shape);
+/// Row mask w/ bits [min, max] set
+CHUNK_ROW_MASK_T chunk_utils_get_row_mask(const CHUNK_COORDS_INT_T min,
+                                          const CHUNK_COORDS_INT_T max);
+
+/// Downsamples chunk blocks into cells of 2^level blocks per axis, each cell taking the most used
+/// color of its blocks. A cell is solid if any of its blocks is, so that thin walls don't get holes.
+/// `colors` receives (CHUNK_SIZE >> level)^3 cells, ordered like in-chunk indexes for that size,
+/// air cells being SHAPE_COLOR_INDEX_AIR_BLOCK. Returns the number of solid cells.
+uint32_t chunk_downsample(const Chunk *chunk, const uint8_t level, SHAPE_COLOR_INDEX_INT_T *colors);
 
 void chunk_get_bounding_box(const Chunk *chunk, float3 *min, float3 *max);
 void chunk_get_bounding_box_2(const Chunk *chunk,
@@ -140,6 +187,19 @@ void *chunk_get_vbma(const Chunk *chunk, bool transparent);
 void chunk_set_vbma(Chunk *chunk, void *vbma, bool transparent);
 void chunk_write_vertices(Shape *shape, Chunk *chunk);
 
+/// Writes already computed vertex attributes (e.g. from a mesh cache) instead of generating them
+/// from blocks, counts are in vertices and must be multiples of DRAWBUFFER_VERTICES_PER_FACE
+void chunk_write_cached_vertices(Shape *shape,
+                                 Chunk *chunk,
+                                 const void *opaque,
+                                 uint32_t opaqueCount,
+                                 const void *transparent,
+                                 uint32_t transparentCount);
+
+/// Copies chunk vertex attributes (as VertexAttributes, whatever the vertex buffer format) into out
+/// if not NULL, returns number of vertices
+uint32_t chunk_read_vertices(const Chunk *chunk, bool transparent, void *out);
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
@@ -14,30 +14,37 @@
 #include <stdlib.h>
 #include <string.h>
 
-void _color_atlas_add_index_to_dirty_slice(ColorAtlas *a, ATLAS_COLOR_INDEX_INT_T index) {
-    if (a->dirty_slice_min != ATLAS_COLOR_INDEX_ERROR &&
-        a->dirty_slice_max != ATLAS_COLOR_INDEX_ERROR) {
-        a->dirty_slice_min = minimum(a->dirty_slice_min, index);
-        a->dirty_slice_max = maximum(a->dirty_slice_max, index);
-    } else {
-        a->dirty_slice_min = a->dirty_slice_max = index;
-    }
-}
+// MARK: - Private functions prototypes -
+
+static bool _color_atlas_reserve(ColorAtlas *a, ATLAS_COLOR_INDEX_INT_T index);
+static void _color_atlas_add_index_to_dirty_slice(ColorAtlas *a, ATLAS_COLOR_INDEX_INT_T index);
+static void _color_atlas_remove_dirty_slice(ColorAtlas *a, uint8_t i);
+static void _color_atlas_update_dirty_bounds(ColorAtlas *a);
+
+// MARK: - Public functions -
 
 ColorAtlas *color_atlas_new(void) {
     ColorAtlas *color_atlas = (ColorAtlas *)malloc(sizeof(ColorAtlas));
 
     color_atlas->wptr = NULL;
-    color_atlas->availableIndices = fifo_list_new();
+    color_atlas->availableIndices = NULL;
+    color_atlas->availableMask = NULL;
+    color_atlas->nbAvailableIndices = 0;
+    color_atlas->availableIndicesCapacity = 0;
     color_atlas->count = 0;
     color_atlas->size = COLOR_ATLAS_SIZE;
+    color_atlas->nbDirtySlices = 0;
     color_atlas->dirty_slice_min = ATLAS_COLOR_INDEX_ERROR;
     color_atlas->dirty_slice_max = ATLAS_COLOR_INDEX_ERROR;
 
-    // color + complementary : half as many unique colors
-    const uint32_t nbColors = color_atlas->size * color_atlas->size / 2;
-    color_atlas->colors = (RGBAColor *)malloc(sizeof(RGBAColor) * nbColors);
-    color_atlas->complementaryColors = (RGBAColor *)malloc(sizeof(RGBAColor) * nbColors);
+    // color + complementary : half as many unique colors, allocated as they are used
+    color_atlas->capacity = minimum(COLOR_ATLAS_INITIAL_CAPACITY,
+                                    color_atlas->size * color_atlas->size / 2);
+    color_atlas->colors = (RGBAColor *)malloc(sizeof(RGBAColor) * color_atlas->capacity);
+    color_atlas->complementaryColors = (RGBAColor *)malloc(sizeof(RGBAColor) *
+                                                           color_atlas->capacity);
+    color_atlas->availableMask = (uint32_t *)calloc((color_atlas->capacity + 31) / 32,
+                                                    sizeof(uint32_t));
 
     return color_atlas;
 }
@@ -47,7 +54,8 @@ void color_atlas_free(ColorAtlas *a) {
         weakptr_invalidate(a->wptr);
         free(a->colors);
         free(a->complementaryColors);
-        fifo_list_free(a->availableIndices, free);
+        free(a->availableIndices);
+        free(a->availableMask);
     }
     free(a);
 }
@@ -73,12 +81,13 @@ Weakptr *color_atlas_get_and_retain_weakptr(ColorAtlas *a) {
 ATLAS_COLOR_INDEX_INT_T color_atlas_check_and_add_color(ColorAtlas *a, RGBAColor color) {
     // get an available index below count, or expand
     ATLAS_COLOR_INDEX_INT_T index;
-    void *pop = fifo_list_pop(a->availableIndices);
-    if (pop != NULL) {
-        index = *((ATLAS_COLOR_INDEX_INT_T *)pop);
-        free(pop);
+    if (a->nbAvailableIndices > 0) {
+        index = a->availableIndices[--a->nbAvailableIndices];
+        a->availableMask[index / 32] &= ~(1u << (index % 32));
     } else if (a->count >= ATLAS_COLOR_INDEX_MAX_COUNT) {
         return ATLAS_COLOR_INDEX_ERROR; // atlas at max capacity
+    } else if (_color_atlas_reserve(a, a->count) == false) {
+        return ATLAS_COLOR_INDEX_ERROR;
     } else {
         index = a->count++;
     }
@@ -98,15 +107,30 @@ ATLAS_COLOR_INDEX_INT_T color_atlas_check_and_add_color(ColorAtlas *a, RGBAColor
 }
 
 void color_atlas_remove_color(ColorAtlas *a, ATLAS_COLOR_INDEX_INT_T index) {
-    if (index >= ATLAS_COLOR_INDEX_MAX_COUNT) {
+    if (index >= a->count) {
+        return;
+    }
+    if ((a->availableMask[index / 32] & (1u << (index % 32))) != 0) {
+        cclog_error("color atlas: color %u already removed", index);
         return;
     }
 
-    // index becomes available
-    ATLAS_COLOR_INDEX_INT_T *push = (ATLAS_COLOR_INDEX_INT_T *)malloc(
-        sizeof(ATLAS_COLOR_INDEX_INT_T));
-    *push = index;
-    fifo_list_push(a->availableIndices, push);
+    // index becomes available, there can't be more available indices than count
+    if (a->nbAvailableIndices == a->availableIndicesCapacity) {
+        const uint32_t capacity = minimum(maximum(a->availableIndicesCapacity * 2,
+                                                  COLOR_ATLAS_INITIAL_CAPACITY),
+                                          a->capacity);
+        ATLAS_COLOR_INDEX_INT_T *indices = (ATLAS_COLOR_INDEX_INT_T *)
+            realloc(a->availableIndices, sizeof(ATLAS_COLOR_INDEX_INT_T) * capacity);
+        if (indices == NULL) {
+            cclog_error("color atlas: can't allocate available indices");
+            return;
+        }
+        a->availableIndices = indices;
+        a->availableIndicesCapacity = capacity;
+    }
+    a->availableIndices[a->nbAvailableIndices++] = index;
+    a->availableMask[index / 32] |= 1u << (index % 32);
 
     // note: removed color do not need to be set dirty, it simply becomes available and won't be
     // used in the meantime
@@ -131,7 +155,7 @@ void color_atlas_remove_palette(ColorAtlas *a, const ColorPalette *p) {
 }
 
 void color_atlas_set_color(ColorAtlas *a, ATLAS_COLOR_INDEX_INT_T index, RGBAColor color) {
-    if (index >= ATLAS_COLOR_INDEX_MAX_COUNT || colors_are_equal(&(a->colors[index]), &color)) {
+    if (index >= a->count || colors_are_equal(&(a->colors[index]), &color)) {
         return;
     }
 
@@ -147,7 +171,7 @@ void color_atlas_set_color(ColorAtlas *a, ATLAS_COLOR_INDEX_INT_T index, RGBACol
 }
 
 RGBAColor *color_atlas_get_color(const ColorAtlas *a, ATLAS_COLOR_INDEX_INT_T index) {
-    if (index >= ATLAS_COLOR_INDEX_MAX_COUNT) {
+    if (index >= a->count) {
         return NULL;
     }
     return &(a->colors[index]);
@@ -155,15 +179,134 @@ RGBAColor *color_atlas_get_color(const ColorAtlas *a, ATLAS_COLOR_INDEX_INT_T in
 
 void color_atlas_force_dirty_slice(ColorAtlas *a) {
     if (a->count > 0) {
-        a->dirty_slice_min = 0;
-        a->dirty_slice_max = a->count - 1;
+        a->dirtySlices[0].min = 0;
+        a->dirtySlices[0].max = a->count - 1;
+        a->nbDirtySlices = 1;
     } else {
-        a->dirty_slice_min = ATLAS_COLOR_INDEX_ERROR;
-        a->dirty_slice_max = ATLAS_COLOR_INDEX_ERROR;
+        a->nbDirtySlices = 0;
     }
+    _color_atlas_update_dirty_bounds(a);
 }
 
 void color_atlas_flush_slice(ColorAtlas *a) {
-    a->dirty_slice_min = ATLAS_COLOR_INDEX_ERROR;
-    a->dirty_slice_max = ATLAS_COLOR_INDEX_ERROR;
+    a->nbDirtySlices = 0;
+    _color_atlas_update_dirty_bounds(a);
+}
+
+// MARK: - Private functions -
+
+/// Grows color arrays so that they can hold given index
+static bool _color_atlas_reserve(ColorAtlas *a, ATLAS_COLOR_INDEX_INT_T index) {
+    if (index < a->capacity) {
+        return true;
+    }
+
+    uint32_t capacity = a->capacity;
+    while (capacity <= index) {
+        capacity *= 2;
+    }
+    capacity = minimum(capacity, a->size * a->size / 2);
+
+    RGBAColor *colors = (RGBAColor *)realloc(a->colors, sizeof(RGBAColor) * capacity);
+    if (colors == NULL) {
+        cclog_error("color atlas: can't grow to %u colors", capacity);
+        return false;
+    }
+    a->colors = colors;
+
+    colors = (RGBAColor *)realloc(a->complementaryColors, sizeof(RGBAColor) * capacity);
+    if (colors == NULL) {
+        cclog_error("color atlas: can't grow to %u colors", capacity);
+        return false;
+    }
+    a->complementaryColors = colors;
+
+    const uint32_t words = (a->capacity + 31) / 32, newWords = (capacity + 31) / 32;
+    uint32_t *mask = (uint32_t *)realloc(a->availableMask, sizeof(uint32_t) * newWords);
+    if (mask == NULL) {
+        cclog_error("color atlas: can't grow to %u colors", capacity);
+        return false;
+    }
+    memset(mask + words, 0, sizeof(uint32_t) * (newWords - words));
+    a->availableMask = mask;
+
+    a->capacity = capacity;
+    return true;
+}
+
+static void _color_atlas_add_index_to_dirty_slice(ColorAtlas *a, ATLAS_COLOR_INDEX_INT_T index) {
+    // first slice that the index belongs to, touches, or precedes
+    uint8_t i = 0;
+    while (i < a->nbDirtySlices && a->dirtySlices[i].max + 1 < index) {
+        ++i;
+    }
+
+    if (i < a->nbDirtySlices && a->dirtySlices[i].min <= index + 1) {
+        a->dirtySlices[i].min = minimum(a->dirtySlices[i].min, index);
+        a->dirtySlices[i].max = maximum(a->dirtySlices[i].max, index);
+
+        // extended slice may now touch the next one
+        if (i + 1 < a->nbDirtySlices &&
+            a->dirtySlices[i + 1].min <= a->dirtySlices[i].max + 1) {
+            a->dirtySlices[i].max = a->dirtySlices[i + 1].max;
+            _color_atlas_remove_dirty_slice(a, i + 1);
+        }
+    } else if (a->nbDirtySlices < COLOR_ATLAS_MAX_DIRTY_SLICES) {
+        for (uint8_t j = a->nbDirtySlices; j > i; --j) {
+            a->dirtySlices[j] = a->dirtySlices[j - 1];
+        }
+        a->dirtySlices[i].min = a->dirtySlices[i].max = index;
+        ++a->nbDirtySlices;
+    } else {
+        // no slice left: either extend the closest slice to the index, or merge the two closest
+        // slices to make room, whichever uploads the fewest clean colors
+        uint32_t gap = UINT32_MAX;
+        uint8_t closest = 0;
+        if (i > 0) {
+            gap = index - a->dirtySlices[i - 1].max;
+            closest = i - 1;
+        }
+        if (i < a->nbDirtySlices && a->dirtySlices[i].min - index < gap) {
+            gap = a->dirtySlices[i].min - index;
+            closest = i;
+        }
+
+        uint32_t mergeGap = UINT32_MAX;
+        uint8_t merge = 0;
+        for (uint8_t j = 0; j + 1 < a->nbDirtySlices; ++j) {
+            if (a->dirtySlices[j + 1].min - a->dirtySlices[j].max < mergeGap) {
+                mergeGap = a->dirtySlices[j + 1].min - a->dirtySlices[j].max;
+                merge = j;
+            }
+        }
+
+        if (gap <= mergeGap) {
+            a->dirtySlices[closest].min = minimum(a->dirtySlices[closest].min, index);
+            a->dirtySlices[closest].max = maximum(a->dirtySlices[closest].max, index);
+        } else {
+            a->dirtySlices[merge].max = a->dirtySlices[merge + 1].max;
+            _color_atlas_remove_dirty_slice(a, merge + 1);
+            _color_atlas_add_index_to_dirty_slice(a, index);
+            return;
+        }
+    }
+
+    _color_atlas_update_dirty_bounds(a);
+}
+
+static void _color_atlas_remove_dirty_slice(ColorAtlas *a, uint8_t i) {
+    --a->nbDirtySlices;
+    for (uint8_t j = i; j < a->nbDirtySlices; ++j) {
+        a->dirtySlices[j] = a->dirtySlices[j + 1];
+    }
+}
+
+static void _color_atlas_update_dirty_bounds(ColorAtlas *a) {
+    if (a->nbDirtySlices > 0) {
+        a->dirty_slice_min = a->dirtySlices[0].min;
+        a->dirty_slice_max = a->dirtySlices[a->nbDirtySlices - 1].max;
+    } else {
+        a->dirty_slice_min = ATLAS_COLOR_INDEX_ERROR;
+        a->dirty_slice_max = ATLAS_COLOR_INDEX_ERROR;
+    }
 }
@@ -14,7 +14,6 @@ extern "C" {
 #include <stdint.h>
 
 #include "colors.h"
-#include "fifo_list.h"
 #include "float3.h"
 #include "hash_uint32_int.h"
 #include "weakptr.h"
@@ -32,13 +31,26 @@ typedef struct ColorPalette ColorPalette;
 /// - odd row numbers contain complementary colors
 ///
 /// The maximum number of colors is therefore: atlas size * atlas size / 2
+///
+/// C-side arrays only cover `capacity` colors, doubled when needed.
 typedef struct ColorAtlas {
     Weakptr *wptr;
     RGBAColor *colors;
     RGBAColor *complementaryColors;
-    FifoList *availableIndices; // pool of available indices below count
+    ATLAS_COLOR_INDEX_INT_T *availableIndices; // stack of available indices below count
+    uint32_t *availableMask;                   // bit set for each index in the stack
+    uint32_t nbAvailableIndices;
+    uint32_t availableIndicesCapacity;
     uint32_t count;
-    uint32_t size; // atlas dimension
+    uint32_t capacity; // allocated colors
+    uint32_t size;     // atlas dimension
+    // sorted, disjoint and non-adjacent ranges of indices to upload renderer-side, the renderer
+    // doesn't use them yet and uploads all colors within the bounds below
+    struct {
+        ATLAS_COLOR_INDEX_INT_T min, max;
+    } dirtySlices[COLOR_ATLAS_MAX_DIRTY_SLICES];
+    uint8_t nbDirtySlices;
+    // bounds of all dirty slices, ATLAS_COLOR_INDEX_ERROR if none
     ATLAS_COLOR_INDEX_INT_T dirty_slice_min, dirty_slice_max;
 } ColorAtlas;
 
@@ -101,9 +101,7 @@ ColorPalette *color_palette_new_from_data(ColorAtlas *atlas,
         p->entries[i].blocksCount = 0;
         p->entries[i].atlasIndex = ATLAS_COLOR_INDEX_ERROR;
         p->entries[i].orderedIndex = i;
-        if (emissive != NULL) {
-            p->entries[i].emissive = emissive[i];
-        }
+        p->entries[i].emissive = emissive != NULL ? emissive[i] : false;
         hash_uint32_int_set(p->colorToIdx, color_to_uint32(&(colors[i])), i);
     }
     for (SHAPE_COLOR_INDEX_INT_T i = count; i < SHAPE_COLOR_INDEX_MAX_COUNT; ++i) {
@@ -111,9 +109,7 @@ ColorPalette *color_palette_new_from_data(ColorAtlas *atlas,
         p->entries[i].blocksCount = 0;
         p->entries[i].atlasIndex = ATLAS_COLOR_INDEX_ERROR;
         p->entries[i].orderedIndex = i;
-        if (emissive != NULL) {
-            p->entries[i].emissive = false;
-        }
+        p->entries[i].emissive = false;
     }
 
     return p;
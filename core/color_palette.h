@@ -15,6 +15,7 @@ extern "C" {
 #include "color_atlas.h"
 #include "colors.h"
 #include "config.h"
+#include "fifo_list.h"
 #include "weakptr.h"
 
 #define DEBUG_PALETTE_RUN_TESTS false
@@ -33,7 +33,9 @@ extern "C" {
 #define MAX_TICK_DELTA_MS 50.0
 #define TICK_DELTA_MS_T double
 #define TICK_DELTA_SEC_T double
-#define NB_UNDOABLE_ACTIONS 20
+#define HISTORY_DEFAULT_BYTE_BUDGET 4194304 // 4MB of packed transactions
+#define HISTORY_MAX_ENTRIES 1024 // whatever their size, small transactions still cost a node each
+#define TRANSACTION_REGION_DENSE_MAX_VOLUME 4096 // bigger regions store their colors as runs
 #define BLENDING_ALPHA 0
 #define BLENDING_ADDITIVE 1
 
@@ -181,6 +183,13 @@ extern unsigned long upper_power_of_two(unsigned long v);
 /// Number of frames during which an awaken rigidbody will skip sleep conditions, max 255 (uint8)
 #define PHYSICS_AWAKE_FRAMES 6
 #define PHYSICS_AWAKE_DISTANCE EPSILON_COLLISION * 2
+/// Per-block collisions of dynamic rigidbodies reuse the solid blocks gathered around their
+/// trajectory, extended by this margin (in blocks), until they move out of it or blocks change
+#define PHYSICS_CONTACT_CACHE_MARGIN 1.0f
+/// Max number of blocks per cached region, denser regions aren't cached
+#define PHYSICS_CONTACT_CACHE_MAX_BLOCKS 128
+/// Number of per-block shapes cached for each dynamic rigidbody
+#define PHYSICS_CONTACT_CACHE_SHAPES 2
 /// Should dynamic rigidbodies' collider be squarified?
 #define PHYSICS_SQUARIFY_DYNAMIC_COLLIDER false
 
@@ -244,6 +253,8 @@ typedef int8_t CHUNK_COORDS_INT_T;
 typedef struct {
     CHUNK_COORDS_INT_T x, y, z;
 } CHUNK_COORDS_INT3_T;
+// one bit per block along a chunk row, must hold CHUNK_SIZE bits
+typedef uint16_t CHUNK_ROW_MASK_T;
 
 typedef uint8_t SHAPE_COLOR_INDEX_INT_T;
 typedef uint32_t ATLAS_COLOR_INDEX_INT_T;
@@ -258,6 +269,10 @@ typedef uint32_t ATLAS_COLOR_INDEX_INT_T;
 #define COLOR_ATLAS_SIZE 512
 #define ATLAS_COLOR_INDEX_MAX_COUNT 131071 // 131072 - 1 for error color
 #define ATLAS_COLOR_INDEX_ERROR ATLAS_COLOR_INDEX_MAX_COUNT
+// Number of colors allocated C-side when a color atlas is created, then doubled as needed
+#define COLOR_ATLAS_INITIAL_CAPACITY 256
+// Disjoint dirty slices tracked by a color atlas, closest slices are merged beyond that
+#define COLOR_ATLAS_MAX_DIRTY_SLICES 8
 
 typedef uint8_t FACE_INDEX_INT_T;
 
@@ -328,6 +343,34 @@ static const FACE_INDEX_INT_T FACE_NONE = 7;
 // Subsequent buffers on init/runtime can be downscaled or upscaled, see shape_add_buffer
 #define SHAPE_BUFFER_INIT_SCALE_RATE .75f
 #define SHAPE_BUFFER_RUNTIME_SCALE_RATE 4.0f
+// Vertices moved to fill buffer gaps per shape refresh (0: no limit), gaps left are filled over
+// the next refreshes, see vertex_buffer_fill_gaps_incremental
+#define SHAPE_BUFFER_COMPACTION_BUDGET 16384
+
+// Maximum number of full chunks merged along each axis into a single occluder, see
+// shape_query_visible_chunks
+#define SHAPE_OCCLUDER_MAX_CHUNKS 4
+
+// Number of last removed chunks a shape keeps track of, older removals invalidate any region,
+// see shape_blocks_changed_in_box
+#define SHAPE_REMOVED_CHUNKS_HISTORY 4
+
+// Box casts longer than this distance, in blocks, advance through empty space by steps as large
+// as the distance to the nearest solid block, see shape_box_cast
+#define SHAPE_CAST_ADVANCEMENT_DISTANCE 16.0f
+// Max distance to the nearest solid block looked up at each advancement step, in blocks
+#define SHAPE_CAST_MAX_FREE_DISTANCE 16.0f
+// Distance swept against blocks at once when they are within 1 block of the cast box, in blocks
+#define SHAPE_CAST_SEGMENT_DISTANCE 4.0f
+// Same w/ replacement, which ignores blocks passed through entirely within a segment, in blocks
+#define SHAPE_CAST_REPLACEMENT_SEGMENT_DISTANCE 1.0f
+
+// Number of coarser levels a shape can be downsampled to, each dividing resolution by 2, see
+// shape_get_lod
+#define SHAPE_LOD_MAX_LEVEL 3
+// Distance, in blocks, from which shape_get_lod_level_for_distance starts picking level 1. Next
+// levels are picked at every doubled distance
+#define SHAPE_LOD_DISTANCE 256.0f
 
 //// Disabling global lighting will use neutral value (15, 0, 0, 0) everywhere
 #define GLOBAL_LIGHTING_ENABLED true
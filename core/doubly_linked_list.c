@@ -8,24 +8,43 @@
 
 // C
 #include <assert.h>
+#include <stdint.h>
 #include <stdlib.h>
 
 #include "cclog.h"
 
+// Nodes allocated at once on first insertion, enough for most lists without extra allocations
+#define DOUBLY_LINKED_LIST_BLOCK_NODES 4
+// Other removed nodes kept for reuse, the ones beyond are released
+#define DOUBLY_LINKED_LIST_RECYCLED_NODES_MAX 8
+
 struct _DoublyLinkedListNode {
     DoublyLinkedListNode *previous; // toward first
     DoublyLinkedListNode *next;     // toward last
     void *ptr;                      // stored pointer
 };
 
+// private prototypes
+
+static DoublyLinkedListNode *_doubly_linked_list_take_node(DoublyLinkedList *list, void *ptr);
+static void _doubly_linked_list_recycle_node(DoublyLinkedList *list, DoublyLinkedListNode *node);
+static bool _doubly_linked_list_node_is_in_block(const DoublyLinkedList *list,
+                                                 const DoublyLinkedListNode *node);
+
 //---------------------
 // DoublyLinkedList
 //---------------------
 
 DoublyLinkedList *doubly_linked_list_new(void) {
     DoublyLinkedList *list = (DoublyLinkedList *)malloc(sizeof(DoublyLinkedList));
+    if (list == NULL) {
+        return NULL;
+    }
     list->first = NULL;
     list->last = NULL;
+    list->recycled = NULL;
+    list->block = NULL;
+    list->nbRecycled = 0;
     return list;
 }
 
@@ -68,11 +87,20 @@ void doubly_linked_list_free(DoublyLinkedList *const list) {
     while (list->last != NULL) {
         doubly_linked_list_pop_last(list);
     }
+    DoublyLinkedListNode *node;
+    while (list->recycled != NULL) {
+        node = list->recycled;
+        list->recycled = node->next;
+        if (_doubly_linked_list_node_is_in_block(list, node) == false) {
+            free(node);
+        }
+    }
+    free(list->block);
     free(list);
 }
 
 DoublyLinkedListNode *doubly_linked_list_push_last(DoublyLinkedList *const list, void *const ptr) {
-    DoublyLinkedListNode *newNode = doubly_linked_list_node_new(ptr);
+    DoublyLinkedListNode *newNode = _doubly_linked_list_take_node(list, ptr);
     if (newNode == NULL) {
         return NULL;
     }
@@ -92,7 +120,7 @@ DoublyLinkedListNode *doubly_linked_list_push_last(DoublyLinkedList *const list,
 }
 
 DoublyLinkedListNode *doubly_linked_list_push_first(DoublyLinkedList *const list, void *const ptr) {
-    DoublyLinkedListNode *newNode = doubly_linked_list_node_new(ptr);
+    DoublyLinkedListNode *newNode = _doubly_linked_list_take_node(list, ptr);
     if (newNode == NULL) {
         return NULL;
     }
@@ -128,7 +156,7 @@ void *doubly_linked_list_pop_last(DoublyLinkedList *list) {
         list->first = NULL;
     }
 
-    doubly_linked_list_node_free(node);
+    _doubly_linked_list_recycle_node(list, node);
 
     return ptr;
 }
@@ -150,7 +178,7 @@ void *doubly_linked_list_pop_first(DoublyLinkedList *list) {
         list->last = NULL;
     }
 
-    doubly_linked_list_node_free(node);
+    _doubly_linked_list_recycle_node(list, node);
 
     return ptr;
 }
@@ -202,7 +230,7 @@ DoublyLinkedListNode *doubly_linked_list_delete_node(DoublyLinkedList *const lis
         }
     }
 
-    doubly_linked_list_node_free(node);
+    _doubly_linked_list_recycle_node(list, node);
 
     return result;
 }
@@ -211,7 +239,7 @@ DoublyLinkedListNode *doubly_linked_list_insert_node_previous(DoublyLinkedList *
                                                               DoublyLinkedListNode *node,
                                                               void *ptr) {
 
-    DoublyLinkedListNode *newNode = doubly_linked_list_node_new(ptr);
+    DoublyLinkedListNode *newNode = _doubly_linked_list_take_node(list, ptr);
 
     if (node->previous != NULL) {
         node->previous->next = newNode;
@@ -229,7 +257,7 @@ DoublyLinkedListNode *doubly_linked_list_insert_node_next(DoublyLinkedList *list
                                                           DoublyLinkedListNode *node,
                                                           void *ptr) {
 
-    DoublyLinkedListNode *newNode = doubly_linked_list_node_new(ptr);
+    DoublyLinkedListNode *newNode = _doubly_linked_list_take_node(list, ptr);
 
     if (node->next != NULL) {
         node->next->previous = newNode;
@@ -363,6 +391,53 @@ void doubly_linked_list_print(const DoublyLinkedList *const list) {
     cclog_debug("------------");
 }
 
+static DoublyLinkedListNode *_doubly_linked_list_take_node(DoublyLinkedList *list, void *ptr) {
+    if (list->recycled == NULL && list->block == NULL) {
+        list->block = (DoublyLinkedListNode *)malloc(sizeof(DoublyLinkedListNode) *
+                                                     DOUBLY_LINKED_LIST_BLOCK_NODES);
+        if (list->block != NULL) {
+            for (int i = 0; i < DOUBLY_LINKED_LIST_BLOCK_NODES - 1; ++i) {
+                list->block[i].next = &list->block[i + 1];
+            }
+            list->block[DOUBLY_LINKED_LIST_BLOCK_NODES - 1].next = NULL;
+            list->recycled = list->block;
+        }
+    }
+    DoublyLinkedListNode *node = list->recycled;
+    if (node == NULL) {
+        return doubly_linked_list_node_new(ptr);
+    }
+    list->recycled = node->next;
+    if (_doubly_linked_list_node_is_in_block(list, node) == false) {
+        list->nbRecycled--;
+    }
+    node->previous = NULL;
+    node->next = NULL;
+    node->ptr = ptr;
+    return node;
+}
+
+// node must already be unlinked from the list
+static void _doubly_linked_list_recycle_node(DoublyLinkedList *list, DoublyLinkedListNode *node) {
+    if (_doubly_linked_list_node_is_in_block(list, node) == false) {
+        if (list->nbRecycled >= DOUBLY_LINKED_LIST_RECYCLED_NODES_MAX) {
+            free(node);
+            return;
+        }
+        list->nbRecycled++;
+    }
+    node->previous = NULL;
+    node->next = list->recycled;
+    list->recycled = node;
+}
+
+static bool _doubly_linked_list_node_is_in_block(const DoublyLinkedList *list,
+                                                 const DoublyLinkedListNode *node) {
+    const uintptr_t address = (uintptr_t)node;
+    return list->block != NULL && address >= (uintptr_t)list->block &&
+           address < (uintptr_t)(list->block + DOUBLY_LINKED_LIST_BLOCK_NODES);
+}
+
 //---------------------
 // DoublyLinkedNode
 //---------------------
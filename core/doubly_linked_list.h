@@ -13,6 +13,7 @@ extern "C" {
 #include "function_pointers.h"
 
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdlib.h>
 
 // types
@@ -21,6 +22,12 @@ typedef struct _DoublyLinkedListNode DoublyLinkedListNode;
 typedef struct {
     DoublyLinkedListNode *first;
     DoublyLinkedListNode *last;
+    // removed nodes available for reuse
+    DoublyLinkedListNode *recycled;
+    // lazily allocated first nodes, released w/ the list
+    DoublyLinkedListNode *block;
+    uint32_t nbRecycled;
+    char pad[4];
 } DoublyLinkedList;
 
 //--------------------
@@ -28,6 +35,8 @@ typedef struct {
 //--------------------
 
 // constructor
+// Note: first nodes are allocated at once on first insertion, removed ones are kept for reuse by
+// later insertions, up to 8 more than those
 DoublyLinkedList *doubly_linked_list_new(void);
 
 // copy
@@ -6,9 +6,15 @@
 
 #include "fifo_list.h"
 
+#include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 
+// Nodes allocated at once on first push, enough for most queues without extra allocations
+#define FIFO_LIST_BLOCK_NODES 4
+// Other popped nodes kept for reuse by default, the ones beyond are released
+#define FIFO_LIST_RECYCLED_NODES_MAX 8
+
 struct _FifoListNode {
     FifoListNode *next;
     // stored pointer
@@ -18,13 +24,20 @@ struct _FifoListNode {
 struct _FifoList {
     FifoListNode *first;
     FifoListNode *last;
+    FifoListNode *recycled; // popped nodes available for reuse
+    FifoListNode *block;    // lazily allocated first nodes, released w/ the list
     uint32_t size;
+    uint32_t nbRecycled;
+    uint32_t recycledMax;
+    char pad[4];
 };
 
 // private prototypes
 
-FifoListNode *fifo_list_node_new(void *ptr);
-void fifo_list_node_free(FifoListNode *node);
+FifoListNode *fifo_list_node_new(FifoList *list, void *ptr);
+void fifo_list_node_free(FifoList *list, FifoListNode *node);
+static void _fifo_list_trim_recycled(FifoList *list);
+static bool _fifo_list_node_is_in_block(const FifoList *list, const FifoListNode *node);
 
 //---------------------
 // FifoList
@@ -37,7 +50,11 @@ FifoList *fifo_list_new(void) {
     }
     list->first = NULL;
     list->last = NULL;
+    list->recycled = NULL;
+    list->block = NULL;
     list->size = 0;
+    list->nbRecycled = 0;
+    list->recycledMax = FIFO_LIST_RECYCLED_NODES_MAX;
     return list;
 }
 
@@ -58,11 +75,14 @@ void fifo_list_free(FifoList *list, pointer_free_function freeFunc) {
             freeFunc(storedPtr);
         }
     }
+    list->recycledMax = 0;
+    _fifo_list_trim_recycled(list);
+    free(list->block);
     free(list);
 }
 
 void fifo_list_push(FifoList *list, void *ptr) {
-    FifoListNode *newNode = fifo_list_node_new(ptr);
+    FifoListNode *newNode = fifo_list_node_new(list, ptr);
     if (list->first == NULL) {
         list->first = newNode;
         list->last = newNode;
@@ -87,7 +107,7 @@ void *fifo_list_pop(FifoList *list) {
         list->last = NULL;
     }
 
-    fifo_list_node_free(node);
+    fifo_list_node_free(list, node);
     list->size--;
     return ptr;
 }
@@ -107,18 +127,67 @@ void fifo_list_flush(FifoList *list, pointer_free_function freeFunc) {
 // FifoListNode
 //---------------------
 
-FifoListNode *fifo_list_node_new(void *ptr) {
-    FifoListNode *node = (FifoListNode *)malloc(sizeof(FifoListNode));
-    if (node == NULL) {
-        return NULL;
+FifoListNode *fifo_list_node_new(FifoList *list, void *ptr) {
+    if (list->recycled == NULL && list->block == NULL) {
+        list->block = (FifoListNode *)malloc(sizeof(FifoListNode) * FIFO_LIST_BLOCK_NODES);
+        if (list->block != NULL) {
+            for (int i = 0; i < FIFO_LIST_BLOCK_NODES - 1; ++i) {
+                list->block[i].next = &list->block[i + 1];
+            }
+            list->block[FIFO_LIST_BLOCK_NODES - 1].next = NULL;
+            list->recycled = list->block;
+        }
+    }
+    FifoListNode *node = list->recycled;
+    if (node != NULL) {
+        list->recycled = node->next;
+        if (_fifo_list_node_is_in_block(list, node) == false) {
+            list->nbRecycled--;
+        }
+    } else {
+        node = (FifoListNode *)malloc(sizeof(FifoListNode));
+        if (node == NULL) {
+            return NULL;
+        }
     }
     node->next = NULL;
     node->ptr = ptr;
     return node;
 }
 
-void fifo_list_node_free(FifoListNode *node) {
-    free(node);
+void fifo_list_node_free(FifoList *list, FifoListNode *node) {
+    if (_fifo_list_node_is_in_block(list, node) == false) {
+        if (list->nbRecycled >= list->recycledMax) {
+            free(node);
+            return;
+        }
+        list->nbRecycled++;
+    }
+    node->next = list->recycled;
+    list->recycled = node;
+}
+
+// releases recycled nodes beyond the limit, block nodes are always kept
+static void _fifo_list_trim_recycled(FifoList *list) {
+    FifoListNode *node = list->recycled, *next;
+    list->recycled = NULL;
+    list->nbRecycled = 0;
+    while (node != NULL) {
+        next = node->next;
+        fifo_list_node_free(list, node);
+        node = next;
+    }
+}
+
+static bool _fifo_list_node_is_in_block(const FifoList *list, const FifoListNode *node) {
+    const uintptr_t address = (uintptr_t)node;
+    return list->block != NULL && address >= (uintptr_t)list->block &&
+           address < (uintptr_t)(list->block + FIFO_LIST_BLOCK_NODES);
+}
+
+void fifo_list_set_recycled_max(FifoList *list, const uint32_t max) {
+    list->recycledMax = max;
+    _fifo_list_trim_recycled(list);
 }
 
 uint32_t fifo_list_get_size(const FifoList *list) {
@@ -21,6 +21,8 @@ extern "C" {
 typedef struct _FifoListNode FifoListNode;
 typedef struct _FifoList FifoList;
 
+// Note: first nodes are allocated at once on first push, popped ones are kept for reuse by later
+// pushes, up to 8 more than those by default, see fifo_list_set_recycled_max
 FifoList *fifo_list_new(void);
 FifoList *fifo_list_new_copy(const FifoList *list);
 // ! \\ stored pointers won't be released
@@ -29,6 +31,9 @@ void fifo_list_push(FifoList *list, void *ptr);
 void *fifo_list_pop(FifoList *list);
 void fifo_list_flush(FifoList *list, pointer_free_function freeFunc);
 void fifo_list_empty_freefunc(void *a);
+/// Maximum number of popped nodes kept for reuse besides the first ones, extra ones are
+/// released. Queues refilled every frame can raise it to stop allocating once warmed up.
+void fifo_list_set_recycled_max(FifoList *list, const uint32_t max);
 uint32_t fifo_list_get_size(const FifoList *list);
 
 #ifdef __cplusplus
@@ -0,0 +1,39 @@
+// -------------------------------------------------------------
+//  Cubzh Core
+//  frustum.c
+//  Created by agent on October 19, 2026.
+// -------------------------------------------------------------
+
+#include "frustum.h"
+
+void frustum_set_from_matrix(Frustum *f, const Matrix4x4 *m) {
+    // rows of the matrix (column-major storage)
+    const float4 r1 = {m->x1y1, m->x2y1, m->x3y1, m->x4y1};
+    const float4 r2 = {m->x1y2, m->x2y2, m->x3y2, m->x4y2};
+    const float4 r3 = {m->x1y3, m->x2y3, m->x3y3, m->x4y3};
+    const float4 r4 = {m->x1y4, m->x2y4, m->x3y4, m->x4y4};
+
+    f->planes[FrustumPlane_Left] = (float4){r4.x + r1.x, r4.y + r1.y, r4.z + r1.z, r4.w + r1.w};
+    f->planes[FrustumPlane_Right] = (float4){r4.x - r1.x, r4.y - r1.y, r4.z - r1.z, r4.w - r1.w};
+    f->planes[FrustumPlane_Bottom] = (float4){r4.x + r2.x, r4.y + r2.y, r4.z + r2.z, r4.w + r2.w};
+    f->planes[FrustumPlane_Top] = (float4){r4.x - r2.x, r4.y - r2.y, r4.z - r2.z, r4.w - r2.w};
+    f->planes[FrustumPlane_Near] = (float4){r4.x + r3.x, r4.y + r3.y, r4.z + r3.z, r4.w + r3.w};
+    f->planes[FrustumPlane_Far] = (float4){r4.x - r3.x, r4.y - r3.y, r4.z - r3.z, r4.w - r3.w};
+}
+
+bool frustum_intersect_box(const Frustum *f, const Box *b) {
+    const float4 *p;
+    for (int i = 0; i < FrustumPlane_Count; ++i) {
+        p = &f->planes[i];
+
+        // box corner furthest along the plane normal
+        const float x = p->x >= 0.0f ? b->max.x : b->min.x;
+        const float y = p->y >= 0.0f ? b->max.y : b->min.y;
+        const float z = p->z >= 0.0f ? b->max.z : b->min.z;
+
+        if (p->x * x + p->y * y + p->z * z + p->w < 0.0f) {
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,46 @@
+// -------------------------------------------------------------
+//  Cubzh Core
+//  frustum.h
+//  Created by agent on October 19, 2026.
+// -------------------------------------------------------------
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+
+#include "box.h"
+#include "float4.h"
+#include "matrix4x4.h"
+
+typedef enum {
+    FrustumPlane_Left,
+    FrustumPlane_Right,
+    FrustumPlane_Bottom,
+    FrustumPlane_Top,
+    FrustumPlane_Near,
+    FrustumPlane_Far,
+    FrustumPlane_Count
+} FrustumPlane;
+
+/// Frustum planes as (a, b, c, d), a point p is inside a plane if a*p.x + b*p.y + c*p.z + d >= 0
+typedef struct Frustum {
+    float4 planes[FrustumPlane_Count];
+} Frustum;
+
+/// Extracts frustum planes from a view-projection matrix, planes are expressed in the space this
+/// matrix transforms from eg. world space for a view-projection, model space for a
+/// model-view-projection. Near plane is taken for a [-1:1] depth range, which is conservative for
+/// a [0:1] depth range
+void frustum_set_from_matrix(Frustum *f, const Matrix4x4 *m);
+
+/// @returns false only if the box is entirely outside at least one plane, may return true for a few
+/// boxes outside of the frustum near its corners
+bool frustum_intersect_box(const Frustum *f, const Box *b);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
@@ -11,210 +11,248 @@
 #include "cclog.h"
 #include "config.h"
 
-#define HASH_UINT32_BIT_SHIFT 2
-// 32 / 2 = 16 levels
-#define HASH_TREE_LEVELS 16
-#define HASH_TREE_LEVELS_MINUS_ONE 15
-#define HASH_UINT32_CHILDREN_PER_NODE 16
-// % 16 (modulo) == & 15 (binary operation)
-#define HASH_UINT32_BIN_MODULO 15 // 1111
-
-typedef struct _HashUInt32IntNode HashUInt32IntNode;
-
-struct _HashUInt32IntNode {
-    void **slots;
-    HashUInt32IntNode *parent;
-    uint8_t level;
-    uint8_t index;
-};
+// Open addressing with Robin Hood probing: all entries live in flat arrays, entries that are far
+// from their ideal slot take the place of closer ones, and deletions shift following entries back.
+
+#define HASH_UINT32_INITIAL_CAPACITY 16 // must be a power of 2
+// grow when count > capacity * 7 / 8
+#define HASH_UINT32_MAX_LOAD_NUM 7
+#define HASH_UINT32_MAX_LOAD_DEN 8
+// Fibonacci hashing, 2^32 / golden ratio
+#define HASH_UINT32_MULTIPLIER 2654435769u
+// distances are stored on a byte, the table grows before an entry would get further
+#define HASH_UINT32_MAX_DISTANCE UINT8_MAX
+// growing to spread out colliding keys stops at this number of slots per entry, further colliding
+// keys are rejected
+#define HASH_UINT32_MAX_SLOTS_PER_ENTRY 8
 
 struct _HashUInt32Int {
-    HashUInt32IntNode *rootNode;
+    uint32_t *keys;
+    int *values;
+    // 0: empty slot, otherwise distance from ideal slot + 1
+    uint8_t *distances;
+    uint32_t capacity;
+    uint32_t count;
+    uint8_t shift; // 32 - log2(capacity)
+    char pad[7];
 };
 
-// when leaf == true, each branch slot contains a value, not another branch
-HashUInt32IntNode *hash_uint32_node_new(HashUInt32IntNode *parent, uint8_t index, uint8_t level) {
-    vx_assert(level <= HASH_TREE_LEVELS);
-    HashUInt32IntNode *const n = (HashUInt32IntNode *)malloc(sizeof(HashUInt32IntNode));
-    void **slots = (void **)malloc(sizeof(void *) * HASH_UINT32_CHILDREN_PER_NODE);
-    for (int i = 0; i < HASH_UINT32_CHILDREN_PER_NODE; ++i) {
-        slots[i] = NULL;
-    }
-    n->slots = slots;
-    n->parent = parent;
-    n->level = level;
-    n->index = index;
-    return n;
-}
+// MARK: - Private functions prototypes -
 
-// frees node and all children
-// + sets parent slot to NULL
-void hash_uint32_node_free(HashUInt32IntNode *n) {
-    HashUInt32IntNode *cursor = n;
-    HashUInt32IntNode *tmp = NULL;
-    uint8_t slotCursor = 0;
-    HashUInt32IntNode **slots;
-
-    while (cursor != NULL) {
-        if (slotCursor == HASH_UINT32_CHILDREN_PER_NODE ||
-            cursor->level == HASH_TREE_LEVELS_MINUS_ONE) {
-            // done freeing all children, or reached last level
-            tmp = cursor->parent;
-            slotCursor = cursor->index + 1;
-            for (int i = 0; i < HASH_UINT32_CHILDREN_PER_NODE; ++i) {
-                if (cursor->slots[i] != NULL) {
-                    free(cursor->slots[i]);
-                    cursor->slots[i] = NULL;
-                }
-            }
-            if (tmp != NULL) {
-                // set parent slot to NULL
-                tmp->slots[cursor->index] = NULL;
-            }
-            if (cursor == n) {
-                // don't free nodes above n
-                tmp = NULL;
-            }
-            free(cursor->slots);
-            free(cursor);
-            cursor = tmp;
-            continue;
-        }
+static uint32_t _hash_uint32_int_ideal_slot(const HashUInt32Int *h, const uint32_t key);
+static bool _hash_uint32_int_find(const HashUInt32Int *h, const uint32_t key, uint32_t *slot);
+static bool _hash_uint32_int_alloc(HashUInt32Int *h, const uint32_t capacity);
+static bool _hash_uint32_int_fits(const HashUInt32Int *h, const uint32_t key);
+static void _hash_uint32_int_insert(HashUInt32Int *h, uint32_t key, int value);
+static bool _hash_uint32_int_rehash(HashUInt32Int *h, const uint32_t capacity);
+static bool _hash_uint32_int_grow(HashUInt32Int *h);
 
-        slots = (HashUInt32IntNode **)(cursor->slots);
-        if (slots[slotCursor] != NULL) {
-            cursor = slots[slotCursor];
-            slotCursor = 0;
-            continue;
-        }
-        ++slotCursor; // child is NULL, go see next
-    }
-}
+// MARK: - Public functions -
 
 HashUInt32Int *hash_uint32_int_new(void) {
     HashUInt32Int *h = (HashUInt32Int *)malloc(sizeof(HashUInt32Int));
-    h->rootNode = hash_uint32_node_new(NULL, 0, 1);
+    if (h == NULL) {
+        return NULL;
+    }
+    if (_hash_uint32_int_alloc(h, HASH_UINT32_INITIAL_CAPACITY) == false) {
+        free(h);
+        return NULL;
+    }
     return h;
 }
 
 void hash_uint32_int_free(HashUInt32Int *h) {
-    hash_uint32_node_free(h->rootNode);
+    if (h == NULL) {
+        return;
+    }
+    free(h->keys);
+    free(h->values);
+    free(h->distances);
     free(h);
 }
 
 void hash_uint32_int_set(HashUInt32Int *const h, uint32_t key, const int value) {
-    uint8_t level = 1;
-    HashUInt32IntNode *n = h->rootNode;
-    vx_assert(n != NULL);
-    uint8_t modulo = (uint8_t)(key & HASH_UINT32_BIN_MODULO);
-    HashUInt32IntNode **slots;
-
-    while (true) {
-        slots = (HashUInt32IntNode **)(n->slots);
-        // cclog_debug("LEVEL: %d - modulo: %d", level, modulo);
-        ++level;
-        if (slots[modulo] == NULL) {
-            slots[modulo] = hash_uint32_node_new(n, modulo, level);
-        }
-        n = slots[modulo];
-        key = key >> HASH_UINT32_BIT_SHIFT;
-        modulo = (uint8_t)(key & HASH_UINT32_BIN_MODULO);
-
-        if (level == HASH_TREE_LEVELS_MINUS_ONE) {
-            slots = (HashUInt32IntNode **)(n->slots);
-            int *i = (int *)slots[modulo];
-
-            if (i == NULL) {
-                slots[modulo] = (void *)malloc(sizeof(int *));
-                i = (int *)slots[modulo];
-            }
+    uint32_t slot;
+    if (_hash_uint32_int_find(h, key, &slot)) {
+        h->values[slot] = value;
+        return;
+    }
 
-            *i = value;
+    if ((h->count + 1) * HASH_UINT32_MAX_LOAD_DEN > h->capacity * HASH_UINT32_MAX_LOAD_NUM) {
+        if (_hash_uint32_int_grow(h) == false) {
+            cclog_error("hash_uint32_int: can't grow to insert key %u", key);
             return;
         }
     }
+    while (_hash_uint32_int_fits(h, key) == false) {
+        if (h->capacity / HASH_UINT32_MAX_SLOTS_PER_ENTRY > h->count ||
+            _hash_uint32_int_grow(h) == false) {
+            cclog_error("hash_uint32_int: can't insert key %u, too many colliding keys", key);
+            return;
+        }
+    }
+    _hash_uint32_int_insert(h, key, value);
+    ++h->count;
 }
 
 bool hash_uint32_int_get(HashUInt32Int *h, uint32_t key, int *outValue) {
-    int level = 1;
-    HashUInt32IntNode *n = h->rootNode;
-    vx_assert(n != NULL);
-    uint8_t modulo = (uint8_t)(key & HASH_UINT32_BIN_MODULO);
-    HashUInt32IntNode **slots;
+    uint32_t slot;
+    if (_hash_uint32_int_find(h, key, &slot) == false) {
+        return false;
+    }
+    *outValue = h->values[slot];
+    return true;
+}
 
-    while (true) {
-        slots = (HashUInt32IntNode **)(n->slots);
+void hash_uint32_int_delete(HashUInt32Int *h, uint32_t key) {
+    uint32_t slot;
+    if (_hash_uint32_int_find(h, key, &slot) == false) {
+        return; // not found, nothing to delete
+    }
 
-        if (slots[modulo] == NULL) {
-            return false;
-        }
-        n = slots[modulo];
-        ++level;
-        key = key >> HASH_UINT32_BIT_SHIFT;
-        modulo = (uint8_t)(key & HASH_UINT32_BIN_MODULO);
+    // backward shift: move following entries of the cluster one slot closer to their ideal slot
+    const uint32_t mask = h->capacity - 1;
+    uint32_t next = (slot + 1) & mask;
+    while (h->distances[next] > 1) {
+        h->keys[slot] = h->keys[next];
+        h->values[slot] = h->values[next];
+        h->distances[slot] = h->distances[next] - 1;
+        slot = next;
+        next = (next + 1) & mask;
+    }
+    h->distances[slot] = 0;
+    --h->count;
+}
 
-        if (level == HASH_TREE_LEVELS_MINUS_ONE) {
+// MARK: - Private functions -
 
-            slots = (HashUInt32IntNode **)(n->slots);
-            int *i = (int *)slots[modulo];
+static uint32_t _hash_uint32_int_ideal_slot(const HashUInt32Int *h, const uint32_t key) {
+    return (key * HASH_UINT32_MULTIPLIER) >> h->shift;
+}
 
-            if (i == NULL) {
-                return false;
-            }
+static bool _hash_uint32_int_find(const HashUInt32Int *h, const uint32_t key, uint32_t *slot) {
+    const uint32_t mask = h->capacity - 1;
+    uint32_t i = _hash_uint32_int_ideal_slot(h, key);
+    uint8_t distance = 1;
 
-            *outValue = *i;
+    // entries are ordered by distance within a cluster, key can't be further than an entry
+    // closer to its own ideal slot
+    while (h->distances[i] >= distance) {
+        if (h->keys[i] == key) {
+            *slot = i;
             return true;
         }
+        i = (i + 1) & mask;
+        ++distance;
     }
-
-    vx_assert(false); // should never reach this point
     return false;
 }
 
-void hash_uint32_int_delete(HashUInt32Int *h, uint32_t key) {
-    int level = 1;
-    HashUInt32IntNode *n = h->rootNode;
-    HashUInt32IntNode *tmp = NULL;
-    vx_assert(n != NULL);
-    uint8_t modulo = (uint8_t)(key & HASH_UINT32_BIN_MODULO);
-    HashUInt32IntNode **slots;
-
-    while (true) {
-        slots = (HashUInt32IntNode **)(n->slots);
-
-        if (slots[modulo] == NULL) {
-            // not found, nothing to delete
-            return;
-        }
-        n = slots[modulo];
-        ++level;
-        key = key >> HASH_UINT32_BIT_SHIFT;
-        modulo = (uint8_t)(key & HASH_UINT32_BIN_MODULO);
-
-        if (level == HASH_TREE_LEVELS_MINUS_ONE) {
+static bool _hash_uint32_int_alloc(HashUInt32Int *h, const uint32_t capacity) {
+    h->keys = (uint32_t *)malloc(sizeof(uint32_t) * capacity);
+    h->values = (int *)malloc(sizeof(int) * capacity);
+    h->distances = (uint8_t *)calloc(capacity, sizeof(uint8_t));
+    if (h->keys == NULL || h->values == NULL || h->distances == NULL) {
+        free(h->keys);
+        free(h->values);
+        free(h->distances);
+        return false;
+    }
+    h->capacity = capacity;
+    h->count = 0;
 
-            slots = (HashUInt32IntNode **)(n->slots);
+    uint8_t log2 = 0;
+    while ((1u << log2) < capacity) {
+        ++log2;
+    }
+    h->shift = (uint8_t)(32 - log2);
+    return true;
+}
 
-            if (slots[modulo] == NULL) {
-                // not found, nothing to delete
-                return;
-            }
+/// Returns false if inserting absent `key` would push an entry past the maximum distance, going
+/// through the same probe sequence as _hash_uint32_int_insert w/o moving entries
+static bool _hash_uint32_int_fits(const HashUInt32Int *h, const uint32_t key) {
+    const uint32_t mask = h->capacity - 1;
+    uint32_t i = _hash_uint32_int_ideal_slot(h, key);
+    uint32_t distance = 1;
+
+    while (h->distances[i] != 0) {
+        // from here, the carried entry is the one that would be taken out of this slot
+        if (h->distances[i] < distance) {
+            distance = h->distances[i];
+        }
+        i = (i + 1) & mask;
+        ++distance;
+        if (distance > HASH_UINT32_MAX_DISTANCE) {
+            return false;
+        }
+    }
+    return true;
+}
 
-            free(slots[modulo]); // free int* (value)
-            slots[modulo] = NULL;
-            break;
+/// Inserts a key known to be absent, capacity must be sufficient and the key must fit
+static void _hash_uint32_int_insert(HashUInt32Int *h, uint32_t key, int value) {
+    const uint32_t mask = h->capacity - 1;
+    uint32_t i = _hash_uint32_int_ideal_slot(h, key);
+    uint8_t distance = 1;
+
+    uint32_t tmpKey;
+    int tmpValue;
+    uint8_t tmpDistance;
+    while (h->distances[i] != 0) {
+        // take the slot from entries closer to their ideal slot, and carry on inserting them
+        if (h->distances[i] < distance) {
+            tmpKey = h->keys[i];
+            tmpValue = h->values[i];
+            tmpDistance = h->distances[i];
+            h->keys[i] = key;
+            h->values[i] = value;
+            h->distances[i] = distance;
+            key = tmpKey;
+            value = tmpValue;
+            distance = tmpDistance;
         }
+        i = (i + 1) & mask;
+        ++distance;
     }
+    h->keys[i] = key;
+    h->values[i] = value;
+    h->distances[i] = distance;
+}
+
+/// Moves all entries to new arrays of given capacity. Returns false if arrays can't be allocated or
+/// if an entry would get too far from its ideal slot, the table is then unchanged
+static bool _hash_uint32_int_rehash(HashUInt32Int *h, const uint32_t capacity) {
+    const HashUInt32Int previous = *h;
 
-    // cleanup empty parents (except root node)
-    while (n != NULL && n->level > 1) {
-        for (int i = 0; i < HASH_UINT32_CHILDREN_PER_NODE; ++i) {
-            if (n->slots[i] != NULL) {
-                return; // at least one slot not empty, stop
+    if (_hash_uint32_int_alloc(h, capacity) == false) {
+        *h = previous;
+        return false;
+    }
+
+    for (uint32_t i = 0; i < previous.capacity; ++i) {
+        if (previous.distances[i] != 0) {
+            if (_hash_uint32_int_fits(h, previous.keys[i]) == false) {
+                free(h->keys);
+                free(h->values);
+                free(h->distances);
+                *h = previous;
+                return false;
             }
+            _hash_uint32_int_insert(h, previous.keys[i], previous.values[i]);
         }
-        tmp = n->parent;
-        hash_uint32_node_free(n);
-        n = tmp;
     }
+    h->count = previous.count;
+
+    free(previous.keys);
+    free(previous.values);
+    free(previous.distances);
+    return true;
+}
+
+static bool _hash_uint32_int_grow(HashUInt32Int *h) {
+    if (h->capacity > UINT32_MAX / 2) {
+        return false;
+    }
+    return _hash_uint32_int_rehash(h, h->capacity * 2);
 }
@@ -18,24 +18,31 @@
 typedef struct _HistoryTransaction HistoryTransaction;
 
 void _history_flush(History *const h);
+void _history_enforce_budget(History *const h);
+Transaction *_history_unpack(History *const h, const HistoryTransaction *const ht);
 
+// transactions are stored packed (see transaction_pack), only unpacked to be undone or redone
 struct _HistoryTransaction {
     HistoryTransaction *previousAction; // 8 bytes
     HistoryTransaction *nextAction;     // 8 bytes
-    Transaction *transaction;           // 8 bytes
+    void *packed;                       // 8 bytes
+    uint32_t packedSize;                // 4 bytes
+
+    char pad[4]; // 4 bytes
 };
 
-HistoryTransaction *history_transaction_new(Transaction *const tr) {
+HistoryTransaction *history_transaction_new(void *packed, const uint32_t packedSize) {
     HistoryTransaction *ht = (HistoryTransaction *)malloc(sizeof(HistoryTransaction));
     ht->previousAction = NULL;
     ht->nextAction = NULL;
-    ht->transaction = tr;
+    ht->packed = packed;
+    ht->packedSize = packedSize;
     return ht;
 }
 
 void history_transaction_free(HistoryTransaction *const ht) {
     if (ht != NULL) {
-        transaction_free(ht->transaction);
+        free(ht->packed);
         free(ht);
     }
 }
@@ -46,31 +53,53 @@ struct _History {
     HistoryTransaction *oldest; // 8 bytes
     HistoryTransaction *cursor; // 8 bytes
 
-    uint16_t limit;     // 2 bytes
+    // last transaction returned for undo/redo, valid until next one
+    Transaction *unpacked; // 8 bytes
+
+    size_t budget;  // 8 bytes
+    size_t nbBytes; // 8 bytes
+
     uint16_t nbActions; // 2 bytes
 
-    char pad[4]; // 4 bytes
+    char pad[6]; // 6 bytes
 };
 
 History *history_new(void) {
     History *h = (History *)malloc(sizeof(History));
-    // h->pendingTransaction = NULL;
     h->latest = NULL;
     h->oldest = NULL;
     h->cursor = NULL;
-    h->limit = NB_UNDOABLE_ACTIONS;
+    h->unpacked = NULL;
+    h->budget = HISTORY_DEFAULT_BYTE_BUDGET;
+    h->nbBytes = 0;
     h->nbActions = 0;
     return h;
 }
 
 void history_free(History *const h) {
     if (h != NULL) {
-        // transaction_free(h->pendingTransaction);
         _history_flush(h);
+        transaction_free(h->unpacked);
         free(h);
     }
 }
 
+void history_set_byte_budget(History *const h, const size_t budget) {
+    vx_assert(h != NULL);
+    h->budget = budget;
+    _history_enforce_budget(h);
+}
+
+size_t history_get_byte_budget(const History *const h) {
+    vx_assert(h != NULL);
+    return h->budget;
+}
+
+size_t history_get_byte_count(const History *const h) {
+    vx_assert(h != NULL);
+    return h->nbBytes;
+}
+
 void history_pushTransaction(History *const h, Transaction *const tr) {
     vx_assert(h != NULL);
     vx_assert(tr != NULL);
@@ -79,7 +108,15 @@ void history_pushTransaction(History *const h, Transaction *const tr) {
         return;
     }
 
-    HistoryTransaction *const htr = history_transaction_new(tr);
+    // block changes are packed & transaction released right away
+    uint32_t packedSize = 0;
+    void *packed = transaction_pack(tr, &packedSize);
+    transaction_free(tr);
+    if (packed == NULL) {
+        cclog_error("HISTORY: failed to pack transaction");
+        return;
+    }
+    HistoryTransaction *const htr = history_transaction_new(packed, packedSize);
 
     if (h->oldest == NULL) {
         // history doesn't contain anything yet, we are setting the first transaction in it.
@@ -96,6 +133,7 @@ void history_pushTransaction(History *const h, Transaction *const tr) {
         h->cursor = htr;
         h->latest = htr;
         h->nbActions = 1;
+        h->nbBytes = packedSize;
 
     } else {
         // there is at least one transaction in history
@@ -121,10 +159,15 @@ void history_pushTransaction(History *const h, Transaction *const tr) {
         h->latest = htr;
         h->cursor = h->latest;
         h->nbActions++;
+        h->nbBytes += packedSize;
     }
 
-    // if there's no space to add an action, we remove the oldest ones
-    while (h->nbActions > h->limit) {
+    _history_enforce_budget(h);
+}
+
+void _history_enforce_budget(History *const h) {
+    // if over budget, we remove the oldest actions, always keeping the latest one
+    while ((h->nbBytes > h->budget || h->nbActions > HISTORY_MAX_ENTRIES) && h->nbActions > 1) {
         if (h->oldest != NULL) {
             // there is at least one action in history
             HistoryTransaction *toDelete = h->oldest;
@@ -142,6 +185,7 @@ void history_pushTransaction(History *const h, Transaction *const tr) {
                 h->oldest->previousAction = NULL;
             }
 
+            h->nbBytes -= toDelete->packedSize;
             history_transaction_free(toDelete);
             h->nbActions--;
         } else {
@@ -176,7 +220,11 @@ Transaction *history_getTransactionToUndo(History *const h) {
     }
 
     // transaction to undo
-    Transaction *tr = h->cursor->transaction;
+    Transaction *tr = _history_unpack(h, h->cursor);
+    if (tr == NULL) {
+        cclog_error("HISTORY", "%s error: failed to unpack transaction", __func__);
+        return NULL;
+    }
 
     // update h->cursor with h->cursor->previous value
     h->cursor = h->cursor->previousAction;
@@ -195,20 +243,21 @@ Transaction *history_getTransactionToRedo(History *const h) {
         return NULL;
     }
 
-    Transaction *tr = NULL;
+    // the transaction to redo is "oldest" if cursor is NULL
+    HistoryTransaction *next = h->cursor != NULL ? h->cursor->nextAction : h->oldest;
+    if (next == NULL) {
+        return NULL;
+    }
 
-    if (h->cursor == NULL) {
-        // the transaction to redo is "oldest"
-        if (h->oldest != NULL) {
-            tr = h->oldest->transaction;
-            h->cursor = h->oldest;
-        }
-    } else if (h->cursor->nextAction != NULL) {
-        tr = h->cursor->nextAction->transaction;
-        // update h->cursor with h->cursor->next value
-        h->cursor = h->cursor->nextAction;
+    Transaction *tr = _history_unpack(h, next);
+    if (tr == NULL) {
+        cclog_error("HISTORY", "%s error: failed to unpack transaction", __func__);
+        return NULL;
     }
 
+    // update h->cursor with h->cursor->next value
+    h->cursor = next;
+
     return tr;
 }
 
@@ -228,6 +277,13 @@ void _history_flush(History *const h) {
     h->cursor = NULL;
     h->latest = NULL;
     h->nbActions = 0;
+    h->nbBytes = 0;
+}
+
+Transaction *_history_unpack(History *const h, const HistoryTransaction *const ht) {
+    transaction_free(h->unpacked);
+    h->unpacked = transaction_new_from_packed(ht->packed, ht->packedSize);
+    return h->unpacked;
 }
 
 void history_discardTransactionsMoreRecentThanCursor(History *const h) {
@@ -250,6 +306,7 @@ void history_discardTransactionsMoreRecentThanCursor(History *const h) {
     while (afterCursor != NULL) {
         HistoryTransaction *toDelete = afterCursor;
         afterCursor = afterCursor->nextAction;
+        h->nbBytes -= toDelete->packedSize;
         history_transaction_free(toDelete);
         h->nbActions--;
     }
@@ -11,9 +11,12 @@ extern "C" {
 #endif
 
 #include <stdbool.h>
+#include <stddef.h>
 
 // An history is used to keep the last actions received by a World
 // It can be used to undo/redo operations.
+// Transactions are stored packed, oldest ones being discarded when over the byte budget or over
+// HISTORY_MAX_ENTRIES entries.
 typedef struct _History History;
 typedef struct _Shape Shape;
 typedef struct _Transaction Transaction;
@@ -24,13 +27,19 @@ History *history_new(void);
 ///
 void history_free(History *const h);
 
+/// Packed transactions total size limit, the most recent transaction is always kept
+void history_set_byte_budget(History *const h, const size_t budget);
+size_t history_get_byte_budget(const History *const h);
+size_t history_get_byte_count(const History *const h);
+
 ///
 void history_discardTransactionsMoreRecentThanCursor(History *const h);
 
-///
+/// Takes ownership of given applied transaction, releasing it once packed
 void history_pushTransaction(History *const h, Transaction *const tr);
 
-///
+/// Returned transactions are owned by the history, valid until next undo/redo. NULL is returned,
+/// and the cursor doesn't move, if the transaction couldn't be unpacked
 bool history_can_undo(const History *const h);
 Transaction *history_getTransactionToUndo(History *const h);
 
@@ -11,202 +11,92 @@
 
 #include "cclog.h"
 
-// has to be a power of two
-// #define INDEX_NODE_SIZE 64
-#define INDEX_NODE_BITWISE_MODULO 63 // INDEX_NODE_SIZE - 1
-// the extra slot is used to go from x > y and y > z or store the actual pointer
-#define INDEX_NODE_ARRAY_SIZE 65           // INDEX_NODE_SIZE + 1
-#define INDEX_NODE_ARRAY_SIZE_MINUS_ONE 64 // INDEX_NODE_ARRAY_SIZE_MINUS_ONE
-#define INDEX_DIVIDE_BYTES 6
+// Entries are stored densely in insertion order, removed entries leave holes (NULL pointer) that
+// are compacted when entries are full, live iterators being moved along. Positions are found
+// through an open-addressing table (linear probing) storing entry index + 1, 0 for empty slots.
+
+#define INDEX3D_INITIAL_CAPACITY 16 // slots, must be a power of 2
+// grow when count > capacity * 3 / 4
+#define INDEX3D_MAX_LOAD_NUM 3
+#define INDEX3D_MAX_LOAD_DEN 4
+// entries are compacted instead of growing when at least 1/4 are holes
+#define INDEX3D_COMPACT_HOLES_DEN 4
+
+typedef struct {
+    int32_t x, y, z;
+    char pad[4];
+    void *ptr; // NULL for holes
+} Index3DEntry;
 
 struct _Index3D {
-    void **topLevelNode;
-    DoublyLinkedList *list;
+    Index3DEntry *entries;
+    uint32_t *slots;
+    Index3DIterator *iterators; // live iterators, remapped when entries are compacted
+    uint32_t nbEntries; // including holes
+    uint32_t entriesCapacity;
+    uint32_t count; // stored pointers
+    uint32_t capacity;
+    uint32_t nbIterators;
+    char pad[4];
 };
 
 struct _Index3DIterator {
-    DoublyLinkedListNode *current;
+    Index3D *index;
+    Index3DIterator *next;
+    uint32_t current; // entry index, a hole if removed since, nbEntries or more at end
+    char pad[4];
 };
 
+// MARK: - Private functions prototypes -
+
+static uint32_t _index3d_ideal_slot(const Index3D *index,
+                                    const int32_t x,
+                                    const int32_t y,
+                                    const int32_t z);
+static bool _index3d_find_slot(const Index3D *index,
+                               const int32_t x,
+                               const int32_t y,
+                               const int32_t z,
+                               uint32_t *slot);
+static bool _index3d_rebuild_slots(Index3D *index, const uint32_t capacity);
+static bool _index3d_reserve_entry(Index3D *index);
+static bool _index3d_is_iterator_current(const Index3D *index, const uint32_t entry);
+static void _index3d_compact(Index3D *index);
+static uint32_t _index3d_next_entry(const Index3D *index, uint32_t position);
+
 //-------------------
 // Index3D
 //-------------------
 
-static void **_new_node(void) {
-    void **arr = (void **)malloc(INDEX_NODE_ARRAY_SIZE * sizeof(void *));
-    for (int i = 0; i < INDEX_NODE_ARRAY_SIZE; ++i) {
-        arr[i] = NULL;
-    }
-    return arr;
-}
-
 void *index3d_get(const Index3D *index, const int32_t x, const int32_t y, const int32_t z) {
-
-    // only use unsigned integers for bitwise operations:
-    uint32_t ux = (uint32_t)x;
-    uint32_t uy = (uint32_t)y;
-    uint32_t uz = (uint32_t)z;
-
-    void **currentNode = index->topLevelNode;
-
-    uint32_t modulo = ux & INDEX_NODE_BITWISE_MODULO;
-    uint32_t quotient = ux >> INDEX_DIVIDE_BYTES;
-
-    // look for x
-
-    while (1) {
-        // found, go to y
-        if (quotient == 0 && modulo == 0) {
-            currentNode = (void **)currentNode[INDEX_NODE_ARRAY_SIZE_MINUS_ONE];
-            if (currentNode == NULL) {
-                // not found
-                return NULL;
-            }
-            break;
-        }
-
-        currentNode = (void **)currentNode[modulo];
-
-        if (currentNode == NULL) {
-            // not found
-            return NULL;
-        }
-
-        if (quotient == 0) {
-            // making sure we're going to y in next loop
-            modulo = 0;
-        } else {
-            // go deeper
-            modulo = quotient & INDEX_NODE_BITWISE_MODULO;
-            quotient = quotient >> INDEX_DIVIDE_BYTES;
-        }
-    }
-
-    // look for y
-
-    modulo = uy & INDEX_NODE_BITWISE_MODULO;
-    quotient = uy >> INDEX_DIVIDE_BYTES;
-
-    while (1) {
-        // found, go to z
-        if (quotient == 0 && modulo == 0) {
-            currentNode = (void **)currentNode[INDEX_NODE_ARRAY_SIZE_MINUS_ONE];
-            if (currentNode == NULL) {
-                // not found
-                return NULL;
-            }
-            break;
-        }
-
-        currentNode = (void **)currentNode[modulo];
-
-        if (currentNode == NULL) {
-            // not found
-            return NULL;
-        }
-
-        if (quotient == 0) {
-            // making sure we're going to z in next loop
-            modulo = 0;
-        } else {
-            // go deeper
-            modulo = quotient & INDEX_NODE_BITWISE_MODULO;
-            quotient = quotient >> INDEX_DIVIDE_BYTES;
-        }
-    }
-
-    // look for z
-
-    modulo = uz & INDEX_NODE_BITWISE_MODULO;
-    quotient = uz >> INDEX_DIVIDE_BYTES;
-
-    while (1) {
-        // found!!!!
-        if (quotient == 0 && modulo == 0) {
-            return doubly_linked_list_node_pointer(
-                (const DoublyLinkedListNode *)currentNode[INDEX_NODE_ARRAY_SIZE_MINUS_ONE]);
-        }
-
-        currentNode = (void **)currentNode[modulo];
-
-        if (currentNode == NULL) {
-            // not found
-            return NULL;
-        }
-
-        if (quotient == 0) {
-            // making sure we're going to z in next loop
-            modulo = 0;
-        } else {
-            // go deeper
-            modulo = quotient & INDEX_NODE_BITWISE_MODULO;
-            quotient = quotient >> INDEX_DIVIDE_BYTES;
-        }
+    uint32_t slot;
+    if (_index3d_find_slot(index, x, y, z, &slot) == false) {
+        return NULL;
     }
-
-    return NULL;
+    return index->entries[index->slots[slot] - 1].ptr;
 }
 
-void index3d_batch_get_reset(const Index3D *index, void ***batchedNode) {
-    *batchedNode = index->topLevelNode;
-}
-
-bool index3d_batch_get_advance(const int32_t value, void ***batchedNode) {
-    uint32_t modulo = (uint32_t)value & INDEX_NODE_BITWISE_MODULO;
-    uint32_t quotient = (uint32_t)value >> INDEX_DIVIDE_BYTES;
-
-    while (1) {
-        if (quotient == 0 && modulo == 0) {
-            *batchedNode = (void **)(*batchedNode)[INDEX_NODE_ARRAY_SIZE_MINUS_ONE];
-            if (*batchedNode == NULL) {
-                return false; // not found
-            }
-            break;
-        }
-
-        *batchedNode = (void **)(*batchedNode)[modulo];
-
-        if (*batchedNode == NULL) {
-            return false; // not found
-        }
-
-        if (quotient == 0) {
-            // making sure we're going to stop next loop
-            modulo = 0;
-        } else {
-            // go deeper
-            modulo = quotient & INDEX_NODE_BITWISE_MODULO;
-            quotient = quotient >> INDEX_DIVIDE_BYTES;
+void index3d_get_neighborhood(const Index3D *index,
+                              const int32_t x,
+                              const int32_t y,
+                              const int32_t z,
+                              void *out[INDEX3D_NEIGHBORHOOD_SIZE]) {
+    if (index->count == 0) {
+        for (int i = 0; i < INDEX3D_NEIGHBORHOOD_SIZE; ++i) {
+            out[i] = NULL;
         }
+        return;
     }
 
-    return true;
-}
-
-void *index3d_batch_get(const int32_t z, void **batchedNode) {
-    uint32_t modulo = (uint32_t)z & INDEX_NODE_BITWISE_MODULO;
-    uint32_t quotient = (uint32_t)z >> INDEX_DIVIDE_BYTES;
-
-    while (1) {
-        // found!!!!
-        if (quotient == 0 && modulo == 0) {
-            return doubly_linked_list_node_pointer(
-                (const DoublyLinkedListNode *)batchedNode[INDEX_NODE_ARRAY_SIZE_MINUS_ONE]);
-        }
-
-        batchedNode = (void **)batchedNode[modulo];
-
-        if (batchedNode == NULL) {
-            return NULL; // not found
-        }
-
-        if (quotient == 0) {
-            // making sure we're going to stop next loop
-            modulo = 0;
-        } else {
-            // go deeper
-            modulo = quotient & INDEX_NODE_BITWISE_MODULO;
-            quotient = quotient >> INDEX_DIVIDE_BYTES;
+    uint32_t slot;
+    int i = 0;
+    for (int32_t dx = -1; dx <= 1; ++dx) {
+        for (int32_t dy = -1; dy <= 1; ++dy) {
+            for (int32_t dz = -1; dz <= 1; ++dz) {
+                out[i++] = _index3d_find_slot(index, x + dx, y + dy, z + dz, &slot)
+                               ? index->entries[index->slots[slot] - 1].ptr
+                               : NULL;
+            }
         }
     }
 }
@@ -216,121 +106,35 @@ void *index3d_remove(Index3D *index,
                      const int32_t y,
                      const int32_t z,
                      Index3DIterator *it) {
+    (void)it; // iterators skip holes, a removed current entry is left by index3d_iterator_next
 
-    // only use unsigned integers for bitwise operations:
-    uint32_t ux = (uint32_t)x;
-    uint32_t uy = (uint32_t)y;
-    uint32_t uz = (uint32_t)z;
-
-    void **currentNode = index->topLevelNode;
-
-    uint32_t modulo = ux & INDEX_NODE_BITWISE_MODULO;
-    uint32_t quotient = ux >> INDEX_DIVIDE_BYTES;
-
-    // look for x
-
-    while (1) {
-        // found, go to y
-        if (quotient == 0 && modulo == 0) {
-            currentNode = (void **)currentNode[INDEX_NODE_ARRAY_SIZE_MINUS_ONE];
-            if (currentNode == NULL) {
-                // not found
-                return NULL;
-            }
-            break;
-        }
-
-        currentNode = (void **)currentNode[modulo];
-
-        if (currentNode == NULL) {
-            // not found
-            return NULL;
-        }
-
-        if (quotient == 0) {
-            // making sure we're going to y in next loop
-            modulo = 0;
-        } else {
-            // go deeper
-            modulo = quotient & INDEX_NODE_BITWISE_MODULO;
-            quotient = quotient >> INDEX_DIVIDE_BYTES;
-        }
+    uint32_t slot;
+    if (_index3d_find_slot(index, x, y, z, &slot) == false) {
+        return NULL;
     }
 
-    // look for y
-
-    modulo = uy & INDEX_NODE_BITWISE_MODULO;
-    quotient = uy >> INDEX_DIVIDE_BYTES;
-
-    while (1) {
-        // found, go to z
-        if (quotient == 0 && modulo == 0) {
-            currentNode = (void **)currentNode[INDEX_NODE_ARRAY_SIZE_MINUS_ONE];
-            if (currentNode == NULL) {
-                // not found
-                return NULL;
-            }
-            break;
-        }
-
-        currentNode = (void **)currentNode[modulo];
-
-        if (currentNode == NULL) {
-            // not found
-            return NULL;
-        }
-
-        if (quotient == 0) {
-            // making sure we're going to z in next loop
-            modulo = 0;
-        } else {
-            // go deeper
-            modulo = quotient & INDEX_NODE_BITWISE_MODULO;
-            quotient = quotient >> INDEX_DIVIDE_BYTES;
-        }
+    Index3DEntry *entry = &index->entries[index->slots[slot] - 1];
+    void *ptr = entry->ptr;
+    entry->ptr = NULL;
+    --index->count;
+
+    // backward shift: move following slots of the cluster back if their ideal slot allows it
+    const uint32_t mask = index->capacity - 1;
+    uint32_t next = (slot + 1) & mask;
+    uint32_t ideal;
+    while (index->slots[next] != 0) {
+        entry = &index->entries[index->slots[next] - 1];
+        ideal = _index3d_ideal_slot(index, entry->x, entry->y, entry->z);
+        // slot can fill the hole if its ideal slot isn't cyclically in (slot, next]
+        if (((next - ideal) & mask) >= ((next - slot) & mask)) {
+            index->slots[slot] = index->slots[next];
+            slot = next;
+        }
+        next = (next + 1) & mask;
     }
+    index->slots[slot] = 0;
 
-    // look for z
-
-    modulo = uz & INDEX_NODE_BITWISE_MODULO;
-    quotient = uz >> INDEX_DIVIDE_BYTES;
-
-    while (1) {
-        // found!!!!
-        if (quotient == 0 && modulo == 0) {
-            // Note: maybe the node itself can be destroyed if contains nothing
-            // else, but it's good enough for now.
-            void *node = currentNode[INDEX_NODE_ARRAY_SIZE_MINUS_ONE];
-            currentNode[INDEX_NODE_ARRAY_SIZE_MINUS_ONE] = NULL;
-
-            // optionally maintain ongoing iterator, if at node being removed
-            if (it != NULL && it->current == node) {
-                it->current = doubly_linked_list_node_previous(it->current);
-            }
-
-            void *ptr = doubly_linked_list_node_pointer((const DoublyLinkedListNode *)node);
-            doubly_linked_list_delete_node(index->list, (DoublyLinkedListNode *)node);
-            return ptr;
-        }
-
-        currentNode = (void **)currentNode[modulo];
-
-        if (currentNode == NULL) {
-            // not found
-            return NULL;
-        }
-
-        if (quotient == 0) {
-            // making sure we're going to z in next loop
-            modulo = 0;
-        } else {
-            // go deeper
-            modulo = quotient & INDEX_NODE_BITWISE_MODULO;
-            quotient = quotient >> INDEX_DIVIDE_BYTES;
-        }
-    }
-
-    return NULL;
+    return ptr;
 }
 
 void index3d_insert(Index3D *index,
@@ -339,160 +143,67 @@ void index3d_insert(Index3D *index,
                     const int32_t y,
                     const int32_t z,
                     Index3DIterator *it) {
+    (void)it; // appended entries are reached by ongoing iterators
 
-    // only use unsigned integers for bitwise operations:
-    uint32_t ux = (uint32_t)x;
-    uint32_t uy = (uint32_t)y;
-    uint32_t uz = (uint32_t)z;
-
-    void **currentNode = index->topLevelNode;
-
-    uint32_t modulo = ux & INDEX_NODE_BITWISE_MODULO;
-    uint32_t quotient = ux >> INDEX_DIVIDE_BYTES;
-
-    // set x
-
-    while (1) {
-        // printf("x -- q: %u - m: %u\n", quotient, modulo);
-        // found, go to y
-        if (quotient == 0 && modulo == 0) {
-            if (currentNode[INDEX_NODE_ARRAY_SIZE_MINUS_ONE] == NULL) {
-                currentNode[INDEX_NODE_ARRAY_SIZE_MINUS_ONE] = _new_node();
-            }
-            currentNode = (void **)currentNode[INDEX_NODE_ARRAY_SIZE_MINUS_ONE];
-            break;
-        }
-
-        if (currentNode[modulo] == NULL) {
-            currentNode[modulo] = _new_node();
-        }
-        currentNode = (void **)currentNode[modulo];
-
-        if (quotient == 0) {
-            // making sure we're going to y in next loop
-            modulo = 0;
-        } else {
-            // go deeper
-            modulo = quotient & INDEX_NODE_BITWISE_MODULO;
-            quotient = quotient >> INDEX_DIVIDE_BYTES;
-        }
+    // NULL pointers mark holes, storing one amounts to a removal
+    if (ptr == NULL) {
+        index3d_remove(index, x, y, z, it);
+        return;
     }
 
-    // set y
-
-    modulo = uy & INDEX_NODE_BITWISE_MODULO;
-    quotient = uy >> INDEX_DIVIDE_BYTES;
-
-    while (1) {
-        // printf("y -- q: %u - m: %u\n", quotient, modulo);
-        // found, go to z
-        if (quotient == 0 && modulo == 0) {
-            if (currentNode[INDEX_NODE_ARRAY_SIZE_MINUS_ONE] == NULL) {
-                currentNode[INDEX_NODE_ARRAY_SIZE_MINUS_ONE] = _new_node();
-            }
-            currentNode = (void **)currentNode[INDEX_NODE_ARRAY_SIZE_MINUS_ONE];
-            break;
-        }
-
-        if (currentNode[modulo] == NULL) {
-            currentNode[modulo] = _new_node();
-        }
-        currentNode = (void **)currentNode[modulo];
-
-        if (quotient == 0) {
-            // making sure we're going to y in next loop
-            modulo = 0;
-        } else {
-            // go deeper
-            modulo = quotient & INDEX_NODE_BITWISE_MODULO;
-            quotient = quotient >> INDEX_DIVIDE_BYTES;
-        }
+    uint32_t slot;
+    if (_index3d_find_slot(index, x, y, z, &slot)) {
+        index->entries[index->slots[slot] - 1].ptr = ptr;
+        return;
     }
 
-    // set z
-
-    modulo = uz & INDEX_NODE_BITWISE_MODULO;
-    quotient = uz >> INDEX_DIVIDE_BYTES;
-
-    while (1) {
-        // printf("z -- q: %u - m: %u\n", quotient, modulo);
-        // found, go to z
-        if (quotient == 0 && modulo == 0) {
-            DoublyLinkedListNode *node = doubly_linked_list_push_last(index->list, ptr);
-            currentNode[INDEX_NODE_ARRAY_SIZE_MINUS_ONE] = node;
-
-            // optionally maintain ongoing iterator, if at the end
-            if (it != NULL && it->current == NULL) {
-                it->current = node;
-            }
-            break;
-        }
-
-        if (currentNode[modulo] == NULL) {
-            currentNode[modulo] = _new_node();
-        }
-        currentNode = (void **)currentNode[modulo];
-
-        if (quotient == 0) {
-            // making sure we're going to y in next loop
-            modulo = 0;
-        } else {
-            // go deeper
-            modulo = quotient & INDEX_NODE_BITWISE_MODULO;
-            quotient = quotient >> INDEX_DIVIDE_BYTES;
+    if (_index3d_reserve_entry(index) == false) {
+        cclog_error("index3d: can't insert at %d, %d, %d", x, y, z);
+        return;
+    }
+    if ((index->count + 1) * INDEX3D_MAX_LOAD_DEN > index->capacity * INDEX3D_MAX_LOAD_NUM) {
+        if (_index3d_rebuild_slots(index, index->capacity * 2) == false) {
+            cclog_error("index3d: can't insert at %d, %d, %d", x, y, z);
+            return;
         }
     }
+    _index3d_find_slot(index, x, y, z, &slot);
+
+    Index3DEntry *entry = &index->entries[index->nbEntries];
+    entry->x = x;
+    entry->y = y;
+    entry->z = z;
+    entry->ptr = ptr;
+    index->slots[slot] = ++index->nbEntries;
+    ++index->count;
 }
 
 /// returns whether index is empty
 bool index3d_is_empty(const Index3D *const index) {
-    for (int i = 0; i < INDEX_NODE_ARRAY_SIZE; i++) {
-        if (index->topLevelNode[i] != NULL) {
-            return false;
-        }
-    }
-    return true;
+    return index->count == 0;
 }
 
-void index3d_flush_node(Index3D *index,
-                        void **node,
-                        uint8_t dimension,
-                        pointer_free_function freePtr) {
-    if (node == NULL)
-        return;
-
-    int lastIndex = INDEX_NODE_ARRAY_SIZE_MINUS_ONE;
-
-    for (int i = 0; i < lastIndex; ++i) {
-        if (node[i] != NULL) {
-            index3d_flush_node(index, (void **)(node[i]), dimension, freePtr);
-            free(node[i]);
-            node[i] = NULL;
-        }
-    }
-
-    // go to next dimension or free content if looking in 3rd one
-    if (node[lastIndex] != NULL) {
-        if (dimension < 3) {
-            index3d_flush_node(index, (void **)(node[lastIndex]), dimension + 1, freePtr);
-            free(node[lastIndex]);
-            node[lastIndex] = NULL;
-        } else {
-            void *ptr = doubly_linked_list_node_pointer(
-                (const DoublyLinkedListNode *)(node[lastIndex]));
-            if (freePtr != NULL) {
-                freePtr(ptr);
-            }
-            doubly_linked_list_delete_node(index->list, (DoublyLinkedListNode *)(node[lastIndex]));
-            node[lastIndex] = NULL;
-        }
-    }
+uint32_t index3d_count(const Index3D *const index) {
+    return index->count;
 }
 
 Index3D *index3d_new(void) {
     Index3D *index = (Index3D *)malloc(sizeof(Index3D));
-    index->topLevelNode = _new_node();
-    index->list = doubly_linked_list_new();
+    if (index == NULL) {
+        return NULL;
+    }
+    index->entries = NULL;
+    index->iterators = NULL;
+    index->nbEntries = 0;
+    index->entriesCapacity = 0;
+    index->count = 0;
+    index->nbIterators = 0;
+    index->capacity = INDEX3D_INITIAL_CAPACITY;
+    index->slots = (uint32_t *)calloc(index->capacity, sizeof(uint32_t));
+    if (index->slots == NULL) {
+        free(index);
+        return NULL;
+    }
     return index;
 }
 
@@ -503,8 +214,11 @@ void index3d_free(Index3D *index) {
     if (index3d_is_empty(index) == false) {
         cclog_error("⚠️ index3d_free error: index is not empty (possible memory leak)");
     }
-    doubly_linked_list_free(index->list);
-    free(index->topLevelNode);
+    if (index->nbIterators > 0) {
+        cclog_error("⚠️ index3d_free error: iterators should be freed first");
+    }
+    free(index->entries);
+    free(index->slots);
     free(index);
 }
 
@@ -512,11 +226,21 @@ void index3d_flush(Index3D *index, pointer_free_function ptr) {
     if (index3d_is_empty(index) == true) {
         return;
     }
-    // list nodes are freed correctly within index3d_flush_node
-    index3d_flush_node(index, index->topLevelNode, 1, ptr);
-    // so it's now safe to free the list and create a new one
-    doubly_linked_list_free(index->list);
-    index->list = doubly_linked_list_new();
+    if (ptr != NULL) {
+        for (uint32_t i = 0; i < index->nbEntries; ++i) {
+            if (index->entries[i].ptr != NULL) {
+                ptr(index->entries[i].ptr);
+            }
+        }
+    }
+    index->nbEntries = 0;
+    index->count = 0;
+    for (Index3DIterator *it = index->iterators; it != NULL; it = it->next) {
+        it->current = 0;
+    }
+    for (uint32_t i = 0; i < index->capacity; ++i) {
+        index->slots[i] = 0;
+    }
 }
 
 //-------------------
@@ -525,23 +249,171 @@ void index3d_flush(Index3D *index, pointer_free_function ptr) {
 
 Index3DIterator *index3d_iterator_new(Index3D *index) {
     Index3DIterator *it = (Index3DIterator *)malloc(sizeof(Index3DIterator));
-    it->current = doubly_linked_list_first(index->list);
+    if (it == NULL) {
+        return NULL;
+    }
+    it->index = index;
+    it->current = _index3d_next_entry(index, 0);
+    it->next = index->iterators;
+    index->iterators = it;
+    ++index->nbIterators;
     return it;
 }
 
 void index3d_iterator_free(Index3DIterator *it) {
-    // the list nodes are the Index3D's responsibility
+    if (it == NULL) {
+        return;
+    }
+    Index3DIterator **link = &it->index->iterators;
+    while (*link != it) {
+        link = &(*link)->next;
+    }
+    *link = it->next;
+    --it->index->nbIterators;
     free(it);
 }
 
 void *index3d_iterator_pointer(const Index3DIterator *it) {
-    return doubly_linked_list_node_pointer(it->current);
+    return it->current < it->index->nbEntries ? it->index->entries[it->current].ptr : NULL;
 }
 
 void index3d_iterator_next(Index3DIterator *it) {
-    it->current = doubly_linked_list_node_next(it->current);
+    if (it->current < it->index->nbEntries) {
+        it->current = _index3d_next_entry(it->index, it->current + 1);
+    }
 }
 
 bool index3d_iterator_is_at_end(const Index3DIterator *it) {
-    return doubly_linked_list_node_next(it->current) == NULL;
+    return it->current >= it->index->nbEntries ||
+           _index3d_next_entry(it->index, it->current + 1) >= it->index->nbEntries;
+}
+
+// MARK: - Private functions -
+
+static uint32_t _index3d_ideal_slot(const Index3D *index,
+                                    const int32_t x,
+                                    const int32_t y,
+                                    const int32_t z) {
+    uint32_t h = (uint32_t)x * 73856093u ^ (uint32_t)y * 19349663u ^ (uint32_t)z * 83492791u;
+    h ^= h >> 16;
+    h *= 2654435769u;
+    h ^= h >> 13;
+    return h & (index->capacity - 1);
+}
+
+/// Returns true and the slot of the position if found, false and the first empty slot otherwise
+static bool _index3d_find_slot(const Index3D *index,
+                               const int32_t x,
+                               const int32_t y,
+                               const int32_t z,
+                               uint32_t *slot) {
+    const uint32_t mask = index->capacity - 1;
+    uint32_t i = _index3d_ideal_slot(index, x, y, z);
+    const Index3DEntry *entry;
+    while (index->slots[i] != 0) {
+        entry = &index->entries[index->slots[i] - 1];
+        if (entry->x == x && entry->y == y && entry->z == z) {
+            *slot = i;
+            return true;
+        }
+        i = (i + 1) & mask;
+    }
+    *slot = i;
+    return false;
+}
+
+static bool _index3d_rebuild_slots(Index3D *index, const uint32_t capacity) {
+    uint32_t *slots = (uint32_t *)calloc(capacity, sizeof(uint32_t));
+    if (slots == NULL) {
+        return false;
+    }
+    free(index->slots);
+    index->slots = slots;
+    index->capacity = capacity;
+
+    const uint32_t mask = capacity - 1;
+    uint32_t slot;
+    const Index3DEntry *entry;
+    for (uint32_t i = 0; i < index->nbEntries; ++i) {
+        entry = &index->entries[i];
+        if (entry->ptr == NULL) {
+            continue;
+        }
+        slot = _index3d_ideal_slot(index, entry->x, entry->y, entry->z);
+        while (slots[slot] != 0) {
+            slot = (slot + 1) & mask;
+        }
+        slots[slot] = i + 1;
+    }
+    return true;
+}
+
+/// Makes room for one more entry, compacting holes or growing entries
+static bool _index3d_reserve_entry(Index3D *index) {
+    if (index->nbEntries < index->entriesCapacity) {
+        return true;
+    }
+
+    const uint32_t holes = index->nbEntries - index->count;
+    if (holes > index->nbIterators && holes * INDEX3D_COMPACT_HOLES_DEN >= index->nbEntries) {
+        // at least one hole isn't an iterator's current, leaving room
+        _index3d_compact(index);
+        return _index3d_rebuild_slots(index, index->capacity);
+    }
+
+    const uint32_t capacity = index->entriesCapacity > 0 ? index->entriesCapacity * 2
+                                                         : INDEX3D_INITIAL_CAPACITY;
+    Index3DEntry *entries = (Index3DEntry *)realloc(index->entries,
+                                                    sizeof(Index3DEntry) * capacity);
+    if (entries == NULL) {
+        return false;
+    }
+    index->entries = entries;
+    index->entriesCapacity = capacity;
+    return true;
+}
+
+/// Whether given entry is the current one of a live iterator
+static bool _index3d_is_iterator_current(const Index3D *index, const uint32_t entry) {
+    const Index3DIterator *it = index->iterators;
+    while (it != NULL && it->current != entry) {
+        it = it->next;
+    }
+    return it != NULL;
+}
+
+/// Removes holes, except those left by the current entry of an iterator since it must still be
+/// moved past, iterators keep pointing at the same entries
+static void _index3d_compact(Index3D *index) {
+    Index3DIterator *it;
+    uint32_t n = 0;
+    for (uint32_t i = 0; i < index->nbEntries; ++i) {
+        const bool current = index->nbIterators > 0 && _index3d_is_iterator_current(index, i);
+        if (index->entries[i].ptr == NULL && current == false) {
+            continue;
+        }
+        if (current) {
+            for (it = index->iterators; it != NULL; it = it->next) {
+                if (it->current == i) {
+                    it->current = n;
+                }
+            }
+        }
+        index->entries[n++] = index->entries[i];
+    }
+    // iterators at end stay at end
+    for (it = index->iterators; it != NULL; it = it->next) {
+        if (it->current >= index->nbEntries) {
+            it->current = n;
+        }
+    }
+    index->nbEntries = n;
+}
+
+/// Returns first entry that isn't a hole from given position, or nbEntries
+static uint32_t _index3d_next_entry(const Index3D *index, uint32_t position) {
+    while (position < index->nbEntries && index->entries[position].ptr == NULL) {
+        ++position;
+    }
+    return position;
 }
@@ -8,8 +8,8 @@
 // storing and retrieving pointers is a little slower compared
 // to 3d arrays. But it takes a lot less space in memory and
 // request time is constant and reliable.
-// index3d also automatically stores pointers in a doubly_linked_list, in no
-// specific order. It's useful when we want to iterate over all entries quickly.
+// Pointers are stored in a flat array, in insertion order, and found through
+// a hash table keyed by position. Iterating over all entries is a linear scan.
 
 #pragma once
 
@@ -21,13 +21,14 @@ extern "C" {
 #include <stdint.h>
 #include <stdio.h>
 
-#include "doubly_linked_list.h"
 #include "function_pointers.h"
 
 typedef struct _Index3D Index3D;
 
-// Index3DIterator can be used to quickly iterate over all stored pointers
-// (uses the doubly_linked_list)
+// Index3DIterator can be used to quickly iterate over all stored pointers,
+// in insertion order. Entries inserted while iterating are visited. Removing
+// the current entry makes index3d_iterator_pointer return NULL until
+// index3d_iterator_next moves to the entry that followed it.
 typedef struct _Index3DIterator Index3DIterator;
 
 // constructor
@@ -42,12 +43,16 @@ void index3d_free(Index3D *index);
 ///
 bool index3d_is_empty(const Index3D *const index);
 
+/// returns the number of indexed pointers
+uint32_t index3d_count(const Index3D *const index);
+
 // index3d_flush flushes all indexed pointers and releases memory for
 // each one of them.
 // see world.c/entity_list_with_distance_free to help for implementation
 void index3d_flush(Index3D *index, pointer_free_function ptr);
 
 // index3d_insert inserts ptr at given position, optionally maintaining given iterator
+// NULL can't be stored, inserting it removes the pointer at given position
 void index3d_insert(Index3D *index,
                     void *ptr,
                     const int32_t x,
@@ -57,9 +62,17 @@ void index3d_insert(Index3D *index,
 
 // index3d_get returns pointer at given position. NULL can be returned
 void *index3d_get(const Index3D *index, const int32_t x, const int32_t y, const int32_t z);
-void index3d_batch_get_reset(const Index3D *index, void ***batchedNode);
-bool index3d_batch_get_advance(const int32_t value, void ***batchedNode);
-void *index3d_batch_get(const int32_t z, void **batchedNode);
+
+#define INDEX3D_NEIGHBORHOOD_SIZE 27
+#define INDEX3D_NEIGHBOR(dx, dy, dz) (((dx) + 1) * 9 + ((dy) + 1) * 3 + ((dz) + 1))
+
+// index3d_get_neighborhood fills `out` with pointers of the 3x3x3 block centered on given
+// position (NULL where empty), use INDEX3D_NEIGHBOR(dx, dy, dz) to read them
+void index3d_get_neighborhood(const Index3D *index,
+                              const int32_t x,
+                              const int32_t y,
+                              const int32_t z,
+                              void *out[INDEX3D_NEIGHBORHOOD_SIZE]);
 
 // index3d_remove removes ptr from index at given position, optionally maintaining given iterator
 // @returns removed pointer or NULL if not found. Its caller's responsibility to free memory.
@@ -70,6 +83,7 @@ void *index3d_remove(Index3D *index,
                      Index3DIterator *it);
 
 // returns new iterator
+// iterators must be freed before the index
 Index3DIterator *index3d_iterator_new(Index3D *index);
 
 // destructor
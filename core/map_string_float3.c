@@ -6,28 +6,59 @@
 
 #include "map_string_float3.h"
 
+#include <stdint.h>
 #include <stdio.h>
 #include <string.h>
 
 #include "cclog.h"
 
+// Entries are chained in iteration order (last inserted first) and indexed by an open-addressing
+// table of key hashes (linear probing), so lookups don't depend on the number of entries.
+
+#define MAP_STRING_FLOAT3_INITIAL_CAPACITY 8 // must be a power of 2
+// grow when count > capacity * 3 / 4
+#define MAP_STRING_FLOAT3_MAX_LOAD_NUM 3
+#define MAP_STRING_FLOAT3_MAX_LOAD_DEN 4
+
 struct node {
     char *key;
     float3 *value;
     struct node *next;
+    struct node *previous;
+    uint32_t hash;
+    char pad[4];
 };
 
 struct _MapStringFloat3 {
     struct node *list;
+    struct node **slots; // NULL until first insertion
+    uint32_t capacity;
+    uint32_t count;
 };
 
 struct _MapStringFloat3Iterator {
     struct node *currentNode;
 };
 
+// MARK: - Private functions prototypes -
+
+static uint32_t _map_string_float3_hash(const char *key);
+static bool _map_string_float3_find_slot(const MapStringFloat3 *m,
+                                         const char *key,
+                                         const uint32_t hash,
+                                         uint32_t *slot);
+static bool _map_string_float3_grow(MapStringFloat3 *m);
+static struct node *_map_string_float3_node_for_key(const MapStringFloat3 *m, const char *key);
+static void _map_string_float3_node_free(struct node *n);
+
+// MARK: - Public functions -
+
 MapStringFloat3 *map_string_float3_new(void) {
     MapStringFloat3 *m = (MapStringFloat3 *)malloc(sizeof(MapStringFloat3));
     m->list = NULL;
+    m->slots = NULL;
+    m->capacity = 0;
+    m->count = 0;
     return m;
 }
 
@@ -40,10 +71,9 @@ void map_string_float3_free(MapStringFloat3 *m) {
     while (m->list != NULL) {
         currentNode = m->list;
         m->list = currentNode->next;
-        float3_free(currentNode->value);
-        free(currentNode->key);
-        free(currentNode);
+        _map_string_float3_node_free(currentNode);
     }
+    free(m->slots);
     // free m
     free(m);
 }
@@ -98,29 +128,43 @@ bool map_string_float3_iterator_is_done(const MapStringFloat3Iterator *i) {
 }
 
 void map_string_float3_set_key_value(MapStringFloat3 *m, const char *key, float3 *f3) {
-    // see if node exists
-    MapStringFloat3Iterator *it = map_string_float3_iterator_new(m);
+    const uint32_t hash = _map_string_float3_hash(key);
+    uint32_t slot;
 
-    while (map_string_float3_iterator_is_done(it) == false) {
-        if (strcmp(key, map_string_float3_iterator_current_key(it)) == 0) {
-            // key exists, update value
-            map_string_float3_iterator_replace_current_value(it, f3);
-            map_string_float3_iterator_free(it);
+    if (m->slots != NULL && _map_string_float3_find_slot(m, key, hash, &slot)) {
+        // key exists, update value
+        float3_free(m->slots[slot]->value);
+        m->slots[slot]->value = f3;
+        return;
+    }
+
+    if ((m->count + 1) * MAP_STRING_FLOAT3_MAX_LOAD_DEN >
+        m->capacity * MAP_STRING_FLOAT3_MAX_LOAD_NUM) {
+        if (_map_string_float3_grow(m) == false) {
+            cclog_error("map_string_float3: can't grow to insert %s", key);
+            float3_free(f3);
             return;
         }
-        map_string_float3_iterator_next(it);
+        _map_string_float3_find_slot(m, key, hash, &slot);
     }
-    map_string_float3_iterator_free(it);
 
     struct node *newNode = (struct node *)malloc(sizeof(struct node));
 
     newNode->key = (char *)malloc(strlen(key) + 1);
     strcpy(newNode->key, key);
     newNode->value = f3;
+    newNode->hash = hash;
 
+    newNode->previous = NULL;
     newNode->next = m->list;
+    if (m->list != NULL) {
+        m->list->previous = newNode;
+    }
     m->list = newNode;
 
+    m->slots[slot] = newNode;
+    ++m->count;
+
     return;
 }
 
@@ -139,54 +183,118 @@ void map_string_float3_debug(MapStringFloat3 *m) {
 }
 
 const float3 *map_string_float3_value_for_key(MapStringFloat3 *m, const char *key) {
-    MapStringFloat3Iterator *it = map_string_float3_iterator_new(m);
-    while (map_string_float3_iterator_is_done(it) == false) {
-        if (strcmp(key, map_string_float3_iterator_current_key(it)) == 0) {
-            const float3 *r = map_string_float3_iterator_current_value(it);
-            map_string_float3_iterator_free(it);
-            return r;
-        }
-        map_string_float3_iterator_next(it);
-    }
-    map_string_float3_iterator_free(it);
-    return NULL;
+    const struct node *n = _map_string_float3_node_for_key(m, key);
+    return n != NULL ? n->value : NULL;
 }
 
 float3 *map_string_mutable_float3_value_for_key(MapStringFloat3 *m, const char *key) {
-    MapStringFloat3Iterator *it = map_string_float3_iterator_new(m);
-    while (map_string_float3_iterator_is_done(it) == false) {
-        if (strcmp(key, map_string_float3_iterator_current_key(it)) == 0) {
-            float3 *r = map_string_float3_iterator_current_value(it);
-            map_string_float3_iterator_free(it);
-            return r;
+    struct node *n = _map_string_float3_node_for_key(m, key);
+    return n != NULL ? n->value : NULL;
+}
+
+void map_string_float3_remove_key(MapStringFloat3 *m, const char *key) {
+    uint32_t slot;
+    if (m->slots == NULL ||
+        _map_string_float3_find_slot(m, key, _map_string_float3_hash(key), &slot) == false) {
+        return;
+    }
+
+    struct node *n = m->slots[slot];
+    if (n->previous == NULL) { // removing first node
+        m->list = n->next;
+    } else {
+        n->previous->next = n->next;
+    }
+    if (n->next != NULL) {
+        n->next->previous = n->previous;
+    }
+    _map_string_float3_node_free(n);
+    --m->count;
+
+    // backward shift: move following entries of the cluster back if their ideal slot allows it
+    const uint32_t mask = m->capacity - 1;
+    uint32_t next = (slot + 1) & mask;
+    uint32_t ideal;
+    while (m->slots[next] != NULL) {
+        ideal = m->slots[next]->hash & mask;
+        // entry can fill the hole if its ideal slot isn't cyclically in (slot, next]
+        if (((next - ideal) & mask) >= ((next - slot) & mask)) {
+            m->slots[slot] = m->slots[next];
+            slot = next;
         }
-        map_string_float3_iterator_next(it);
+        next = (next + 1) & mask;
     }
-    map_string_float3_iterator_free(it);
-    return NULL;
+    m->slots[slot] = NULL;
 }
 
-void map_string_float3_remove_key(MapStringFloat3 *m, const char *key) {
+// MARK: - Private functions -
 
-    struct node *previousNode = NULL;
+/// FNV-1a
+static uint32_t _map_string_float3_hash(const char *key) {
+    uint32_t hash = 2166136261u;
+    while (*key != '\0') {
+        hash ^= (uint8_t)*key;
+        hash *= 16777619u;
+        ++key;
+    }
+    return hash;
+}
 
-    MapStringFloat3Iterator *it = map_string_float3_iterator_new(m);
-    while (map_string_float3_iterator_is_done(it) == false) {
-        if (strcmp(key, map_string_float3_iterator_current_key(it)) == 0) {
-            if (previousNode == NULL) { // removing first node
-                m->list = it->currentNode->next;
-            } else {
-                previousNode->next = it->currentNode->next;
-            }
-            // free node
-            float3_free(it->currentNode->value);
-            free(it->currentNode->key);
-            free(it->currentNode);
-            break;
+/// Returns true and the slot of the key if found, false and the first empty slot otherwise
+static bool _map_string_float3_find_slot(const MapStringFloat3 *m,
+                                         const char *key,
+                                         const uint32_t hash,
+                                         uint32_t *slot) {
+    const uint32_t mask = m->capacity - 1;
+    uint32_t i = hash & mask;
+    while (m->slots[i] != NULL) {
+        if (m->slots[i]->hash == hash && strcmp(m->slots[i]->key, key) == 0) {
+            *slot = i;
+            return true;
         }
-        previousNode = it->currentNode;
-        map_string_float3_iterator_next(it);
+        i = (i + 1) & mask;
     }
-    map_string_float3_iterator_free(it);
-    return;
+    *slot = i;
+    return false;
+}
+
+static bool _map_string_float3_grow(MapStringFloat3 *m) {
+    const uint32_t capacity = m->capacity > 0 ? m->capacity * 2
+                                              : MAP_STRING_FLOAT3_INITIAL_CAPACITY;
+    struct node **slots = (struct node **)calloc(capacity, sizeof(struct node *));
+    if (slots == NULL) {
+        return false;
+    }
+
+    const uint32_t mask = capacity - 1;
+    uint32_t i;
+    struct node *n = m->list;
+    while (n != NULL) {
+        i = n->hash & mask;
+        while (slots[i] != NULL) {
+            i = (i + 1) & mask;
+        }
+        slots[i] = n;
+        n = n->next;
+    }
+
+    free(m->slots);
+    m->slots = slots;
+    m->capacity = capacity;
+    return true;
+}
+
+static struct node *_map_string_float3_node_for_key(const MapStringFloat3 *m, const char *key) {
+    uint32_t slot;
+    if (m->slots == NULL ||
+        _map_string_float3_find_slot(m, key, _map_string_float3_hash(key), &slot) == false) {
+        return NULL;
+    }
+    return m->slots[slot];
+}
+
+static void _map_string_float3_node_free(struct node *n) {
+    float3_free(n->value);
+    free(n->key);
+    free(n);
 }
@@ -0,0 +1,357 @@
+// -------------------------------------------------------------
+//  Cubzh Core
+//  occlusion_buffer.c
+//  Created by agent on October 19, 2026.
+// -------------------------------------------------------------
+
+#include "occlusion_buffer.h"
+
+#include <float.h>
+#include <math.h>
+#include <stdlib.h>
+
+#include "float4.h"
+#include "utils.h"
+
+// minimum clip w for a box corner to be considered in front of the camera
+#define OCCLUSION_BUFFER_MIN_W 1e-4f
+
+struct _OcclusionBuffer {
+    float *depth;
+    uint16_t width, height;
+
+    char pad[4];
+};
+
+// MARK: - Private functions prototypes -
+
+/// Projects box corners to screen space (pixels, NDC z), returns false if a corner is behind
+/// or too close to the camera
+bool _occlusion_buffer_project_box(const OcclusionBuffer *ob,
+                                   const Matrix4x4 *mvp,
+                                   const Box *box,
+                                   float3 *corners);
+/// Camera center in box space, as homogeneous coordinates w/ w >= 0 (w == 0: orthographic, then
+/// xyz is the direction toward the camera)
+void _occlusion_buffer_get_eye(const Matrix4x4 *mvp, float4 *eye);
+/// Convex hull of projected corners, counter-clockwise, returns number of hull points
+int _occlusion_buffer_convex_hull(const float3 *corners, float3 *hull);
+
+// MARK: - Lifecycle -
+
+OcclusionBuffer *occlusion_buffer_new(uint16_t width, uint16_t height) {
+    if (width == 0 || height == 0) {
+        return NULL;
+    }
+
+    OcclusionBuffer *ob = (OcclusionBuffer *)malloc(sizeof(OcclusionBuffer));
+    if (ob == NULL) {
+        return NULL;
+    }
+    ob->depth = (float *)malloc(sizeof(float) * width * height);
+    if (ob->depth == NULL) {
+        free(ob);
+        return NULL;
+    }
+    ob->width = width;
+    ob->height = height;
+
+    occlusion_buffer_clear(ob);
+
+    return ob;
+}
+
+void occlusion_buffer_free(OcclusionBuffer *ob) {
+    if (ob == NULL) {
+        return;
+    }
+    free(ob->depth);
+    free(ob);
+}
+
+uint16_t occlusion_buffer_get_width(const OcclusionBuffer *ob) {
+    return ob->width;
+}
+
+uint16_t occlusion_buffer_get_height(const OcclusionBuffer *ob) {
+    return ob->height;
+}
+
+void occlusion_buffer_clear(OcclusionBuffer *ob) {
+    const size_t size = (size_t)ob->width * ob->height;
+    for (size_t i = 0; i < size; ++i) {
+        ob->depth[i] = FLT_MAX;
+    }
+}
+
+// MARK: - Occluders & occludees -
+
+bool occlusion_buffer_add_occluder(OcclusionBuffer *ob, const Matrix4x4 *mvp, const Box *box) {
+    float3 corners[8];
+    if (_occlusion_buffer_project_box(ob, mvp, box, corners) == false) {
+        return false;
+    }
+
+    // coverage: pixels entirely inside the box silhouette ie. convex hull of its corners
+    float3 hull[8];
+    const int nbHull = _occlusion_buffer_convex_hull(corners, hull);
+    if (nbHull < 3) {
+        return false;
+    }
+    float ha[8], hb[8], hc[8], hMargin[8];
+    for (int i = 0; i < nbHull; ++i) {
+        const float3 *from = &hull[i];
+        const float3 *to = &hull[(i + 1) % nbHull];
+        ha[i] = from->y - to->y;
+        hb[i] = to->x - from->x;
+        hc[i] = from->x * to->y - from->y * to->x;
+        // edge function minimum over a pixel is at pixel center minus this margin
+        hMargin[i] = .5f * (fabsf(ha[i]) + fabsf(hb[i]));
+    }
+
+    // depth: nearest surface is made of up to 3 front faces, a pixel gets the furthest depth of
+    // front faces touching it
+    float4 eye;
+    _occlusion_buffer_get_eye(mvp, &eye);
+    const float eyeBox[3] = {eye.x, eye.y, eye.z};
+    const float boxMin[3] = {box->min.x, box->min.y, box->min.z};
+    const float boxMax[3] = {box->max.x, box->max.y, box->max.z};
+
+    int nbFaces = 0;
+    float fa[3][4], fb[3][4], fc[3][4], fMargin[3][4];
+    float z0[3], dzdx[3], dzdy[3], zMargin[3], zMax[3];
+    float3 q0[3];
+    for (int axis = 0; axis < 3; ++axis) {
+        int side;
+        if (eyeBox[axis] < boxMin[axis] * eye.w) {
+            side = 0;
+        } else if (eyeBox[axis] > boxMax[axis] * eye.w) {
+            side = 1;
+        } else {
+            continue;
+        }
+
+        // face corners in cyclic order, as corner index bits (x, y, z)
+        const int bit = 1 << axis;
+        const int u = 1 << ((axis + 1) % 3);
+        const int v = 1 << ((axis + 2) % 3);
+        const int base = side ? bit : 0;
+        const float3 *q[4] = {&corners[base],
+                              &corners[base | u],
+                              &corners[base | u | v],
+                              &corners[base | v]};
+
+        const float area = (q[1]->x - q[0]->x) * (q[2]->y - q[0]->y) -
+                           (q[2]->x - q[0]->x) * (q[1]->y - q[0]->y);
+        if (float_isZero(area, EPSILON_ZERO)) {
+            // seen from the edge, covers no pixel on its own
+            continue;
+        }
+        const float sign = area > 0.0f ? 1.0f : -1.0f;
+
+        for (int i = 0; i < 4; ++i) {
+            const float3 *from = q[i];
+            const float3 *to = q[(i + 1) % 4];
+            fa[nbFaces][i] = sign * (from->y - to->y);
+            fb[nbFaces][i] = sign * (to->x - from->x);
+            fc[nbFaces][i] = sign * (from->x * to->y - from->y * to->x);
+            fMargin[nbFaces][i] = .5f * (fabsf(fa[nbFaces][i]) + fabsf(fb[nbFaces][i]));
+        }
+
+        // depth plane, its maximum over a pixel is at pixel center plus a margin
+        q0[nbFaces] = *q[0];
+        z0[nbFaces] = q[0]->z;
+        dzdx[nbFaces] = ((q[1]->z - q[0]->z) * (q[2]->y - q[0]->y) -
+                         (q[2]->z - q[0]->z) * (q[1]->y - q[0]->y)) /
+                        area;
+        dzdy[nbFaces] = ((q[2]->z - q[0]->z) * (q[1]->x - q[0]->x) -
+                         (q[1]->z - q[0]->z) * (q[2]->x - q[0]->x)) /
+                        area;
+        zMargin[nbFaces] = .5f * (fabsf(dzdx[nbFaces]) + fabsf(dzdy[nbFaces]));
+        zMax[nbFaces] = maximum(maximum(q[0]->z, q[1]->z), maximum(q[2]->z, q[3]->z));
+        ++nbFaces;
+    }
+    if (nbFaces == 0) {
+        return false;
+    }
+
+    float3 min = hull[0], max = hull[0];
+    for (int i = 1; i < nbHull; ++i) {
+        min.x = minimum(min.x, hull[i].x);
+        min.y = minimum(min.y, hull[i].y);
+        max.x = maximum(max.x, hull[i].x);
+        max.y = maximum(max.y, hull[i].y);
+    }
+    const int x0 = maximum((int)floorf(min.x), 0);
+    const int y0 = maximum((int)floorf(min.y), 0);
+    const int x1 = minimum((int)ceilf(max.x), (int)ob->width);
+    const int y1 = minimum((int)ceilf(max.y), (int)ob->height);
+
+    float px, py, z, faceZ;
+    float *row;
+    bool inside;
+    for (int y = y0; y < y1; ++y) {
+        py = (float)y + .5f;
+        row = ob->depth + y * ob->width;
+        for (int x = x0; x < x1; ++x) {
+            px = (float)x + .5f;
+
+            inside = true;
+            for (int i = 0; i < nbHull && inside; ++i) {
+                inside = ha[i] * px + hb[i] * py + hc[i] >= hMargin[i];
+            }
+            if (inside == false) {
+                continue;
+            }
+
+            z = -FLT_MAX;
+            for (int f = 0; f < nbFaces; ++f) {
+                // face touches the pixel
+                inside = true;
+                for (int i = 0; i < 4 && inside; ++i) {
+                    inside = fa[f][i] * px + fb[f][i] * py + fc[f][i] + fMargin[f][i] >= 0.0f;
+                }
+                if (inside) {
+                    faceZ = z0[f] + dzdx[f] * (px - q0[f].x) + dzdy[f] * (py - q0[f].y);
+                    z = maximum(z, minimum(faceZ + zMargin[f], zMax[f]));
+                }
+            }
+
+            if (z > -FLT_MAX && z < row[x]) {
+                row[x] = z;
+            }
+        }
+    }
+    return true;
+}
+
+bool occlusion_buffer_is_box_occluded(const OcclusionBuffer *ob,
+                                      const Matrix4x4 *mvp,
+                                      const Box *box) {
+    float3 corners[8];
+    if (_occlusion_buffer_project_box(ob, mvp, box, corners) == false) {
+        return false;
+    }
+
+    float3 min = corners[0], max = corners[0];
+    for (int i = 1; i < 8; ++i) {
+        min.x = minimum(min.x, corners[i].x);
+        min.y = minimum(min.y, corners[i].y);
+        min.z = minimum(min.z, corners[i].z);
+        max.x = maximum(max.x, corners[i].x);
+        max.y = maximum(max.y, corners[i].y);
+    }
+
+    // every pixel touched by the screen rectangle
+    const int x0 = maximum((int)floorf(min.x), 0);
+    const int y0 = maximum((int)floorf(min.y), 0);
+    const int x1 = minimum((int)ceilf(max.x), (int)ob->width);
+    const int y1 = minimum((int)ceilf(max.y), (int)ob->height);
+    if (x0 >= x1 || y0 >= y1) {
+        // off-screen, left for frustum culling to decide
+        return false;
+    }
+
+    const float *row;
+    for (int y = y0; y < y1; ++y) {
+        row = ob->depth + y * ob->width;
+        for (int x = x0; x < x1; ++x) {
+            if (row[x] >= min.z) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// MARK: - Private functions -
+
+bool _occlusion_buffer_project_box(const OcclusionBuffer *ob,
+                                   const Matrix4x4 *mvp,
+                                   const Box *box,
+                                   float3 *corners) {
+    const float halfWidth = .5f * (float)ob->width;
+    const float halfHeight = .5f * (float)ob->height;
+
+    float4 p, clip;
+    p.w = 1.0f;
+    for (int i = 0; i < 8; ++i) {
+        p.x = (i & 1) ? box->max.x : box->min.x;
+        p.y = (i & 2) ? box->max.y : box->min.y;
+        p.z = (i & 4) ? box->max.z : box->min.z;
+        matrix4x4_op_multiply_vec(&clip, &p, mvp);
+
+        if (clip.w < OCCLUSION_BUFFER_MIN_W) {
+            return false;
+        }
+        corners[i].x = (clip.x / clip.w + 1.0f) * halfWidth;
+        corners[i].y = (clip.y / clip.w + 1.0f) * halfHeight;
+        corners[i].z = clip.z / clip.w;
+    }
+    return true;
+}
+
+void _occlusion_buffer_get_eye(const Matrix4x4 *m, float4 *eye) {
+    // camera center projects to clip x = y = w = 0, it is the cross product of these 3 rows
+    const float r1[4] = {m->x1y1, m->x2y1, m->x3y1, m->x4y1};
+    const float r2[4] = {m->x1y2, m->x2y2, m->x3y2, m->x4y2};
+    const float r4[4] = {m->x1y4, m->x2y4, m->x3y4, m->x4y4};
+    float c[4];
+    for (int i = 0; i < 4; ++i) {
+        const int j = (i + 1) % 4, k = (i + 2) % 4, l = (i + 3) % 4;
+        const float minor = r1[j] * (r2[k] * r4[l] - r2[l] * r4[k]) -
+                            r1[k] * (r2[j] * r4[l] - r2[l] * r4[j]) +
+                            r1[l] * (r2[j] * r4[k] - r2[k] * r4[j]);
+        c[i] = (i % 2 == 0) ? minor : -minor;
+    }
+
+    float sign;
+    if (float_isZero(c[3], EPSILON_ZERO) == false) {
+        sign = c[3] > 0.0f ? 1.0f : -1.0f;
+    } else {
+        // orthographic: toward the camera is where depth decreases
+        const float dz = m->x1y3 * c[0] + m->x2y3 * c[1] + m->x3y3 * c[2];
+        sign = dz < 0.0f ? 1.0f : -1.0f;
+    }
+    eye->x = sign * c[0];
+    eye->y = sign * c[1];
+    eye->z = sign * c[2];
+    eye->w = sign * c[3];
+}
+
+int _occlusion_buffer_convex_hull(const float3 *corners, float3 *hull) {
+    // monotone chain
+    float3 sorted[8];
+    for (int i = 0; i < 8; ++i) {
+        int j = i;
+        while (j > 0 && (sorted[j - 1].x > corners[i].x ||
+                         (sorted[j - 1].x == corners[i].x && sorted[j - 1].y > corners[i].y))) {
+            sorted[j] = sorted[j - 1];
+            --j;
+        }
+        sorted[j] = corners[i];
+    }
+
+    float3 chain[16];
+    int n = 0;
+    for (int pass = 0; pass < 2; ++pass) {
+        const int start = n;
+        for (int k = 0; k < 8; ++k) {
+            const float3 *p = &sorted[pass == 0 ? k : 7 - k];
+            while (n >= start + 2 &&
+                   (chain[n - 1].x - chain[n - 2].x) * (p->y - chain[n - 2].y) -
+                           (chain[n - 1].y - chain[n - 2].y) * (p->x - chain[n - 2].x) <=
+                       0.0f) {
+                --n;
+            }
+            chain[n++] = *p;
+        }
+        // last point is the first of the other chain
+        --n;
+    }
+
+    for (int i = 0; i < n; ++i) {
+        hull[i] = chain[i];
+    }
+    return n;
+}
@@ -0,0 +1,48 @@
+// -------------------------------------------------------------
+//  Cubzh Core
+//  occlusion_buffer.h
+//  Created by agent on October 19, 2026.
+// -------------------------------------------------------------
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "box.h"
+#include "matrix4x4.h"
+
+/// Low resolution depth buffer rasterized on CPU, used to discard boxes hidden behind large opaque
+/// boxes (occluders) before submitting them for draw.
+/// - occluders only write pixels they cover entirely, with their furthest depth over the pixel
+/// - a box is occluded only if all pixels its screen rectangle touches are nearer than the box
+/// - boxes crossing the near plane are never occluders nor occluded
+/// This makes the test conservative: an occluded box is never visible, some hidden boxes may be
+/// reported visible. Depth is NDC z, expecting a depth range where nearer is smaller.
+typedef struct _OcclusionBuffer OcclusionBuffer;
+
+OcclusionBuffer *occlusion_buffer_new(uint16_t width, uint16_t height);
+void occlusion_buffer_free(OcclusionBuffer *ob);
+
+uint16_t occlusion_buffer_get_width(const OcclusionBuffer *ob);
+uint16_t occlusion_buffer_get_height(const OcclusionBuffer *ob);
+
+/// Resets all pixels to the far depth, to be called before adding occluders for a new frame
+void occlusion_buffer_clear(OcclusionBuffer *ob);
+
+/// Rasterizes a box that must be entirely opaque, `mvp` transforms box space to clip space
+/// @returns false if box could not be used as an occluder
+bool occlusion_buffer_add_occluder(OcclusionBuffer *ob, const Matrix4x4 *mvp, const Box *box);
+
+/// @returns true if box is entirely hidden behind occluders added since last clear
+bool occlusion_buffer_is_box_occluded(const OcclusionBuffer *ob,
+                                      const Matrix4x4 *mvp,
+                                      const Box *box);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
@@ -71,6 +71,17 @@ uint32_t nb_elements_for_levels(const size_t levels);
 size_t octree_element_index_1d(const Octree *octree, size_t x, size_t y, size_t z);
 void *_octree_set_element(const Octree *octree, const void *element, size_t x, size_t y, size_t z);
 static Octree *_octree_new(void);
+static void _octree_node_set_branch(OctreeNode *node, const int branch);
+
+// offsets of each branch (index in branch), see octree_set_element
+static const uint8_t branchOffsets[8][3] = {{0, 0, 0},
+                                            {1, 0, 0},
+                                            {1, 0, 1},
+                                            {0, 0, 1},
+                                            {0, 1, 0},
+                                            {1, 1, 0},
+                                            {1, 1, 1},
+                                            {0, 1, 1}};
 
 Octree *octree_new_with_default_element(const OctreeLevelsForSize levels,
                                         const void *element,
@@ -254,6 +265,59 @@ bool octree_set_element(const Octree *octree, const void *element, size_t x, siz
     return true;
 }
 
+void octree_set_elements(Octree *octree, const void *elements, const void *emptyElement) {
+    memcpy(octree->elements, elements, octree->elements_size_in_memory);
+    memset(octree->nodes, 0, octree->nodes_size_in_memory);
+    if (octree->levels == 0) {
+        return;
+    }
+
+    OctreeNode *nodes = (OctreeNode *)octree->nodes;
+    const size_t dimension = octree->width_height_depth;
+    const uint8_t deepest = octree->levels - 1;
+
+    // deepest nodes branches point to elements, relative node index digits (base 8) being the
+    // branches taken from root
+    const uint32_t nbDeepest = (uint32_t)1 << (3 * deepest);
+    const char *element;
+    for (uint32_t i = 0; i < nbDeepest; ++i) {
+        size_t x = 0, y = 0, z = 0;
+        for (uint8_t level = 0; level < deepest; ++level) {
+            const uint32_t branch = (i >> (3 * (deepest - 1 - level))) & 7;
+            const size_t half = dimension >> (level + 1);
+            x += branchOffsets[branch][0] * half;
+            y += branchOffsets[branch][1] * half;
+            z += branchOffsets[branch][2] * half;
+        }
+        OctreeNode *node = nodes + startIndexForLevel[deepest] + i;
+        for (int branch = 0; branch < 8; ++branch) {
+            element = (const char *)elements +
+                      octree->element_size *
+                          octree_element_index_1d(octree,
+                                                  x + branchOffsets[branch][0],
+                                                  y + branchOffsets[branch][1],
+                                                  z + branchOffsets[branch][2]);
+            if (memcmp(element, emptyElement, octree->element_size) != 0) {
+                _octree_node_set_branch(node, branch);
+            }
+        }
+    }
+
+    // then each level from its children
+    for (int level = (int)deepest - 1; level >= 0; --level) {
+        const uint32_t nbNodes = (uint32_t)1 << (3 * level);
+        for (uint32_t i = 0; i < nbNodes; ++i) {
+            OctreeNode *node = nodes + startIndexForLevel[level] + i;
+            const OctreeNode *children = nodes + startIndexForLevel[level + 1] + 8 * i;
+            for (int branch = 0; branch < 8; ++branch) {
+                if (*(const uint8_t *)(children + branch) != 0) {
+                    _octree_node_set_branch(node, branch);
+                }
+            }
+        }
+    }
+}
+
 bool octree_remove_element(const Octree *octree, size_t x, size_t y, size_t z, void *emptyElement) {
     if (x >= octree->width_height_depth || y >= octree->width_height_depth ||
         z >= octree->width_height_depth) {
@@ -1260,6 +1324,35 @@ bool octree_iterator_is_done(const OctreeIterator *oi) {
 // MARK: - static functions -
 //
 
+static void _octree_node_set_branch(OctreeNode *node, const int branch) {
+    switch (branch) {
+        case 0:
+            node->n000 = 1;
+            break;
+        case 1:
+            node->n100 = 1;
+            break;
+        case 2:
+            node->n101 = 1;
+            break;
+        case 3:
+            node->n001 = 1;
+            break;
+        case 4:
+            node->n010 = 1;
+            break;
+        case 5:
+            node->n110 = 1;
+            break;
+        case 6:
+            node->n111 = 1;
+            break;
+        default:
+            node->n011 = 1;
+            break;
+    }
+}
+
 /// Allocates an Octree structure and return its address.
 static Octree *_octree_new(void) {
     Octree *o = (Octree *)malloc(sizeof(Octree));
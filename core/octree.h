@@ -66,6 +66,11 @@ bool octree_set_element(const Octree *octree, const void *element, size_t x, siz
 
 bool octree_remove_element(const Octree *octree, size_t x, size_t y, size_t z, void *emptyElement);
 
+/// Replaces all elements at once w/ `elements`, a flat array of dimension^3 elements indexed
+/// (z * dimension + y) * dimension + x, then builds all nodes bottom-up. Elements equal to
+/// `emptyElement` are considered empty. Faster than setting elements one by one to fill an octree.
+void octree_set_elements(Octree *octree, const void *elements, const void *emptyElement);
+
 void octree_log(const Octree *octree);
 
 void octree_non_recursive_iteration(const Octree *octree);
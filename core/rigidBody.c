@@ -28,6 +28,21 @@ static int debug_rigidbody_sleeps = 0;
 static int debug_rigidbody_awakes = 0;
 #endif
 
+// solid blocks of a per-block shape around a dynamic rigidbody trajectory, reused by the solver
+// as long as the trajectory stays within `region` and these blocks are unchanged
+typedef struct {
+    // handle to the transform of the shape the blocks belong to, TRANSFORM_HANDLE_NONE if unused,
+    // stale once the shape is freed
+    TransformHandle shape;
+    // model space region in which all solid blocks are listed
+    Box region;
+    // model coordinates of solid blocks within region
+    SHAPE_COORDS_INT3_T blocks[PHYSICS_CONTACT_CACHE_MAX_BLOCKS];
+    uint32_t nbBlocks;
+    // shape blocks stamp as of last check
+    uint32_t stamp;
+} _ContactCache;
+
 struct _RigidBody {
     // collider axis-aligned box, may be arbitrary or similar to the axis-aligned bounding box
     Box *collider;
@@ -47,6 +62,9 @@ struct _RigidBody {
     // last known valid position
     float3 *checkpoint;
 
+    // per-block shapes contacts, created on first per-block collision (NULL if none)
+    _ContactCache *contactCache;
+
     // combined friction of 2 surfaces in contact represents how much force is absorbed,
     // it is a rate between 0 (full stop on contact) and 1 (full slide, no friction), or
     // below 0 (inverted movement) and above 1 (amplified movement)
@@ -75,8 +93,10 @@ struct _RigidBody {
     // [5-7] <unused>
     uint8_t simulationFlags;
     uint8_t awakeFlag;
+    // contact cache entry to be replaced next
+    uint8_t contactCacheNext;
 
-    char pad[5];
+    char pad[4];
 };
 
 static pointer_rigidbody_collision_func rigidbody_collision_callback = NULL;
@@ -425,15 +445,12 @@ bool _rigidbody_dynamic_tick(Scene *scene,
                     if (box_collide_epsilon3(&modelBroadphase, &collider, &modelEpsilon)) {
                         // shapes may enable per-block collisions
                         if (hitPerBlock) {
-                            swept = shape_box_cast(shape,
-                                                   &modelBox,
-                                                   &modelDv,
-                                                   &modelEpsilon,
-                                                   true,
-                                                   &normal,
-                                                   NULL,
-                                                   NULL,
-                                                   NULL);
+                            swept = rigidbody_cached_box_cast(rb,
+                                                              shape,
+                                                              &modelBox,
+                                                              &modelDv,
+                                                              &modelEpsilon,
+                                                              &normal);
                         } else {
                             swept = box_swept(&modelBox,
                                               &modelDv,
@@ -936,6 +953,8 @@ RigidBody *rigidbody_new(const uint8_t mode, const uint16_t groups, const uint16
     rb->velocity = float3_new_zero();
     rb->constantAcceleration = float3_new_zero();
     rb->checkpoint = NULL;
+    rb->contactCache = NULL;
+    rb->contactCacheNext = 0;
     rb->mass = PHYSICS_MASS_DEFAULT;
     rb->contact = AxesMaskNone;
     rb->groups = groups;
@@ -977,6 +996,8 @@ RigidBody *rigidbody_new_copy(const RigidBody *other) {
     rb->velocity = float3_new_zero();
     rb->constantAcceleration = float3_new_copy(other->constantAcceleration);
     rb->checkpoint = other->checkpoint != NULL ? float3_new_copy(other->checkpoint) : NULL;
+    rb->contactCache = NULL;
+    rb->contactCacheNext = 0;
     rb->mass = other->mass;
     rb->contact = AxesMaskNone;
     rb->groups = other->groups;
@@ -1017,6 +1038,7 @@ void rigidbody_free(RigidBody *rb) {
     }
     free(rb->friction);
     free(rb->bounciness);
+    free(rb->contactCache);
 
     free(rb);
 }
@@ -1455,6 +1477,113 @@ void rigidbody_broadphase_world_to_model(const Matrix4x4 *invModel,
     *outEpsilon3 = float3_mmax2(outEpsilon3, &float3_epsilon_zero);
 }
 
+float rigidbody_cached_box_cast(RigidBody *rb,
+                                Shape *shape,
+                                const Box *modelBox,
+                                const float3 *modelDv,
+                                const float3 *modelEpsilon,
+                                float3 *normal) {
+    // fast bodies advance through empty space, blocks around their trajectory aren't worth caching
+    if (float3_length(modelDv) > SHAPE_CAST_ADVANCEMENT_DISTANCE) {
+        return shape_box_cast(shape,
+                              modelBox,
+                              modelDv,
+                              modelEpsilon,
+                              true,
+                              normal,
+                              NULL,
+                              NULL,
+                              NULL);
+    }
+
+    Box broadphase;
+    box_set_broadphase_box(modelBox, modelDv, &broadphase);
+
+    if (rb->contactCache == NULL) {
+        rb->contactCache = (_ContactCache *)calloc(PHYSICS_CONTACT_CACHE_SHAPES,
+                                                   sizeof(_ContactCache));
+        if (rb->contactCache == NULL) {
+            return shape_box_cast(shape,
+                                  modelBox,
+                                  modelDv,
+                                  modelEpsilon,
+                                  true,
+                                  normal,
+                                  NULL,
+                                  NULL,
+                                  NULL);
+        }
+    }
+
+    const TransformHandle handle = transform_get_handle(shape_get_transform(shape));
+    _ContactCache *cache = NULL;
+    for (uint8_t i = 0; i < PHYSICS_CONTACT_CACHE_SHAPES; ++i) {
+        if (rb->contactCache[i].shape == handle) {
+            cache = &rb->contactCache[i];
+            break;
+        }
+    }
+
+    bool valid = false;
+    if (cache != NULL) {
+        valid = box_contains(&cache->region, &broadphase.min) &&
+                box_contains(&cache->region, &broadphase.max) &&
+                shape_blocks_changed_in_box(shape, &cache->region, cache->stamp) == false;
+    } else {
+        cache = &rb->contactCache[rb->contactCacheNext];
+        rb->contactCacheNext = (uint8_t)((rb->contactCacheNext + 1) % PHYSICS_CONTACT_CACHE_SHAPES);
+        cache->shape = handle;
+    }
+
+    if (valid == false) {
+        cache->region = broadphase;
+        float3_op_substract_scalar(&cache->region.min, PHYSICS_CONTACT_CACHE_MARGIN);
+        float3_op_add_scalar(&cache->region.max, PHYSICS_CONTACT_CACHE_MARGIN);
+        cache->nbBlocks = shape_get_solid_blocks_in_box(shape,
+                                                        &cache->region,
+                                                        cache->blocks,
+                                                        PHYSICS_CONTACT_CACHE_MAX_BLOCKS);
+
+        // too many blocks around, fallback to regular cast
+        if (cache->nbBlocks > PHYSICS_CONTACT_CACHE_MAX_BLOCKS) {
+            cache->shape = TRANSFORM_HANDLE_NONE;
+            return shape_box_cast(shape,
+                                  modelBox,
+                                  modelDv,
+                                  modelEpsilon,
+                                  true,
+                                  normal,
+                                  NULL,
+                                  NULL,
+                                  NULL);
+        }
+    }
+    cache->stamp = shape_get_blocks_stamp(shape);
+
+    float3_set_one(normal);
+
+    float minSwept = 1.0f, swept;
+    float3 tmpNormal;
+    Box blockBox;
+    for (uint32_t i = 0; i < cache->nbBlocks; ++i) {
+        blockBox.min = (float3){(float)cache->blocks[i].x,
+                                (float)cache->blocks[i].y,
+                                (float)cache->blocks[i].z};
+        blockBox.max = (float3){blockBox.min.x + 1.0f,
+                                blockBox.min.y + 1.0f,
+                                blockBox.min.z + 1.0f};
+        if (box_collide_epsilon(&blockBox, &broadphase, EPSILON_COLLISION) == false) {
+            continue;
+        }
+        swept = box_swept(modelBox, modelDv, &blockBox, modelEpsilon, true, &tmpNormal, NULL);
+        if (swept < minSwept) {
+            minSwept = swept;
+            *normal = tmpNormal;
+        }
+    }
+    return minSwept;
+}
+
 // MARK: - Callbacks -
 
 void rigidbody_set_collision_callback(pointer_rigidbody_collision_func f) {
@@ -33,6 +33,7 @@ extern "C" {
 typedef struct _RigidBody RigidBody;
 typedef struct _Transform Transform;
 typedef struct _Scene Scene;
+typedef struct _Shape Shape;
 
 static const float3 float3_epsilon_zero = {EPSILON_ZERO, EPSILON_ZERO, EPSILON_ZERO};
 static const float3 float3_epsilon_collision = {EPSILON_COLLISION,
@@ -163,6 +164,14 @@ void rigidbody_broadphase_world_to_model(const Matrix4x4 *invModel,
                                          float3 *outVector,
                                          float epsilon,
                                          float3 *outEpsilon3);
+/// Per-block shape cast, same as shape_box_cast w/ replacement, using solid blocks around the
+/// trajectory cached in `rb` between frames
+float rigidbody_cached_box_cast(RigidBody *rb,
+                                Shape *shape,
+                                const Box *modelBox,
+                                const float3 *modelDv,
+                                const float3 *modelEpsilon,
+                                float3 *normal);
 
 /// MARK: - Callbacks -
 void rigidbody_set_collision_callback(pointer_rigidbody_collision_func f);
@@ -13,6 +13,9 @@
 #include "shape.h"
 #include "transform.h"
 
+// nodes kept by the traversal queue reused by queries, covering the widest levels of most trees
+#define RTREE_QUERY_QUEUE_RECYCLED_MAX 256
+
 #if DEBUG_RTREE
 static int debug_rtree_insert_calls = 0;
 static int debug_rtree_split_calls = 0;
@@ -33,6 +36,9 @@ struct _Rtree {
     uint8_t M;
 
     char pad[4];
+
+    // traversal queue reused by queries, NULL while taken by a query
+    FifoList *queryQueue;
 };
 
 struct _RtreeNode {
@@ -59,9 +65,26 @@ struct _RtreeNode {
 
 void _rtree_node_assign(RtreeNode *parent, RtreeNode *child, bool merge);
 void _rtree_node_free(RtreeNode *rn);
+FifoList *_rtree_take_query_queue(Rtree *r);
+void _rtree_give_back_query_queue(Rtree *r, FifoList *queue);
 
 // MARK: - Private functions -
 
+// queries may run from within other queries' callbacks, those get their own queue
+FifoList *_rtree_take_query_queue(Rtree *r) {
+    FifoList *queue = r->queryQueue;
+    r->queryQueue = NULL;
+    return queue != NULL ? queue : fifo_list_new();
+}
+
+void _rtree_give_back_query_queue(Rtree *r, FifoList *queue) {
+    if (r->queryQueue == NULL) {
+        r->queryQueue = queue;
+    } else {
+        fifo_list_free(queue, NULL);
+    }
+}
+
 RtreeNode *_rtree_node_new_root(Rtree *r) {
     RtreeNode *rn = (RtreeNode *)malloc(sizeof(RtreeNode));
     if (rn == NULL) {
@@ -503,6 +526,8 @@ Rtree *rtree_new(uint8_t m, uint8_t M) {
     r->h = 0;
     r->m = m;
     r->M = M;
+    r->queryQueue = fifo_list_new();
+    fifo_list_set_recycled_max(r->queryQueue, RTREE_QUERY_QUEUE_RECYCLED_MAX);
 
     _rtree_node_new_root(r);
 
@@ -511,6 +536,9 @@ Rtree *rtree_new(uint8_t m, uint8_t M) {
 
 void rtree_free(Rtree *r) {
     rtree_recurse(r->root, _rtree_node_free);
+    if (r->queryQueue != NULL) {
+        fifo_list_free(r->queryQueue, NULL);
+    }
     free(r);
 }
 
@@ -784,7 +812,7 @@ size_t rtree_query_overlap_func(Rtree *r,
                                 FifoList *results,
                                 const float3 *epsilon) {
 
-    FifoList *toExamine = fifo_list_new();
+    FifoList *toExamine = _rtree_take_query_queue(r);
     DoublyLinkedListNode *n;
     RtreeNode *rn, *child;
     size_t hits = 0;
@@ -818,7 +846,7 @@ size_t rtree_query_overlap_func(Rtree *r,
         rn = (RtreeNode *)fifo_list_pop(toExamine);
     }
 
-    fifo_list_free(toExamine, NULL);
+    _rtree_give_back_query_queue(r, toExamine);
 
     return hits;
 }
@@ -854,7 +882,7 @@ size_t rtree_query_cast_all_func(Rtree *r,
                                  DoublyLinkedList *results) {
     vx_assert(results != NULL);
 
-    FifoList *toExamine = fifo_list_new();
+    FifoList *toExamine = _rtree_take_query_queue(r);
     DoublyLinkedListNode *n;
     RtreeNode *rn, *child;
     size_t hits = 0;
@@ -893,7 +921,7 @@ size_t rtree_query_cast_all_func(Rtree *r,
         rn = (RtreeNode *)fifo_list_pop(toExamine);
     }
 
-    fifo_list_free(toExamine, NULL);
+    _rtree_give_back_query_queue(r, toExamine);
 
     return hits;
 }
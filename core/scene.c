@@ -11,6 +11,9 @@
 
 #include "weakptr.h"
 
+// nodes kept by the hierarchy traversal queue, covering the widest levels of most scenes
+#define SCENE_REFRESH_QUEUE_RECYCLED_MAX 8192
+
 #if DEBUG_SCENE
 static int debug_scene_awake_queries = 0;
 #endif
@@ -36,6 +39,9 @@ struct _Scene {
     // awake volumes can be registered for end-of-frame awake phase
     DoublyLinkedList *awakeBoxes;
 
+    // hierarchy traversal queue used in scene_refresh, kept to reuse its nodes every frame
+    FifoList *toExamine;
+
     // constant acceleration for the whole Scene (gravity usually)
     float3 constantAcceleration;
 
@@ -148,6 +154,8 @@ Scene *scene_new(Weakptr *g) {
         sc->recursionLocked = fifo_list_new();
         sc->collisions = doubly_linked_list_new();
         sc->awakeBoxes = doubly_linked_list_new();
+        sc->toExamine = fifo_list_new();
+        fifo_list_set_recycled_max(sc->toExamine, SCENE_REFRESH_QUEUE_RECYCLED_MAX);
         float3_set(&sc->constantAcceleration, 0.0f, 0.0f, 0.0f);
         sc->recursionLockCount = 0;
 
@@ -187,6 +195,7 @@ void scene_free(Scene *sc) {
     doubly_linked_list_free(sc->collisions);
     doubly_linked_list_flush(sc->awakeBoxes, box_free_std);
     doubly_linked_list_free(sc->awakeBoxes);
+    fifo_list_free(sc->toExamine, NULL);
 
     free(sc);
 }
@@ -229,7 +238,7 @@ void scene_refresh(Scene *sc, const TICK_DELTA_SEC_T dt, void *callbackData) {
     cclog_debug("🏞 physics step");
 #endif
 
-    FifoList *toExamine = fifo_list_new();
+    FifoList *toExamine = sc->toExamine;
     Transform *t = sc->root, *child = NULL;
     DoublyLinkedListNode *n;
     while (t != NULL) {
@@ -282,7 +291,6 @@ void scene_refresh(Scene *sc, const TICK_DELTA_SEC_T dt, void *callbackData) {
 
         t = (Transform *)fifo_list_pop(toExamine);
     }
-    fifo_list_free(toExamine, NULL);
 
 #if DEBUG_RTREE_CHECK
     vx_assert(debug_rtree_integrity_check(sc->rtree));
@@ -659,11 +667,11 @@ HitType scene_cast_ray(Scene *sc,
                        rigidbody_uses_per_block_collisions(transform_get_rigidbody(hitTr))) {
 
                 CastResult blockHit;
-                Block *b = scene_cast_ray_shape_only(sc,
-                                                     hitTr,
-                                                     transform_utils_get_shape(hitTr),
-                                                     worldRay,
-                                                     &blockHit);
+                const Block *b = scene_cast_ray_shape_only(sc,
+                                                           hitTr,
+                                                           transform_utils_get_shape(hitTr),
+                                                           worldRay,
+                                                           &blockHit);
                 if (b != NULL && blockHit.distance < hit.distance) {
                     hit = blockHit;
                 }
@@ -807,11 +815,11 @@ size_t scene_cast_all_ray(Scene *sc,
     return count;
 }
 
-Block *scene_cast_ray_shape_only(Scene *sc,
-                                 const Transform *t,
-                                 const Shape *sh,
-                                 const Ray *worldRay,
-                                 CastResult *result) {
+const Block *scene_cast_ray_shape_only(Scene *sc,
+                                       const Transform *t,
+                                       const Shape *sh,
+                                       const Ray *worldRay,
+                                       CastResult *result) {
     CastResult hit = scene_cast_result_default();
 
     if (result != NULL) {
@@ -917,7 +925,7 @@ HitType scene_cast_box(Scene *sc,
                 if (box_collide_epsilon3(&modelBroadphase, collider, &modelEpsilon)) {
                     // shapes may enable per-block collisions
                     if (hitShape != NULL && rigidbody_uses_per_block_collisions(hitRb)) {
-                        Block *block = NULL;
+                        const Block *block = NULL;
                         SHAPE_COORDS_INT3_T blockCoords;
                         float3 normal;
                         const float swept = shape_box_cast(hitShape,
@@ -1058,7 +1066,7 @@ size_t scene_cast_all_box(Scene *sc,
                 if (box_collide_epsilon3(&modelBroadphase, collider, &modelEpsilon)) {
                     // shapes may enable per-block collisions
                     if (hitShape != NULL && rigidbody_uses_per_block_collisions(hitRb)) {
-                        Block *block = NULL;
+                        const Block *block = NULL;
                         SHAPE_COORDS_INT3_T blockCoords;
                         float3 normal;
                         const float swept = shape_box_cast(hitShape,
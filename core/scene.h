@@ -109,7 +109,7 @@ typedef enum {
 
 typedef struct {
     Transform *hitTr;
-    Block *block;
+    const Block *block;
     float distance;
     HitType type;
     SHAPE_COORDS_INT3_T blockCoords;
@@ -136,11 +136,11 @@ size_t scene_cast_all_ray(Scene *sc,
                           uint16_t groups,
                           const DoublyLinkedList *filterOutTransforms,
                           DoublyLinkedList *results);
-Block *scene_cast_ray_shape_only(Scene *sc,
-                                 const Transform *t,
-                                 const Shape *sh,
-                                 const Ray *worldRay,
-                                 CastResult *result);
+const Block *scene_cast_ray_shape_only(Scene *sc,
+                                       const Transform *t,
+                                       const Shape *sh,
+                                       const Ray *worldRay,
+                                       CastResult *result);
 HitType scene_cast_box(Scene *sc,
                        const Box *aabb,
                        const float3 *unit,
@@ -10,6 +10,7 @@
 #include <string.h>
 
 #include "cclog.h"
+#include "hash_uint32_int.h"
 #include "serialization_v5.h"
 #include "serialization_v6.h"
 #include "serialization_vox.h"
@@ -221,7 +222,8 @@ bool serialization_load_assets(Stream *stream,
             }
             break;
         }
-        case 6: {
+        case 6:
+        case 7: { // 6 w/ shape payload filters
             *out = serialization_load_assets_v6(stream, colorAtlas, filter, shapeSettings);
             break;
         }
@@ -370,6 +372,7 @@ bool get_preview_data(const char *filepath, void **imageData, uint32_t *size) {
             success = serialization_v5_get_preview_data(s, imageData, size);
             break;
         case 6:
+        case 7:
             // cclog_info("get preview data v6 for file : %s", filepath);
             success = serialization_v6_get_preview_data(s, imageData, size);
             break;
@@ -425,13 +428,71 @@ void serialization_utils_writeUint32(void *dest, const uint32_t src, uint32_t *c
 
 // MARK: - Baked files -
 
+// re-baking stale chunks also re-bakes 1 chunk around them, using the next chunk as light source
+#define BAKED_STALE_MERGE_DISTANCE 3
+
+typedef struct {
+    SHAPE_COORDS_INT3_T min, max;
+} BakedStaleArea;
+
+/// Stale chunks are gathered in areas that are re-baked separately, chunks close enough for their
+/// re-baked areas to affect each other being merged in the same area
+typedef struct {
+    BakedStaleArea *areas;
+    uint32_t count;
+    uint32_t capacity;
+} BakedStaleAreas;
+
+bool _serialization_baked_stale_areas_close(const BakedStaleArea *a, const BakedStaleArea *b) {
+    // re-baked areas span whole columns, only x & z matter
+    return a->min.x <= b->max.x + BAKED_STALE_MERGE_DISTANCE &&
+           b->min.x <= a->max.x + BAKED_STALE_MERGE_DISTANCE &&
+           a->min.z <= b->max.z + BAKED_STALE_MERGE_DISTANCE &&
+           b->min.z <= a->max.z + BAKED_STALE_MERGE_DISTANCE;
+}
+
+bool _serialization_baked_add_stale(BakedStaleAreas *stale, const SHAPE_COORDS_INT3_T coords) {
+    BakedStaleArea area = {coords, coords};
+
+    // absorb all close areas, which can make the area close to other ones
+    uint32_t i = 0;
+    while (i < stale->count) {
+        const BakedStaleArea *other = &stale->areas[i];
+        if (_serialization_baked_stale_areas_close(&area, other)) {
+            area.min.x = minimum(area.min.x, other->min.x);
+            area.min.y = minimum(area.min.y, other->min.y);
+            area.min.z = minimum(area.min.z, other->min.z);
+            area.max.x = maximum(area.max.x, other->max.x);
+            area.max.y = maximum(area.max.y, other->max.y);
+            area.max.z = maximum(area.max.z, other->max.z);
+            stale->areas[i] = stale->areas[--stale->count];
+            i = 0;
+        } else {
+            ++i;
+        }
+    }
+
+    if (stale->count == stale->capacity) {
+        const uint32_t capacity = stale->capacity > 0 ? 2 * stale->capacity : 4;
+        BakedStaleArea *areas = (BakedStaleArea *)realloc(stale->areas,
+                                                          capacity * sizeof(BakedStaleArea));
+        if (areas == NULL) {
+            return false;
+        }
+        stale->areas = areas;
+        stale->capacity = capacity;
+    }
+    stale->areas[stale->count++] = area;
+    return true;
+}
+
 bool serialization_save_baked_file(const Shape *s, uint64_t hash, FILE *fd) {
     if (shape_uses_baked_lighting(s) == false) {
         return false;
     }
 
     // write baked file version
-    uint32_t version = 2;
+    uint32_t version = 3;
     if (fwrite(&version, sizeof(uint32_t), 1, fd) != 1) {
         cclog_error("baked file: failed to write version");
         return false;
@@ -439,6 +500,13 @@ bool serialization_save_baked_file(const Shape *s, uint64_t hash, FILE *fd) {
 
     // write shape hash
     if (fwrite(&hash, sizeof(uint64_t), 1, fd) != 1) {
+        cclog_error("baked file: failed to write shape hash");
+        return false;
+    }
+
+    // write palette lighting hash, chunks are validated individually
+    const uint32_t paletteHash = color_palette_get_lighting_hash(shape_get_palette(s));
+    if (fwrite(&paletteHash, sizeof(uint32_t), 1, fd) != 1) {
         cclog_error("baked file: failed to write palette hash");
         return false;
     }
@@ -461,6 +529,15 @@ bool serialization_save_baked_file(const Shape *s, uint64_t hash, FILE *fd) {
         const SHAPE_COORDS_INT3_T coords = chunk_utils_get_coords(origin);
         if (fwrite(&coords, sizeof(SHAPE_COORDS_INT3_T), 1, fd) != 1) {
             cclog_error("baked file: failed to write chunk coordinates");
+            index3d_iterator_free(it);
+            return false;
+        }
+
+        // write chunk hash
+        const uint64_t chunkHash = chunk_get_hash(chunk, 0);
+        if (fwrite(&chunkHash, sizeof(uint64_t), 1, fd) != 1) {
+            cclog_error("baked file: failed to write chunk hash");
+            index3d_iterator_free(it);
             return false;
         }
 
@@ -469,16 +546,20 @@ bool serialization_save_baked_file(const Shape *s, uint64_t hash, FILE *fd) {
         uLong compressedSize = compressBound(size);
         const void *uncompressedData = chunk_get_lighting_data(chunk);
         void *compressedData = malloc(compressedSize);
-        if (compress(compressedData, &compressedSize, uncompressedData, size) != Z_OK) {
+        if (compressedData == NULL ||
+            compress(compressedData, &compressedSize, uncompressedData, size) != Z_OK) {
             cclog_error("baked file: failed to compress lighting data");
             free(compressedData);
+            index3d_iterator_free(it);
             return false;
         }
 
         // write lighting data compressed size
-        if (fwrite(&compressedSize, sizeof(uint32_t), 1, fd) != 1) {
+        const uint32_t compressedSize32 = (uint32_t)compressedSize;
+        if (fwrite(&compressedSize32, sizeof(uint32_t), 1, fd) != 1) {
             cclog_error("baked file: failed to write lighting data compressed size");
             free(compressedData);
+            index3d_iterator_free(it);
             return false;
         }
 
@@ -486,6 +567,7 @@ bool serialization_save_baked_file(const Shape *s, uint64_t hash, FILE *fd) {
         if (fwrite(compressedData, compressedSize, 1, fd) != 1) {
             cclog_error("baked file: failed to write compressed lighting data");
             free(compressedData);
+            index3d_iterator_free(it);
             return false;
         }
 
@@ -558,13 +640,16 @@ bool serialization_load_baked_file(Shape *s, uint64_t expectedHash, FILE *fd) {
 
                 chunk = (Chunk *)index3d_get(chunks, coords.x, coords.y, coords.z);
                 if (chunk == NULL) {
-                    fseek(fd, compressedSize, SEEK_CUR);
+                    if (fseek(fd, compressedSize, SEEK_CUR) != 0) {
+                        cclog_error("baked file (v2): failed to skip chunk");
+                        return false;
+                    }
                     continue;
                 }
 
                 // read compressed lighting data
                 void *compressedData = malloc(compressedSize);
-                if (fread(compressedData, compressedSize, 1, fd) != 1) {
+                if (compressedData == NULL || fread(compressedData, compressedSize, 1, fd) != 1) {
                     cclog_error("baked file (v2): failed to read compressed lighting data");
                     free(compressedData);
                     return false;
@@ -602,9 +687,479 @@ bool serialization_load_baked_file(Shape *s, uint64_t expectedHash, FILE *fd) {
 
             return true;
         }
+        case 3: {
+            // read shape hash
+            uint64_t hash;
+            if (fread(&hash, sizeof(uint64_t), 1, fd) != 1) {
+                cclog_error("baked file (v3): failed to read shape hash");
+                return false;
+            }
+
+            // read palette lighting hash
+            uint32_t paletteHash;
+            if (fread(&paletteHash, sizeof(uint32_t), 1, fd) != 1) {
+                cclog_error("baked file (v3): failed to read palette hash");
+                return false;
+            }
+
+            // palette lighting properties affect all chunks
+            if (paletteHash != color_palette_get_lighting_hash(shape_get_palette(s))) {
+                cclog_info("baked file (v3): mismatched palette hash, skip");
+                return false;
+            }
+
+            // if whole shape hash matches, no need to validate each chunk
+            const bool validateChunks = hash != expectedHash;
+
+            // read number of chunks
+            uint32_t nbChunks;
+            if (fread(&nbChunks, sizeof(uint32_t), 1, fd) != 1) {
+                cclog_error("baked file (v3): failed to read number of chunks");
+                return false;
+            }
+
+            // read chunks, keeping track of the ones loaded and of the stale ones
+            Chunk *chunk;
+            Index3D *chunks = shape_get_chunks(s);
+            Index3D *loaded = index3d_new();
+            if (loaded == NULL) {
+                cclog_error("baked file (v3): failed to allocate loaded chunks index");
+                return false;
+            }
+            BakedStaleAreas stale = {NULL, 0, 0};
+            bool success = true;
+            const size_t size = (size_t)CHUNK_SIZE_CUBE * (size_t)sizeof(VERTEX_LIGHT_STRUCT_T);
+            for (uint32_t i = 0; i < nbChunks; ++i) {
+                // read chunk coordinates, hash & lighting data compressed size
+                SHAPE_COORDS_INT3_T coords;
+                uint64_t chunkHash;
+                uint32_t compressedSize;
+                if (fread(&coords, sizeof(SHAPE_COORDS_INT3_T), 1, fd) != 1 ||
+                    fread(&chunkHash, sizeof(uint64_t), 1, fd) != 1 ||
+                    fread(&compressedSize, sizeof(uint32_t), 1, fd) != 1) {
+                    cclog_error("baked file (v3): failed to read chunk header");
+                    success = false;
+                    break;
+                }
+
+                // removed or modified chunks need re-baking, along with their neighbors
+                chunk = (Chunk *)index3d_get(chunks, coords.x, coords.y, coords.z);
+                if (chunk == NULL || (validateChunks && chunk_get_hash(chunk, 0) != chunkHash)) {
+                    if (fseek(fd, compressedSize, SEEK_CUR) != 0) {
+                        cclog_error("baked file (v3): failed to skip chunk");
+                        success = false;
+                        break;
+                    }
+                    if (_serialization_baked_add_stale(&stale, coords) == false) {
+                        cclog_error("baked file (v3): failed to allocate stale areas");
+                        success = false;
+                        break;
+                    }
+                    continue;
+                }
+
+                // read compressed lighting data
+                void *compressedData = malloc(compressedSize);
+                if (compressedData == NULL || fread(compressedData, compressedSize, 1, fd) != 1) {
+                    cclog_error("baked file (v3): failed to read compressed lighting data");
+                    free(compressedData);
+                    success = false;
+                    break;
+                }
+
+                // uncompress lighting data
+                uLong resultSize = size;
+                void *uncompressedData = malloc(size);
+                if (uncompressedData == NULL) {
+                    cclog_error(
+                        "baked file (v3): failed to uncompress lighting data (memory alloc)");
+                    free(compressedData);
+                    success = false;
+                    break;
+                }
+
+                if (uncompress(uncompressedData, &resultSize, compressedData, compressedSize) !=
+                        Z_OK ||
+                    resultSize != size) {
+                    cclog_info("baked file (v3): failed to uncompress lighting data, re-bake chunk");
+                    free(uncompressedData);
+                    free(compressedData);
+                    if (_serialization_baked_add_stale(&stale, coords) == false) {
+                        cclog_error("baked file (v3): failed to allocate stale areas");
+                        success = false;
+                        break;
+                    }
+                    continue;
+                }
+                free(compressedData);
+                compressedData = NULL;
+
+                chunk_set_lighting_data(chunk, (VERTEX_LIGHT_STRUCT_T *)uncompressedData);
+                index3d_insert(loaded, chunk, coords.x, coords.y, coords.z, NULL);
+            }
+
+            // chunks added since the file was baked
+            if (success && (nbChunks != shape_get_nb_chunks(s) || stale.count > 0)) {
+                Index3DIterator *it = index3d_iterator_new(chunks);
+                while (index3d_iterator_pointer(it) != NULL) {
+                    chunk = index3d_iterator_pointer(it);
+                    const SHAPE_COORDS_INT3_T coords = chunk_utils_get_coords(
+                        chunk_get_origin(chunk));
+                    if (index3d_get(loaded, coords.x, coords.y, coords.z) == NULL &&
+                        _serialization_baked_add_stale(&stale, coords) == false) {
+                        cclog_error("baked file (v3): failed to allocate stale areas");
+                        success = false;
+                        break;
+                    }
+                    index3d_iterator_next(it);
+                }
+                index3d_iterator_free(it);
+            }
+            index3d_flush(loaded, NULL);
+            index3d_free(loaded);
+
+            // each area is re-baked on its own, so that distant edits don't re-bake all in-between
+            if (success && stale.count > 0) {
+                cclog_info("baked file (v3): re-baking stale chunks");
+                for (uint32_t i = 0; i < stale.count; ++i) {
+                    shape_compute_baked_lighting_in_chunks(s,
+                                                           stale.areas[i].min,
+                                                           stale.areas[i].max);
+                }
+            }
+            free(stale.areas);
+
+            return success;
+        }
         default: {
             cclog_error("baked file: unsupported version");
             return false;
         }
     }
 }
+
+// MARK: - Mesh cache files -
+
+#define MESH_CACHE_FLAG_BAKED_LIGHTING 1
+#define MESH_CACHE_FLAG_VERTEX_LIGHTING 2
+#define MESH_CACHE_FLAG_TRANSPARENCY 4
+
+uint8_t _serialization_mesh_cache_flags(const Shape *s) {
+    uint8_t flags = 0;
+    if (shape_uses_baked_lighting(s)) {
+        flags |= MESH_CACHE_FLAG_BAKED_LIGHTING;
+    }
+    if (vertex_buffer_get_lighting_enabled()) {
+        flags |= MESH_CACHE_FLAG_VERTEX_LIGHTING;
+    }
+#if ENABLE_TRANSPARENCY
+    flags |= MESH_CACHE_FLAG_TRANSPARENCY;
+#endif
+    return flags;
+}
+
+void _serialization_mesh_cache_free_hashes(Index3D *hashes) {
+    index3d_flush(hashes, free);
+    index3d_free(hashes);
+}
+
+/// Chunk vertices depend on its own blocks and lighting, but also on neighbors for faces culling,
+/// ambient occlusion and smooth lighting. Each chunk hash is computed once and indexed by coords,
+/// returns NULL if allocation failed
+Index3D *_serialization_mesh_cache_chunk_hashes(const Shape *s) {
+    Index3D *hashes = index3d_new();
+    if (hashes == NULL) {
+        return NULL;
+    }
+    const bool vLighting = shape_uses_baked_lighting(s);
+    const size_t lightingSize = (size_t)CHUNK_SIZE_CUBE * (size_t)sizeof(VERTEX_LIGHT_STRUCT_T);
+
+    Chunk *chunk;
+    Index3DIterator *it = index3d_iterator_new(shape_get_chunks(s));
+    while (index3d_iterator_pointer(it) != NULL) {
+        chunk = index3d_iterator_pointer(it);
+
+        uint64_t *hash = (uint64_t *)malloc(sizeof(uint64_t));
+        if (hash == NULL) {
+            index3d_iterator_free(it);
+            _serialization_mesh_cache_free_hashes(hashes);
+            return NULL;
+        }
+        *hash = chunk_get_hash(chunk, 0);
+        const VERTEX_LIGHT_STRUCT_T *lighting = chunk_get_lighting_data(chunk);
+        if (vLighting && lighting != NULL) {
+            *hash = (uint64_t)crc32((uLong)*hash, (const Bytef *)lighting, (uInt)lightingSize);
+        }
+
+        const SHAPE_COORDS_INT3_T coords = chunk_utils_get_coords(chunk_get_origin(chunk));
+        index3d_insert(hashes, hash, coords.x, coords.y, coords.z, NULL);
+
+        index3d_iterator_next(it);
+    }
+    index3d_iterator_free(it);
+
+    return hashes;
+}
+
+uint32_t _serialization_mesh_cache_key(const Index3D *hashes, const SHAPE_COORDS_INT3_T coords) {
+    uint64_t neighborhood[27];
+    int i = 0;
+    for (int x = -1; x <= 1; ++x) {
+        for (int y = -1; y <= 1; ++y) {
+            for (int z = -1; z <= 1; ++z) {
+                const uint64_t *hash = (const uint64_t *)index3d_get(hashes,
+                                                                     coords.x + x,
+                                                                     coords.y + y,
+                                                                     coords.z + z);
+                neighborhood[i++] = hash != NULL ? *hash : 0;
+            }
+        }
+    }
+    return (uint32_t)crc32(0, (const Bytef *)neighborhood, (uInt)sizeof(neighborhood));
+}
+
+bool serialization_save_mesh_cache_file(const Shape *s, FILE *fd) {
+    ColorPalette *palette = shape_get_palette(s);
+    if (palette == NULL) {
+        return false;
+    }
+
+    // write mesh cache file version
+    const uint32_t version = 1;
+    if (fwrite(&version, sizeof(uint32_t), 1, fd) != 1) {
+        cclog_error("mesh cache file: failed to write version");
+        return false;
+    }
+
+    // write palette lighting hash, it covers colors affecting vertices other than through the atlas
+    const uint32_t paletteHash = color_palette_get_lighting_hash(palette);
+    if (fwrite(&paletteHash, sizeof(uint32_t), 1, fd) != 1) {
+        cclog_error("mesh cache file: failed to write palette hash");
+        return false;
+    }
+
+    // write vertices generation flags
+    const uint8_t flags = _serialization_mesh_cache_flags(s);
+    if (fwrite(&flags, sizeof(uint8_t), 1, fd) != 1) {
+        cclog_error("mesh cache file: failed to write flags");
+        return false;
+    }
+
+    // only chunks with up-to-date vertices are written, reserve number of chunks
+    const long nbChunksPos = ftell(fd);
+    uint32_t nbChunks = 0;
+    if (fwrite(&nbChunks, sizeof(uint32_t), 1, fd) != 1) {
+        cclog_error("mesh cache file: failed to write number of chunks");
+        return false;
+    }
+
+    // vertices store atlas indices, which are only valid for current session: store shape color
+    // indices instead
+    HashUInt32Int *atlasToShape = hash_uint32_int_new();
+    const uint8_t count = color_palette_get_count(palette);
+    for (SHAPE_COLOR_INDEX_INT_T i = count; i > 0; --i) {
+        hash_uint32_int_set(atlasToShape,
+                            color_palette_get_atlas_index(palette, i - 1),
+                            (int)(i - 1));
+    }
+
+    Index3D *hashes = _serialization_mesh_cache_chunk_hashes(s);
+    if (hashes == NULL) {
+        cclog_error("mesh cache file: failed to hash chunks");
+        hash_uint32_int_free(atlasToShape);
+        return false;
+    }
+    bool success = true;
+
+    Chunk *chunk;
+    Index3DIterator *it = index3d_iterator_new(shape_get_chunks(s));
+    while (index3d_iterator_pointer(it) != NULL) {
+        chunk = index3d_iterator_pointer(it);
+        index3d_iterator_next(it);
+
+        if (chunk_is_dirty(chunk)) {
+            continue;
+        }
+
+        const uint32_t opaqueCount = chunk_read_vertices(chunk, false, NULL);
+        const uint32_t transparentCount = chunk_read_vertices(chunk, true, NULL);
+        const size_t size = (size_t)(opaqueCount + transparentCount) * DRAWBUFFER_VERTICES_BYTES;
+        VertexAttributes *vertices = (VertexAttributes *)malloc(size > 0 ? size : 1);
+        if (vertices == NULL) {
+            success = false;
+            break;
+        }
+        chunk_read_vertices(chunk, false, vertices);
+        chunk_read_vertices(chunk, true, vertices + opaqueCount);
+
+        int shapeColor;
+        for (uint32_t i = 0; i < opaqueCount + transparentCount; ++i) {
+            if (hash_uint32_int_get(atlasToShape, (uint32_t)vertices[i].color, &shapeColor) ==
+                false) {
+                shapeColor = SHAPE_COLOR_INDEX_AIR_BLOCK;
+            }
+            vertices[i].color = (float)shapeColor;
+        }
+
+        uLong compressedSize = compressBound(size);
+        void *compressedData = malloc(compressedSize);
+        if (compressedData == NULL ||
+            compress(compressedData, &compressedSize, (const Bytef *)vertices, size) != Z_OK) {
+            cclog_error("mesh cache file: failed to compress vertices");
+            free(compressedData);
+            free(vertices);
+            success = false;
+            break;
+        }
+        free(vertices);
+
+        const SHAPE_COORDS_INT3_T coords = chunk_utils_get_coords(chunk_get_origin(chunk));
+        const uint32_t key = _serialization_mesh_cache_key(hashes, coords);
+        const uint32_t compressedSize32 = (uint32_t)compressedSize;
+        if (fwrite(&coords, sizeof(SHAPE_COORDS_INT3_T), 1, fd) != 1 ||
+            fwrite(&key, sizeof(uint32_t), 1, fd) != 1 ||
+            fwrite(&opaqueCount, sizeof(uint32_t), 1, fd) != 1 ||
+            fwrite(&transparentCount, sizeof(uint32_t), 1, fd) != 1 ||
+            fwrite(&compressedSize32, sizeof(uint32_t), 1, fd) != 1 ||
+            fwrite(compressedData, compressedSize, 1, fd) != 1) {
+            cclog_error("mesh cache file: failed to write chunk");
+            free(compressedData);
+            success = false;
+            break;
+        }
+        free(compressedData);
+
+        ++nbChunks;
+    }
+    index3d_iterator_free(it);
+    _serialization_mesh_cache_free_hashes(hashes);
+    hash_uint32_int_free(atlasToShape);
+
+    if (success == false) {
+        return false;
+    }
+
+    // write final number of chunks
+    const long endPos = ftell(fd);
+    if (fseek(fd, nbChunksPos, SEEK_SET) != 0 ||
+        fwrite(&nbChunks, sizeof(uint32_t), 1, fd) != 1 || fseek(fd, endPos, SEEK_SET) != 0) {
+        cclog_error("mesh cache file: failed to write number of chunks");
+        return false;
+    }
+
+    return true;
+}
+
+bool serialization_load_mesh_cache_file(Shape *s, FILE *fd) {
+    ColorPalette *palette = shape_get_palette(s);
+    if (palette == NULL) {
+        return false;
+    }
+
+    // read mesh cache file version
+    uint32_t version;
+    if (fread(&version, sizeof(uint32_t), 1, fd) != 1) {
+        cclog_error("mesh cache file: failed to read version");
+        return false;
+    }
+    if (version != 1) {
+        cclog_error("mesh cache file: unsupported version");
+        return false;
+    }
+
+    // palette and generation flags must match for any chunk to be reused
+    uint32_t paletteHash;
+    uint8_t flags;
+    if (fread(&paletteHash, sizeof(uint32_t), 1, fd) != 1 ||
+        fread(&flags, sizeof(uint8_t), 1, fd) != 1) {
+        cclog_error("mesh cache file: failed to read header");
+        return false;
+    }
+    if (paletteHash != color_palette_get_lighting_hash(palette) ||
+        flags != _serialization_mesh_cache_flags(s)) {
+        cclog_info("mesh cache file: mismatched palette or flags, skip");
+        return false;
+    }
+
+    uint32_t nbChunks;
+    if (fread(&nbChunks, sizeof(uint32_t), 1, fd) != 1) {
+        cclog_error("mesh cache file: failed to read number of chunks");
+        return false;
+    }
+
+    Index3D *hashes = _serialization_mesh_cache_chunk_hashes(s);
+    if (hashes == NULL) {
+        cclog_error("mesh cache file: failed to hash chunks");
+        return false;
+    }
+    Index3D *chunks = shape_get_chunks(s);
+    Chunk *chunk;
+    bool success = true;
+    for (uint32_t i = 0; i < nbChunks; ++i) {
+        SHAPE_COORDS_INT3_T coords;
+        uint32_t key, opaqueCount, transparentCount, compressedSize;
+        if (fread(&coords, sizeof(SHAPE_COORDS_INT3_T), 1, fd) != 1 ||
+            fread(&key, sizeof(uint32_t), 1, fd) != 1 ||
+            fread(&opaqueCount, sizeof(uint32_t), 1, fd) != 1 ||
+            fread(&transparentCount, sizeof(uint32_t), 1, fd) != 1 ||
+            fread(&compressedSize, sizeof(uint32_t), 1, fd) != 1) {
+            cclog_error("mesh cache file: failed to read chunk");
+            success = false;
+            break;
+        }
+
+        // chunks that changed, or which neighbors changed, are left dirty for regular refresh
+        chunk = (Chunk *)index3d_get(chunks, coords.x, coords.y, coords.z);
+        if (chunk == NULL || _serialization_mesh_cache_key(hashes, coords) != key ||
+            opaqueCount % DRAWBUFFER_VERTICES_PER_FACE != 0 ||
+            transparentCount % DRAWBUFFER_VERTICES_PER_FACE != 0) {
+            if (fseek(fd, compressedSize, SEEK_CUR) != 0) {
+                cclog_error("mesh cache file: failed to skip chunk");
+                success = false;
+                break;
+            }
+            continue;
+        }
+
+        void *compressedData = malloc(compressedSize);
+        if (compressedData == NULL || fread(compressedData, compressedSize, 1, fd) != 1) {
+            cclog_error("mesh cache file: failed to read compressed vertices");
+            free(compressedData);
+            success = false;
+            break;
+        }
+
+        const size_t size = (size_t)(opaqueCount + transparentCount) * DRAWBUFFER_VERTICES_BYTES;
+        uLong resultSize = size;
+        VertexAttributes *vertices = (VertexAttributes *)malloc(size > 0 ? size : 1);
+        if (vertices == NULL ||
+            uncompress((Bytef *)vertices, &resultSize, compressedData, compressedSize) != Z_OK ||
+            resultSize != size) {
+            cclog_error("mesh cache file: failed to uncompress vertices");
+            free(vertices);
+            free(compressedData);
+            continue;
+        }
+        free(compressedData);
+
+        for (uint32_t v = 0; v < opaqueCount + transparentCount; ++v) {
+            vertices[v].color = (float)color_palette_get_atlas_index(
+                palette,
+                (SHAPE_COLOR_INDEX_INT_T)vertices[v].color);
+        }
+
+        chunk_write_cached_vertices(s,
+                                    chunk,
+                                    vertices,
+                                    opaqueCount,
+                                    vertices + opaqueCount,
+                                    transparentCount);
+        chunk_set_dirty(chunk, false);
+        free(vertices);
+    }
+    _serialization_mesh_cache_free_hashes(hashes);
+
+    shape_prune_dirty_chunks(s);
+
+    return success;
+}
@@ -153,7 +153,7 @@ bool serialization_save_shape_as_buffer(Shape *shape,
                                         uint32_t *outBufferSize);
 
 /// get preview data from save file path (caller must free *imageData)
-/// returns true on success, false otherwise
+/// returns true on success, false otherwise, a file without preview isn't an error
 bool get_preview_data(const char *filepath, void **imageData, uint32_t *size);
 
 /// convenience function to release preview data allocated in get_preview_data
@@ -189,9 +189,20 @@ void serialization_utils_writeUint32(void *dest, const uint32_t src, uint32_t *c
 
 // MARK: - Baked files -
 
+/// Baked lighting is stored per chunk along with the chunk hash. When loading, only the chunks
+/// whose hash changed (and their light-affected neighbors) are re-baked. A palette lighting
+/// mismatch or an older file version returns false, the whole shape has to be re-baked
 bool serialization_save_baked_file(const Shape *s, uint64_t hash, FILE *fd);   // does not close fd
 bool serialization_load_baked_file(Shape *s, uint64_t expectedHash, FILE *fd); // does not close fd
 
+// MARK: - Mesh cache files -
+
+/// Vertices of each up-to-date chunk are stored along with a key made of the hashes of the chunk
+/// and its neighbors. When loading, vertices of matching chunks are written directly into vertex
+/// buffers, remaining chunks are left dirty to be refreshed as usual
+bool serialization_save_mesh_cache_file(const Shape *s, FILE *fd); // does not close fd
+bool serialization_load_mesh_cache_file(Shape *s, FILE *fd);       // does not close fd
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
@@ -60,6 +60,7 @@ uint32_t chunk_v5_read_general_rendering_options(Stream *s,
                                                  bool *globalIllumination,
                                                  bool *directionalLight,
                                                  bool *ambientOcclusion);
+/// Returns number of bytes read or 0 on error, an empty preview chunk sets `*imageData` to NULL
 uint32_t chunk_v5_read_preview_image(Stream *s, void **imageData, uint32_t *size);
 uint32_t chunk_v5_read_shape_point(Stream *s, MapStringFloat3 *m);
 
@@ -152,7 +153,7 @@ bool serialization_v5_get_preview_data(Stream *s, void **imageData, uint32_t *si
                     cclog_error("error while reading preview image");
                     return false;
                 }
-                return true;
+                return *imageData != NULL;
             default:
                 // chunks we don't need to read
                 totalSizeRead += chunk_v5_skip(s);
@@ -809,12 +810,19 @@ uint32_t chunk_v5_read_general_rendering_options(Stream *s,
 
 //
 uint32_t chunk_v5_read_preview_image(Stream *s, void **imageData, uint32_t *size) {
-    uint32_t chunkSize = chunk_v5_read_size(s);
-    if (chunkSize == 0) {
+    uint32_t chunkSize = 0;
+    if (stream_read_uint32(s, &chunkSize) == false) {
         cclog_error("can't read preview image chunk size (v5)");
         return 0;
     }
 
+    // files saved without a preview have an empty preview chunk
+    if (chunkSize == 0) {
+        *size = 0;
+        *imageData = NULL;
+        return 4;
+    }
+
     // read preview data
     void *previewData = malloc(chunkSize);
 
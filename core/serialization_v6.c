@@ -48,7 +48,23 @@ typedef enum P3sCompressionMethod {
 #define P3S_CHUNK_ID_SHAPE_PALETTE 22        // palette
 #define P3S_CHUNK_ID_OBJECT_COLLISION_BOX 23 // collision box
 #define P3S_CHUNK_ID_OBJECT_IS_HIDDEN 24     // isHidden
-#define P3S_CHUNK_ID_MAX 25                  // /!\ update this when adding chunks
+#define P3S_CHUNK_ID_SHAPE_PAYLOAD_FILTER 25 // filters applied to blocks & baked lighting
+#define P3S_CHUNK_ID_MAX 26                  // /!\ update this when adding chunks
+
+// Pre-compression filters, applied before zlib to shape payloads (flags, can be combined)
+#define P3S_PAYLOAD_FILTER_NONE 0
+// blocks sub-chunk is a sequence of (varint run length, uint8 color index) pairs
+#define P3S_PAYLOAD_FILTER_BLOCKS_RLE 1
+// baked lighting sub-chunk values are stored as deltas from the previous value in scan order
+#define P3S_PAYLOAD_FILTER_LIGHTING_DELTA 2
+
+// file format version, files w/ shapes using pre-compression filters are written w/ a newer
+// version, so that older readers reject them instead of misreading blocks & lighting
+#define P3S_FORMAT_VERSION 6
+#define P3S_FORMAT_VERSION_PAYLOAD_FILTERS 7
+
+// whether or not pre-compression filters may be used when writing shapes
+static bool payloadFiltersWriteEnabled = true;
 
 // size of the chunk header, without chunk ID (it's already read at this point)
 #define CHUNK_V6_HEADER_NO_ID_SIZE (sizeof(uint32_t) + sizeof(uint8_t) + sizeof(uint32_t))
@@ -60,20 +76,26 @@ typedef enum P3sCompressionMethod {
 // MARK: - Private functions prototypes -
 // MARK: Write as buffer -
 
+// `payloadFilters` is combined w/ the filters used by the shape, filters are only tried if
+// `tryPayloadFilters` and kept if they're expected to shrink the compressed payload
 bool chunk_v6_shape_create_and_write_uncompressed_buffer(const Shape *shape,
                                                          uint16_t shapeId,
                                                          uint16_t shapeParentId,
                                                          const ColorPalette *sharedPalette,
+                                                         const bool tryPayloadFilters,
                                                          uint32_t *uncompressedSize,
-                                                         void **uncompressedData);
+                                                         void **uncompressedData,
+                                                         uint8_t *payloadFilters);
 
+// shape chunk is compressed w/ and w/o payload filters, the smallest compressed output is kept
 bool chunk_v6_shape_create_and_write_compressed_buffer(const Shape *shape,
                                                        uint16_t shapeId,
                                                        uint16_t shapeParentId,
                                                        const ColorPalette *sharedPalette,
                                                        uint32_t *uncompressedSize,
                                                        uint32_t *compressedSize,
-                                                       void **compressedData);
+                                                       void **compressedData,
+                                                       uint8_t *payloadFilters);
 
 void _chunk_v6_palette_create_and_write_uncompressed_buffer(
     const ColorPalette *palette,
@@ -105,15 +127,29 @@ static bool write_preview_chunk_in_buffer(void *destBuffer,
 // MARK: Write as file -
 
 bool v6_write_size_at(long position, uint32_t size, FILE *fd);
+bool v6_write_format_at(long position, uint32_t format, FILE *fd);
 // Writes full chunk (header + data) to file, compress the data if required, function will free data
 // when done
 bool chunk_v6_write_file(uint8_t chunkID, uint32_t size, void *data, uint8_t doCompress, FILE *fd);
+// Writes full chunk (header + already compressed data) to file, function will free data when done
+bool chunk_v6_write_compressed_file(uint8_t chunkID,
+                                    uint32_t compressedSize,
+                                    uint32_t uncompressedSize,
+                                    void *data,
+                                    FILE *fd);
+static bool _chunk_v6_write_file_header_and_data(uint8_t chunkID,
+                                                 uint32_t chunkSize,
+                                                 uint8_t isCompressed,
+                                                 uint32_t uncompressedSize,
+                                                 void *data,
+                                                 FILE *fd);
 bool chunk_v6_write_shape(FILE *fd,
                           Shape *shape,
                           uint16_t *shapeId,
                           uint16_t shapeParentId,
                           const ColorPalette *sharedPalette,
-                          bool doCompress);
+                          bool doCompress,
+                          uint8_t *payloadFilters);
 bool chunk_v6_write_preview_image(FILE *fd, const void *imageData, uint32_t imageDataSize);
 
 // MARK: Read -
@@ -148,6 +184,16 @@ uint32_t chunk_v6_read_shape_process_blocks(void *cursor,
                                             uint8_t paletteID,
                                             ColorPalette *shrinkPalette);
 
+// same as chunk_v6_read_shape_process_blocks, for a blocks sub-chunk encoded w/
+// P3S_PAYLOAD_FILTER_BLOCKS_RLE
+uint32_t chunk_v6_read_shape_process_blocks_rle(void *cursor,
+                                                Shape *shape,
+                                                uint16_t w,
+                                                uint16_t h,
+                                                uint16_t d,
+                                                uint8_t paletteID,
+                                                ColorPalette *shrinkPalette);
+
 // chunk_v6_read_shape allocates a new Shape if shape != NULL
 uint32_t chunk_v6_read_shape(Stream *s,
                              Shape **shape,
@@ -158,6 +204,7 @@ uint32_t chunk_v6_read_shape(Stream *s,
                              uint8_t paletteID,
                              ColorPalette **rootShapePalette);
 
+/// Returns number of bytes read or 0 on error, an empty preview chunk sets `*imageData` to NULL
 uint32_t chunk_v6_read_preview_image(Stream *s, void **imageData, uint32_t *size);
 
 //  MARK: Utils -
@@ -166,6 +213,25 @@ static uint32_t getChunkHeaderSize(const uint8_t chunkID);
 static uint32_t compute_preview_chunk_size(const uint32_t previewBytesCount);
 static uint32_t compute_shape_chunk_size(uint32_t shapeBufferDataSize);
 
+/// Run-length encodes blocks in scan order, returns number of bytes written in dst
+/// dst must be able to hold at least 2 * count bytes
+static uint32_t _payload_blocks_rle_encode(const uint8_t *src, uint32_t count, uint8_t *dst);
+/// Reads one run, returns number of bytes read or 0 if the run is malformed
+static uint32_t _payload_blocks_rle_read_run(const uint8_t *src,
+                                             uint32_t size,
+                                             uint32_t *length,
+                                             uint8_t *value);
+static void _payload_lighting_delta_encode(VERTEX_LIGHT_STRUCT_T *data, uint32_t count);
+static void _payload_lighting_delta_decode(VERTEX_LIGHT_STRUCT_T *data, uint32_t count);
+/// Compresses `data` in a newly allocated buffer of the exact compressed size, `data` isn't freed
+static bool _payload_compress(const void *data,
+                              uint32_t size,
+                              void **compressedData,
+                              uint32_t *compressedSize);
+/// Number of values equal to their predecessor, zlib encodes those repeats for almost nothing,
+/// used as a cheap estimate of which lighting payload compresses best
+static uint32_t _payload_lighting_repeats(const VERTEX_LIGHT_STRUCT_T *data, uint32_t count);
+
 typedef struct _ShapeBuffers {
     uint32_t shapeUncompressedDataSize;
     uint32_t shapeCompressedDataSize;
@@ -177,7 +243,8 @@ static bool create_shape_buffers(DoublyLinkedList *shapeBuffers,
                                  uint16_t *shapeId,
                                  uint16_t shapeParentId,
                                  const ColorPalette *sharedPalette,
-                                 uint32_t *size);
+                                 uint32_t *size,
+                                 uint8_t *payloadFilters);
 
 // MARK: - Exposed functions -
 
@@ -190,8 +257,9 @@ bool serialization_v6_save_shape(Shape *shape,
     // HEADER
     // -------------------
 
-    // write file format version
-    uint32_t format = 6;
+    // write file format version (updated at the end if shapes use pre-compression filters)
+    const long positionBeforeFormat = ftell(fd);
+    uint32_t format = P3S_FORMAT_VERSION;
     if (fwrite(&format, sizeof(uint32_t), 1, fd) != 1) {
         cclog_error("failed to write file format");
         return false;
@@ -222,7 +290,8 @@ bool serialization_v6_save_shape(Shape *shape,
     chunk_v6_write_preview_image(fd, imageData, imageDataSize);
 
     uint16_t shapeId = 1;
-    chunk_v6_write_shape(fd, shape, &shapeId, 0, shape_get_palette(shape), true);
+    uint8_t payloadFilters = P3S_PAYLOAD_FILTER_NONE;
+    chunk_v6_write_shape(fd, shape, &shapeId, 0, shape_get_palette(shape), true, &payloadFilters);
 
     // -------------------
     // END OF FILE
@@ -236,6 +305,12 @@ bool serialization_v6_save_shape(Shape *shape,
         return false;
     }
 
+    if (payloadFilters != P3S_PAYLOAD_FILTER_NONE &&
+        v6_write_format_at(positionBeforeFormat, P3S_FORMAT_VERSION_PAYLOAD_FILTERS, fd) == false) {
+        cclog_error("failed to write file format");
+        return false;
+    }
+
     return true;
 }
 
@@ -277,8 +352,14 @@ bool serialization_v6_save_shape_as_buffer(const Shape *const shape,
     }
 
     uint16_t shapeId = 1;
-    if (create_shape_buffers(shapesBuffers, shape, &shapeId, 0, shape_get_palette(shape), &size) ==
-        false) {
+    uint8_t payloadFilters = P3S_PAYLOAD_FILTER_NONE;
+    if (create_shape_buffers(shapesBuffers,
+                             shape,
+                             &shapeId,
+                             0,
+                             shape_get_palette(shape),
+                             &size,
+                             &payloadFilters) == false) {
         doubly_linked_list_free(shapesBuffers);
         return false;
     }
@@ -316,7 +397,9 @@ bool serialization_v6_save_shape_as_buffer(const Shape *const shape,
     serialization_utils_writeCString(buf + cursor, MAGIC_BYTES, MAGIC_BYTES_SIZE, &cursor);
 
     // write file format version
-    const uint32_t formatVersion = 6;
+    const uint32_t formatVersion = payloadFilters != P3S_PAYLOAD_FILTER_NONE
+                                       ? P3S_FORMAT_VERSION_PAYLOAD_FILTERS
+                                       : P3S_FORMAT_VERSION;
     serialization_utils_writeUint32(buf + cursor, formatVersion, &cursor);
 
     // write compression algo
@@ -376,6 +459,7 @@ bool serialization_v6_save_shape_as_buffer(const Shape *const shape,
             return false;
         }
 
+        free(shapeBuffersCursor->shapeCompressedData);
         free(shapeBuffersCursor);
         n = doubly_linked_list_node_next(n);
     }
@@ -393,6 +477,10 @@ bool serialization_v6_save_shape_as_buffer(const Shape *const shape,
     return true;
 }
 
+void serialization_v6_set_payload_filters_enabled(const bool enabled) {
+    payloadFiltersWriteEnabled = enabled;
+}
+
 /// get preview data from save file path (caller must free *imageData)
 bool serialization_v6_get_preview_data(Stream *s, void **imageData, uint32_t *size) {
 
@@ -438,7 +526,7 @@ bool serialization_v6_get_preview_data(Stream *s, void **imageData, uint32_t *si
                     cclog_error("error while reading overview image");
                     return false;
                 }
-                return true;
+                return *imageData != NULL;
             case P3S_CHUNK_ID_SHAPE:
             case P3S_CHUNK_ID_PALETTE:
             case P3S_CHUNK_ID_PALETTE_LEGACY:
@@ -470,6 +558,19 @@ bool v6_write_size_at(long position, uint32_t size, FILE *fd) {
     return true;
 }
 
+bool v6_write_format_at(long position, uint32_t format, FILE *fd) {
+
+    long currentPosition = ftell(fd);
+
+    fseek(fd, position, SEEK_SET);
+    if (fwrite(&format, sizeof(uint32_t), 1, fd) != 1) {
+        return false;
+    }
+
+    fseek(fd, currentPosition, SEEK_SET); // back to current position
+    return true;
+}
+
 bool chunk_v6_write_file(uint8_t chunkID, uint32_t size, void *data, uint8_t doCompress, FILE *fd) {
     uint32_t chunkSize = size;
     const uint32_t uncompressedSize = size;
@@ -489,6 +590,33 @@ bool chunk_v6_write_file(uint8_t chunkID, uint32_t size, void *data, uint8_t doC
         data = compressedData;
     }
 
+    return _chunk_v6_write_file_header_and_data(chunkID,
+                                                chunkSize,
+                                                doCompress,
+                                                uncompressedSize,
+                                                data,
+                                                fd);
+}
+
+bool chunk_v6_write_compressed_file(uint8_t chunkID,
+                                    uint32_t compressedSize,
+                                    uint32_t uncompressedSize,
+                                    void *data,
+                                    FILE *fd) {
+    return _chunk_v6_write_file_header_and_data(chunkID,
+                                                compressedSize,
+                                                1,
+                                                uncompressedSize,
+                                                data,
+                                                fd);
+}
+
+bool _chunk_v6_write_file_header_and_data(uint8_t chunkID,
+                                          uint32_t chunkSize,
+                                          uint8_t isCompressed,
+                                          uint32_t uncompressedSize,
+                                          void *data,
+                                          FILE *fd) {
     // write header
     if (fwrite(&chunkID, sizeof(uint8_t), 1, fd) != 1) {
         free(data);
@@ -498,7 +626,7 @@ bool chunk_v6_write_file(uint8_t chunkID, uint32_t size, void *data, uint8_t doC
         free(data);
         return false;
     }
-    if (fwrite(&doCompress, sizeof(uint8_t), 1, fd) != 1) {
+    if (fwrite(&isCompressed, sizeof(uint8_t), 1, fd) != 1) {
         free(data);
         return false;
     }
@@ -521,7 +649,8 @@ bool chunk_v6_write_shape(FILE *fd,
                           uint16_t *shapeId,
                           uint16_t shapeParentId,
                           const ColorPalette *sharedPalette,
-                          bool doCompress) {
+                          bool doCompress,
+                          uint8_t *payloadFilters) {
 
     if (fd == NULL) {
         return false;
@@ -531,27 +660,58 @@ bool chunk_v6_write_shape(FILE *fd,
     }
 
     uint32_t uncompressedSize = 0;
-    void *uncompressedData = NULL;
 
-    if (chunk_v6_shape_create_and_write_uncompressed_buffer(shape,
-                                                            *shapeId,
-                                                            shapeParentId,
-                                                            sharedPalette,
-                                                            &uncompressedSize,
-                                                            &uncompressedData) == false) {
-        cclog_error("chunk_v6_shape_create_and_write_uncompressed_buffer failed");
-        return false;
-    }
+    if (doCompress) {
+        uint32_t compressedSize = 0;
+        void *compressedData = NULL;
+
+        if (chunk_v6_shape_create_and_write_compressed_buffer(shape,
+                                                              *shapeId,
+                                                              shapeParentId,
+                                                              sharedPalette,
+                                                              &uncompressedSize,
+                                                              &compressedSize,
+                                                              &compressedData,
+                                                              payloadFilters) == false) {
+            cclog_error("chunk_v6_shape_create_and_write_compressed_buffer failed");
+            return false;
+        }
 
-    /// write file
-    // uncompressedData freed within chunk_v6_write_file
-    if (chunk_v6_write_file(P3S_CHUNK_ID_SHAPE,
-                            uncompressedSize,
-                            uncompressedData,
-                            doCompress,
-                            fd) == false) {
-        cclog_error("failed to write shape chunk");
-        return false;
+        /// write file
+        // compressedData freed within chunk_v6_write_compressed_file
+        if (chunk_v6_write_compressed_file(P3S_CHUNK_ID_SHAPE,
+                                           compressedSize,
+                                           uncompressedSize,
+                                           compressedData,
+                                           fd) == false) {
+            cclog_error("failed to write shape chunk");
+            return false;
+        }
+    } else {
+        void *uncompressedData = NULL;
+
+        if (chunk_v6_shape_create_and_write_uncompressed_buffer(shape,
+                                                                *shapeId,
+                                                                shapeParentId,
+                                                                sharedPalette,
+                                                                payloadFiltersWriteEnabled,
+                                                                &uncompressedSize,
+                                                                &uncompressedData,
+                                                                payloadFilters) == false) {
+            cclog_error("chunk_v6_shape_create_and_write_uncompressed_buffer failed");
+            return false;
+        }
+
+        /// write file
+        // uncompressedData freed within chunk_v6_write_file
+        if (chunk_v6_write_file(P3S_CHUNK_ID_SHAPE,
+                                uncompressedSize,
+                                uncompressedData,
+                                false,
+                                fd) == false) {
+            cclog_error("failed to write shape chunk");
+            return false;
+        }
     }
 
     shapeParentId = *shapeId;
@@ -565,7 +725,13 @@ bool chunk_v6_write_shape(FILE *fd,
         // hide transforms reserved for engine
         Shape *childShape = transform_utils_get_shape(child);
         if (childShape != NULL) {
-            chunk_v6_write_shape(fd, childShape, shapeId, shapeParentId, sharedPalette, true);
+            chunk_v6_write_shape(fd,
+                                 childShape,
+                                 shapeId,
+                                 shapeParentId,
+                                 sharedPalette,
+                                 true,
+                                 payloadFilters);
         }
         n = doubly_linked_list_node_next(n);
     }
@@ -765,6 +931,36 @@ uint32_t chunk_v6_read_palette_id(Stream *s, uint8_t *paletteID) {
     return CHUNK_V6_HEADER_NO_ID_SIZE + chunkSize;
 }
 
+static void _chunk_v6_read_shape_add_block(Shape *shape,
+                                           ColorPalette *palette,
+                                           SHAPE_COLOR_INDEX_INT_T colorIndex,
+                                           SHAPE_COORDS_INT_T x,
+                                           SHAPE_COORDS_INT_T y,
+                                           SHAPE_COORDS_INT_T z,
+                                           uint8_t paletteID,
+                                           ColorPalette *shrinkPalette) {
+    bool success = true;
+    // translate & shrink to a shape palette w/ only used colors if,
+    // 1) octree was serialized w/ a palette ID using any of the default palettes
+    if (paletteID == PALETTE_ID_IOS_ITEM_EDITOR_LEGACY) {
+        success = color_palette_check_and_add_default_color_pico8p(palette,
+                                                                   colorIndex,
+                                                                   &colorIndex);
+    } else if (paletteID == PALETTE_ID_2021) {
+        success = color_palette_check_and_add_default_color_2021(palette, colorIndex, &colorIndex);
+    }
+    // 2) octree was serialized w/ a palette that exceeds max size
+    else if (shrinkPalette != NULL) {
+        RGBAColor color = color_palette_get_color(shrinkPalette, colorIndex);
+        success = color_palette_check_and_add_color(palette, color, &colorIndex, false);
+    }
+    if (success == false) {
+        colorIndex = 0;
+    }
+
+    shape_add_block(shape, colorIndex, x, y, z, false);
+}
+
 uint32_t chunk_v6_read_shape_process_blocks(void *cursor,
                                             Shape *shape,
                                             uint16_t w,
@@ -787,30 +983,75 @@ uint32_t chunk_v6_read_shape_process_blocks(void *cursor,
                     continue;
                 }
 
-                bool success = true;
-                // translate & shrink to a shape palette w/ only used colors if,
-                // 1) octree was serialized w/ a palette ID using any of the default palettes
-                if (paletteID == PALETTE_ID_IOS_ITEM_EDITOR_LEGACY) {
-                    success = color_palette_check_and_add_default_color_pico8p(palette,
-                                                                               colorIndex,
-                                                                               &colorIndex);
-                } else if (paletteID == PALETTE_ID_2021) {
-                    success = color_palette_check_and_add_default_color_2021(palette,
-                                                                             colorIndex,
-                                                                             &colorIndex);
-                }
-                // 2) octree was serialized w/ a palette that exceeds max size
-                else if (shrinkPalette != NULL) {
-                    RGBAColor color = color_palette_get_color(shrinkPalette, colorIndex);
-                    success = color_palette_check_and_add_color(palette, color, &colorIndex, false);
-                }
-                if (success == false) {
-                    colorIndex = 0;
-                }
+                _chunk_v6_read_shape_add_block(shape,
+                                               palette,
+                                               colorIndex,
+                                               x,
+                                               y,
+                                               z,
+                                               paletteID,
+                                               shrinkPalette);
+            }
+        }
+    }
+    color_palette_clear_lighting_dirty(palette);
+
+    return size + sizeof(uint32_t);
+}
+
+uint32_t chunk_v6_read_shape_process_blocks_rle(void *cursor,
+                                                Shape *shape,
+                                                uint16_t w,
+                                                uint16_t h,
+                                                uint16_t d,
+                                                uint8_t paletteID,
+                                                ColorPalette *shrinkPalette) {
+    uint32_t size = 0;
+    memcpy(&size, cursor, sizeof(uint32_t));
+    const uint8_t *runs = (const uint8_t *)cursor + sizeof(uint32_t);
+
+    ColorPalette *palette = shape_get_palette(shape);
+    const uint32_t blockCount = (uint32_t)w * (uint32_t)h * (uint32_t)d;
+    const uint32_t columnSize = (uint32_t)d;
+    const uint32_t planeSize = (uint32_t)h * (uint32_t)d;
+
+    uint32_t read = 0, runSize, length, i = 0;
+    uint8_t colorIndex;
+    while (read < size && i < blockCount) {
+        runSize = _payload_blocks_rle_read_run(runs + read, size - read, &length, &colorIndex);
+        if (runSize == 0 || length > blockCount - i) {
+            cclog_error("malformed shape blocks run");
+            break;
+        }
+        read += runSize;
 
-                shape_add_block(shape, colorIndex, x, y, z, false);
+        // air runs are skipped entirely, which is the bulk of most shapes
+        if (colorIndex == SHAPE_COLOR_INDEX_AIR_BLOCK) {
+            i += length;
+            continue;
+        }
+
+        SHAPE_COORDS_INT_T x = (SHAPE_COORDS_INT_T)(i / planeSize);
+        SHAPE_COORDS_INT_T y = (SHAPE_COORDS_INT_T)((i % planeSize) / columnSize);
+        SHAPE_COORDS_INT_T z = (SHAPE_COORDS_INT_T)(i % columnSize);
+        for (uint32_t j = 0; j < length; ++j) {
+            _chunk_v6_read_shape_add_block(shape,
+                                           palette,
+                                           colorIndex,
+                                           x,
+                                           y,
+                                           z,
+                                           paletteID,
+                                           shrinkPalette);
+            if (++z == d) {
+                z = 0;
+                if (++y == h) {
+                    y = 0;
+                    ++x;
+                }
             }
         }
+        i += length;
     }
     color_palette_clear_lighting_dirty(palette);
 
@@ -876,6 +1117,7 @@ uint32_t chunk_v6_read_shape(Stream *s,
     float3 collisionBoxMin = float3_zero;
     float3 collisionBoxMax = float3_zero;
     uint8_t isHiddenSelf = false;
+    uint8_t payloadFilter = P3S_PAYLOAD_FILTER_NONE;
 
     LocalTransform localTransform;
     memset(&localTransform, 0, sizeof(LocalTransform));
@@ -960,6 +1202,14 @@ uint32_t chunk_v6_read_shape(Stream *s,
                 totalSizeRead += sizeRead + (uint32_t)sizeof(uint32_t);
                 break;
             }
+            case P3S_CHUNK_ID_SHAPE_PAYLOAD_FILTER: {
+                memcpy(&sizeRead, cursor, sizeof(uint32_t)); // payload filter chunk size
+                cursor = (void *)((uint32_t *)cursor + 1);
+                memcpy(&payloadFilter, cursor, sizeof(uint8_t));
+                cursor = (void *)((uint8_t *)cursor + sizeRead);
+                totalSizeRead += sizeRead + (uint32_t)sizeof(uint32_t);
+                break;
+            }
             case P3S_CHUNK_ID_SHAPE_NAME: {
                 uint8_t nameLen;
                 memcpy(&nameLen, cursor, sizeof(uint8_t));
@@ -1167,13 +1417,23 @@ uint32_t chunk_v6_read_shape(Stream *s,
 
     // process blocks now
     if (shapeBlocksCursor != NULL) {
-        chunk_v6_read_shape_process_blocks(shapeBlocksCursor,
-                                           *shape,
-                                           width,
-                                           height,
-                                           depth,
-                                           paletteID,
-                                           shrinkPalette ? filePalette : NULL);
+        if ((payloadFilter & P3S_PAYLOAD_FILTER_BLOCKS_RLE) != 0) {
+            chunk_v6_read_shape_process_blocks_rle(shapeBlocksCursor,
+                                                   *shape,
+                                                   width,
+                                                   height,
+                                                   depth,
+                                                   paletteID,
+                                                   shrinkPalette ? filePalette : NULL);
+        } else {
+            chunk_v6_read_shape_process_blocks(shapeBlocksCursor,
+                                               *shape,
+                                               width,
+                                               height,
+                                               depth,
+                                               paletteID,
+                                               shrinkPalette ? filePalette : NULL);
+        }
     }
 
     free(chunkData);
@@ -1211,6 +1471,11 @@ uint32_t chunk_v6_read_shape(Stream *s,
             cclog_warning("shape uses lighting but does not match lighting data size");
             free(lightingData);
         } else {
+            if ((payloadFilter & P3S_PAYLOAD_FILTER_LIGHTING_DELTA) != 0) {
+                _payload_lighting_delta_decode(lightingData,
+                                               lightingDataSizeRead /
+                                                   (uint32_t)sizeof(VERTEX_LIGHT_STRUCT_T));
+            }
             shape_set_lighting_data_from_blob(*shape,
                                               lightingData,
                                               coords3_zero,
@@ -1280,12 +1545,19 @@ uint32_t chunk_v6_read_shape(Stream *s,
 
 //
 uint32_t chunk_v6_read_preview_image(Stream *s, void **imageData, uint32_t *size) {
-    uint32_t chunkSize = chunk_v6_read_size(s);
-    if (chunkSize == 0) {
+    uint32_t chunkSize = 0;
+    if (stream_read_uint32(s, &chunkSize) == false) {
         cclog_error("can't read preview image chunk size (v6)");
         return 0;
     }
 
+    // files saved without a preview have an empty preview chunk
+    if (chunkSize == 0) {
+        *size = 0;
+        *imageData = NULL;
+        return 4;
+    }
+
     // read preview data
     void *previewData = malloc(chunkSize);
 
@@ -1391,8 +1663,10 @@ bool chunk_v6_shape_create_and_write_uncompressed_buffer(const Shape *shape,
                                                          uint16_t shapeId,
                                                          uint16_t shapeParentId,
                                                          const ColorPalette *sharedPalette,
+                                                         const bool tryPayloadFilters,
                                                          uint32_t *uncompressedSize,
-                                                         void **uncompressedData) {
+                                                         void **uncompressedData,
+                                                         uint8_t *payloadFilters) {
     if (uncompressedSize == NULL) {
         return false;
     }
@@ -1464,6 +1738,85 @@ bool chunk_v6_shape_create_and_write_uncompressed_buffer(const Shape *shape,
     uint32_t shapeBlocksSize = blockCount * sizeof(uint8_t);
     uint32_t shapeLightingSize = blockCount * sizeof(VERTEX_LIGHT_STRUCT_T);
     uint32_t nameLenSize = sizeof(uint8_t);
+    uint32_t payloadFilterSize = sizeof(uint8_t);
+
+    // gather blocks in scan order, they are written as is or run-length encoded
+    uint8_t *blocks = shapeBlocksSize > 0 ? (uint8_t *)malloc(shapeBlocksSize) : NULL;
+    if (shapeBlocksSize > 0 && blocks == NULL) {
+        free(shapePaletteData);
+        free(paletteMapping);
+        return false;
+    }
+    {
+        uint8_t *blocksCursor = blocks;
+        for (int x = start.x; x < end.x; ++x) {
+            for (int y = start.y; y < end.y; ++y) {
+                for (int z = start.z; z < end.z; ++z) {
+                    block = shape_get_block(shape,
+                                            (SHAPE_COORDS_INT_T)x,
+                                            (SHAPE_COORDS_INT_T)y,
+                                            (SHAPE_COORDS_INT_T)z);
+                    if (block_is_solid(block)) {
+                        *blocksCursor = paletteMapping != NULL
+                                            ? paletteMapping[block_get_color_index(block)]
+                                            : block_get_color_index(block);
+                    } else {
+                        *blocksCursor = SHAPE_COLOR_INDEX_AIR_BLOCK;
+                    }
+                    ++blocksCursor;
+                }
+            }
+        }
+    }
+    free(paletteMapping);
+
+    VERTEX_LIGHT_STRUCT_T *lighting = NULL;
+    if (hasLighting && blockCount > 0) {
+        lighting = shape_create_lighting_data_blob(shape, NULL);
+        if (lighting == NULL) {
+            free(shapePaletteData);
+            free(blocks);
+            return false;
+        }
+    }
+
+    // filters are kept if they're likely to help, the compressed chunk is then compared to the one
+    // without filters, see chunk_v6_shape_create_and_write_compressed_buffer
+    uint8_t payloadFilter = P3S_PAYLOAD_FILTER_NONE;
+    if (tryPayloadFilters) {
+        // worst case for RLE is 2 bytes per block
+        uint8_t *blocksRLE = blockCount > 0 ? (uint8_t *)malloc(2 * (size_t)blockCount) : NULL;
+        if (blocksRLE != NULL) {
+            const uint32_t rleSize = _payload_blocks_rle_encode(blocks, blockCount, blocksRLE);
+            if (rleSize < shapeBlocksSize) {
+                free(blocks);
+                blocks = blocksRLE;
+                shapeBlocksSize = rleSize;
+                payloadFilter |= P3S_PAYLOAD_FILTER_BLOCKS_RLE;
+            } else {
+                free(blocksRLE);
+            }
+        }
+        VERTEX_LIGHT_STRUCT_T *lightingDelta = lighting != NULL
+                                                   ? (VERTEX_LIGHT_STRUCT_T *)malloc(
+                                                         shapeLightingSize)
+                                                   : NULL;
+        if (lightingDelta != NULL) {
+            memcpy(lightingDelta, lighting, shapeLightingSize);
+            _payload_lighting_delta_encode(lightingDelta, blockCount);
+            if (_payload_lighting_repeats(lightingDelta, blockCount) >
+                _payload_lighting_repeats(lighting, blockCount)) {
+                free(lighting);
+                lighting = lightingDelta;
+                payloadFilter |= P3S_PAYLOAD_FILTER_LIGHTING_DELTA;
+            } else {
+                free(lightingDelta);
+            }
+        }
+    }
+    if (payloadFilters != NULL) {
+        *payloadFilters |= payloadFilter;
+    }
 
     // Point positions sub-chunks collective size /!\ the name length can vary
     // TODO store this in a list to avoid recomputing it later
@@ -1522,11 +1875,16 @@ bool chunk_v6_shape_create_and_write_uncompressed_buffer(const Shape *shape,
                         shapePointPositionsCount * subheaderSize + shapePointPositionsSize +
                         shapePointRotationsCount * subheaderSize + shapePointRotationsSize +
                         (hasLighting ? subheaderSize + shapeLightingSize : 0) +
-                        (nameLen > 0 ? subheaderSize + nameLenSize + nameLen : 0);
+                        (nameLen > 0 ? subheaderSize + nameLenSize + nameLen : 0) +
+                        (payloadFilter != P3S_PAYLOAD_FILTER_NONE
+                             ? subheaderSize + payloadFilterSize
+                             : 0);
 
     *uncompressedData = malloc(*uncompressedSize);
     if (*uncompressedData == NULL) {
         free(shapePaletteData);
+        free(blocks);
+        free(lighting);
         return false;
     }
 
@@ -1549,6 +1907,19 @@ bool chunk_v6_shape_create_and_write_uncompressed_buffer(const Shape *shape,
     memcpy(cursor, &(shapeSize.z), sizeof(uint16_t)); // shape size Z
     cursor = (void *)((uint16_t *)cursor + 1);
 
+    // payload filter sub-chunk, must be known before reading blocks & baked lighting
+    if (payloadFilter != P3S_PAYLOAD_FILTER_NONE) {
+        const uint8_t chunk_id_payload_filter = P3S_CHUNK_ID_SHAPE_PAYLOAD_FILTER;
+        memcpy(cursor, &chunk_id_payload_filter, sizeof(uint8_t)); // payload filter chunk ID
+        cursor = (void *)((uint8_t *)cursor + 1);
+
+        memcpy(cursor, &payloadFilterSize, sizeof(uint32_t)); // size chunk payload filter
+        cursor = (void *)((uint32_t *)cursor + 1);
+
+        memcpy(cursor, &payloadFilter, sizeof(uint8_t));
+        cursor = (void *)((uint8_t *)cursor + 1);
+    }
+
     // shape id sub-chunk
     if (shapeId != 0) {
         const uint8_t chunk_id_shape_id = P3S_CHUNK_ID_SHAPE_ID;
@@ -1657,24 +2028,11 @@ bool chunk_v6_shape_create_and_write_uncompressed_buffer(const Shape *shape,
     cursor = (void *)((uint8_t *)cursor + 1);
     *((uint32_t *)cursor) = shapeBlocksSize; // shape blocks chunk size
     cursor = (void *)((uint32_t *)cursor + 1);
-    for (int x = start.x; x < end.x; ++x) { // shape blocks
-        for (int y = start.y; y < end.y; ++y) {
-            for (int z = start.z; z < end.z; ++z) {
-                block = shape_get_block(shape,
-                                        (SHAPE_COORDS_INT_T)x,
-                                        (SHAPE_COORDS_INT_T)y,
-                                        (SHAPE_COORDS_INT_T)z);
-                if (block_is_solid(block)) {
-                    *((uint8_t *)cursor) = paletteMapping != NULL
-                                               ? paletteMapping[block_get_color_index(block)]
-                                               : block_get_color_index(block);
-                } else {
-                    *((uint8_t *)cursor) = SHAPE_COLOR_INDEX_AIR_BLOCK;
-                }
-                cursor = (void *)((uint8_t *)cursor + 1);
-            }
-        }
+    if (shapeBlocksSize > 0) {
+        memcpy(cursor, blocks, shapeBlocksSize); // shape blocks
+        cursor = (void *)((uint8_t *)cursor + shapeBlocksSize);
     }
+    free(blocks);
 
     // shape POI sub-chunks (one per POI)
     {
@@ -1765,7 +2123,11 @@ bool chunk_v6_shape_create_and_write_uncompressed_buffer(const Shape *shape,
         memcpy(cursor, &shapeLightingSize, sizeof(uint32_t));
         cursor = (void *)((uint32_t *)cursor + 1);
 
-        shape_create_lighting_data_blob(shape, &cursor);
+        if (lighting != NULL) {
+            memcpy(cursor, lighting, shapeLightingSize);
+            cursor = (void *)((uint8_t *)cursor + shapeLightingSize);
+            free(lighting);
+        }
     }
 
     if (nameLen > 0) {
@@ -1789,7 +2151,8 @@ bool chunk_v6_shape_create_and_write_compressed_buffer(const Shape *shape,
                                                        const ColorPalette *sharedPalette,
                                                        uint32_t *uncompressedSize,
                                                        uint32_t *compressedSize,
-                                                       void **compressedData) {
+                                                       void **compressedData,
+                                                       uint8_t *payloadFilters) {
 
     if (uncompressedSize == NULL) {
         return false;
@@ -1809,7 +2172,7 @@ bool chunk_v6_shape_create_and_write_compressed_buffer(const Shape *shape,
     *uncompressedSize = 0;
     *compressedSize = 0;
 
-    // first, get uncompressed data
+    // first, get uncompressed data w/o filters and compress it
 
     void *uncompressedData = NULL;
 
@@ -1817,39 +2180,70 @@ bool chunk_v6_shape_create_and_write_compressed_buffer(const Shape *shape,
                                                             shapeId,
                                                             shapeParentId,
                                                             sharedPalette,
+                                                            false,
                                                             uncompressedSize,
-                                                            &uncompressedData) == false) {
+                                                            &uncompressedData,
+                                                            NULL) == false) {
         cclog_error("chunk_v6_shape_create_and_write_uncompressed_buffer failed");
         return false;
     }
 
-    // compress it
-
-    // compressBound is a zlib function making sure the buffer for compression will be large enough
-    // _compressedSize here is not final, it will be known after compression.
-    uLong _compressedSize = compressBound(*uncompressedSize);
-    void *_compressedData = malloc(_compressedSize);
-    if (_compressedData == NULL) {
-        return false; // malloc failed
+    const bool compressed = _payload_compress(uncompressedData,
+                                              *uncompressedSize,
+                                              compressedData,
+                                              compressedSize);
+    free(uncompressedData);
+    if (compressed == false) {
+        return false;
     }
 
-    if (compress(_compressedData, &_compressedSize, uncompressedData, *uncompressedSize) != Z_OK) {
-        free(_compressedData);
-        return false;
+    if (payloadFiltersWriteEnabled == false) {
+        return true;
     }
 
-    free(uncompressedData);
+    // then w/ filters, keeping whichever compressed output is the smallest
 
-    // now we have the final compressed size and data, we can pass it to our outputs.
-    *compressedSize = (uint32_t)_compressedSize;
-    *compressedData = malloc(*compressedSize);
-    if (*compressedData == NULL) {
-        free(_compressedData);
-        return false;
+    uint32_t filteredSize = 0;
+    void *filteredData = NULL;
+    uint8_t filters = P3S_PAYLOAD_FILTER_NONE;
+
+    if (chunk_v6_shape_create_and_write_uncompressed_buffer(shape,
+                                                            shapeId,
+                                                            shapeParentId,
+                                                            sharedPalette,
+                                                            true,
+                                                            &filteredSize,
+                                                            &filteredData,
+                                                            &filters) == false) {
+        // not an error, the shape can still be written w/o filters
+        return true;
     }
-    memcpy(*compressedData, _compressedData, *compressedSize);
 
-    free(_compressedData);
+    // same data as w/o filters
+    if (filters == P3S_PAYLOAD_FILTER_NONE) {
+        free(filteredData);
+        return true;
+    }
+
+    uint32_t filteredCompressedSize = 0;
+    void *filteredCompressedData = NULL;
+    const bool filteredCompressed = _payload_compress(filteredData,
+                                                      filteredSize,
+                                                      &filteredCompressedData,
+                                                      &filteredCompressedSize);
+    free(filteredData);
+
+    if (filteredCompressed && filteredCompressedSize < *compressedSize) {
+        free(*compressedData);
+        *compressedData = filteredCompressedData;
+        *compressedSize = filteredCompressedSize;
+        *uncompressedSize = filteredSize;
+        if (payloadFilters != NULL) {
+            *payloadFilters |= filters;
+        }
+    } else {
+        free(filteredCompressedData);
+    }
 
     return true;
 }
@@ -1966,12 +2360,127 @@ uint32_t compute_shape_chunk_size(uint32_t shapeBufferDataSize) {
     return getChunkHeaderSize(P3S_CHUNK_ID_SHAPE) + shapeBufferDataSize;
 }
 
+static uint32_t _payload_blocks_rle_write_run(uint8_t *dst, uint32_t length, uint8_t value) {
+    uint32_t written = 0;
+    // run length as a varint, 7 bits per byte, high bit set if more bytes follow
+    while (length >= 0x80) {
+        dst[written++] = (uint8_t)((length & 0x7F) | 0x80);
+        length >>= 7;
+    }
+    dst[written++] = (uint8_t)length;
+    dst[written++] = value;
+    return written;
+}
+
+uint32_t _payload_blocks_rle_encode(const uint8_t *src, uint32_t count, uint8_t *dst) {
+    if (count == 0) {
+        return 0;
+    }
+    uint32_t written = 0, length = 1;
+    uint8_t value = src[0];
+    for (uint32_t i = 1; i < count; ++i) {
+        if (src[i] == value) {
+            ++length;
+        } else {
+            written += _payload_blocks_rle_write_run(dst + written, length, value);
+            value = src[i];
+            length = 1;
+        }
+    }
+    written += _payload_blocks_rle_write_run(dst + written, length, value);
+    return written;
+}
+
+uint32_t _payload_blocks_rle_read_run(const uint8_t *src,
+                                      uint32_t size,
+                                      uint32_t *length,
+                                      uint8_t *value) {
+    uint32_t read = 0, shift = 0;
+    *length = 0;
+    while (read < size && shift < 32) {
+        const uint8_t b = src[read++];
+        *length |= (uint32_t)(b & 0x7F) << shift;
+        if ((b & 0x80) == 0) {
+            if (read == size) {
+                return 0; // missing value
+            }
+            *value = src[read++];
+            return *length > 0 ? read : 0;
+        }
+        shift += 7;
+    }
+    return 0;
+}
+
+void _payload_lighting_delta_encode(VERTEX_LIGHT_STRUCT_T *data, uint32_t count) {
+    // backwards, so that each value is diffed against its original predecessor
+    uint16_t current, previous;
+    for (uint32_t i = count; i > 1; --i) {
+        memcpy(&current, &data[i - 1], sizeof(uint16_t));
+        memcpy(&previous, &data[i - 2], sizeof(uint16_t));
+        current = (uint16_t)(current - previous);
+        memcpy(&data[i - 1], &current, sizeof(uint16_t));
+    }
+}
+
+uint32_t _payload_lighting_repeats(const VERTEX_LIGHT_STRUCT_T *data, uint32_t count) {
+    uint32_t repeats = 0;
+    for (uint32_t i = 1; i < count; ++i) {
+        if (memcmp(&data[i], &data[i - 1], sizeof(VERTEX_LIGHT_STRUCT_T)) == 0) {
+            ++repeats;
+        }
+    }
+    return repeats;
+}
+
+bool _payload_compress(const void *data,
+                       uint32_t size,
+                       void **compressedData,
+                       uint32_t *compressedSize) {
+    // compressBound is a zlib function making sure the buffer for compression will be large enough
+    // _compressedSize here is not final, it will be known after compression.
+    uLong _compressedSize = compressBound(size);
+    void *_compressedData = malloc(_compressedSize);
+    if (_compressedData == NULL) {
+        return false; // malloc failed
+    }
+
+    if (compress(_compressedData, &_compressedSize, data, size) != Z_OK) {
+        free(_compressedData);
+        return false;
+    }
+
+    // now we have the final compressed size and data, we can pass it to our outputs.
+    *compressedSize = (uint32_t)_compressedSize;
+    *compressedData = malloc(*compressedSize);
+    if (*compressedData == NULL) {
+        free(_compressedData);
+        return false;
+    }
+    memcpy(*compressedData, _compressedData, *compressedSize);
+
+    free(_compressedData);
+
+    return true;
+}
+
+void _payload_lighting_delta_decode(VERTEX_LIGHT_STRUCT_T *data, uint32_t count) {
+    uint16_t current, previous;
+    for (uint32_t i = 1; i < count; ++i) {
+        memcpy(&current, &data[i], sizeof(uint16_t));
+        memcpy(&previous, &data[i - 1], sizeof(uint16_t));
+        current = (uint16_t)(current + previous);
+        memcpy(&data[i], &current, sizeof(uint16_t));
+    }
+}
+
 bool create_shape_buffers(DoublyLinkedList *shapesBuffers,
                           Shape const *shape,
                           uint16_t *shapeId,
                           uint16_t shapeParentId,
                           const ColorPalette *sharedPalette,
-                          uint32_t *size) {
+                          uint32_t *size,
+                          uint8_t *payloadFilters) {
 
     ShapeBuffers *currentBuffer = calloc(1, sizeof(ShapeBuffers));
     if (currentBuffer == NULL) {
@@ -1985,8 +2494,8 @@ bool create_shape_buffers(DoublyLinkedList *shapesBuffers,
                                                           sharedPalette,
                                                           &currentBuffer->shapeUncompressedDataSize,
                                                           &currentBuffer->shapeCompressedDataSize,
-                                                          &currentBuffer->shapeCompressedData) ==
-        false) {
+                                                          &currentBuffer->shapeCompressedData,
+                                                          payloadFilters) == false) {
         return false;
     }
     *size += compute_shape_chunk_size(currentBuffer->shapeCompressedDataSize);
@@ -2005,7 +2514,8 @@ bool create_shape_buffers(DoublyLinkedList *shapesBuffers,
                                      shapeId,
                                      shapeParentId,
                                      sharedPalette,
-                                     size) == false) {
+                                     size,
+                                     payloadFilters) == false) {
                 return false;
             }
         }
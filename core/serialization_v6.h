@@ -53,6 +53,10 @@ bool serialization_v6_save_shape_as_buffer(const Shape *const shape,
 /// get preview data from save file path (caller must free *imageData)
 bool serialization_v6_get_preview_data(Stream *s, void **imageData, uint32_t *size);
 
+/// Pre-compression filters (blocks RLE, baked lighting delta) are used when writing shapes if they
+/// make them smaller, files using them are written as version 7. Enabled by default
+void serialization_v6_set_payload_filters_enabled(const bool enabled);
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
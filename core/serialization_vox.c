@@ -25,6 +25,16 @@
 
 #define VOX_MAX_NB_COLORS 256 // there are always 256 colors in a .vox
 
+// .vox coordinates are stored on 1 byte, blocks can only fall in these chunks
+#define VOX_NB_CHUNKS_PER_AXIS (256 / CHUNK_SIZE)
+#define VOX_NB_CHUNKS_SQR (VOX_NB_CHUNKS_PER_AXIS * VOX_NB_CHUNKS_PER_AXIS)
+#define VOX_NB_CHUNKS (VOX_NB_CHUNKS_SQR * VOX_NB_CHUNKS_PER_AXIS)
+
+static uint32_t _vox_chunk_index(const uint8_t x, const uint8_t y, const uint8_t z) {
+    return (uint32_t)(x / CHUNK_SIZE) * VOX_NB_CHUNKS_SQR +
+           (uint32_t)(y / CHUNK_SIZE) * VOX_NB_CHUNKS_PER_AXIS + (uint32_t)(z / CHUNK_SIZE);
+}
+
 bool _readExpectedBytes(Stream *s, const char *bytes, size_t size) {
     char current = 0;
     for (size_t i = 0; i < size; ++i) {
@@ -271,7 +281,7 @@ bool serialization_vox_save_shapes(Shape **shapes, const size_t nbShapes, FILE *
         Chunk *chunk = NULL;
         SHAPE_COORDS_INT3_T coords_in_shape;
         CHUNK_COORDS_INT3_T coords_in_chunk;
-        Block *b = NULL;
+        const Block *b = NULL;
         int colorIndexInCombinedPalette;
         RGBAColor color;
 
@@ -807,9 +817,6 @@ enum serialization_vox_error serialization_vox_load(Stream *s,
     stream_set_cursor_position(s, blocksPosition);
 
     uint32_t nbVoxels;
-    uint8_t x, y, z;
-    SHAPE_COLOR_INDEX_INT_T color_index;
-
     if (stream_read_uint32(s, &nbVoxels) == false) {
         cclog_error("could not read nbVoxels");
         shape_release(*out);
@@ -817,57 +824,91 @@ enum serialization_vox_error serialization_vox_load(Stream *s,
         return invalid_format;
     }
 
-    ColorPalette *palette = shape_get_palette(*out);
-    for (uint32_t i = 0; i < nbVoxels; i++) {
-
-        // ⚠️ y -> z, z -> y
-        if (stream_read_uint8(s, &x) == false) {
-            cclog_error("could not read x");
-            err = invalid_format;
-            break;
-        }
-
-        if (stream_read_uint8(s, &z) == false) {
-            cclog_error("could not read z");
-            err = invalid_format;
-            break;
-        }
-
-        if (stream_read_uint8(s, &y) == false) {
-            cclog_error("could not read y");
-            err = invalid_format;
-            break;
-        }
-
-        if (stream_read_uint8(s, &color_index) == false) {
-            cclog_error("could not read color_index");
-            err = invalid_format;
-            break;
-        }
-
-        // MV block indexes start at 1, while palette indexes start at 0.
-        // We have to shift the color index.
-        // It's also done when exporting .vox (+1 instead of -1)
-        SHAPE_COLOR_INDEX_INT_T colorIdx = color_index - 1;
-
-        // translate & shrink to a shape palette w/ only used colors
-        if (color_palette_check_and_add_color(palette, colors[colorIdx], &colorIdx, false) ==
-            false) {
-            colorIdx = 0;
+    // XYZI entries are read at once, then bucketed per chunk so that each chunk is populated
+    // in one pass instead of going through shape_add_block for each voxel
+    uint8_t *voxels = (uint8_t *)malloc((size_t)nbVoxels * 4);
+    uint32_t *chunkOffsets = (uint32_t *)calloc(VOX_NB_CHUNKS + 1, sizeof(uint32_t));
+    uint16_t *blockCoords = (uint16_t *)malloc((size_t)nbVoxels * sizeof(uint16_t));
+    SHAPE_COLOR_INDEX_INT_T *blockColors = (SHAPE_COLOR_INDEX_INT_T *)malloc(
+        (size_t)nbVoxels * sizeof(SHAPE_COLOR_INDEX_INT_T));
+
+    if (voxels == NULL || chunkOffsets == NULL || blockCoords == NULL || blockColors == NULL) {
+        cclog_error("could not allocate voxels");
+        err = invalid_format;
+    } else if (nbVoxels > 0 && stream_read(s, voxels, 4, nbVoxels) == false) {
+        cclog_error("could not read voxels");
+        err = invalid_format;
+    }
+
+    if (err == no_error) {
+        ColorPalette *palette = shape_get_palette(*out);
+
+        // .vox color index -> shape palette index, translated on first use to build a shape
+        // palette w/ only used colors, in order of appearance
+        SHAPE_COLOR_INDEX_INT_T lut[VOX_MAX_NB_COLORS];
+        bool mapped[VOX_MAX_NB_COLORS] = {false};
+
+        // count voxels per chunk, ⚠️ y -> z, z -> y
+        uint8_t *v = voxels;
+        for (uint32_t i = 0; i < nbVoxels; ++i, v += 4) {
+            if (mapped[v[3]] == false) {
+                // MV block indexes start at 1, while palette indexes start at 0.
+                // We have to shift the color index.
+                // It's also done when exporting .vox (+1 instead of -1)
+                SHAPE_COLOR_INDEX_INT_T colorIdx = (SHAPE_COLOR_INDEX_INT_T)(v[3] - 1);
+                if (color_palette_check_and_add_color(palette,
+                                                      colors[colorIdx],
+                                                      &colorIdx,
+                                                      false) == false) {
+                    colorIdx = 0;
+                }
+                lut[v[3]] = colorIdx;
+                mapped[v[3]] = true;
+            }
+            ++chunkOffsets[_vox_chunk_index(v[0], v[2], v[1]) + 1];
+        }
+        for (uint32_t c = 1; c <= VOX_NB_CHUNKS; ++c) {
+            chunkOffsets[c] += chunkOffsets[c - 1];
+        }
+
+        // scatter voxels in their chunk bucket, offsets are shifted back in the process
+        v = voxels;
+        for (uint32_t i = 0; i < nbVoxels; ++i, v += 4) {
+            const uint32_t slot = chunkOffsets[_vox_chunk_index(v[0], v[2], v[1])]++;
+            blockCoords[slot] = (uint16_t)((v[0] % CHUNK_SIZE) * CHUNK_SIZE_SQR +
+                                           (v[2] % CHUNK_SIZE) * CHUNK_SIZE + (v[1] % CHUNK_SIZE));
+            blockColors[slot] = lut[v[3]];
+        }
+
+        uint32_t first = 0;
+        for (uint32_t c = 0; c < VOX_NB_CHUNKS; ++c) {
+            const uint32_t last = chunkOffsets[c];
+            if (last > first) {
+                shape_add_blocks_in_chunk(
+                    *out,
+                    (SHAPE_COORDS_INT3_T){(SHAPE_COORDS_INT_T)(c / VOX_NB_CHUNKS_SQR),
+                                          (SHAPE_COORDS_INT_T)(c / VOX_NB_CHUNKS_PER_AXIS %
+                                                               VOX_NB_CHUNKS_PER_AXIS),
+                                          (SHAPE_COORDS_INT_T)(c % VOX_NB_CHUNKS_PER_AXIS)},
+                    blockCoords + first,
+                    blockColors + first,
+                    last - first);
+            }
+            first = last;
         }
 
-        shape_add_block(*out,
-                        colorIdx,
-                        (SHAPE_COORDS_INT_T)x,
-                        (SHAPE_COORDS_INT_T)y,
-                        (SHAPE_COORDS_INT_T)z,
-                        false);
+        color_palette_clear_lighting_dirty(palette);
     }
-    color_palette_clear_lighting_dirty(palette);
+
+    free(voxels);
+    free(chunkOffsets);
+    free(blockCoords);
+    free(blockColors);
+    free(colors);
 
     if (err != no_error) {
         shape_release(*out);
-        free(colors);
+        *out = NULL;
         return err;
     }
 
@@ -14,6 +14,7 @@
 #include "cclog.h"
 #include "config.h"
 #include "easings.h"
+#include "frustum.h"
 #include "history.h"
 #include "rigidBody.h"
 #include "scene.h"
@@ -36,6 +37,8 @@
 #define SHAPE_RENDERING_FLAG_BAKED_LIGHTING 8
 // no automatic refresh, no model changes until unlocked
 #define SHAPE_RENDERING_FLAG_BAKE_LOCKED 16
+// whether or not vertex buffers use the compact vertex format
+#define SHAPE_RENDERING_FLAG_COMPACT_VERTICES 32
 
 #define SHAPE_LUA_FLAG_NONE 0
 #define SHAPE_LUA_FLAG_MUTABLE 1
@@ -47,6 +50,50 @@ typedef struct {
     uint32_t addColor; /* 4 bytes */
 } ShapeDrawmodes;
 
+// blocks count of each slice along each axis (ie. blocks sharing a same x, y or z), giving the
+// bounding box w/o scanning chunks
+typedef struct {
+    uint32_t *counts[3]; /* 3 x 8 bytes */
+    // coordinate of counts[axis][0]
+    int32_t origin[3]; /* 3 x 4 bytes */
+    uint32_t size[3]; /* 3 x 4 bytes */
+} ShapeSlices;
+
+// source shape of a combine, see shape_combine_new
+typedef struct {
+    Shape *shape;
+    // combined shape model space to source model space, used if not a translation
+    Matrix4x4 inverse;
+    // source palette entries to combined palette entries
+    SHAPE_COLOR_INDEX_INT_T mapping[SHAPE_COLOR_INDEX_MAX_COUNT];
+    // box covered in combined shape model space [min, max[
+    int32_t min[3], max[3];
+    // integer translation from source to combined shape, if `translation`
+    int32_t offset[3];
+    bool translation;
+    char pad[3];
+} ShapeCombineSource;
+
+// chunk of a combined shape, built independently from the others
+typedef struct {
+    // indexes of sources overlapping that chunk, in combine order
+    uint32_t *sources;
+    uint32_t nbSources, sourcesCapacity;
+    // NULL if not processed yet, or once transferred to combined shape
+    Chunk *chunk;
+    // NULL if not processed yet
+    uint32_t *colorsCount;
+    SHAPE_COORDS_INT3_T coords;
+    char pad[2];
+} ShapeCombineJob;
+
+struct _ShapeCombine {
+    ShapeCombineSource *sources;
+    ShapeCombineJob **jobs;
+    ColorPalette *palette;
+    size_t nbSources, nbJobs;
+};
+
 struct _Shape {
     Weakptr *wptr;
 
@@ -76,12 +123,29 @@ struct _Shape {
     // fragmented vertex buffers
     DoublyLinkedList *fragmentedVBs;
 
+    // shape this one is an instance of, drawn w/ its vertex buffers until either of them gets
+    // modified, see shape_new_instance (NULL if not an instance)
+    Shape *model;
+    DoublyLinkedListNode *instanceNode;
+    // instances currently drawn w/ this shape's vertex buffers (NULL if none)
+    DoublyLinkedList *instances;
+
+    // coarser versions of this shape, created on demand, see shape_get_lod
+    Shape **lods;
+    // coordinates of chunks which blocks changed since LODs were last refreshed
+    Index3D *lodDirtyChunks;
+
     // block adds/removes/paints history
     History *history;
 
     // Current shape transaction, to be applied at end of frame (lua coords)
     Transaction *pendingTransaction;
 
+    // light sources & removals gathered while applying a transaction, to run a single removal
+    // and propagation pass, see _shape_lighting_batch_begin (NULL when not batching)
+    LightNodeQueue *batchLightQueue;
+    LightRemovalNodeQueue *batchLightRemovalQueue;
+
     // name of the original item <username>.<itemname>, used for baked files
     char *fullname;
 
@@ -90,9 +154,23 @@ struct _Shape {
     size_t nbChunks;
     size_t nbBlocks;
 
+    // maintained along w/ blocks, NULL if it has to be rebuilt (see _shape_slices_build)
+    ShapeSlices *slices;
+
+    // incremented w/ every block addition or removal, chunks keep the stamp of their last change
+    uint32_t blocksStamp; /* 4 bytes */
+    // stamp of the last chunks flush, or of the last chunk removal no longer tracked below
+    uint32_t chunksStamp; /* 4 bytes */
+    // last removed chunks w/ their stamps (0 if none), see shape_blocks_changed_in_box
+    uint32_t removedChunksStamps[SHAPE_REMOVED_CHUNKS_HISTORY];
+    SHAPE_COORDS_INT3_T removedChunks[SHAPE_REMOVED_CHUNKS_HISTORY];
+
     // model axis-aligned bounding box (bbMax - 1 is the max block)
     SHAPE_COORDS_INT3_T bbMin, bbMax; /* 6 x 2 bytes */
 
+    // changed light values bounding box of the current lighting batch
+    SHAPE_COORDS_INT3_T batchLightMin, batchLightMax; /* 6 x 2 bytes */
+
     uint16_t layers; // 2 bytes
 
     // internal flag used for variable-size VB allocation, see shape_add_buffer
@@ -104,6 +182,8 @@ struct _Shape {
     uint8_t renderingFlags; // 1 byte
     uint8_t luaFlags;       // 1 byte
 
+    uint8_t removedChunksNext; // 1 byte
+
     char pad[1];
 };
 
@@ -115,9 +195,63 @@ static void _shape_toggle_lua_flag(Shape *s, const uint8_t flag, const bool togg
 static bool _shape_get_lua_flag(const Shape *s, const uint8_t flag);
 
 void _shape_chunk_enqueue_refresh(Shape *shape, Chunk *c);
+Shape *_shape_new_copy(Shape *const s, const bool instance);
+/// stop drawing instance w/ its model's buffers, `refresh` to enqueue all chunks for its own
+void _shape_instance_attach(Shape *s, Shape *model);
+void _shape_instance_detach(Shape *s, const bool refresh);
+void _shape_detach_instances(Shape *s);
 void _shape_chunk_check_neighbors_dirty(Shape *shape,
                                         const Chunk *chunk,
                                         CHUNK_COORDS_INT3_T block_pos);
+Chunk *_shape_get_or_create_chunk(Shape *shape,
+                                  const SHAPE_COORDS_INT3_T chunk_coords,
+                                  bool *chunkAdded);
+bool _shape_has_transparent_blocks(const Shape *s);
+void _shape_lod_set_dirty(Shape *s, const Chunk *c);
+/// to be called when blocks are added to or removed from `c`
+void _shape_chunk_stamp(Shape *s, Chunk *c);
+/// to be called when an empty chunk is removed, see shape_blocks_changed_in_box
+void _shape_chunk_removed(Shape *s, const SHAPE_COORDS_INT3_T chunkCoords);
+/// range of chunk coordinates overlapped by `modelBox`
+void _shape_get_chunks_range(const Box *modelBox, int3 *min, int3 *max);
+Shape *_shape_lod_build(Shape *s, const uint8_t level);
+void _shape_lod_refresh_chunk(Shape *s, Shape *lod, const uint8_t level, const int3 *chunkCoords);
+void _shape_free_lods(Shape *s);
+bool _shape_chunk_is_full(const Chunk *c);
+void _shape_get_occluder_box(const Chunk *c, Box *box);
+bool _shape_query_frustum_func(RtreeNode *rn, void *ptr, const float3 *epsilon);
+/// range of chunk blocks colliding w/ `modelBox`, same test as box_collide_epsilon w/
+/// EPSILON_COLLISION. Returns false if the range is empty
+bool _shape_chunk_get_colliding_range(const Chunk *c,
+                                      const Box *modelBox,
+                                      CHUNK_COORDS_INT3_T *min,
+                                      CHUNK_COORDS_INT3_T *max);
+/// whether any solid block collides w/ `modelBox`, looked up in chunks index
+bool _shape_box_collides_blocks(const Shape *s, const Box *modelBox);
+/// distance around `modelBox` free of solid blocks, in blocks, as the largest power of 2 up to
+/// SHAPE_CAST_MAX_FREE_DISTANCE. Returns 0 if a block is within 1 block of the box
+float _shape_get_free_distance(const Shape *s, const Box *modelBox);
+/// box cast (w/o replacement) over a short vector, against the solid blocks within its
+/// broadphase box
+float _shape_box_cast_segment(const Shape *s,
+                              const Box *modelBox,
+                              const float3 *modelVector,
+                              const float3 *modelEpsilon,
+                              float3 *normal,
+                              const Block **block,
+                              SHAPE_COORDS_INT3_T *blockCoords);
+/// box cast using conservative advancement: steps through empty space are as large as the free
+/// distance around the box, segments are swept only when blocks are near
+float _shape_box_cast_advancing(const Shape *s,
+                                const Box *modelBox,
+                                const float3 *unit,
+                                const float maxDist,
+                                const float3 *modelEpsilon,
+                                const bool withReplacement,
+                                float3 *normal,
+                                float3 *extraReplacement,
+                                const Block **block,
+                                SHAPE_COORDS_INT3_T *blockCoords);
 static bool _shape_add_block_in_chunks(Shape *shape,
                                        const Block block,
                                        const SHAPE_COORDS_INT_T x,
@@ -126,7 +260,7 @@ static bool _shape_add_block_in_chunks(Shape *shape,
                                        CHUNK_COORDS_INT3_T *block_coords,
                                        bool *chunkAdded,
                                        Chunk **added_or_existing_chunk,
-                                       Block **added_or_existing_block);
+                                       const Block **added_or_existing_block);
 
 void _set_vb_allocation_flag_one_frame(Shape *s);
 
@@ -194,7 +328,50 @@ void _light_removal(Shape *s,
                     LightRemovalNodeQueue *lightRemovalQueue,
                     LightNodeQueue *lightQueue);
 void _light_removal_all(Shape *s, SHAPE_COORDS_INT3_T *min, SHAPE_COORDS_INT3_T *max);
+/// gather lighting changes of subsequent block changes until _shape_lighting_batch_end, returns
+/// false if baked lighting isn't used or if a batch was already started
+bool _shape_lighting_batch_begin(Shape *s);
+void _shape_lighting_batch_add(Shape *s, SHAPE_COORDS_INT3_T coords);
+void _shape_lighting_batch_end(Shape *s);
+/// sets blocks of the [min, max[ box to `colors` or to `fill` if NULL, air or unlisted entries
+/// leaving blocks unchanged unless `writeAir` is true. Previous colors are stored in `previous` if
+/// not NULL, all of them if dense, only the changed ones if runs. Returns the number of changed
+/// blocks, `previous` is freed if it couldn't be recorded
+uint32_t _shape_edit_region(Shape *s,
+                            const SHAPE_COORDS_INT3_T min,
+                            const SHAPE_COORDS_INT3_T max,
+                            const TransactionColors *colors,
+                            const SHAPE_COLOR_INDEX_INT_T fill,
+                            const bool writeAir,
+                            TransactionColors *previous);
+/// lists solid blocks of the [min, max[ box in initialized `colors`, air in dense entries
+bool _shape_read_region(const Shape *s,
+                        const SHAPE_COORDS_INT3_T min,
+                        const SHAPE_COORDS_INT3_T max,
+                        TransactionColors *colors);
+uint32_t _shape_apply_region(Shape *s, TransactionRegion *r, const bool undo);
+/// applies a volume change as its own transaction & history entry, takes ownership of `after`
+uint32_t _shape_region_operation(Shape *s,
+                                 Scene *scene,
+                                 const SHAPE_COORDS_INT3_T min,
+                                 const SHAPE_COORDS_INT3_T max,
+                                 TransactionColors *after,
+                                 const SHAPE_COLOR_INDEX_INT_T fill);
+bool _shape_region_is_valid(const SHAPE_COORDS_INT3_T min, const SHAPE_COORDS_INT3_T max);
+/// reset lighting of all chunks in the columns spanned by given chunk coordinates range
+void _light_removal_columns(Shape *s,
+                            SHAPE_COORDS_INT3_T chunkMin,
+                            SHAPE_COORDS_INT3_T chunkMax,
+                            SHAPE_COORDS_INT3_T *min,
+                            SHAPE_COORDS_INT3_T *max);
+/// enqueue lit blocks found right outside of given area, as sources to propagate into it
+void _light_enqueue_area_border_sources(Shape *s,
+                                        LightNodeQueue *q,
+                                        SHAPE_COORDS_INT3_T min,
+                                        SHAPE_COORDS_INT3_T max);
 void _shape_check_all_vb_fragmented(Shape *s, VertexBuffer *first);
+/// fills vertex buffers gaps, moving at most SHAPE_BUFFER_COMPACTION_BUDGET vertices
+void _shape_fill_gaps(Shape *s);
 void _shape_flush_all_vb(Shape *s);
 void _shape_fill_draw_slices(VertexBuffer *vb);
 VertexBuffer *_shape_get_latest_buffer(const Shape *s, const bool transparent);
@@ -214,6 +391,42 @@ bool _shape_compute_size_and_origin(const Shape *shape,
 
 bool _shape_is_bounding_box_empty(const Shape *shape);
 
+/// returns empty slices if `src` is NULL
+ShapeSlices *_shape_slices_new_copy(const ShapeSlices *src);
+/// builds slices from chunks, see ShapeSlices
+void _shape_slices_build(Shape *s);
+void _shape_slices_free(Shape *s);
+/// translation of `m` if it is one on the integer grid
+bool _shape_combine_get_translation(const Matrix4x4 *m, int32_t offset[3]);
+/// box covered by [min, max[ in combined shape model space
+void _shape_combine_get_box(const ShapeCombineSource *src,
+                            const Matrix4x4 *m,
+                            const SHAPE_COORDS_INT3_T min,
+                            const SHAPE_COORDS_INT3_T max,
+                            int32_t outMin[3],
+                            int32_t outMax[3]);
+void _shape_combine_map_colors(ColorPalette *palette, ShapeCombineSource *src);
+bool _shape_combine_add_source_to_job(ShapeCombine *c,
+                                      Index3D *index,
+                                      const int32_t x,
+                                      const int32_t y,
+                                      const int32_t z,
+                                      const uint32_t source);
+/// writes source blocks overlapping the combined shape chunk at `origin`
+void _shape_combine_write_source(const ShapeCombineSource *src,
+                                 const SHAPE_COORDS_INT3_T origin,
+                                 Block *blocks);
+void _shape_combine_free(ShapeCombine *c);
+/// adds `delta` to the slices containing given block, if slices are built
+void _shape_slices_update(Shape *s, const SHAPE_COORDS_INT3_T coords, const int32_t delta);
+/// first & last non-empty slices along given axis, within [min, max[ range
+void _shape_slices_get_bounds(const Shape *s,
+                              const int axis,
+                              const int32_t min,
+                              const int32_t max,
+                              SHAPE_COORDS_INT_T *outMin,
+                              SHAPE_COORDS_INT_T *outMax);
+
 // --------------------------------------------------
 //
 // MARK: - public functions -
@@ -254,11 +467,23 @@ Shape *shape_new(void) {
     s->fullname = NULL;
     s->drawmodes = NULL;
     s->pendingTransaction = NULL;
+    s->batchLightQueue = NULL;
+    s->batchLightRemovalQueue = NULL;
     s->nbChunks = 0;
     s->nbBlocks = 0;
+    s->blocksStamp = 0;
+    s->chunksStamp = 0;
+    memset(s->removedChunksStamps, 0, sizeof(s->removedChunksStamps));
+    s->removedChunksNext = 0;
+    s->slices = _shape_slices_new_copy(NULL);
     s->bbMin = coords3_zero;
     s->bbMax = coords3_zero;
     s->fragmentedVBs = doubly_linked_list_new();
+    s->model = NULL;
+    s->instanceNode = NULL;
+    s->instances = NULL;
+    s->lods = NULL;
+    s->lodDirtyChunks = NULL;
 
     s->drawMode = SHAPE_DRAWMODE_DEFAULT;
     s->renderingFlags = SHAPE_RENDERING_FLAG_INNER_TRANSPARENT_FACES;
@@ -276,14 +501,40 @@ Shape *shape_new_2(const bool isMutable) {
 }
 
 Shape *shape_new_copy(Shape *const s) {
+    return _shape_new_copy(s, false);
+}
+
+Shape *shape_new_instance(Shape *const model) {
+    return _shape_new_copy(model, true);
+}
+
+Shape *_shape_new_copy(Shape *const s, const bool instance) {
     shape_apply_current_transaction(s, true);
 
     Shape *copy = shape_new();
     transform_copy(copy->transform, s->transform);
-    copy->palette = color_palette_new_copy(s->palette);
+    // instances share model's palette, unless it can't be retained anymore
+    if (instance && color_palette_retain(s->palette)) {
+        copy->palette = s->palette;
+        const uint8_t count = color_palette_get_count(copy->palette);
+        for (uint8_t i = 0; i < count; ++i) {
+            color_palette_increment_color(copy->palette, i, s->blocksCount[i]);
+        }
+    } else {
+        copy->palette = color_palette_new_copy(s->palette);
+    }
     memcpy(copy->blocksCount, s->blocksCount, SHAPE_COLOR_INDEX_MAX_COUNT * sizeof(uint32_t));
+    copy->nbBlocks = s->nbBlocks;
+    copy->nbChunks = s->nbChunks;
+    copy->blocksStamp = s->blocksStamp;
+    copy->chunksStamp = s->chunksStamp;
+    memcpy(copy->removedChunksStamps, s->removedChunksStamps, sizeof(s->removedChunksStamps));
+    memcpy(copy->removedChunks, s->removedChunks, sizeof(s->removedChunks));
+    copy->removedChunksNext = s->removedChunksNext;
     copy->bbMin = s->bbMin;
     copy->bbMax = s->bbMax;
+    _shape_slices_free(copy);
+    copy->slices = s->slices != NULL ? _shape_slices_new_copy(s->slices) : NULL;
     copy->drawMode = s->drawMode;
     copy->renderingFlags = s->renderingFlags;
     copy->layers = s->layers;
@@ -352,13 +603,19 @@ Shape *shape_new_copy(Shape *const s) {
         chunk_set_rtree_leaf(chunkCopy,
                              rtree_create_and_insert(copy->rtree, &chunkBox, 1, 1, chunkCopy));
 
-        // enqueue new shape buffers
-        _shape_chunk_enqueue_refresh(copy, chunkCopy);
+        // enqueue new shape buffers, unless drawn w/ model's
+        if (instance == false) {
+            _shape_chunk_enqueue_refresh(copy, chunkCopy);
+        }
 
         index3d_iterator_next(chunks_it);
     }
     index3d_iterator_free(chunks_it);
 
+    if (instance) {
+        _shape_instance_attach(copy, s->model != NULL ? s->model : s);
+    }
+
     return copy;
 }
 
@@ -371,7 +628,15 @@ void shape_flush(Shape *shape) {
         }
         memset(shape->blocksCount, 0, SHAPE_COLOR_INDEX_MAX_COUNT * sizeof(uint32_t));
 
+        if (shape->model != NULL) {
+            _shape_instance_detach(shape, false);
+        }
+        if (shape->instances != NULL) {
+            _shape_detach_instances(shape);
+        }
+
         index3d_flush(shape->chunks, chunk_free_func);
+        shape->chunksStamp = ++shape->blocksStamp;
 
         map_string_float3_free(shape->POIs);
         shape->POIs = map_string_float3_new();
@@ -381,6 +646,7 @@ void shape_flush(Shape *shape) {
 
         shape->bbMin = coords3_zero;
         shape->bbMax = coords3_zero;
+        _shape_slices_free(shape);
 
         RigidBody *rb = shape_get_rigidbody(shape);
         if (rb != NULL) {
@@ -407,6 +673,8 @@ void shape_flush(Shape *shape) {
         shape->nbChunks = 0;
         shape->nbBlocks = 0;
         shape->fragmentedVBs = doubly_linked_list_new();
+
+        _shape_free_lods(shape);
     }
 }
 
@@ -430,6 +698,15 @@ void shape_free(Shape *const shape) {
 
     weakptr_invalidate(shape->wptr);
 
+    if (shape->model != NULL) {
+        _shape_instance_detach(shape, false);
+    }
+    if (shape->instances != NULL) {
+        _shape_detach_instances(shape);
+    }
+
+    _shape_free_lods(shape);
+
     if (shape->palette != NULL) {
         // remove own blocks count from (potentially shared) palette
         const uint8_t count = color_palette_get_count(shape->palette);
@@ -486,6 +763,8 @@ void shape_free(Shape *const shape) {
     transaction_free(shape->pendingTransaction);
     shape->pendingTransaction = NULL;
 
+    _shape_slices_free(shape);
+
     free(shape->fullname);
     free(shape->drawmodes);
 
@@ -510,7 +789,7 @@ Weakptr *shape_get_and_retain_weakptr(Shape *const s) {
     }
 }
 
-uint16_t shape_get_id(const Shape *shape) {
+uint32_t shape_get_id(const Shape *shape) {
     return transform_get_id(shape->transform);
 }
 
@@ -679,6 +958,7 @@ bool shape_add_block(Shape *shape,
 
     if (blockAdded) {
         shape->nbBlocks++;
+        _shape_slices_update(shape, (SHAPE_COORDS_INT3_T){x, y, z}, 1);
         _shape_chunk_enqueue_refresh(shape, chunk);
         _shape_chunk_check_neighbors_dirty(shape, chunk, block_coords);
 
@@ -699,6 +979,84 @@ bool shape_add_block(Shape *shape,
     return blockAdded;
 }
 
+uint32_t shape_add_blocks_in_chunk(Shape *shape,
+                                   const SHAPE_COORDS_INT3_T chunkCoords,
+                                   const uint16_t *coords,
+                                   const SHAPE_COLOR_INDEX_INT_T *colors,
+                                   const uint32_t count) {
+
+    if (shape == NULL || count == 0) {
+        return 0;
+    }
+
+    bool chunkAdded = false;
+    Chunk *chunk = _shape_get_or_create_chunk(shape, chunkCoords, &chunkAdded);
+    if (chunkAdded) {
+        shape->nbChunks++;
+    }
+
+    uint32_t colorsCount[SHAPE_COLOR_INDEX_MAX_COUNT] = {0};
+    const uint32_t added = chunk_add_blocks(chunk, coords, colors, count, colorsCount);
+    if (added == 0) {
+        return 0;
+    }
+    _shape_lod_set_dirty(shape, chunk);
+    _shape_chunk_stamp(shape, chunk);
+
+    // added blocks are only known if none was skipped, otherwise slices are rebuilt when needed
+    if (added == count) {
+        const SHAPE_COORDS_INT3_T origin = chunk_get_origin(chunk);
+        for (uint32_t i = 0; i < count; ++i) {
+            _shape_slices_update(
+                shape,
+                (SHAPE_COORDS_INT3_T){(SHAPE_COORDS_INT_T)(origin.x + coords[i] / CHUNK_SIZE_SQR),
+                                      (SHAPE_COORDS_INT_T)(origin.y + coords[i] / CHUNK_SIZE %
+                                                                          CHUNK_SIZE),
+                                      (SHAPE_COORDS_INT_T)(origin.z + coords[i] % CHUNK_SIZE)},
+                1);
+        }
+    } else {
+        _shape_slices_free(shape);
+    }
+
+    shape->nbBlocks += added;
+    for (int i = 0; i < SHAPE_COLOR_INDEX_MAX_COUNT; ++i) {
+        if (colorsCount[i] > 0) {
+            color_palette_increment_color(shape->palette,
+                                          (SHAPE_COLOR_INDEX_INT_T)i,
+                                          colorsCount[i]);
+            shape->blocksCount[i] += colorsCount[i];
+        }
+    }
+
+    // chunk bounding box covers all added blocks, use it to refresh neighbors & expand shape box
+    CHUNK_COORDS_INT3_T bbMin, bbMax;
+    chunk_get_bounding_box_2(chunk, &bbMin, &bbMax);
+
+    _shape_chunk_enqueue_refresh(shape, chunk);
+    _shape_chunk_check_neighbors_dirty(shape, chunk, bbMin);
+    _shape_chunk_check_neighbors_dirty(
+        shape,
+        chunk,
+        (CHUNK_COORDS_INT3_T){bbMax.x - 1, bbMax.y - 1, bbMax.z - 1});
+
+    const SHAPE_COORDS_INT3_T origin = chunk_get_origin(chunk);
+    shape_expand_box(shape,
+                     (SHAPE_COORDS_INT3_T){(SHAPE_COORDS_INT_T)(origin.x + bbMin.x),
+                                           (SHAPE_COORDS_INT_T)(origin.y + bbMin.y),
+                                           (SHAPE_COORDS_INT_T)(origin.z + bbMin.z)});
+    shape_expand_box(shape,
+                     (SHAPE_COORDS_INT3_T){(SHAPE_COORDS_INT_T)(origin.x + bbMax.x - 1),
+                                           (SHAPE_COORDS_INT_T)(origin.y + bbMax.y - 1),
+                                           (SHAPE_COORDS_INT_T)(origin.z + bbMax.z - 1)});
+
+    if (_shape_get_rendering_flag(shape, SHAPE_RENDERING_FLAG_BAKED_LIGHTING)) {
+        shape_compute_baked_lighting_in_chunks(shape, chunkCoords, chunkCoords);
+    }
+
+    return added;
+}
+
 bool shape_remove_block(Shape *shape,
                         const SHAPE_COORDS_INT_T x,
                         const SHAPE_COORDS_INT_T y,
@@ -725,8 +1083,11 @@ bool shape_remove_block(Shape *shape,
 
         if (removed) {
             shape->nbBlocks--;
+            _shape_slices_update(shape, coords_in_shape, -1);
             _shape_chunk_check_neighbors_dirty(shape, chunk, coords_in_chunk);
             _shape_chunk_enqueue_refresh(shape, chunk);
+            _shape_lod_set_dirty(shape, chunk);
+            _shape_chunk_stamp(shape, chunk);
 
             if (_shape_get_rendering_flag(shape, SHAPE_RENDERING_FLAG_BAKED_LIGHTING)) {
                 shape_compute_baked_lighting_removed_block(shape,
@@ -781,6 +1142,7 @@ bool shape_paint_block(Shape *shape,
             ++shape->blocksCount[colorIndex];
 
             _shape_chunk_enqueue_refresh(shape, chunk);
+            _shape_lod_set_dirty(shape, chunk);
 
             if (_shape_get_rendering_flag(shape, SHAPE_RENDERING_FLAG_BAKED_LIGHTING)) {
                 shape_compute_baked_lighting_replaced_block(shape,
@@ -795,6 +1157,334 @@ bool shape_paint_block(Shape *shape,
     return painted;
 }
 
+uint32_t shape_fill_box(Shape *shape,
+                        Scene *scene,
+                        const SHAPE_COORDS_INT3_T min,
+                        const SHAPE_COORDS_INT3_T max,
+                        const SHAPE_COLOR_INDEX_INT_T colorIndex) {
+
+    if (shape == NULL || colorIndex == SHAPE_COLOR_INDEX_AIR_BLOCK ||
+        _shape_region_is_valid(min, max) == false) {
+        return 0;
+    }
+    return _shape_region_operation(shape, scene, min, max, NULL, colorIndex);
+}
+
+uint32_t shape_clear_box(Shape *shape,
+                         Scene *scene,
+                         const SHAPE_COORDS_INT3_T min,
+                         const SHAPE_COORDS_INT3_T max) {
+
+    if (shape == NULL || _shape_region_is_valid(min, max) == false) {
+        return 0;
+    }
+    return _shape_region_operation(shape, scene, min, max, NULL, SHAPE_COLOR_INDEX_AIR_BLOCK);
+}
+
+uint32_t shape_copy_region(Shape *dst,
+                           Scene *scene,
+                           const Shape *src,
+                           const SHAPE_COORDS_INT3_T srcMin,
+                           const SHAPE_COORDS_INT3_T srcMax,
+                           const SHAPE_COORDS_INT3_T dstMin,
+                           const SHAPE_COLOR_INDEX_INT_T *remap) {
+
+    if (dst == NULL || src == NULL || _shape_region_is_valid(srcMin, srcMax) == false) {
+        return 0;
+    }
+
+    const int32_t dstMaxX = (int32_t)dstMin.x + srcMax.x - srcMin.x;
+    const int32_t dstMaxY = (int32_t)dstMin.y + srcMax.y - srcMin.y;
+    const int32_t dstMaxZ = (int32_t)dstMin.z + srcMax.z - srcMin.z;
+    if (dstMaxX > INT16_MAX || dstMaxY > INT16_MAX || dstMaxZ > INT16_MAX) {
+        cclog_error("shape_copy_region: destination out of bounds");
+        return 0;
+    }
+    const SHAPE_COORDS_INT3_T dstMax = {(SHAPE_COORDS_INT_T)dstMaxX,
+                                        (SHAPE_COORDS_INT_T)dstMaxY,
+                                        (SHAPE_COORDS_INT_T)dstMaxZ};
+
+    // source is read entirely first, so that src & dst regions can overlap
+    const size_t volume = (size_t)(srcMax.x - srcMin.x) * (size_t)(srcMax.y - srcMin.y) *
+                          (size_t)(srcMax.z - srcMin.z);
+    TransactionColors colors;
+    if (transaction_colors_init(&colors, volume) == false ||
+        _shape_read_region(src, srcMin, srcMax, &colors) == false) {
+        cclog_error("shape_copy_region: failed to read source region");
+        transaction_colors_free(&colors);
+        return 0;
+    }
+
+    // map source palette entries to destination ones, only for the colors being used
+    SHAPE_COLOR_INDEX_INT_T mapping[SHAPE_COLOR_INDEX_MAX_COUNT];
+    bool mapped[SHAPE_COLOR_INDEX_MAX_COUNT] = {false};
+    const bool samePalette = src->palette == dst->palette;
+    const size_t count = colors.dense != NULL ? volume : colors.nbRuns;
+    for (size_t i = 0; i < count; ++i) {
+        SHAPE_COLOR_INDEX_INT_T *entry = colors.dense != NULL ? &colors.dense[i]
+                                                              : &colors.runs[i].color;
+        const SHAPE_COLOR_INDEX_INT_T c = *entry;
+        if (c == SHAPE_COLOR_INDEX_AIR_BLOCK) {
+            continue;
+        }
+        if (mapped[c] == false) {
+            if (remap != NULL) {
+                mapping[c] = remap[c];
+            } else if (samePalette) {
+                mapping[c] = c;
+            } else {
+                const RGBAColor color = color_palette_get_color(src->palette, c);
+                if (color_palette_find(dst->palette, color, &mapping[c]) == false) {
+                    if (color_palette_check_and_add_color(dst->palette,
+                                                          color,
+                                                          &mapping[c],
+                                                          true)) {
+                        color_palette_set_emissive(dst->palette,
+                                                   mapping[c],
+                                                   color_palette_is_emissive(src->palette, c));
+                    } else {
+                        // destination palette is full, skip those blocks
+                        mapping[c] = SHAPE_COLOR_INDEX_AIR_BLOCK;
+                    }
+                }
+            }
+            mapped[c] = true;
+        }
+        *entry = mapping[c];
+    }
+
+    return _shape_region_operation(dst,
+                                   scene,
+                                   dstMin,
+                                   dstMax,
+                                   &colors,
+                                   SHAPE_COLOR_INDEX_AIR_BLOCK);
+}
+
+// MARK: - Combine -
+
+ShapeCombine *shape_combine_new(Shape **shapes,
+                                const Matrix4x4 **transforms,
+                                const size_t count) {
+    if (shapes == NULL || count == 0 || count > UINT32_MAX) {
+        return NULL;
+    }
+    ShapeCombine *c = (ShapeCombine *)malloc(sizeof(ShapeCombine));
+    if (c == NULL) {
+        return NULL;
+    }
+    c->sources = (ShapeCombineSource *)malloc(count * sizeof(ShapeCombineSource));
+    c->jobs = NULL;
+    c->palette = NULL;
+    c->nbSources = 0;
+    c->nbJobs = 0;
+
+    Index3D *index = index3d_new();
+    if (c->sources == NULL || index == NULL) {
+        index3d_free(index);
+        _shape_combine_free(c);
+        return NULL;
+    }
+
+    bool ok = true;
+    for (size_t i = 0; ok && i < count; ++i) {
+        Shape *s = shapes[i];
+        if (s == NULL || s->palette == NULL) {
+            continue;
+        }
+        shape_apply_current_transaction(s, true);
+        if (s->nbBlocks == 0) {
+            continue;
+        }
+
+        // combined palette uses the atlas of the first shape
+        if (c->palette == NULL) {
+            c->palette = color_palette_new(color_palette_get_atlas(s->palette));
+            if (c->palette == NULL) {
+                ok = false;
+                break;
+            }
+        }
+
+        ShapeCombineSource *src = &c->sources[c->nbSources];
+        src->shape = s;
+        const Matrix4x4 *m = transforms != NULL && transforms[i] != NULL ? transforms[i]
+                                                                          : &matrix4x4_identity;
+        src->translation = _shape_combine_get_translation(m, src->offset);
+        if (src->translation == false) {
+            matrix4x4_copy(&src->inverse, m);
+            matrix4x4_op_invert(&src->inverse);
+        }
+        _shape_combine_get_box(src, m, s->bbMin, s->bbMax, src->min, src->max);
+        if (src->min[0] >= src->max[0] || src->min[1] >= src->max[1] ||
+            src->min[2] >= src->max[2]) {
+            continue;
+        }
+        _shape_combine_map_colors(c->palette, src);
+
+        // combined shape chunks overlapped by each source chunk
+        int32_t min[3], max[3];
+        CHUNK_COORDS_INT3_T bbMin, bbMax;
+        Index3DIterator *it = index3d_iterator_new(s->chunks);
+        while (ok && index3d_iterator_pointer(it) != NULL) {
+            const Chunk *chunk = (const Chunk *)index3d_iterator_pointer(it);
+            index3d_iterator_next(it);
+            if (chunk_get_nb_blocks(chunk) == 0) {
+                continue;
+            }
+            const SHAPE_COORDS_INT3_T origin = chunk_get_origin(chunk);
+            chunk_get_bounding_box_2(chunk, &bbMin, &bbMax);
+            _shape_combine_get_box(
+                src,
+                m,
+                (SHAPE_COORDS_INT3_T){origin.x + bbMin.x, origin.y + bbMin.y, origin.z + bbMin.z},
+                (SHAPE_COORDS_INT3_T){origin.x + bbMax.x, origin.y + bbMax.y, origin.z + bbMax.z},
+                min,
+                max);
+            if (min[0] >= max[0] || min[1] >= max[1] || min[2] >= max[2]) {
+                continue;
+            }
+            const SHAPE_COORDS_INT3_T from = chunk_utils_get_coords(
+                (SHAPE_COORDS_INT3_T){(SHAPE_COORDS_INT_T)min[0],
+                                      (SHAPE_COORDS_INT_T)min[1],
+                                      (SHAPE_COORDS_INT_T)min[2]});
+            const SHAPE_COORDS_INT3_T to = chunk_utils_get_coords(
+                (SHAPE_COORDS_INT3_T){(SHAPE_COORDS_INT_T)(max[0] - 1),
+                                      (SHAPE_COORDS_INT_T)(max[1] - 1),
+                                      (SHAPE_COORDS_INT_T)(max[2] - 1)});
+            for (int32_t x = from.x; ok && x <= to.x; ++x) {
+                for (int32_t y = from.y; ok && y <= to.y; ++y) {
+                    for (int32_t z = from.z; ok && z <= to.z; ++z) {
+                        ok = _shape_combine_add_source_to_job(c,
+                                                              index,
+                                                              x,
+                                                              y,
+                                                              z,
+                                                              (uint32_t)c->nbSources);
+                    }
+                }
+            }
+        }
+        index3d_iterator_free(it);
+
+        ++c->nbSources;
+    }
+
+    // jobs are owned by the combine from here
+    index3d_flush(index, NULL);
+    index3d_free(index);
+
+    if (ok == false) {
+        cclog_error("shape combine: can't allocate jobs");
+        _shape_combine_free(c);
+        return NULL;
+    }
+
+    if (c->palette == NULL) {
+        c->palette = color_palette_new(NULL);
+    }
+
+    return c;
+}
+
+size_t shape_combine_get_nb_jobs(const ShapeCombine *c) {
+    return c->nbJobs;
+}
+
+void shape_combine_process(ShapeCombine *c, const size_t job) {
+    ShapeCombineJob *j = c->jobs[job];
+    if (j->colorsCount != NULL) {
+        return;
+    }
+    j->colorsCount = (uint32_t *)calloc(SHAPE_COLOR_INDEX_MAX_COUNT, sizeof(uint32_t));
+    if (j->colorsCount == NULL) {
+        return;
+    }
+
+    const SHAPE_COORDS_INT3_T origin = {(SHAPE_COORDS_INT_T)(j->coords.x * CHUNK_SIZE),
+                                        (SHAPE_COORDS_INT_T)(j->coords.y * CHUNK_SIZE),
+                                        (SHAPE_COORDS_INT_T)(j->coords.z * CHUNK_SIZE)};
+
+    // later sources overwrite previous ones
+    Block blocks[CHUNK_SIZE_CUBE];
+    memset(blocks, SHAPE_COLOR_INDEX_AIR_BLOCK, sizeof(blocks));
+    for (uint32_t i = 0; i < j->nbSources; ++i) {
+        _shape_combine_write_source(&c->sources[j->sources[i]], origin, blocks);
+    }
+
+    j->chunk = chunk_new(origin);
+    if (j->chunk != NULL && chunk_set_blocks(j->chunk, blocks, j->colorsCount) == 0) {
+        chunk_free(j->chunk, false);
+        j->chunk = NULL;
+    }
+}
+
+Shape *shape_combine_end(ShapeCombine *c) {
+    Shape *s = shape_new();
+    s->palette = c->palette;
+    c->palette = NULL;
+
+    SHAPE_COORDS_INT3_T bbMin = {INT16_MAX, INT16_MAX, INT16_MAX};
+    SHAPE_COORDS_INT3_T bbMax = {INT16_MIN, INT16_MIN, INT16_MIN};
+    CHUNK_COORDS_INT3_T min, max;
+    for (size_t i = 0; i < c->nbJobs; ++i) {
+        ShapeCombineJob *j = c->jobs[i];
+        shape_combine_process(c, i);
+        if (j->chunk == NULL) {
+            continue;
+        }
+        Chunk *chunk = j->chunk;
+        j->chunk = NULL;
+
+        const SHAPE_COORDS_INT3_T origin = chunk_get_origin(chunk);
+        index3d_insert(s->chunks, chunk, j->coords.x, j->coords.y, j->coords.z, NULL);
+        chunk_move_in_neighborhood(s->chunks, chunk, j->coords);
+        Box chunkBox = {{(float)origin.x, (float)origin.y, (float)origin.z},
+                        {(float)(origin.x + CHUNK_SIZE),
+                         (float)(origin.y + CHUNK_SIZE),
+                         (float)(origin.z + CHUNK_SIZE)}};
+        chunk_set_rtree_leaf(chunk, rtree_create_and_insert(s->rtree, &chunkBox, 1, 1, chunk));
+        _shape_chunk_enqueue_refresh(s, chunk);
+
+        ++s->nbChunks;
+        s->nbBlocks += (size_t)chunk_get_nb_blocks(chunk);
+        for (int k = 0; k < SHAPE_COLOR_INDEX_MAX_COUNT; ++k) {
+            if (j->colorsCount[k] > 0) {
+                s->blocksCount[k] += j->colorsCount[k];
+                color_palette_increment_color(s->palette,
+                                              (SHAPE_COLOR_INDEX_INT_T)k,
+                                              j->colorsCount[k]);
+            }
+        }
+
+        chunk_get_bounding_box_2(chunk, &min, &max);
+        bbMin.x = minimum(bbMin.x, origin.x + min.x);
+        bbMin.y = minimum(bbMin.y, origin.y + min.y);
+        bbMin.z = minimum(bbMin.z, origin.z + min.z);
+        bbMax.x = maximum(bbMax.x, origin.x + max.x);
+        bbMax.y = maximum(bbMax.y, origin.y + max.y);
+        bbMax.z = maximum(bbMax.z, origin.z + max.z);
+    }
+    if (s->nbBlocks > 0) {
+        s->bbMin = bbMin;
+        s->bbMax = bbMax;
+    }
+
+    // rebuilt on demand
+    _shape_slices_free(s);
+
+    _shape_combine_free(c);
+    return s;
+}
+
+Shape *shape_combine(Shape **shapes, const Matrix4x4 **transforms, const size_t count) {
+    ShapeCombine *c = shape_combine_new(shapes, transforms, count);
+    if (c == NULL) {
+        return NULL;
+    }
+    return shape_combine_end(c);
+}
+
 ColorPalette *shape_get_palette(const Shape *shape) {
     return shape->palette;
 }
@@ -817,6 +1507,14 @@ void shape_set_palette(Shape *shape, ColorPalette *palette, const bool retain) {
     }
     shape->palette = palette;
 
+    if (shape->lods != NULL) {
+        for (int i = 0; i < SHAPE_LOD_MAX_LEVEL; ++i) {
+            if (shape->lods[i] != NULL) {
+                shape_set_palette(shape->lods[i], palette, true);
+            }
+        }
+    }
+
     shape_refresh_all_vertices(shape);
 }
 
@@ -826,7 +1524,7 @@ void shape_remap_colors(Shape *s, const SHAPE_COLOR_INDEX_INT_T *remap) {
     SHAPE_COORDS_INT3_T chunkTo = chunk_utils_get_coords(
         (SHAPE_COORDS_INT3_T){s->bbMax.x - 1, s->bbMax.y - 1, s->bbMax.z - 1});
 
-    Block *b;
+    const Block *b;
     Chunk *chunk;
     SHAPE_COORDS_INT3_T coords_in_shape;
     for (SHAPE_COORDS_INT_T x = chunkFrom.x; x <= chunkTo.x; ++x) {
@@ -860,7 +1558,8 @@ void shape_remap_colors(Shape *s, const SHAPE_COLOR_INDEX_INT_T *remap) {
                                     continue;
                                 }
 
-                                block_set_color_index(b, newColor);
+                                // painting through the chunk, its blocks may be shared w/ copies
+                                chunk_paint_block(chunk, cx, cy, cz, newColor, NULL);
 
                                 color_palette_decrement_color(s->palette, prevColor, 1);
                                 color_palette_increment_color(s->palette, newColor, 1);
@@ -877,6 +1576,15 @@ void shape_remap_colors(Shape *s, const SHAPE_COLOR_INDEX_INT_T *remap) {
         }
     }
 
+    // LODs blocks use the same palette
+    if (s->lods != NULL) {
+        for (int i = 0; i < SHAPE_LOD_MAX_LEVEL; ++i) {
+            if (s->lods[i] != NULL) {
+                shape_remap_colors(s->lods[i], remap);
+            }
+        }
+    }
+
     if (_shape_get_rendering_flag(s, SHAPE_RENDERING_FLAG_BAKED_LIGHTING)) {
         shape_compute_baked_lighting(s);
     }
@@ -902,10 +1610,10 @@ const Block *shape_get_block(const Shape *const shape,
     return b;
 }
 
-Block *shape_get_block_immediate(const Shape *const shape,
-                                 const SHAPE_COORDS_INT_T x,
-                                 const SHAPE_COORDS_INT_T y,
-                                 const SHAPE_COORDS_INT_T z) {
+const Block *shape_get_block_immediate(const Shape *const shape,
+                                       const SHAPE_COORDS_INT_T x,
+                                       const SHAPE_COORDS_INT_T y,
+                                       const SHAPE_COORDS_INT_T z) {
 
     Chunk *chunk;
     CHUNK_COORDS_INT3_T coords_in_chunk;
@@ -1023,6 +1731,35 @@ void shape_reset_box(Shape *shape) {
         cclog_error("[shape_reset_box] shape arg is NULL. Abort.");
         return;
     }
+    if (shape->slices != NULL) {
+        if (shape->nbBlocks == 0) {
+            shape->bbMin = shape->bbMax = coords3_zero;
+        } else {
+            const ShapeSlices *slices = shape->slices;
+            _shape_slices_get_bounds(shape,
+                                     0,
+                                     slices->origin[0],
+                                     slices->origin[0] + (int32_t)slices->size[0],
+                                     &shape->bbMin.x,
+                                     &shape->bbMax.x);
+            _shape_slices_get_bounds(shape,
+                                     1,
+                                     slices->origin[1],
+                                     slices->origin[1] + (int32_t)slices->size[1],
+                                     &shape->bbMin.y,
+                                     &shape->bbMax.y);
+            _shape_slices_get_bounds(shape,
+                                     2,
+                                     slices->origin[2],
+                                     slices->origin[2] + (int32_t)slices->size[2],
+                                     &shape->bbMin.z,
+                                     &shape->bbMax.z);
+        }
+        shape_fit_collider_to_bounding_box(shape);
+        _shape_clear_cached_world_aabb(shape);
+        return;
+    }
+
     SHAPE_SIZE_INT_T size_x, size_y, size_z;
     SHAPE_COORDS_INT_T origin_x, origin_y, origin_z;
     _shape_compute_size_and_origin(shape,
@@ -1048,185 +1785,27 @@ void shape_shrink_box(Shape *shape, const SHAPE_COORDS_INT3_T coords) {
         return;
     }
 
-    const SHAPE_COORDS_INT3_T chunkMin = chunk_utils_get_coords(shape->bbMin);
-    const SHAPE_COORDS_INT3_T chunkMax = chunk_utils_get_coords(shape->bbMax);
-
-    // for each BB side the removed block was in, gather the new boundary from chunks BB
-    if (coords.x == shape->bbMax.x - 1) {
-        Chunk *c;
-        CHUNK_COORDS_INT3_T bbMax;
-        CHUNK_COORDS_INT_T max;
-        bool isEmpty = true, unchanged = false;
-        for (SHAPE_COORDS_INT_T x = chunkMax.x; isEmpty && x >= chunkMin.x; --x) {
-            max = 0;
-            for (SHAPE_COORDS_INT_T z = chunkMin.z; z <= chunkMax.z; ++z) {
-                for (SHAPE_COORDS_INT_T y = chunkMin.y; y <= chunkMax.y; ++y) {
-                    c = index3d_get(shape->chunks, x, y, z);
-                    if (c != NULL && chunk_get_nb_blocks(c) > 0) {
-                        isEmpty = false;
-                        chunk_get_bounding_box_2(c, NULL, &bbMax);
-                        max = maximum(max, bbMax.x);
-
-                        if (x == chunkMax.x && x * CHUNK_SIZE + bbMax.x == shape->bbMax.x) {
-                            unchanged = true;
-                            break; // no change, early stop
-                        }
-                    }
-                }
-                if (unchanged) {
-                    break;
-                }
-            }
-            if (isEmpty == false && unchanged == false) {
-                shape->bbMax.x = x * CHUNK_SIZE + max;
-            }
-        }
-    } else if (coords.x == shape->bbMin.x) {
-        Chunk *c;
-        CHUNK_COORDS_INT3_T bbMin;
-        CHUNK_COORDS_INT_T min;
-        bool isEmpty = true, unchanged = false;
-        for (SHAPE_COORDS_INT_T x = chunkMin.x; isEmpty && x <= chunkMax.x; ++x) {
-            min = CHUNK_SIZE;
-            for (SHAPE_COORDS_INT_T z = chunkMin.z; z <= chunkMax.z; ++z) {
-                for (SHAPE_COORDS_INT_T y = chunkMin.y; y <= chunkMax.y; ++y) {
-                    c = index3d_get(shape->chunks, x, y, z);
-                    if (c != NULL && chunk_get_nb_blocks(c) > 0) {
-                        isEmpty = false;
-                        chunk_get_bounding_box_2(c, &bbMin, NULL);
-                        min = minimum(min, bbMin.x);
-
-                        if (x == chunkMin.x && x * CHUNK_SIZE + bbMin.x == shape->bbMin.x) {
-                            unchanged = true; // no change, early stop
-                            break;
-                        }
-                    }
-                }
-                if (unchanged) {
-                    break;
-                }
-            }
-            if (isEmpty == false && unchanged == false) {
-                shape->bbMin.x = x * CHUNK_SIZE + min;
-            }
-        }
-    }
-    if (coords.y == shape->bbMax.y - 1) {
-        Chunk *c;
-        CHUNK_COORDS_INT3_T bbMax;
-        CHUNK_COORDS_INT_T max;
-        bool isEmpty = true, unchanged = false;
-        for (SHAPE_COORDS_INT_T y = chunkMax.y; isEmpty && y >= chunkMin.y; --y) {
-            max = 0;
-            for (SHAPE_COORDS_INT_T z = chunkMin.z; z <= chunkMax.z; ++z) {
-                for (SHAPE_COORDS_INT_T x = chunkMin.x; x <= chunkMax.x; ++x) {
-                    c = index3d_get(shape->chunks, x, y, z);
-                    if (c != NULL && chunk_get_nb_blocks(c) > 0) {
-                        isEmpty = false;
-                        chunk_get_bounding_box_2(c, NULL, &bbMax);
-                        max = maximum(max, bbMax.y);
-
-                        if (y == chunkMax.y && y * CHUNK_SIZE + bbMax.y == shape->bbMax.y) {
-                            unchanged = true; // no change, early stop
-                            break;
-                        }
-                    }
-                }
-                if (unchanged) {
-                    break;
-                }
-            }
-            if (isEmpty == false && unchanged == false) {
-                shape->bbMax.y = y * CHUNK_SIZE + max;
-            }
-        }
-    } else if (coords.y == shape->bbMin.y) {
-        Chunk *c;
-        CHUNK_COORDS_INT3_T bbMin;
-        CHUNK_COORDS_INT_T min;
-        bool isEmpty = true, unchanged = false;
-        for (SHAPE_COORDS_INT_T y = chunkMin.y; isEmpty && y <= chunkMax.y; ++y) {
-            min = CHUNK_SIZE;
-            for (SHAPE_COORDS_INT_T z = chunkMin.z; z <= chunkMax.z; ++z) {
-                for (SHAPE_COORDS_INT_T x = chunkMin.x; x <= chunkMax.x; ++x) {
-                    c = index3d_get(shape->chunks, x, y, z);
-                    if (c != NULL && chunk_get_nb_blocks(c) > 0) {
-                        isEmpty = false;
-                        chunk_get_bounding_box_2(c, &bbMin, NULL);
-                        min = minimum(min, bbMin.y);
-
-                        if (y == chunkMin.y && y * CHUNK_SIZE + bbMin.y == shape->bbMin.y) {
-                            unchanged = true; // no change, early stop
-                            break;
-                        }
-                    }
-                }
-                if (unchanged) {
-                    break;
-                }
-            }
-            if (isEmpty == false && unchanged == false) {
-                shape->bbMin.y = y * CHUNK_SIZE + min;
-            }
+    if (shape->slices == NULL) {
+        _shape_slices_build(shape);
+        if (shape->slices == NULL) {
+            shape_reset_box(shape);
+            return;
         }
     }
-    if (coords.z == shape->bbMax.z - 1) {
-        Chunk *c;
-        CHUNK_COORDS_INT3_T bbMax;
-        CHUNK_COORDS_INT_T max;
-        bool isEmpty = true, unchanged = false;
-        for (SHAPE_COORDS_INT_T z = chunkMax.z; isEmpty && z >= chunkMin.z; --z) {
-            max = 0;
-            for (SHAPE_COORDS_INT_T x = chunkMin.x; x <= chunkMax.x; ++x) {
-                for (SHAPE_COORDS_INT_T y = chunkMin.y; y <= chunkMax.y; ++y) {
-                    c = index3d_get(shape->chunks, x, y, z);
-                    if (c != NULL && chunk_get_nb_blocks(c) > 0) {
-                        isEmpty = false;
-                        chunk_get_bounding_box_2(c, NULL, &bbMax);
-                        max = maximum(max, bbMax.z);
-
-                        if (z == chunkMax.z && z * CHUNK_SIZE + bbMax.z == shape->bbMax.z) {
-                            unchanged = true; // no change, early stop
-                            break;
-                        }
-                    }
-                }
-                if (unchanged) {
-                    break;
-                }
-            }
-            if (isEmpty == false && unchanged == false) {
-                shape->bbMax.z = z * CHUNK_SIZE + max;
-            }
-        }
-    } else if (coords.z == shape->bbMin.z) {
-        Chunk *c;
-        CHUNK_COORDS_INT3_T bbMin;
-        CHUNK_COORDS_INT_T min;
-        bool isEmpty = true, unchanged = false;
-        for (SHAPE_COORDS_INT_T z = chunkMin.z; isEmpty && z <= chunkMax.z; ++z) {
-            min = CHUNK_SIZE;
-            for (SHAPE_COORDS_INT_T x = chunkMin.x; x <= chunkMax.x; ++x) {
-                for (SHAPE_COORDS_INT_T y = chunkMin.y; y <= chunkMax.y; ++y) {
-                    c = index3d_get(shape->chunks, x, y, z);
-                    if (c != NULL && chunk_get_nb_blocks(c) > 0) {
-                        isEmpty = false;
-                        chunk_get_bounding_box_2(c, &bbMin, NULL);
-                        min = minimum(min, bbMin.z);
-
-                        if (z == chunkMin.z && z * CHUNK_SIZE + bbMin.z == shape->bbMin.z) {
-                            unchanged = true; // no change, early stop
-                            break;
-                        }
-                    }
-                }
-                if (unchanged) {
-                    break;
-                }
-            }
-            if (isEmpty == false && unchanged == false) {
-                shape->bbMin.z = z * CHUNK_SIZE + min;
-            }
+
+    // for each BB side the removed block was in, skip slices that are now empty, only the ones
+    // emptied since last shrink are visited
+    const SHAPE_COORDS_INT_T coordsArr[3] = {coords.x, coords.y, coords.z};
+    SHAPE_COORDS_INT_T *mins[3] = {&shape->bbMin.x, &shape->bbMin.y, &shape->bbMin.z};
+    SHAPE_COORDS_INT_T *maxs[3] = {&shape->bbMax.x, &shape->bbMax.y, &shape->bbMax.z};
+    for (int axis = 0; axis < 3; ++axis) {
+        if (coordsArr[axis] == *maxs[axis] - 1 || coordsArr[axis] == *mins[axis]) {
+            _shape_slices_get_bounds(shape,
+                                     axis,
+                                     *mins[axis],
+                                     *maxs[axis],
+                                     mins[axis],
+                                     maxs[axis]);
         }
     }
 
@@ -1650,9 +2229,12 @@ VertexBuffer *shape_add_buffer(Shape *shape, bool transparency) {
 
     // create and add new VB to the appropriate chain
     // Note: order in chain doesn't matter, but we keep the same 1st ptr for convenience
-    VertexBuffer *vb = vertex_buffer_new_with_max_count(facesCapacity *
-                                                            DRAWBUFFER_VERTICES_PER_FACE,
-                                                        transparency);
+    VertexBuffer *vb = vertex_buffer_new_with_format(
+        facesCapacity * DRAWBUFFER_VERTICES_PER_FACE,
+        transparency,
+        _shape_get_rendering_flag(shape, SHAPE_RENDERING_FLAG_COMPACT_VERTICES)
+            ? VertexFormatCompact
+            : VertexFormatDefault);
     if (transparency) {
         if (shape->firstVB_transparent != NULL) {
             vertex_buffer_insert_after(vb, shape->firstVB_transparent);
@@ -1670,6 +2252,12 @@ VertexBuffer *shape_add_buffer(Shape *shape, bool transparency) {
 }
 
 void shape_refresh_vertices(Shape *shape) {
+    // instances are drawn w/ their model's buffers, refreshing them even if the model isn't drawn
+    if (shape->model != NULL) {
+        shape_refresh_vertices(shape->model);
+        return;
+    }
+
     if (_shape_get_rendering_flag(shape, SHAPE_RENDERING_FLAG_BAKE_LOCKED)) {
         _shape_fill_draw_slices(shape->firstVB_opaque);
         _shape_fill_draw_slices(shape->firstVB_transparent);
@@ -1678,6 +2266,12 @@ void shape_refresh_vertices(Shape *shape) {
 
     Chunk *c = shape->dirtyChunks != NULL ? fifo_list_pop(shape->dirtyChunks) : NULL;
     if (c == NULL) {
+        // keep compacting buffers left fragmented by a previous refresh
+        if (doubly_linked_list_first(shape->fragmentedVBs) != NULL) {
+            _shape_fill_gaps(shape);
+            _shape_fill_draw_slices(shape->firstVB_opaque);
+            _shape_fill_draw_slices(shape->firstVB_transparent);
+        }
         return;
     }
     while (c != NULL) {
@@ -1697,6 +2291,7 @@ void shape_refresh_vertices(Shape *shape) {
             rtree_remove(shape->rtree, chunk_get_rtree_leaf(c), true);
             chunk_free(c, true);
             c = NULL;
+            _shape_chunk_removed(shape, chunk_coords);
 
             shape->nbChunks--;
         }
@@ -1712,30 +2307,8 @@ void shape_refresh_vertices(Shape *shape) {
         c = fifo_list_pop(shape->dirtyChunks);
     }
 
-    // check all vertex buffers used by this shape, to see if they have to be defragmented
-    _shape_check_all_vb_fragmented(shape, shape->firstVB_opaque);
-    _shape_check_all_vb_fragmented(shape, shape->firstVB_transparent);
-
     // DEFRAGMENTATION
-
-    // fill remaining mem area gaps (for all vertex buffers involved)
-    VertexBuffer *fragmentedVB = (VertexBuffer *)doubly_linked_list_pop_first(shape->fragmentedVBs);
-
-    // bool log = true; // fragmentedVB != NULL;
-
-    //    if (log) {
-    //        shape_log_vertex_buffers(shape, true);
-    //    }
-
-    while (fragmentedVB != NULL) {
-        vertex_buffer_fill_gaps(fragmentedVB);
-
-        fragmentedVB = (VertexBuffer *)doubly_linked_list_pop_first(shape->fragmentedVBs);
-    }
-
-    //    if (log) {
-    //        shape_log_vertex_buffers(shape, true);
-    //    }
+    _shape_fill_gaps(shape);
 
     // fill draw slices after defragmentation
     _shape_fill_draw_slices(shape->firstVB_opaque);
@@ -1745,6 +2318,13 @@ void shape_refresh_vertices(Shape *shape) {
 }
 
 void shape_refresh_all_vertices(Shape *s) {
+    if (s->model != NULL) {
+        _shape_instance_detach(s, false);
+    }
+    if (s->instances != NULL) {
+        _shape_detach_instances(s);
+    }
+
     // refresh all chunks
     Index3DIterator *it = index3d_iterator_new(s->chunks);
     Chunk *chunk;
@@ -1769,13 +2349,49 @@ void shape_refresh_all_vertices(Shape *s) {
     }
 }
 
-VertexBuffer *shape_get_first_vertex_buffer(const Shape *shape, bool transparent) {
-    return transparent ? shape->firstVB_transparent : shape->firstVB_opaque;
-}
-
-// MARK: - Physics -
+void shape_prune_dirty_chunks(Shape *s) {
+    if (s->dirtyChunks == NULL) {
+        return;
+    }
 
-Rtree *shape_get_rtree(const Shape *shape) {
+    FifoList *dirtyChunks = fifo_list_new();
+    Chunk *c = fifo_list_pop(s->dirtyChunks);
+    while (c != NULL) {
+        if (chunk_is_dirty(c)) {
+            fifo_list_push(dirtyChunks, c);
+        }
+        c = fifo_list_pop(s->dirtyChunks);
+    }
+    fifo_list_free(s->dirtyChunks, NULL);
+    s->dirtyChunks = dirtyChunks;
+
+    // draw slices of vertices written outside of refresh
+    _shape_fill_draw_slices(s->firstVB_opaque);
+    _shape_fill_draw_slices(s->firstVB_transparent);
+}
+
+VertexBuffer *shape_get_first_vertex_buffer(const Shape *shape, bool transparent) {
+    if (shape->model != NULL) {
+        shape = shape->model;
+    }
+    return transparent ? shape->firstVB_transparent : shape->firstVB_opaque;
+}
+
+Shape *shape_get_model(Shape *s) {
+    return s->model != NULL ? s->model : s;
+}
+
+bool shape_is_instance(const Shape *s) {
+    return s->model != NULL;
+}
+
+const DoublyLinkedList *shape_get_instances(const Shape *model) {
+    return model->instances;
+}
+
+// MARK: - Physics -
+
+Rtree *shape_get_rtree(const Shape *shape) {
     vx_assert(shape != NULL);
     return shape->rtree;
 }
@@ -1862,7 +2478,7 @@ float shape_box_cast(const Shape *s,
                      const bool withReplacement,
                      float3 *normal,
                      float3 *extraReplacement,
-                     Block **block,
+                     const Block **block,
                      SHAPE_COORDS_INT3_T *blockCoords) {
 
     if (normal != NULL) {
@@ -1879,6 +2495,20 @@ float shape_box_cast(const Shape *s,
                          modelVector->y / maxDist,
                          modelVector->z / maxDist};
 
+    // long casts skip empty space instead of examining every chunk along the way
+    if (maxDist > SHAPE_CAST_ADVANCEMENT_DISTANCE) {
+        return _shape_box_cast_advancing(s,
+                                         modelBox,
+                                         &unit,
+                                         maxDist,
+                                         modelEpsilon,
+                                         withReplacement,
+                                         normal,
+                                         extraReplacement,
+                                         block,
+                                         blockCoords);
+    }
+
     // select overlapped chunks
     DoublyLinkedList *chunksQuery = doubly_linked_list_new();
     if (rtree_query_cast_all_box(s->rtree,
@@ -1899,9 +2529,10 @@ float shape_box_cast(const Shape *s,
         // examine query results in order, return first hit block
         DoublyLinkedListNode *n = doubly_linked_list_first(chunksQuery);
         RtreeCastResult *rtreeHit;
-        OctreeIterator *oi;
         Chunk *c;
-        bool didHit = false, leaf;
+        CHUNK_COORDS_INT3_T min, max;
+        CHUNK_ROW_MASK_T xMask, row;
+        bool didHit = false;
         float3 tmpNormal, tmpReplacement;
         float swept = 1.0f, lastRtreeDist = FLT_MAX;
         while (n != NULL) {
@@ -1916,110 +2547,106 @@ float shape_box_cast(const Shape *s,
             lastRtreeDist = rtreeHit->distance;
 
             const SHAPE_COORDS_INT3_T chunkOrigin = chunk_get_origin(c);
-            leaf = false;
 #if PHYSICS_EXTRA_REPLACEMENTS
             float blockedX = false, blockedY = false, blockedZ = false;
 #endif
 
-            oi = octree_iterator_new(chunk_get_octree(c));
-            while (octree_iterator_is_done(oi) == false) {
-                octree_iterator_get_node_box(oi, &tmpBox);
-
-                // chunk octree box in model space
-                tmpBox.min.x += chunkOrigin.x;
-                tmpBox.min.y += chunkOrigin.y;
-                tmpBox.min.z += chunkOrigin.z;
-                tmpBox.max.x += chunkOrigin.x;
-                tmpBox.max.y += chunkOrigin.y;
-                tmpBox.max.z += chunkOrigin.z;
-
-                const bool collides = box_collide_epsilon(&tmpBox,
-                                                          &broadPhaseBox,
-                                                          EPSILON_COLLISION);
-                if (leaf && collides) {
-                    swept = box_swept(modelBox,
-                                      modelVector,
-                                      &tmpBox,
-                                      modelEpsilon,
-                                      withReplacement,
-                                      &tmpNormal,
-                                      &tmpReplacement);
-                    if (swept < minSwept) {
-                        minSwept = swept;
-                        didHit = true;
-                        if (normal != NULL) {
-                            *normal = tmpNormal;
-                        }
-                        if (block != NULL) {
-                            *block = (Block *)octree_iterator_get_element(oi);
-                        }
-                        if (blockCoords != NULL) {
-                            uint16_t x, y, z;
-                            octree_iterator_get_current_position(oi, &x, &y, &z);
-                            blockCoords->x = (SHAPE_COORDS_INT_T)x;
-                            blockCoords->y = (SHAPE_COORDS_INT_T)y;
-                            blockCoords->z = (SHAPE_COORDS_INT_T)z;
+            // test solid blocks within broadphase box, skipping empty rows at once
+            if (_shape_chunk_get_colliding_range(c, &broadPhaseBox, &min, &max) == false) {
+                n = doubly_linked_list_node_next(n);
+                continue;
+            }
+            xMask = chunk_utils_get_row_mask(min.x, max.x);
+            for (CHUNK_COORDS_INT_T z = min.z; z <= max.z; ++z) {
+                for (CHUNK_COORDS_INT_T y = min.y; y <= max.y; ++y) {
+                    row = chunk_get_solid_row(c, y, z) & xMask;
+                    for (CHUNK_COORDS_INT_T x = min.x; row != 0; ++x) {
+                        if ((row & (1u << x)) == 0) {
+                            continue;
                         }
-                    }
-#if PHYSICS_EXTRA_REPLACEMENTS
-                    if (extraReplacement != NULL) {
-                        if (tmpReplacement.x != 0.0f && blockedX == false) {
-                            // previous replacement is positive and new replacement is positive &
-                            // bigger
-                            if (extraReplacement->x >= 0.0f &&
-                                tmpReplacement.x > extraReplacement->x) {
-                                extraReplacement->x = tmpReplacement.x;
+                        row &= (CHUNK_ROW_MASK_T) ~(1u << x);
+
+                        // block box in model space
+                        tmpBox.min = (float3){(float)(chunkOrigin.x + x),
+                                              (float)(chunkOrigin.y + y),
+                                              (float)(chunkOrigin.z + z)};
+                        tmpBox.max = (float3){tmpBox.min.x + 1.0f,
+                                              tmpBox.min.y + 1.0f,
+                                              tmpBox.min.z + 1.0f};
+
+                        swept = box_swept(modelBox,
+                                          modelVector,
+                                          &tmpBox,
+                                          modelEpsilon,
+                                          withReplacement,
+                                          &tmpNormal,
+                                          &tmpReplacement);
+                        if (swept < minSwept) {
+                            minSwept = swept;
+                            didHit = true;
+                            if (normal != NULL) {
+                                *normal = tmpNormal;
                             }
-                            // previous replacement is negative and new replacement is negative &
-                            // bigger
-                            else if (extraReplacement->x <= 0.0f &&
-                                     tmpReplacement.x < extraReplacement->x) {
-                                extraReplacement->x = tmpReplacement.x;
+                            if (block != NULL) {
+                                *block = chunk_get_block(c, x, y, z);
                             }
-                            // previous & new replacements are opposite... this axis is blocked,
-                            // set to 0 to avoid stuttering and wait for another axis to replace
-                            else if (extraReplacement->x * tmpReplacement.x < 0.0f) {
-                                extraReplacement->x = 0.0f;
-                                blockedX = true;
+                            if (blockCoords != NULL) {
+                                blockCoords->x = (SHAPE_COORDS_INT_T)(chunkOrigin.x + x);
+                                blockCoords->y = (SHAPE_COORDS_INT_T)(chunkOrigin.y + y);
+                                blockCoords->z = (SHAPE_COORDS_INT_T)(chunkOrigin.z + z);
                             }
                         }
-                        if (tmpReplacement.y != 0.0f && blockedY == false) {
-                            if (extraReplacement->y >= 0.0f &&
-                                tmpReplacement.y > extraReplacement->y) {
-                                extraReplacement->y = tmpReplacement.y;
-                            } else if (extraReplacement->y <= 0.0f &&
-                                       tmpReplacement.y < extraReplacement->y) {
-                                extraReplacement->y = tmpReplacement.y;
-                            } else if (extraReplacement->y * tmpReplacement.y < 0.0f) {
-                                extraReplacement->y = 0.0f;
-                                blockedX = true;
+#if PHYSICS_EXTRA_REPLACEMENTS
+                        if (extraReplacement != NULL) {
+                            if (tmpReplacement.x != 0.0f && blockedX == false) {
+                                // previous replacement is positive and new replacement is
+                                // positive & bigger
+                                if (extraReplacement->x >= 0.0f &&
+                                    tmpReplacement.x > extraReplacement->x) {
+                                    extraReplacement->x = tmpReplacement.x;
+                                }
+                                // previous replacement is negative and new replacement is
+                                // negative & bigger
+                                else if (extraReplacement->x <= 0.0f &&
+                                         tmpReplacement.x < extraReplacement->x) {
+                                    extraReplacement->x = tmpReplacement.x;
+                                }
+                                // previous & new replacements are opposite... this axis is
+                                // blocked, set to 0 to avoid stuttering and wait for another axis
+                                // to replace
+                                else if (extraReplacement->x * tmpReplacement.x < 0.0f) {
+                                    extraReplacement->x = 0.0f;
+                                    blockedX = true;
+                                }
                             }
-                        }
-                        if (tmpReplacement.z != 0.0f && blockedZ == false) {
-                            if (extraReplacement->z >= 0.0f &&
-                                tmpReplacement.z > extraReplacement->z) {
-                                extraReplacement->z = tmpReplacement.z;
-                            } else if (extraReplacement->z <= 0.0f &&
-                                       tmpReplacement.z < extraReplacement->z) {
-                                extraReplacement->z = tmpReplacement.z;
-                            } else if (extraReplacement->z * tmpReplacement.z < 0.0f) {
-                                extraReplacement->z = 0.0f;
-                                blockedX = true;
+                            if (tmpReplacement.y != 0.0f && blockedY == false) {
+                                if (extraReplacement->y >= 0.0f &&
+                                    tmpReplacement.y > extraReplacement->y) {
+                                    extraReplacement->y = tmpReplacement.y;
+                                } else if (extraReplacement->y <= 0.0f &&
+                                           tmpReplacement.y < extraReplacement->y) {
+                                    extraReplacement->y = tmpReplacement.y;
+                                } else if (extraReplacement->y * tmpReplacement.y < 0.0f) {
+                                    extraReplacement->y = 0.0f;
+                                    blockedX = true;
+                                }
+                            }
+                            if (tmpReplacement.z != 0.0f && blockedZ == false) {
+                                if (extraReplacement->z >= 0.0f &&
+                                    tmpReplacement.z > extraReplacement->z) {
+                                    extraReplacement->z = tmpReplacement.z;
+                                } else if (extraReplacement->z <= 0.0f &&
+                                           tmpReplacement.z < extraReplacement->z) {
+                                    extraReplacement->z = tmpReplacement.z;
+                                } else if (extraReplacement->z * tmpReplacement.z < 0.0f) {
+                                    extraReplacement->z = 0.0f;
+                                    blockedX = true;
+                                }
                             }
                         }
-                    }
 #endif
+                    }
                 }
-
-                octree_iterator_next(oi, collides == false && leaf == false, &leaf);
-            }
-            octree_iterator_free(oi);
-
-            if (didHit && blockCoords != NULL) {
-                // chunk block coordinates in model space
-                blockCoords->x += chunkOrigin.x;
-                blockCoords->y += chunkOrigin.y;
-                blockCoords->z += chunkOrigin.z;
             }
 
             n = doubly_linked_list_node_next(n);
@@ -2036,7 +2663,7 @@ bool shape_ray_cast(const Transform *t,
                     const Ray *worldRay,
                     float *worldDistance,
                     float3 *localImpact,
-                    Block **block,
+                    const Block **block,
                     SHAPE_COORDS_INT3_T *coords) {
 
     if (s == NULL || worldRay == NULL) {
@@ -2205,40 +2832,22 @@ bool shape_box_overlap(const Shape *s, const Box *modelBox, const float3 *modelE
 
         // examine query results, stop at first overlap
         RtreeNode *hit = fifo_list_pop(chunksQuery);
-        OctreeIterator *oi;
-        bool leaf;
+        CHUNK_COORDS_INT3_T min, max, coords;
         Chunk *c;
-        Box tmpBox;
         while (hit != NULL && didHit == false) {
             c = (Chunk *)rtree_node_get_leaf_ptr(hit);
 
-            const SHAPE_COORDS_INT3_T chunkOrigin = chunk_get_origin(c);
-            leaf = false;
-
-            oi = octree_iterator_new(chunk_get_octree(c));
-            while (octree_iterator_is_done(oi) == false) {
-                octree_iterator_get_node_box(oi, &tmpBox);
-
-                // chunk octree box in model space
-                tmpBox.min.x += chunkOrigin.x;
-                tmpBox.min.y += chunkOrigin.y;
-                tmpBox.min.z += chunkOrigin.z;
-                tmpBox.max.x += chunkOrigin.x;
-                tmpBox.max.y += chunkOrigin.y;
-                tmpBox.max.z += chunkOrigin.z;
-
-                const bool collides = box_collide_epsilon(modelBox, &tmpBox, EPSILON_COLLISION);
-                if (leaf && collides) {
-                    didHit = true;
-                    if (out != NULL) {
-                        *out = tmpBox;
-                    }
-                    break;
+            if (_shape_chunk_get_colliding_range(c, modelBox, &min, &max) &&
+                chunk_get_first_solid_block_in_range(c, min, max, &coords)) {
+                didHit = true;
+                if (out != NULL) {
+                    const SHAPE_COORDS_INT3_T chunkOrigin = chunk_get_origin(c);
+                    out->min = (float3){(float)(chunkOrigin.x + coords.x),
+                                        (float)(chunkOrigin.y + coords.y),
+                                        (float)(chunkOrigin.z + coords.z)};
+                    out->max = (float3){out->min.x + 1.0f, out->min.y + 1.0f, out->min.z + 1.0f};
                 }
-
-                octree_iterator_next(oi, collides == false && leaf == false, &leaf);
             }
-            octree_iterator_free(oi);
 
             hit = fifo_list_pop(chunksQuery);
         }
@@ -2248,6 +2857,90 @@ bool shape_box_overlap(const Shape *s, const Box *modelBox, const float3 *modelE
     return didHit;
 }
 
+uint32_t shape_get_blocks_stamp(const Shape *s) {
+    return s->blocksStamp;
+}
+
+bool shape_blocks_changed_in_box(const Shape *s, const Box *modelBox, const uint32_t stamp) {
+    if (s->blocksStamp == stamp) {
+        return false;
+    }
+    // removals older than the tracked ones can't be located
+    if (s->chunksStamp > stamp) {
+        return true;
+    }
+
+    int3 min, max;
+    _shape_get_chunks_range(modelBox, &min, &max);
+
+    // new chunks are stamped, removed ones are looked up in the last removals
+    SHAPE_COORDS_INT3_T removed;
+    for (uint8_t i = 0; i < SHAPE_REMOVED_CHUNKS_HISTORY; ++i) {
+        removed = s->removedChunks[i];
+        if (s->removedChunksStamps[i] > stamp && removed.x >= min.x && removed.x <= max.x &&
+            removed.y >= min.y && removed.y <= max.y && removed.z >= min.z && removed.z <= max.z) {
+            return true;
+        }
+    }
+    const Chunk *c;
+    for (int z = min.z; z <= max.z; ++z) {
+        for (int y = min.y; y <= max.y; ++y) {
+            for (int x = min.x; x <= max.x; ++x) {
+                c = (const Chunk *)index3d_get(s->chunks, x, y, z);
+                if (c != NULL && chunk_get_stamp(c) > stamp) {
+                    return true;
+                }
+            }
+        }
+    }
+    return false;
+}
+
+uint32_t shape_get_solid_blocks_in_box(const Shape *s,
+                                       const Box *modelBox,
+                                       SHAPE_COORDS_INT3_T *coords,
+                                       const uint32_t max) {
+    int3 chunkMin, chunkMax;
+    _shape_get_chunks_range(modelBox, &chunkMin, &chunkMax);
+
+    uint32_t count = 0;
+    const Chunk *c;
+    CHUNK_COORDS_INT3_T min, max3;
+    CHUNK_ROW_MASK_T xMask, row;
+    for (int cz = chunkMin.z; cz <= chunkMax.z; ++cz) {
+        for (int cy = chunkMin.y; cy <= chunkMax.y; ++cy) {
+            for (int cx = chunkMin.x; cx <= chunkMax.x; ++cx) {
+                c = (const Chunk *)index3d_get(s->chunks, cx, cy, cz);
+                if (c == NULL ||
+                    _shape_chunk_get_colliding_range(c, modelBox, &min, &max3) == false) {
+                    continue;
+                }
+                const SHAPE_COORDS_INT3_T origin = chunk_get_origin(c);
+                xMask = chunk_utils_get_row_mask(min.x, max3.x);
+                for (CHUNK_COORDS_INT_T z = min.z; z <= max3.z; ++z) {
+                    for (CHUNK_COORDS_INT_T y = min.y; y <= max3.y; ++y) {
+                        row = chunk_get_solid_row(c, y, z) & xMask;
+                        for (CHUNK_COORDS_INT_T x = min.x; row != 0; ++x) {
+                            if ((row & (1u << x)) == 0) {
+                                continue;
+                            }
+                            row &= (CHUNK_ROW_MASK_T) ~(1u << x);
+                            if (count == max) {
+                                return max + 1;
+                            }
+                            coords[count++] = (SHAPE_COORDS_INT3_T){
+                                (SHAPE_COORDS_INT_T)(origin.x + x),
+                                (SHAPE_COORDS_INT_T)(origin.y + y),
+                                (SHAPE_COORDS_INT_T)(origin.z + z)};
+                        }
+                    }
+                }
+            }
+        }
+    }
+    return count;
+}
+
 // MARK: - Graphics -
 
 bool shape_is_hidden(Shape *s) {
@@ -2332,6 +3025,30 @@ bool shape_is_unlit(const Shape *s) {
     return _shape_get_rendering_flag(s, SHAPE_RENDERING_FLAG_UNLIT);
 }
 
+void shape_set_compact_vertices(Shape *s, const bool value) {
+    if (_shape_get_rendering_flag(s, SHAPE_RENDERING_FLAG_COMPACT_VERTICES) == value) {
+        return;
+    }
+    _shape_toggle_rendering_flag(s, SHAPE_RENDERING_FLAG_COMPACT_VERTICES, value);
+
+    // instances can't be drawn w/ their model's buffers if using a different format
+    if (s->model != NULL) {
+        _shape_instance_detach(s, true);
+    }
+    if (s->instances != NULL) {
+        _shape_detach_instances(s);
+    }
+
+    // existing buffers are re-created w/ the new format on next refresh
+    if (s->firstVB_opaque != NULL || s->firstVB_transparent != NULL) {
+        _shape_flush_all_vb(s);
+    }
+}
+
+bool shape_uses_compact_vertices(const Shape *s) {
+    return _shape_get_rendering_flag(s, SHAPE_RENDERING_FLAG_COMPACT_VERTICES);
+}
+
 void shape_set_layers(Shape *s, const uint16_t value) {
     s->layers = value;
 }
@@ -2340,6 +3057,177 @@ uint16_t shape_get_layers(const Shape *s) {
     return s->layers;
 }
 
+size_t shape_query_visible_chunks(const Shape *s,
+                                  const Matrix4x4 *viewProj,
+                                  OcclusionBuffer *ob,
+                                  FifoList *results) {
+    if (s == NULL || viewProj == NULL) {
+        return 0;
+    }
+
+    // chunks boxes are in model space
+    Matrix4x4 model;
+    transform_utils_get_model_ltw(s->transform, &model);
+    Matrix4x4 mvp = *viewProj;
+    matrix4x4_op_multiply(&mvp, &model);
+
+    Frustum frustum;
+    frustum_set_from_matrix(&frustum, &mvp);
+
+    FifoList *chunksQuery = fifo_list_new();
+    const size_t nbChunks = rtree_query_overlap_func(s->rtree,
+                                                     0,
+                                                     1,
+                                                     _shape_query_frustum_func,
+                                                     &frustum,
+                                                     NULL,
+                                                     chunksQuery,
+                                                     NULL);
+    if (nbChunks == 0) {
+        fifo_list_free(chunksQuery, NULL);
+        return 0;
+    }
+
+    Chunk **chunks = (Chunk **)malloc(nbChunks * sizeof(Chunk *));
+    if (chunks == NULL) {
+        fifo_list_free(chunksQuery, NULL);
+        return 0;
+    }
+    for (size_t i = 0; i < nbChunks; ++i) {
+        chunks[i] = (Chunk *)rtree_node_get_leaf_ptr((RtreeNode *)fifo_list_pop(chunksQuery));
+    }
+    fifo_list_free(chunksQuery, NULL);
+
+    Box box;
+    SHAPE_COORDS_INT3_T origin;
+    if (ob != NULL && _shape_has_transparent_blocks(s) == false) {
+        int x;
+        for (size_t i = 0; i < nbChunks; ++i) {
+            if (_shape_chunk_is_full(chunks[i]) == false) {
+                continue;
+            }
+            // neighbor full chunks are merged into larger occluders, since seams between two
+            // occluders can't hide anything
+            x = chunk_get_origin(chunks[i]).x / CHUNK_SIZE;
+            if (_shape_chunk_is_full(chunk_get_neighbor(chunks[i], NX)) &&
+                (x % SHAPE_OCCLUDER_MAX_CHUNKS + SHAPE_OCCLUDER_MAX_CHUNKS) %
+                        SHAPE_OCCLUDER_MAX_CHUNKS !=
+                    0) {
+                continue;
+            }
+            _shape_get_occluder_box(chunks[i], &box);
+            if (occlusion_buffer_add_occluder(ob, &mvp, &box) == false) {
+                // merged box may cross near plane
+                origin = chunk_get_origin(chunks[i]);
+                box.min = (float3){(float)origin.x, (float)origin.y, (float)origin.z};
+                box.max = (float3){box.min.x + CHUNK_SIZE,
+                                   box.min.y + CHUNK_SIZE,
+                                   box.min.z + CHUNK_SIZE};
+                occlusion_buffer_add_occluder(ob, &mvp, &box);
+            }
+        }
+    }
+
+    size_t visible = 0;
+    for (size_t i = 0; i < nbChunks; ++i) {
+        if (ob != NULL) {
+            // tight chunk box
+            origin = chunk_get_origin(chunks[i]);
+            chunk_get_bounding_box(chunks[i], &box.min, &box.max);
+            box.min.x += origin.x;
+            box.min.y += origin.y;
+            box.min.z += origin.z;
+            box.max.x += origin.x;
+            box.max.y += origin.y;
+            box.max.z += origin.z;
+
+            if (occlusion_buffer_is_box_occluded(ob, &mvp, &box)) {
+                continue;
+            }
+        }
+        if (results != NULL) {
+            fifo_list_push(results, chunks[i]);
+        }
+        ++visible;
+    }
+    free(chunks);
+
+    return visible;
+}
+
+// MARK: - LOD -
+
+Shape *shape_get_lod(Shape *s, const uint8_t level) {
+    if (s == NULL || level > SHAPE_LOD_MAX_LEVEL) {
+        return NULL;
+    }
+    if (level == 0) {
+        return s;
+    }
+
+    if (s->lods == NULL) {
+        s->lods = (Shape **)calloc(SHAPE_LOD_MAX_LEVEL, sizeof(Shape *));
+        if (s->lods == NULL) {
+            return NULL;
+        }
+        s->lodDirtyChunks = index3d_new();
+    }
+
+    // downsample chunks changed since last request, for all existing LODs
+    Index3DIterator *it = index3d_iterator_new(s->lodDirtyChunks);
+    const int3 *chunkCoords;
+    while (index3d_iterator_pointer(it) != NULL) {
+        chunkCoords = (const int3 *)index3d_iterator_pointer(it);
+        for (uint8_t i = 0; i < SHAPE_LOD_MAX_LEVEL; ++i) {
+            if (s->lods[i] != NULL) {
+                _shape_lod_refresh_chunk(s, s->lods[i], i + 1, chunkCoords);
+            }
+        }
+        index3d_iterator_next(it);
+    }
+    index3d_iterator_free(it);
+    index3d_flush(s->lodDirtyChunks, free);
+
+    Shape *lod = s->lods[level - 1];
+    if (lod == NULL) {
+        lod = _shape_lod_build(s, level);
+        s->lods[level - 1] = lod;
+    }
+
+    // follow pivot changes
+    const float scale = (float)(1 << level);
+    const float3 pivot = shape_get_pivot(s);
+    const float3 lodPivot = {pivot.x / scale, pivot.y / scale, pivot.z / scale};
+    const float3 current = shape_get_pivot(lod);
+    if (float3_isEqual(&current, &lodPivot, EPSILON_ZERO) == false) {
+        shape_set_pivot(lod, lodPivot.x, lodPivot.y, lodPivot.z);
+    }
+
+    return lod;
+}
+
+uint8_t shape_get_lod_level_for_distance(Shape *s, const float distance) {
+    if (s == NULL) {
+        return 0;
+    }
+
+    float3 scale;
+    transform_get_lossy_scale(s->transform, &scale, false);
+    const float blockSize = maximum(maximum(scale.x, scale.y), scale.z);
+    if (blockSize <= 0.0f) {
+        return 0;
+    }
+
+    const float blocks = distance / blockSize;
+    float threshold = SHAPE_LOD_DISTANCE;
+    uint8_t level = 0;
+    while (level < SHAPE_LOD_MAX_LEVEL && blocks >= threshold) {
+        ++level;
+        threshold *= 2.0f;
+    }
+    return level;
+}
+
 // MARK: - POI -
 
 MapStringFloat3Iterator *shape_get_poi_iterator(const Shape *s) {
@@ -2396,6 +3284,33 @@ void shape_compute_baked_lighting(Shape *s) {
 #endif
 }
 
+void shape_compute_baked_lighting_in_chunks(Shape *s,
+                                            SHAPE_COORDS_INT3_T chunkMin,
+                                            SHAPE_COORDS_INT3_T chunkMax) {
+    _shape_toggle_rendering_flag(s, SHAPE_RENDERING_FLAG_BAKED_LIGHTING, true);
+
+    // emission and lateral sunlight fade out within one chunk distance, but sunlight travels
+    // vertically without attenuation: affected area spans whole columns of neighboring chunks
+    chunkMin.x -= 1;
+    chunkMin.z -= 1;
+    chunkMax.x += 1;
+    chunkMax.z += 1;
+
+    LightNodeQueue *q = light_node_queue_new();
+    SHAPE_COORDS_INT3_T min, max;
+
+    _light_removal_columns(s, chunkMin, chunkMax, &min, &max);
+    _light_enqueue_ambient_and_block_sources(s, q, min, max, false);
+    _light_enqueue_area_border_sources(s, q, min, max);
+    _light_propagate(s, &min, &max, q, min.x - 1, max.y, min.z - 1, true);
+
+    light_node_queue_free(q);
+
+#if SHAPE_LIGHTING_DEBUG
+    cclog_debug("Shape light computed in chunks area");
+#endif
+}
+
 void shape_toggle_baked_lighting(Shape *s, const bool toggle) {
     _shape_toggle_rendering_flag(s, SHAPE_RENDERING_FLAG_BAKED_LIGHTING, toggle);
 }
@@ -2523,7 +3438,9 @@ void shape_compute_baked_lighting_removed_block(Shape *s,
                 coords_in_shape.z);
 #endif
 
-    LightNodeQueue *lightQueue = light_node_queue_new();
+    // if batching, only gather light removal & propagation sources
+    const bool batch = s->batchLightQueue != NULL;
+    LightNodeQueue *lightQueue = batch ? s->batchLightQueue : light_node_queue_new();
 
     // changed values bounding box need to include both removed and added lights
     SHAPE_COORDS_INT3_T min, max;
@@ -2535,7 +3452,16 @@ void shape_compute_baked_lighting_removed_block(Shape *s,
     VERTEX_LIGHT_STRUCT_T existingLight = chunk_get_light_without_checking(c, coords_in_chunk);
 
     // if self is emissive, start light removal
-    if (existingLight.red > 0 || existingLight.green > 0 || existingLight.blue > 0) {
+    if (batch) {
+        if (existingLight.red > 0 || existingLight.green > 0 || existingLight.blue > 0) {
+            light_removal_node_queue_push(s->batchLightRemovalQueue,
+                                          c,
+                                          coords_in_shape,
+                                          existingLight,
+                                          15,
+                                          blockID);
+        }
+    } else if (existingLight.red > 0 || existingLight.green > 0 || existingLight.blue > 0) {
         LightRemovalNodeQueue *lightRemovalQueue = light_removal_node_queue_new();
 
         light_removal_node_queue_push(lightRemovalQueue,
@@ -2604,6 +3530,11 @@ void shape_compute_baked_lighting_removed_block(Shape *s,
     ZERO_LIGHT(zero)
     chunk_set_light(c, coords_in_chunk, zero, false);
 
+    if (batch) {
+        _shape_lighting_batch_add(s, coords_in_shape);
+        return;
+    }
+
     // Then we run the regular light propagation algorithm
     _light_propagate(s,
                      &min,
@@ -2638,8 +3569,11 @@ void shape_compute_baked_lighting_added_block(Shape *s,
                 coords_in_shape.z);
 #endif
 
-    LightNodeQueue *lightQueue = light_node_queue_new();
-    LightRemovalNodeQueue *lightRemovalQueue = light_removal_node_queue_new();
+    // if batching, only gather light removal & propagation sources
+    const bool batch = s->batchLightQueue != NULL;
+    LightNodeQueue *lightQueue = batch ? s->batchLightQueue : light_node_queue_new();
+    LightRemovalNodeQueue *lightRemovalQueue = batch ? s->batchLightRemovalQueue
+                                                     : light_removal_node_queue_new();
 
     // changed values bounding box need to include both removed and added lights
     SHAPE_COORDS_INT3_T min, max;
@@ -2696,6 +3630,11 @@ void shape_compute_baked_lighting_added_block(Shape *s,
         }
     }
 
+    if (batch) {
+        _shape_lighting_batch_add(s, coords_in_shape);
+        return;
+    }
+
     // run light removal
     _light_removal(s, &min, &max, lightRemovalQueue, lightQueue);
 
@@ -2744,7 +3683,9 @@ void shape_compute_baked_lighting_replaced_block(Shape *s,
         return;
     }
 
-    LightNodeQueue *lightQueue = light_node_queue_new();
+    // if batching, only gather light removal & propagation sources
+    const bool batch = s->batchLightQueue != NULL;
+    LightNodeQueue *lightQueue = batch ? s->batchLightQueue : light_node_queue_new();
 
     // changed values bounding box need to include both removed and added lights
     SHAPE_COORDS_INT3_T min, max;
@@ -2753,7 +3694,16 @@ void shape_compute_baked_lighting_replaced_block(Shape *s,
     min.z = max.z = coords_in_shape.z;
 
     // if replaced light was emissive, start light removal
-    if (existingLight.red > 0 || existingLight.green > 0 || existingLight.blue > 0) {
+    if (batch) {
+        if (existingLight.red > 0 || existingLight.green > 0 || existingLight.blue > 0) {
+            light_removal_node_queue_push(s->batchLightRemovalQueue,
+                                          c,
+                                          coords_in_shape,
+                                          existingLight,
+                                          15,
+                                          blockID);
+        }
+    } else if (existingLight.red > 0 || existingLight.green > 0 || existingLight.blue > 0) {
         LightRemovalNodeQueue *lightRemovalQueue = light_removal_node_queue_new();
 
         light_removal_node_queue_push(lightRemovalQueue,
@@ -2782,6 +3732,11 @@ void shape_compute_baked_lighting_replaced_block(Shape *s,
         chunk_set_light(c, coords_in_chunk, zero, false);
     }
 
+    if (batch) {
+        _shape_lighting_batch_add(s, coords_in_shape);
+        return;
+    }
+
     // Then we run the regular light propagation algorithm
     _light_propagate(s,
                      &min,
@@ -2862,6 +3817,13 @@ bool shape_history_getKeepTransactionPending(Shape *s) {
     return _shape_get_lua_flag(s, SHAPE_LUA_FLAG_HISTORY_KEEP_PENDING);
 }
 
+void shape_history_setByteBudget(Shape *s, const size_t budget) {
+    if (s == NULL || s->history == NULL) {
+        return;
+    }
+    history_set_byte_budget(s->history, budget);
+}
+
 bool shape_history_canUndo(const Shape *const s) {
     if (s == NULL) {
         return false;
@@ -2987,36 +3949,481 @@ uint32_t shape_drawmode_get_additive_color(const Shape *s) {
 
 // MARK: - private functions -
 
-static void _shape_toggle_rendering_flag(Shape *s, const uint8_t flag, const bool toggle) {
-    if (toggle) {
-        s->renderingFlags |= flag;
-    } else {
-        s->renderingFlags &= ~flag;
+bool _shape_has_transparent_blocks(const Shape *s) {
+    const uint8_t count = color_palette_get_count(s->palette);
+    for (uint8_t i = 0; i < count; ++i) {
+        if (s->blocksCount[i] > 0 && color_palette_is_transparent(s->palette, i)) {
+            return true;
+        }
     }
+    return false;
 }
 
-static bool _shape_get_rendering_flag(const Shape *s, const uint8_t flag) {
-    return (s->renderingFlags & flag) != 0;
+bool _shape_chunk_is_full(const Chunk *c) {
+    return c != NULL && chunk_get_nb_blocks(c) == CHUNK_SIZE_CUBE;
+}
+
+bool _shape_chunk_get_colliding_range(const Chunk *c,
+                                      const Box *modelBox,
+                                      CHUNK_COORDS_INT3_T *min,
+                                      CHUNK_COORDS_INT3_T *max) {
+    const SHAPE_COORDS_INT3_T origin = chunk_get_origin(c);
+    const float boxMin[3] = {modelBox->min.x - (float)origin.x,
+                             modelBox->min.y - (float)origin.y,
+                             modelBox->min.z - (float)origin.z};
+    const float boxMax[3] = {modelBox->max.x - (float)origin.x,
+                             modelBox->max.y - (float)origin.y,
+                             modelBox->max.z - (float)origin.z};
+    int first[3], last[3];
+    for (int i = 0; i < 3; ++i) {
+        // block i collides if i > boxMin + epsilon - 1 and i < boxMax - epsilon
+        const float lo = CLAMP(boxMin[i] + EPSILON_COLLISION - 1.0f, -2.0f, (float)CHUNK_SIZE);
+        const float hi = CLAMP(boxMax[i] - EPSILON_COLLISION, -1.0f, (float)CHUNK_SIZE + 1.0f);
+        first[i] = maximum((int)floorf(lo) + 1, 0);
+        last[i] = minimum((int)ceilf(hi) - 1, CHUNK_SIZE_MINUS_ONE);
+        if (first[i] > last[i]) {
+            return false;
+        }
+    }
+    *min = (CHUNK_COORDS_INT3_T){(CHUNK_COORDS_INT_T)first[0],
+                                 (CHUNK_COORDS_INT_T)first[1],
+                                 (CHUNK_COORDS_INT_T)first[2]};
+    *max = (CHUNK_COORDS_INT3_T){(CHUNK_COORDS_INT_T)last[0],
+                                 (CHUNK_COORDS_INT_T)last[1],
+                                 (CHUNK_COORDS_INT_T)last[2]};
+    return true;
 }
 
-static void _shape_toggle_lua_flag(Shape *s, const uint8_t flag, const bool toggle) {
-    if (toggle) {
-        s->luaFlags |= flag;
-    } else {
-        s->luaFlags &= ~flag;
+void _shape_get_occluder_box(const Chunk *c, Box *box) {
+    // full chunks along +X
+    int nx = 1;
+    const Chunk *itr = chunk_get_neighbor(c, X);
+    while (nx < SHAPE_OCCLUDER_MAX_CHUNKS && _shape_chunk_is_full(itr)) {
+        ++nx;
+        itr = chunk_get_neighbor(itr, X);
+    }
+
+    // rows of nx full chunks along +Y
+    int ny = 1;
+    const Chunk *row = chunk_get_neighbor(c, Y);
+    bool full = true;
+    while (ny < SHAPE_OCCLUDER_MAX_CHUNKS && full) {
+        itr = row;
+        for (int i = 0; i < nx && full; ++i) {
+            full = _shape_chunk_is_full(itr);
+            itr = full ? chunk_get_neighbor(itr, X) : NULL;
+        }
+        if (full) {
+            ++ny;
+            row = chunk_get_neighbor(row, Y);
+        }
     }
-}
 
-static bool _shape_get_lua_flag(const Shape *s, const uint8_t flag) {
-    return (s->luaFlags & flag) != 0;
+    // slabs of nx * ny full chunks along +Z
+    int nz = 1;
+    const Chunk *slab = chunk_get_neighbor(c, Z);
+    full = true;
+    while (nz < SHAPE_OCCLUDER_MAX_CHUNKS && full) {
+        row = slab;
+        for (int j = 0; j < ny && full; ++j) {
+            itr = row;
+            for (int i = 0; i < nx && full; ++i) {
+                full = _shape_chunk_is_full(itr);
+                itr = full ? chunk_get_neighbor(itr, X) : NULL;
+            }
+            row = full ? chunk_get_neighbor(row, Y) : NULL;
+        }
+        if (full) {
+            ++nz;
+            slab = chunk_get_neighbor(slab, Z);
+        }
+    }
+
+    const SHAPE_COORDS_INT3_T origin = chunk_get_origin(c);
+    box->min = (float3){(float)origin.x, (float)origin.y, (float)origin.z};
+    box->max = (float3){box->min.x + (float)(nx * CHUNK_SIZE),
+                        box->min.y + (float)(ny * CHUNK_SIZE),
+                        box->min.z + (float)(nz * CHUNK_SIZE)};
 }
 
-void _shape_chunk_enqueue_refresh(Shape *shape, Chunk *c) {
-    if (c == NULL)
+void _shape_lod_set_dirty(Shape *s, const Chunk *c) {
+    if (s->lodDirtyChunks == NULL) {
         return;
-    if (chunk_is_dirty(c) == false) {
-        if (shape->dirtyChunks == NULL) {
-            shape->dirtyChunks = fifo_list_new();
+    }
+    const SHAPE_COORDS_INT3_T coords = chunk_utils_get_coords(chunk_get_origin(c));
+    if (index3d_get(s->lodDirtyChunks, coords.x, coords.y, coords.z) == NULL) {
+        index3d_insert(s->lodDirtyChunks,
+                       int3_new(coords.x, coords.y, coords.z),
+                       coords.x,
+                       coords.y,
+                       coords.z,
+                       NULL);
+    }
+}
+
+void _shape_chunk_stamp(Shape *s, Chunk *c) {
+    chunk_set_stamp(c, ++s->blocksStamp);
+}
+
+void _shape_chunk_removed(Shape *s, const SHAPE_COORDS_INT3_T chunkCoords) {
+    const uint8_t i = s->removedChunksNext;
+    if (s->removedChunksStamps[i] != 0) {
+        s->chunksStamp = s->removedChunksStamps[i];
+    }
+    s->removedChunks[i] = chunkCoords;
+    s->removedChunksStamps[i] = ++s->blocksStamp;
+    s->removedChunksNext = (uint8_t)((i + 1) % SHAPE_REMOVED_CHUNKS_HISTORY);
+}
+
+void _shape_get_chunks_range(const Box *modelBox, int3 *min, int3 *max) {
+    min->x = (int)floorf(CLAMP(modelBox->min.x, (float)INT16_MIN, (float)INT16_MAX) / CHUNK_SIZE);
+    min->y = (int)floorf(CLAMP(modelBox->min.y, (float)INT16_MIN, (float)INT16_MAX) / CHUNK_SIZE);
+    min->z = (int)floorf(CLAMP(modelBox->min.z, (float)INT16_MIN, (float)INT16_MAX) / CHUNK_SIZE);
+    max->x = (int)floorf(CLAMP(modelBox->max.x, (float)INT16_MIN, (float)INT16_MAX) / CHUNK_SIZE);
+    max->y = (int)floorf(CLAMP(modelBox->max.y, (float)INT16_MIN, (float)INT16_MAX) / CHUNK_SIZE);
+    max->z = (int)floorf(CLAMP(modelBox->max.z, (float)INT16_MIN, (float)INT16_MAX) / CHUNK_SIZE);
+}
+
+bool _shape_box_collides_blocks(const Shape *s, const Box *modelBox) {
+    int3 chunkMin, chunkMax;
+    _shape_get_chunks_range(modelBox, &chunkMin, &chunkMax);
+
+    const Chunk *c;
+    CHUNK_COORDS_INT3_T min, max, coords;
+    for (int z = chunkMin.z; z <= chunkMax.z; ++z) {
+        for (int y = chunkMin.y; y <= chunkMax.y; ++y) {
+            for (int x = chunkMin.x; x <= chunkMax.x; ++x) {
+                c = (const Chunk *)index3d_get(s->chunks, x, y, z);
+                if (c != NULL && chunk_get_nb_blocks(c) > 0 &&
+                    _shape_chunk_get_colliding_range(c, modelBox, &min, &max) &&
+                    chunk_get_first_solid_block_in_range(c, min, max, &coords)) {
+                    return true;
+                }
+            }
+        }
+    }
+    return false;
+}
+
+float _shape_get_free_distance(const Shape *s, const Box *modelBox) {
+    float free = 0.0f;
+    Box window;
+    for (float d = 1.0f; d <= SHAPE_CAST_MAX_FREE_DISTANCE; d *= 2.0f) {
+        window.min = (float3){modelBox->min.x - d, modelBox->min.y - d, modelBox->min.z - d};
+        window.max = (float3){modelBox->max.x + d, modelBox->max.y + d, modelBox->max.z + d};
+        if (_shape_box_collides_blocks(s, &window)) {
+            break;
+        }
+        free = d;
+    }
+    return free;
+}
+
+float _shape_box_cast_segment(const Shape *s,
+                              const Box *modelBox,
+                              const float3 *modelVector,
+                              const float3 *modelEpsilon,
+                              float3 *normal,
+                              const Block **block,
+                              SHAPE_COORDS_INT3_T *blockCoords) {
+    Box broadPhaseBox, blockBox;
+    box_set_broadphase_box(modelBox, modelVector, &broadPhaseBox);
+
+    int3 chunkMin, chunkMax;
+    _shape_get_chunks_range(&broadPhaseBox, &chunkMin, &chunkMax);
+
+    const Chunk *c;
+    CHUNK_COORDS_INT3_T min, max;
+    CHUNK_ROW_MASK_T xMask, row;
+    float3 tmpNormal;
+    float swept, minSwept = 1.0f;
+    for (int cz = chunkMin.z; cz <= chunkMax.z; ++cz) {
+        for (int cy = chunkMin.y; cy <= chunkMax.y; ++cy) {
+            for (int cx = chunkMin.x; cx <= chunkMax.x; ++cx) {
+                c = (const Chunk *)index3d_get(s->chunks, cx, cy, cz);
+                if (c == NULL ||
+                    _shape_chunk_get_colliding_range(c, &broadPhaseBox, &min, &max) == false) {
+                    continue;
+                }
+                const SHAPE_COORDS_INT3_T origin = chunk_get_origin(c);
+                xMask = chunk_utils_get_row_mask(min.x, max.x);
+                for (CHUNK_COORDS_INT_T z = min.z; z <= max.z; ++z) {
+                    for (CHUNK_COORDS_INT_T y = min.y; y <= max.y; ++y) {
+                        row = chunk_get_solid_row(c, y, z) & xMask;
+                        for (CHUNK_COORDS_INT_T x = min.x; row != 0; ++x) {
+                            if ((row & (1u << x)) == 0) {
+                                continue;
+                            }
+                            row &= (CHUNK_ROW_MASK_T) ~(1u << x);
+
+                            blockBox.min = (float3){(float)(origin.x + x),
+                                                    (float)(origin.y + y),
+                                                    (float)(origin.z + z)};
+                            blockBox.max = (float3){blockBox.min.x + 1.0f,
+                                                    blockBox.min.y + 1.0f,
+                                                    blockBox.min.z + 1.0f};
+
+                            swept = box_swept(modelBox,
+                                              modelVector,
+                                              &blockBox,
+                                              modelEpsilon,
+                                              false,
+                                              &tmpNormal,
+                                              NULL);
+                            if (swept < minSwept) {
+                                minSwept = swept;
+                                if (normal != NULL) {
+                                    *normal = tmpNormal;
+                                }
+                                if (block != NULL) {
+                                    *block = chunk_get_block(c, x, y, z);
+                                }
+                                if (blockCoords != NULL) {
+                                    blockCoords->x = (SHAPE_COORDS_INT_T)(origin.x + x);
+                                    blockCoords->y = (SHAPE_COORDS_INT_T)(origin.y + y);
+                                    blockCoords->z = (SHAPE_COORDS_INT_T)(origin.z + z);
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+    return minSwept;
+}
+
+float _shape_box_cast_advancing(const Shape *s,
+                                const Box *modelBox,
+                                const float3 *unit,
+                                const float maxDist,
+                                const float3 *modelEpsilon,
+                                const bool withReplacement,
+                                float3 *normal,
+                                float3 *extraReplacement,
+                                const Block **block,
+                                SHAPE_COORDS_INT3_T *blockCoords) {
+    // clip trajectory to the shape bounding box w/ a 1-block margin, nothing to hit outside
+    const float boxMin[3] = {modelBox->min.x, modelBox->min.y, modelBox->min.z};
+    const float boxMax[3] = {modelBox->max.x, modelBox->max.y, modelBox->max.z};
+    const float bbMin[3] = {(float)s->bbMin.x - 1.0f,
+                            (float)s->bbMin.y - 1.0f,
+                            (float)s->bbMin.z - 1.0f};
+    const float bbMax[3] = {(float)s->bbMax.x + 1.0f,
+                            (float)s->bbMax.y + 1.0f,
+                            (float)s->bbMax.z + 1.0f};
+    const float u[3] = {unit->x, unit->y, unit->z};
+    float start = 0.0f, end = maxDist, maxAxis = 0.0f;
+    for (int i = 0; i < 3; ++i) {
+        if (u[i] == 0.0f) {
+            if (boxMax[i] <= bbMin[i] || boxMin[i] >= bbMax[i]) {
+                return 1.0f;
+            }
+        } else {
+            const float t1 = (bbMin[i] - boxMax[i]) / u[i];
+            const float t2 = (bbMax[i] - boxMin[i]) / u[i];
+            start = maximum(start, minimum(t1, t2));
+            end = minimum(end, maximum(t1, t2));
+        }
+        maxAxis = maximum(maxAxis, fabsf(u[i]));
+    }
+
+    // moving the box by a distance d along unit displaces it by d * maxAxis at most on any axis,
+    // distances in blocks are converted accordingly
+    const float segment = (withReplacement ? SHAPE_CAST_REPLACEMENT_SEGMENT_DISTANCE
+                                           : SHAPE_CAST_SEGMENT_DISTANCE) /
+                          maxAxis;
+    Box box;
+    float3 vector;
+    float d = start, free, length, swept;
+    while (d < end) {
+        box.min = (float3){modelBox->min.x + unit->x * d,
+                           modelBox->min.y + unit->y * d,
+                           modelBox->min.z + unit->z * d};
+        box.max = (float3){modelBox->max.x + unit->x * d,
+                           modelBox->max.y + unit->y * d,
+                           modelBox->max.z + unit->z * d};
+
+        free = _shape_get_free_distance(s, &box);
+        if (free > 0.0f) {
+            d += (free - EPSILON_COLLISION) / maxAxis;
+            continue;
+        }
+
+        length = minimum(end - d, segment);
+        vector = (float3){unit->x * length, unit->y * length, unit->z * length};
+        if (withReplacement) {
+            // segments are shorter than SHAPE_CAST_ADVANCEMENT_DISTANCE, replacement is solved
+            // by the regular cast, extra replacement only applies to the box at its origin
+            swept = shape_box_cast(s,
+                                   &box,
+                                   &vector,
+                                   modelEpsilon,
+                                   true,
+                                   normal,
+                                   d == 0.0f ? extraReplacement : NULL,
+                                   block,
+                                   blockCoords);
+        } else {
+            swept = _shape_box_cast_segment(s,
+                                            &box,
+                                            &vector,
+                                            modelEpsilon,
+                                            normal,
+                                            block,
+                                            blockCoords);
+        }
+        if (swept < 1.0f) {
+            return (d + swept * length) / maxDist;
+        }
+        d += length;
+    }
+    return 1.0f;
+}
+
+Shape *_shape_lod_build(Shape *s, const uint8_t level) {
+    Shape *lod = shape_new();
+    shape_set_palette(lod, s->palette, true);
+    const float scale = (float)(1 << level);
+    transform_set_local_scale(lod->transform, scale, scale, scale);
+
+    const int size = CHUNK_SIZE >> level;
+    SHAPE_COLOR_INDEX_INT_T cells[CHUNK_SIZE_CUBE / 8];
+    uint16_t coords[CHUNK_SIZE_CUBE / 8];
+    SHAPE_COLOR_INDEX_INT_T colors[CHUNK_SIZE_CUBE / 8];
+    uint32_t count;
+
+    Index3DIterator *it = index3d_iterator_new(s->chunks);
+    const Chunk *c;
+    while (index3d_iterator_pointer(it) != NULL) {
+        c = (const Chunk *)index3d_iterator_pointer(it);
+        if (chunk_downsample(c, level, cells) > 0) {
+            // chunk cells fall in a single LOD chunk
+            const SHAPE_COORDS_INT3_T origin = chunk_get_origin(c);
+            const SHAPE_COORDS_INT3_T lodOrigin = {(SHAPE_COORDS_INT_T)(origin.x / (1 << level)),
+                                                   (SHAPE_COORDS_INT_T)(origin.y / (1 << level)),
+                                                   (SHAPE_COORDS_INT_T)(origin.z / (1 << level))};
+            const CHUNK_COORDS_INT3_T base = chunk_utils_get_coords_in_chunk(lodOrigin);
+
+            count = 0;
+            for (int x = 0; x < size; ++x) {
+                for (int y = 0; y < size; ++y) {
+                    for (int z = 0; z < size; ++z) {
+                        const SHAPE_COLOR_INDEX_INT_T color = cells[(x * size + y) * size + z];
+                        if (color != SHAPE_COLOR_INDEX_AIR_BLOCK) {
+                            coords[count] = (uint16_t)((base.x + x) * CHUNK_SIZE_SQR +
+                                                       (base.y + y) * CHUNK_SIZE + base.z + z);
+                            colors[count] = color;
+                            ++count;
+                        }
+                    }
+                }
+            }
+            shape_add_blocks_in_chunk(lod, chunk_utils_get_coords(lodOrigin), coords, colors, count);
+        }
+        index3d_iterator_next(it);
+    }
+    index3d_iterator_free(it);
+
+    return lod;
+}
+
+void _shape_lod_refresh_chunk(Shape *s, Shape *lod, const uint8_t level, const int3 *chunkCoords) {
+    const int size = CHUNK_SIZE >> level;
+    SHAPE_COLOR_INDEX_INT_T cells[CHUNK_SIZE_CUBE / 8];
+
+    // chunk may have been removed since
+    const Chunk *c = (const Chunk *)
+        index3d_get(s->chunks, chunkCoords->x, chunkCoords->y, chunkCoords->z);
+    if (c != NULL) {
+        chunk_downsample(c, level, cells);
+    } else {
+        memset(cells, SHAPE_COLOR_INDEX_AIR_BLOCK, (size_t)(size * size * size));
+    }
+
+    const int x0 = chunkCoords->x * size, y0 = chunkCoords->y * size, z0 = chunkCoords->z * size;
+    const Block *b;
+    SHAPE_COLOR_INDEX_INT_T color;
+    SHAPE_COORDS_INT_T x, y, z;
+    for (int i = 0; i < size; ++i) {
+        for (int j = 0; j < size; ++j) {
+            for (int k = 0; k < size; ++k) {
+                color = cells[(i * size + j) * size + k];
+                x = (SHAPE_COORDS_INT_T)(x0 + i);
+                y = (SHAPE_COORDS_INT_T)(y0 + j);
+                z = (SHAPE_COORDS_INT_T)(z0 + k);
+
+                b = shape_get_block_immediate(lod, x, y, z);
+                if (block_is_solid(b)) {
+                    if (color == SHAPE_COLOR_INDEX_AIR_BLOCK) {
+                        shape_remove_block(lod, x, y, z);
+                    } else if (b->colorIndex != color) {
+                        shape_paint_block(lod, color, x, y, z);
+                    }
+                } else if (color != SHAPE_COLOR_INDEX_AIR_BLOCK) {
+                    shape_add_block(lod, color, x, y, z, false);
+                }
+            }
+        }
+    }
+}
+
+void _shape_free_lods(Shape *s) {
+    if (s->lods != NULL) {
+        for (int i = 0; i < SHAPE_LOD_MAX_LEVEL; ++i) {
+            shape_release(s->lods[i]);
+        }
+        free(s->lods);
+        s->lods = NULL;
+    }
+    if (s->lodDirtyChunks != NULL) {
+        index3d_flush(s->lodDirtyChunks, free);
+        index3d_free(s->lodDirtyChunks);
+        s->lodDirtyChunks = NULL;
+    }
+}
+
+bool _shape_query_frustum_func(RtreeNode *rn, void *ptr, const float3 *epsilon) {
+    return frustum_intersect_box((const Frustum *)ptr, rtree_node_get_aabb(rn));
+}
+
+static void _shape_toggle_rendering_flag(Shape *s, const uint8_t flag, const bool toggle) {
+    if (toggle) {
+        s->renderingFlags |= flag;
+    } else {
+        s->renderingFlags &= ~flag;
+    }
+}
+
+static bool _shape_get_rendering_flag(const Shape *s, const uint8_t flag) {
+    return (s->renderingFlags & flag) != 0;
+}
+
+static void _shape_toggle_lua_flag(Shape *s, const uint8_t flag, const bool toggle) {
+    if (toggle) {
+        s->luaFlags |= flag;
+    } else {
+        s->luaFlags &= ~flag;
+    }
+}
+
+static bool _shape_get_lua_flag(const Shape *s, const uint8_t flag) {
+    return (s->luaFlags & flag) != 0;
+}
+
+void _shape_chunk_enqueue_refresh(Shape *shape, Chunk *c) {
+    if (c == NULL)
+        return;
+    // vertices can't be shared once modified
+    if (shape->model != NULL) {
+        _shape_instance_detach(shape, true);
+    }
+    if (shape->instances != NULL) {
+        _shape_detach_instances(shape);
+    }
+    if (chunk_is_dirty(c) == false) {
+        if (shape->dirtyChunks == NULL) {
+            shape->dirtyChunks = fifo_list_new();
         }
         fifo_list_push(shape->dirtyChunks, c);
         chunk_set_dirty(c, true);
@@ -3049,18 +4456,10 @@ void _shape_chunk_check_neighbors_dirty(Shape *shape,
     }
 }
 
-bool _shape_add_block_in_chunks(Shape *shape,
-                                const Block block,
-                                const SHAPE_COORDS_INT_T x,
-                                const SHAPE_COORDS_INT_T y,
-                                const SHAPE_COORDS_INT_T z,
-                                CHUNK_COORDS_INT3_T *block_coords,
-                                bool *chunkAdded,
-                                Chunk **added_or_existing_chunk,
-                                Block **added_or_existing_block) {
+Chunk *_shape_get_or_create_chunk(Shape *shape,
+                                  const SHAPE_COORDS_INT3_T chunk_coords,
+                                  bool *chunkAdded) {
 
-    // see if there's a chunk ready for that block
-    const SHAPE_COORDS_INT3_T chunk_coords = chunk_utils_get_coords((SHAPE_COORDS_INT3_T){x, y, z});
     Chunk *chunk = (Chunk *)
         index3d_get(shape->chunks, chunk_coords.x, chunk_coords.y, chunk_coords.z);
 
@@ -3079,12 +4478,30 @@ bool _shape_add_block_in_chunks(Shape *shape,
                          (float)(chunkOrigin.y + CHUNK_SIZE),
                          (float)(chunkOrigin.z + CHUNK_SIZE)}};
         chunk_set_rtree_leaf(chunk, rtree_create_and_insert(shape->rtree, &chunkBox, 1, 1, chunk));
+        _shape_chunk_stamp(shape, chunk);
 
         *chunkAdded = true;
     } else {
         *chunkAdded = false;
     }
 
+    return chunk;
+}
+
+bool _shape_add_block_in_chunks(Shape *shape,
+                                const Block block,
+                                const SHAPE_COORDS_INT_T x,
+                                const SHAPE_COORDS_INT_T y,
+                                const SHAPE_COORDS_INT_T z,
+                                CHUNK_COORDS_INT3_T *block_coords,
+                                bool *chunkAdded,
+                                Chunk **added_or_existing_chunk,
+                                const Block **added_or_existing_block) {
+
+    // see if there's a chunk ready for that block
+    const SHAPE_COORDS_INT3_T chunk_coords = chunk_utils_get_coords((SHAPE_COORDS_INT3_T){x, y, z});
+    Chunk *chunk = _shape_get_or_create_chunk(shape, chunk_coords, chunkAdded);
+
     if (added_or_existing_chunk != NULL) {
         *added_or_existing_chunk = chunk;
     }
@@ -3101,6 +4518,10 @@ bool _shape_add_block_in_chunks(Shape *shape,
                                  coords_in_chunk.x,
                                  coords_in_chunk.y,
                                  coords_in_chunk.z);
+    if (added) {
+        _shape_lod_set_dirty(shape, chunk);
+        _shape_chunk_stamp(shape, chunk);
+    }
 
     if (added_or_existing_block != NULL) {
         *added_or_existing_block = chunk_get_block_2(chunk, coords_in_chunk);
@@ -4063,6 +5484,400 @@ void _light_removal(Shape *s,
 #endif
 }
 
+bool _shape_lighting_batch_begin(Shape *s) {
+    if (_shape_get_rendering_flag(s, SHAPE_RENDERING_FLAG_BAKED_LIGHTING) == false ||
+        s->batchLightQueue != NULL) {
+        return false;
+    }
+    s->batchLightQueue = light_node_queue_new();
+    s->batchLightRemovalQueue = light_removal_node_queue_new();
+    s->batchLightMin = (SHAPE_COORDS_INT3_T){INT16_MAX, INT16_MAX, INT16_MAX};
+    s->batchLightMax = (SHAPE_COORDS_INT3_T){INT16_MIN, INT16_MIN, INT16_MIN};
+    return true;
+}
+
+void _shape_lighting_batch_add(Shape *s, SHAPE_COORDS_INT3_T coords) {
+    s->batchLightMin.x = minimum(s->batchLightMin.x, coords.x);
+    s->batchLightMin.y = minimum(s->batchLightMin.y, coords.y);
+    s->batchLightMin.z = minimum(s->batchLightMin.z, coords.z);
+    s->batchLightMax.x = maximum(s->batchLightMax.x, coords.x);
+    s->batchLightMax.y = maximum(s->batchLightMax.y, coords.y);
+    s->batchLightMax.z = maximum(s->batchLightMax.z, coords.z);
+}
+
+void _shape_lighting_batch_end(Shape *s) {
+    if (s->batchLightQueue == NULL) {
+        return;
+    }
+    LightNodeQueue *lightQueue = s->batchLightQueue;
+    LightRemovalNodeQueue *lightRemovalQueue = s->batchLightRemovalQueue;
+    s->batchLightQueue = NULL;
+    s->batchLightRemovalQueue = NULL;
+
+    // skip if no block change affected lighting
+    if (s->batchLightMin.x <= s->batchLightMax.x) {
+        SHAPE_COORDS_INT3_T min = s->batchLightMin, max = s->batchLightMax;
+
+        // one light removal pass for all removed light sources, enqueuing valid light values at
+        // its boundaries, then one propagation pass for all of them and the new light sources
+        _light_removal(s, &min, &max, lightRemovalQueue, lightQueue);
+        _light_propagate(s, &min, &max, lightQueue, min.x, min.y, min.z, false);
+    }
+
+    light_removal_node_queue_free(lightRemovalQueue);
+    light_node_queue_free(lightQueue);
+}
+
+uint32_t _shape_edit_region(Shape *s,
+                            const SHAPE_COORDS_INT3_T min,
+                            const SHAPE_COORDS_INT3_T max,
+                            const TransactionColors *colors,
+                            const SHAPE_COLOR_INDEX_INT_T fill,
+                            const bool writeAir,
+                            TransactionColors *previous) {
+
+    const size_t sizeY = (size_t)(max.y - min.y), sizeZ = (size_t)(max.z - min.z);
+    const bool lighting = _shape_get_rendering_flag(s, SHAPE_RENDERING_FLAG_BAKED_LIGHTING);
+    const bool lightingBatch = _shape_lighting_batch_begin(s);
+
+    uint32_t addedCount[SHAPE_COLOR_INDEX_MAX_COUNT] = {0};
+    uint32_t removedCount[SHAPE_COLOR_INDEX_MAX_COUNT] = {0};
+    SHAPE_COORDS_INT3_T addedMin = max, addedMax = min;
+    uint32_t changed = 0, added = 0, removed = 0;
+    uint32_t colorsHint = 0;
+    bool recorded = true;
+
+    const SHAPE_COORDS_INT3_T chunkMin = chunk_utils_get_coords(min);
+    const SHAPE_COORDS_INT3_T chunkMax = chunk_utils_get_coords(
+        (SHAPE_COORDS_INT3_T){max.x - 1, max.y - 1, max.z - 1});
+
+    // work chunk by chunk, so that each chunk is looked up & refreshed once
+    for (int32_t cx = chunkMin.x; cx <= chunkMax.x; ++cx) {
+        for (int32_t cy = chunkMin.y; cy <= chunkMax.y; ++cy) {
+            for (int32_t cz = chunkMin.z; cz <= chunkMax.z; ++cz) {
+                Chunk *chunk = (Chunk *)index3d_get(s->chunks, cx, cy, cz);
+                const int32_t ox = cx * CHUNK_SIZE, oy = cy * CHUNK_SIZE, oz = cz * CHUNK_SIZE;
+
+                CHUNK_COORDS_INT3_T changedMin = {CHUNK_SIZE, CHUNK_SIZE, CHUNK_SIZE};
+                CHUNK_COORDS_INT3_T changedMax = {-1, -1, -1};
+
+                for (int32_t x = maximum(min.x, ox); x < minimum(max.x, ox + CHUNK_SIZE); ++x) {
+                    for (int32_t y = maximum(min.y, oy); y < minimum(max.y, oy + CHUNK_SIZE);
+                         ++y) {
+                        size_t i = ((size_t)(x - min.x) * sizeY + (size_t)(y - min.y)) * sizeZ +
+                                   (size_t)(maximum(min.z, oz) - min.z);
+                        for (int32_t z = maximum(min.z, oz); z < minimum(max.z, oz + CHUNK_SIZE);
+                             ++z, ++i) {
+
+                            const CHUNK_COORDS_INT3_T inChunk = {(CHUNK_COORDS_INT_T)(x - ox),
+                                                                 (CHUNK_COORDS_INT_T)(y - oy),
+                                                                 (CHUNK_COORDS_INT_T)(z - oz)};
+                            const Block *b = chunk_get_block_2(chunk, inChunk);
+                            SHAPE_COLOR_INDEX_INT_T current = SHAPE_COLOR_INDEX_AIR_BLOCK;
+                            if (block_is_solid(b)) {
+                                current = b->colorIndex;
+                            }
+                            if (previous != NULL && previous->dense != NULL) {
+                                previous->dense[i] = current;
+                            }
+
+                            SHAPE_COLOR_INDEX_INT_T color = fill;
+                            if (colors != NULL && transaction_colors_get(colors,
+                                                                         (uint32_t)i,
+                                                                         &colorsHint,
+                                                                         &color) == false) {
+                                continue;
+                            }
+                            if (color == current ||
+                                (color == SHAPE_COLOR_INDEX_AIR_BLOCK && writeAir == false)) {
+                                continue;
+                            }
+                            if (previous != NULL && previous->runs != NULL && recorded) {
+                                recorded = transaction_colors_set(previous, (uint32_t)i, current);
+                            }
+
+                            const SHAPE_COORDS_INT3_T inShape = {(SHAPE_COORDS_INT_T)x,
+                                                                 (SHAPE_COORDS_INT_T)y,
+                                                                 (SHAPE_COORDS_INT_T)z};
+                            if (color == SHAPE_COLOR_INDEX_AIR_BLOCK) {
+                                chunk_remove_block(chunk, inChunk.x, inChunk.y, inChunk.z, NULL);
+                                _shape_slices_update(s, inShape, -1);
+                                ++removedCount[current];
+                                ++removed;
+                                if (lighting) {
+                                    shape_compute_baked_lighting_removed_block(s,
+                                                                               chunk,
+                                                                               inShape,
+                                                                               inChunk,
+                                                                               current);
+                                }
+                            } else if (current == SHAPE_COLOR_INDEX_AIR_BLOCK) {
+                                if (chunk == NULL) {
+                                    bool chunkAdded;
+                                    chunk = _shape_get_or_create_chunk(
+                                        s,
+                                        (SHAPE_COORDS_INT3_T){(SHAPE_COORDS_INT_T)cx,
+                                                              (SHAPE_COORDS_INT_T)cy,
+                                                              (SHAPE_COORDS_INT_T)cz},
+                                        &chunkAdded);
+                                    if (chunkAdded) {
+                                        s->nbChunks++;
+                                    }
+                                }
+                                chunk_add_block(chunk,
+                                                (Block){color},
+                                                inChunk.x,
+                                                inChunk.y,
+                                                inChunk.z);
+                                _shape_slices_update(s, inShape, 1);
+                                ++addedCount[color];
+                                ++added;
+                                addedMin.x = minimum(addedMin.x, inShape.x);
+                                addedMin.y = minimum(addedMin.y, inShape.y);
+                                addedMin.z = minimum(addedMin.z, inShape.z);
+                                addedMax.x = maximum(addedMax.x, inShape.x);
+                                addedMax.y = maximum(addedMax.y, inShape.y);
+                                addedMax.z = maximum(addedMax.z, inShape.z);
+                                if (lighting) {
+                                    shape_compute_baked_lighting_added_block(s,
+                                                                             chunk,
+                                                                             inShape,
+                                                                             inChunk,
+                                                                             color);
+                                }
+                            } else {
+                                chunk_paint_block(chunk,
+                                                  inChunk.x,
+                                                  inChunk.y,
+                                                  inChunk.z,
+                                                  color,
+                                                  NULL);
+                                ++removedCount[current];
+                                ++addedCount[color];
+                                if (lighting) {
+                                    shape_compute_baked_lighting_replaced_block(s,
+                                                                                chunk,
+                                                                                inShape,
+                                                                                inChunk,
+                                                                                color);
+                                }
+                            }
+                            ++changed;
+
+                            changedMin.x = minimum(changedMin.x, inChunk.x);
+                            changedMin.y = minimum(changedMin.y, inChunk.y);
+                            changedMin.z = minimum(changedMin.z, inChunk.z);
+                            changedMax.x = maximum(changedMax.x, inChunk.x);
+                            changedMax.y = maximum(changedMax.y, inChunk.y);
+                            changedMax.z = maximum(changedMax.z, inChunk.z);
+                        }
+                    }
+                }
+
+                if (changedMax.x >= 0) {
+                    _shape_chunk_enqueue_refresh(s, chunk);
+                    _shape_chunk_check_neighbors_dirty(s, chunk, changedMin);
+                    _shape_chunk_check_neighbors_dirty(s, chunk, changedMax);
+                    _shape_lod_set_dirty(s, chunk);
+                    _shape_chunk_stamp(s, chunk);
+                }
+            }
+        }
+    }
+
+    if (lightingBatch) {
+        _shape_lighting_batch_end(s);
+    }
+
+    if (previous != NULL) {
+        if (recorded) {
+            transaction_colors_seal(previous);
+        } else {
+            cclog_error("_shape_edit_region: failed to record previous colors");
+            transaction_colors_free(previous);
+        }
+    }
+
+    if (changed == 0) {
+        return 0;
+    }
+
+    s->nbBlocks = s->nbBlocks + added - removed;
+    for (int i = 0; i < SHAPE_COLOR_INDEX_MAX_COUNT; ++i) {
+        const SHAPE_COLOR_INDEX_INT_T entry = (SHAPE_COLOR_INDEX_INT_T)i;
+        if (removedCount[i] > 0) {
+            color_palette_decrement_color(s->palette, entry, removedCount[i]);
+            s->blocksCount[i] -= removedCount[i];
+        }
+        if (addedCount[i] > 0) {
+            color_palette_increment_color(s->palette, entry, addedCount[i]);
+            s->blocksCount[i] += addedCount[i];
+        }
+    }
+
+    if (addedMin.x <= addedMax.x) {
+        shape_expand_box(s, addedMin);
+        shape_expand_box(s, addedMax);
+    }
+    if (removed > 0) {
+        shape_reset_box(s);
+    }
+
+    return changed;
+}
+
+bool _shape_read_region(const Shape *s,
+                        const SHAPE_COORDS_INT3_T min,
+                        const SHAPE_COORDS_INT3_T max,
+                        TransactionColors *colors) {
+
+    const size_t sizeY = (size_t)(max.y - min.y), sizeZ = (size_t)(max.z - min.z);
+    if (colors->dense != NULL) {
+        memset(colors->dense,
+               SHAPE_COLOR_INDEX_AIR_BLOCK,
+               (size_t)(max.x - min.x) * sizeY * sizeZ * sizeof(SHAPE_COLOR_INDEX_INT_T));
+    }
+
+    const SHAPE_COORDS_INT3_T chunkMin = chunk_utils_get_coords(min);
+    const SHAPE_COORDS_INT3_T chunkMax = chunk_utils_get_coords(
+        (SHAPE_COORDS_INT3_T){max.x - 1, max.y - 1, max.z - 1});
+
+    for (int32_t cx = chunkMin.x; cx <= chunkMax.x; ++cx) {
+        for (int32_t cy = chunkMin.y; cy <= chunkMax.y; ++cy) {
+            for (int32_t cz = chunkMin.z; cz <= chunkMax.z; ++cz) {
+                const Chunk *chunk = (const Chunk *)index3d_get(s->chunks, cx, cy, cz);
+                if (chunk == NULL) {
+                    continue;
+                }
+                const int32_t ox = cx * CHUNK_SIZE, oy = cy * CHUNK_SIZE, oz = cz * CHUNK_SIZE;
+
+                for (int32_t x = maximum(min.x, ox); x < minimum(max.x, ox + CHUNK_SIZE); ++x) {
+                    for (int32_t y = maximum(min.y, oy); y < minimum(max.y, oy + CHUNK_SIZE);
+                         ++y) {
+                        size_t i = ((size_t)(x - min.x) * sizeY + (size_t)(y - min.y)) * sizeZ +
+                                   (size_t)(maximum(min.z, oz) - min.z);
+                        for (int32_t z = maximum(min.z, oz); z < minimum(max.z, oz + CHUNK_SIZE);
+                             ++z, ++i) {
+                            const Block *b = chunk_get_block(chunk,
+                                                             (CHUNK_COORDS_INT_T)(x - ox),
+                                                             (CHUNK_COORDS_INT_T)(y - oy),
+                                                             (CHUNK_COORDS_INT_T)(z - oz));
+                            if (block_is_solid(b) &&
+                                transaction_colors_set(colors, (uint32_t)i, b->colorIndex) ==
+                                    false) {
+                                return false;
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+    transaction_colors_seal(colors);
+    return true;
+}
+
+uint32_t _shape_apply_region(Shape *s, TransactionRegion *r, const bool undo) {
+    if (undo) {
+        if (transaction_colors_is_set(&r->before) == false) {
+            return 0;
+        }
+        return _shape_edit_region(s,
+                                  r->min,
+                                  r->max,
+                                  &r->before,
+                                  SHAPE_COLOR_INDEX_AIR_BLOCK,
+                                  true,
+                                  NULL);
+    }
+    if (transaction_colors_is_set(&r->before) == false) {
+        const size_t volume = (size_t)(r->max.x - r->min.x) * (size_t)(r->max.y - r->min.y) *
+                              (size_t)(r->max.z - r->min.z);
+        if (transaction_colors_init(&r->before, volume) == false) {
+            transaction_colors_free(&r->before);
+            return 0;
+        }
+    } else {
+        // recorded again when redone
+        r->before.nbRuns = 0;
+    }
+    const bool fill = transaction_colors_is_set(&r->after) == false;
+    return _shape_edit_region(s,
+                              r->min,
+                              r->max,
+                              fill ? NULL : &r->after,
+                              r->fill,
+                              fill,
+                              &r->before);
+}
+
+uint32_t _shape_region_operation(Shape *s,
+                                 Scene *scene,
+                                 const SHAPE_COORDS_INT3_T min,
+                                 const SHAPE_COORDS_INT3_T max,
+                                 TransactionColors *after,
+                                 const SHAPE_COLOR_INDEX_INT_T fill) {
+
+    // pending block changes are applied first, and closed if kept pending, so that they remain
+    // their own history entry before this one
+    shape_apply_current_transaction(s, false);
+    if (s->pendingTransaction != NULL) {
+        if (s->history != NULL) {
+            transaction_resetIndex3DIterator(s->pendingTransaction);
+            history_pushTransaction(s->history, s->pendingTransaction);
+        } else {
+            transaction_free(s->pendingTransaction);
+        }
+        s->pendingTransaction = NULL;
+    }
+
+    Transaction *tr = transaction_new();
+    if (transaction_addRegion(tr, min, max, after, fill) == false) {
+        if (after != NULL) {
+            transaction_colors_free(after);
+        }
+        transaction_free(tr);
+        return 0;
+    }
+
+    TransactionRegion *r = transaction_getRegion(tr, 0);
+    const uint32_t changed = _shape_apply_region(s, r, false);
+
+    // can't be undone if previous colors couldn't be recorded
+    if (changed > 0 && _shape_get_lua_flag(s, SHAPE_LUA_FLAG_HISTORY) && s->history != NULL &&
+        transaction_colors_is_set(&r->before)) {
+        history_discardTransactionsMoreRecentThanCursor(s->history);
+        history_pushTransaction(s->history, tr);
+    } else {
+        transaction_free(tr);
+    }
+
+    // register awake box if using per-block collisions
+    if (changed > 0 && scene != NULL &&
+        rigidbody_uses_per_block_collisions(transform_get_rigidbody(s->transform))) {
+        Matrix4x4 model;
+        transform_utils_get_model_ltw(s->transform, &model);
+
+        const Box box = {{(float)min.x, (float)min.y, (float)min.z},
+                         {(float)max.x, (float)max.y, (float)max.z}};
+        Box aab;
+        box_to_aabox2(&box, &aab, &model, NULL, NoSquarify);
+        scene_register_awake_box(scene,
+                                 box_new_2(aab.min.x - PHYSICS_AWAKE_DISTANCE,
+                                           aab.min.y - PHYSICS_AWAKE_DISTANCE,
+                                           aab.min.z - PHYSICS_AWAKE_DISTANCE,
+                                           aab.max.x + PHYSICS_AWAKE_DISTANCE,
+                                           aab.max.y + PHYSICS_AWAKE_DISTANCE,
+                                           aab.max.z + PHYSICS_AWAKE_DISTANCE));
+    }
+
+    return changed;
+}
+
+bool _shape_region_is_valid(const SHAPE_COORDS_INT3_T min, const SHAPE_COORDS_INT3_T max) {
+    return min.x < max.x && min.y < max.y && min.z < max.z;
+}
+
 void _light_removal_all(Shape *s, SHAPE_COORDS_INT3_T *min, SHAPE_COORDS_INT3_T *max) {
     Index3DIterator *it = index3d_iterator_new(s->chunks);
     Chunk *c;
@@ -4096,6 +5911,106 @@ void _light_removal_all(Shape *s, SHAPE_COORDS_INT3_T *min, SHAPE_COORDS_INT3_T
     }
 }
 
+void _light_removal_columns(Shape *s,
+                            SHAPE_COORDS_INT3_T chunkMin,
+                            SHAPE_COORDS_INT3_T chunkMax,
+                            SHAPE_COORDS_INT3_T *min,
+                            SHAPE_COORDS_INT3_T *max) {
+    SHAPE_COORDS_INT_T yMin = chunkMin.y, yMax = chunkMax.y;
+
+    Index3DIterator *it = index3d_iterator_new(s->chunks);
+    Chunk *c;
+    while (index3d_iterator_pointer(it) != NULL) {
+        c = index3d_iterator_pointer(it);
+
+        const SHAPE_COORDS_INT3_T coords = chunk_utils_get_coords(chunk_get_origin(c));
+        yMin = minimum(yMin, coords.y);
+        yMax = maximum(yMax, coords.y);
+        if (coords.x >= chunkMin.x && coords.x <= chunkMax.x && coords.z >= chunkMin.z &&
+            coords.z <= chunkMax.z) {
+            chunk_reset_lighting_data(c, true);
+        }
+
+        index3d_iterator_next(it);
+    }
+    index3d_iterator_free(it);
+
+    *min = (SHAPE_COORDS_INT3_T){(SHAPE_COORDS_INT_T)(chunkMin.x * CHUNK_SIZE),
+                                 (SHAPE_COORDS_INT_T)(yMin * CHUNK_SIZE),
+                                 (SHAPE_COORDS_INT_T)(chunkMin.z * CHUNK_SIZE)};
+    *max = (SHAPE_COORDS_INT3_T){(SHAPE_COORDS_INT_T)((chunkMax.x + 1) * CHUNK_SIZE),
+                                 (SHAPE_COORDS_INT_T)((yMax + 1) * CHUNK_SIZE),
+                                 (SHAPE_COORDS_INT_T)((chunkMax.z + 1) * CHUNK_SIZE)};
+}
+
+void _light_enqueue_area_border_sources(Shape *s,
+                                        LightNodeQueue *q,
+                                        SHAPE_COORDS_INT3_T min,
+                                        SHAPE_COORDS_INT3_T max) {
+    Chunk *chunk;
+    CHUNK_COORDS_INT3_T coords_in_chunk;
+    SHAPE_COORDS_INT3_T coords_in_shape;
+    const Block *b;
+    VERTEX_LIGHT_STRUCT_T light;
+    for (SHAPE_COORDS_INT_T x = min.x - 1; x <= max.x; ++x) {
+        for (SHAPE_COORDS_INT_T z = min.z - 1; z <= max.z; ++z) {
+            // only the ring of columns around the area
+            if (x >= min.x && x < max.x && z >= min.z && z < max.z) {
+                continue;
+            }
+            for (SHAPE_COORDS_INT_T y = min.y; y < max.y; ++y) {
+                coords_in_shape = (SHAPE_COORDS_INT3_T){x, y, z};
+                shape_get_chunk_and_coordinates(s, coords_in_shape, &chunk, NULL, &coords_in_chunk);
+                if (chunk == NULL) {
+                    continue;
+                }
+
+                b = chunk_get_block_2(chunk, coords_in_chunk);
+                if (b == NULL) {
+                    continue;
+                }
+                if (color_palette_is_emissive(s->palette, b->colorIndex)) {
+                    light_node_queue_push(q, chunk, coords_in_shape);
+                } else if (b->colorIndex == SHAPE_COLOR_INDEX_AIR_BLOCK ||
+                           color_palette_is_transparent(s->palette, b->colorIndex)) {
+                    light = chunk_get_light_without_checking(chunk, coords_in_chunk);
+                    if (light.ambient > 0 || light.red > 0 || light.green > 0 || light.blue > 0) {
+                        light_node_queue_push(q, chunk, coords_in_shape);
+                    }
+                }
+            }
+        }
+    }
+}
+
+void _shape_fill_gaps(Shape *s) {
+    // check all vertex buffers used by this shape, to see if they have to be defragmented
+    doubly_linked_list_flush(s->fragmentedVBs, NULL);
+    _shape_check_all_vb_fragmented(s, s->firstVB_opaque);
+    _shape_check_all_vb_fragmented(s, s->firstVB_transparent);
+
+    // fill remaining mem area gaps (for all vertex buffers involved), within budget
+    // Note: buffers still fragmented stay enlisted, to be continued next refresh
+    // Note: a buffer is still processed w/ no budget left, to merge & clear its gaps
+    uint32_t budget = SHAPE_BUFFER_COMPACTION_BUDGET > 0 ? SHAPE_BUFFER_COMPACTION_BUDGET
+                                                          : UINT32_MAX;
+    uint32_t moved;
+    DoublyLinkedListNode *n = doubly_linked_list_first(s->fragmentedVBs);
+    while (n != NULL) {
+        VertexBuffer *vb = (VertexBuffer *)doubly_linked_list_node_pointer(n);
+        DoublyLinkedListNode *next = doubly_linked_list_node_next(n);
+
+        moved = vertex_buffer_fill_gaps_incremental(vb, budget);
+        budget = moved < budget ? budget - moved : 0;
+
+        if (vertex_buffer_is_fragmented(vb) == false) {
+            doubly_linked_list_delete_node(s->fragmentedVBs, n);
+        }
+
+        n = next;
+    }
+}
+
 void _shape_check_all_vb_fragmented(Shape *s, VertexBuffer *first) {
     VertexBuffer *vb = first;
     while (vb != NULL) {
@@ -4128,6 +6043,50 @@ void _shape_flush_all_vb(Shape *s) {
     s->firstVB_transparent = NULL;
     s->vbAllocationFlag_opaque = 0;
     s->vbAllocationFlag_transparent = 0;
+    doubly_linked_list_flush(s->fragmentedVBs, NULL);
+}
+
+void _shape_instance_attach(Shape *s, Shape *model) {
+    if (model->instances == NULL) {
+        model->instances = doubly_linked_list_new();
+    }
+    s->model = model;
+    s->instanceNode = doubly_linked_list_push_last(model->instances, s);
+}
+
+void _shape_instance_detach(Shape *s, const bool refresh) {
+    Shape *model = s->model;
+    doubly_linked_list_delete_node(model->instances, s->instanceNode);
+    if (doubly_linked_list_first(model->instances) == NULL) {
+        doubly_linked_list_free(model->instances);
+        model->instances = NULL;
+    }
+    s->model = NULL;
+    s->instanceNode = NULL;
+
+    if (refresh) {
+        Index3DIterator *it = index3d_iterator_new(s->chunks);
+        while (index3d_iterator_pointer(it) != NULL) {
+            _shape_chunk_enqueue_refresh(s, index3d_iterator_pointer(it));
+            index3d_iterator_next(it);
+        }
+        index3d_iterator_free(it);
+    }
+}
+
+void _shape_detach_instances(Shape *s) {
+    // first instance is re-meshed and becomes the model of the others, which still have the same
+    // blocks, so that only one of them needs new buffers
+    Shape *model = (Shape *)doubly_linked_list_node_pointer(doubly_linked_list_first(s->instances));
+    _shape_instance_detach(model, true);
+
+    // instances list is freed along w/ last instance
+    Shape *instance;
+    while (s->instances != NULL) {
+        instance = (Shape *)doubly_linked_list_node_pointer(doubly_linked_list_first(s->instances));
+        _shape_instance_detach(instance, false);
+        _shape_instance_attach(instance, model);
+    }
 }
 
 void _shape_fill_draw_slices(VertexBuffer *vb) {
@@ -4172,6 +6131,9 @@ bool _shape_apply_transaction(Shape *const sh, Transaction *tr) {
     BlockChange *bc;
     const Block *b;
 
+    // gather lighting changes of all block changes, to process them at once
+    const bool lightingBatch = _shape_lighting_batch_begin(sh);
+
     while (index3d_iterator_pointer(it) != NULL) {
         bc = (BlockChange *)index3d_iterator_pointer(it);
 
@@ -4211,6 +6173,15 @@ bool _shape_apply_transaction(Shape *const sh, Transaction *tr) {
         index3d_iterator_next(it);
     }
 
+    // then volume changes
+    for (uint32_t i = 0; i < transaction_getRegionCount(tr); ++i) {
+        _shape_apply_region(sh, transaction_getRegion(tr, i), false);
+    }
+
+    if (lightingBatch) {
+        _shape_lighting_batch_end(sh);
+    }
+
     if (resetBoxNeeded) {
         shape_reset_box(sh);
     }
@@ -4244,6 +6215,14 @@ bool _shape_undo_transaction(Shape *const sh, Transaction *tr) {
     BlockChange *bc;
     const Block *b;
 
+    // gather lighting changes of all block changes, to process them at once
+    const bool lightingBatch = _shape_lighting_batch_begin(sh);
+
+    // volume changes were applied last, revert them first
+    for (uint32_t i = transaction_getRegionCount(tr); i > 0; --i) {
+        _shape_apply_region(sh, transaction_getRegion(tr, i - 1), true);
+    }
+
     while (index3d_iterator_pointer(it) != NULL) {
         bc = (BlockChange *)index3d_iterator_pointer(it);
 
@@ -4276,6 +6255,10 @@ bool _shape_undo_transaction(Shape *const sh, Transaction *tr) {
         index3d_iterator_next(it);
     }
 
+    if (lightingBatch) {
+        _shape_lighting_batch_end(sh);
+    }
+
     if (resetBoxNeeded == true) {
         shape_reset_box(sh);
     }
@@ -4364,3 +6347,374 @@ bool _shape_is_bounding_box_empty(const Shape *shape) {
     return shape->bbMin.x == shape->bbMax.x || shape->bbMin.y == shape->bbMax.y ||
            shape->bbMin.z == shape->bbMax.z;
 }
+
+bool _shape_combine_get_translation(const Matrix4x4 *m, int32_t offset[3]) {
+    const float linear[9] = {m->x1y1, m->x1y2, m->x1y3, m->x2y1, m->x2y2, m->x2y3,
+                             m->x3y1, m->x3y2, m->x3y3};
+    for (int i = 0; i < 9; ++i) {
+        const float expected = i % 4 == 0 ? 1.0f : 0.0f;
+        if (fabsf(linear[i] - expected) > EPSILON_ZERO) {
+            return false;
+        }
+    }
+    const float translation[3] = {m->x4y1, m->x4y2, m->x4y3};
+    for (int i = 0; i < 3; ++i) {
+        const float rounded = roundf(translation[i]);
+        if (fabsf(translation[i] - rounded) > EPSILON_ZERO || fabsf(rounded) > (float)INT16_MAX) {
+            return false;
+        }
+        offset[i] = (int32_t)rounded;
+    }
+    return true;
+}
+
+void _shape_combine_get_box(const ShapeCombineSource *src,
+                            const Matrix4x4 *m,
+                            const SHAPE_COORDS_INT3_T min,
+                            const SHAPE_COORDS_INT3_T max,
+                            int32_t outMin[3],
+                            int32_t outMax[3]) {
+    if (src->translation) {
+        outMin[0] = min.x + src->offset[0];
+        outMin[1] = min.y + src->offset[1];
+        outMin[2] = min.z + src->offset[2];
+        outMax[0] = max.x + src->offset[0];
+        outMax[1] = max.y + src->offset[1];
+        outMax[2] = max.z + src->offset[2];
+    } else {
+        float3 fMin = {FLT_MAX, FLT_MAX, FLT_MAX}, fMax = {-FLT_MAX, -FLT_MAX, -FLT_MAX};
+        float3 corner, transformed;
+        for (int i = 0; i < 8; ++i) {
+            corner.x = (float)((i & 1) ? max.x : min.x);
+            corner.y = (float)((i & 2) ? max.y : min.y);
+            corner.z = (float)((i & 4) ? max.z : min.z);
+            matrix4x4_op_multiply_vec_point(&transformed, &corner, m);
+            fMin.x = minimum(fMin.x, transformed.x);
+            fMin.y = minimum(fMin.y, transformed.y);
+            fMin.z = minimum(fMin.z, transformed.z);
+            fMax.x = maximum(fMax.x, transformed.x);
+            fMax.y = maximum(fMax.y, transformed.y);
+            fMax.z = maximum(fMax.z, transformed.z);
+        }
+        const float limit = (float)INT16_MAX;
+        outMin[0] = (int32_t)floorf(CLAMP(fMin.x, -limit, limit));
+        outMin[1] = (int32_t)floorf(CLAMP(fMin.y, -limit, limit));
+        outMin[2] = (int32_t)floorf(CLAMP(fMin.z, -limit, limit));
+        outMax[0] = (int32_t)ceilf(CLAMP(fMax.x, -limit, limit));
+        outMax[1] = (int32_t)ceilf(CLAMP(fMax.y, -limit, limit));
+        outMax[2] = (int32_t)ceilf(CLAMP(fMax.z, -limit, limit));
+    }
+
+    // combined shape coordinates must fit in SHAPE_COORDS_INT_T
+    for (int i = 0; i < 3; ++i) {
+        outMin[i] = maximum(outMin[i], INT16_MIN);
+        outMax[i] = minimum(outMax[i], INT16_MAX);
+    }
+}
+
+void _shape_combine_map_colors(ColorPalette *palette, ShapeCombineSource *src) {
+    const Shape *s = src->shape;
+    memset(src->mapping, SHAPE_COLOR_INDEX_AIR_BLOCK, sizeof(src->mapping));
+    const uint8_t count = color_palette_get_count(s->palette);
+    for (uint8_t i = 0; i < count; ++i) {
+        if (s->blocksCount[i] == 0) {
+            continue;
+        }
+        const RGBAColor color = color_palette_get_color(s->palette, i);
+        if (color_palette_find(palette, color, &src->mapping[i])) {
+            continue;
+        }
+        if (color_palette_check_and_add_color(palette, color, &src->mapping[i], true)) {
+            color_palette_set_emissive(palette,
+                                       src->mapping[i],
+                                       color_palette_is_emissive(s->palette, i));
+        } else {
+            // combined palette is full, skip those blocks
+            src->mapping[i] = SHAPE_COLOR_INDEX_AIR_BLOCK;
+        }
+    }
+}
+
+bool _shape_combine_add_source_to_job(ShapeCombine *c,
+                                      Index3D *index,
+                                      const int32_t x,
+                                      const int32_t y,
+                                      const int32_t z,
+                                      const uint32_t source) {
+    ShapeCombineJob *j = (ShapeCombineJob *)index3d_get(index, x, y, z);
+    if (j == NULL) {
+        if ((c->nbJobs & (c->nbJobs - 1)) == 0) { // grow when reaching a power of 2
+            const size_t capacity = c->nbJobs == 0 ? 1 : c->nbJobs * 2;
+            ShapeCombineJob **jobs =
+                (ShapeCombineJob **)realloc(c->jobs, capacity * sizeof(ShapeCombineJob *));
+            if (jobs == NULL) {
+                return false;
+            }
+            c->jobs = jobs;
+        }
+        j = (ShapeCombineJob *)malloc(sizeof(ShapeCombineJob));
+        if (j == NULL) {
+            return false;
+        }
+        j->sources = NULL;
+        j->nbSources = 0;
+        j->sourcesCapacity = 0;
+        j->chunk = NULL;
+        j->colorsCount = NULL;
+        j->coords = (SHAPE_COORDS_INT3_T){(SHAPE_COORDS_INT_T)x,
+                                          (SHAPE_COORDS_INT_T)y,
+                                          (SHAPE_COORDS_INT_T)z};
+        c->jobs[c->nbJobs++] = j;
+        index3d_insert(index, j, x, y, z, NULL);
+    } else if (j->nbSources > 0 && j->sources[j->nbSources - 1] == source) {
+        return true;
+    }
+
+    if (j->nbSources == j->sourcesCapacity) {
+        const uint32_t capacity = j->sourcesCapacity == 0 ? 2 : j->sourcesCapacity * 2;
+        uint32_t *sources = (uint32_t *)realloc(j->sources, capacity * sizeof(uint32_t));
+        if (sources == NULL) {
+            return false;
+        }
+        j->sources = sources;
+        j->sourcesCapacity = capacity;
+    }
+    j->sources[j->nbSources++] = source;
+    return true;
+}
+
+void _shape_combine_write_source(const ShapeCombineSource *src,
+                                 const SHAPE_COORDS_INT3_T origin,
+                                 Block *blocks) {
+    const int32_t min[3] = {maximum(src->min[0], origin.x),
+                            maximum(src->min[1], origin.y),
+                            maximum(src->min[2], origin.z)};
+    const int32_t max[3] = {minimum(src->max[0], origin.x + CHUNK_SIZE),
+                            minimum(src->max[1], origin.y + CHUNK_SIZE),
+                            minimum(src->max[2], origin.z + CHUNK_SIZE)};
+    if (min[0] >= max[0] || min[1] >= max[1] || min[2] >= max[2]) {
+        return;
+    }
+
+    const Shape *s = src->shape;
+    const Block *srcBlocks = NULL;
+    SHAPE_COORDS_INT3_T srcChunkCoords = {0, 0, 0};
+    bool cached = false;
+    SHAPE_COORDS_INT3_T coords, chunkCoords;
+    CHUNK_COORDS_INT3_T coordsInChunk;
+    const Block *b;
+    Block *dst;
+    int32_t x, n;
+
+    for (int32_t z = min[2]; z < max[2]; ++z) {
+        for (int32_t y = min[1]; y < max[1]; ++y) {
+            dst = blocks + ((z - origin.z) * CHUNK_SIZE + (y - origin.y)) * CHUNK_SIZE +
+                  (min[0] - origin.x);
+            x = min[0];
+            while (x < max[0]) {
+                n = 1;
+                if (src->translation) {
+                    coords = (SHAPE_COORDS_INT3_T){(SHAPE_COORDS_INT_T)(x - src->offset[0]),
+                                                   (SHAPE_COORDS_INT_T)(y - src->offset[1]),
+                                                   (SHAPE_COORDS_INT_T)(z - src->offset[2])};
+                } else {
+                    // sample source at cell center
+                    const float3 center = {(float)x + 0.5f, (float)y + 0.5f, (float)z + 0.5f};
+                    float3 p;
+                    matrix4x4_op_multiply_vec_point(&p, &center, &src->inverse);
+                    if (p.x < (float)s->bbMin.x || p.y < (float)s->bbMin.y ||
+                        p.z < (float)s->bbMin.z || p.x >= (float)s->bbMax.x ||
+                        p.y >= (float)s->bbMax.y || p.z >= (float)s->bbMax.z) {
+                        ++x;
+                        ++dst;
+                        continue;
+                    }
+                    coords = (SHAPE_COORDS_INT3_T){(SHAPE_COORDS_INT_T)floorf(p.x),
+                                                   (SHAPE_COORDS_INT_T)floorf(p.y),
+                                                   (SHAPE_COORDS_INT_T)floorf(p.z)};
+                }
+                coordsInChunk = chunk_utils_get_coords_in_chunk(coords);
+
+                // translated rows are read in runs, up to the end of source chunk
+                if (src->translation) {
+                    n = minimum(max[0] - x, CHUNK_SIZE - coordsInChunk.x);
+                }
+
+                chunkCoords = chunk_utils_get_coords(coords);
+                if (cached == false || chunkCoords.x != srcChunkCoords.x ||
+                    chunkCoords.y != srcChunkCoords.y || chunkCoords.z != srcChunkCoords.z) {
+                    const Chunk *chunk = (const Chunk *)
+                        index3d_get(s->chunks, chunkCoords.x, chunkCoords.y, chunkCoords.z);
+                    srcBlocks = chunk != NULL ? chunk_get_blocks(chunk) : NULL;
+                    srcChunkCoords = chunkCoords;
+                    cached = true;
+                }
+
+                if (srcBlocks != NULL) {
+                    b = srcBlocks + (coordsInChunk.z * CHUNK_SIZE + coordsInChunk.y) * CHUNK_SIZE +
+                        coordsInChunk.x;
+                    for (int32_t i = 0; i < n; ++i) {
+                        if (block_is_solid(b + i) &&
+                            src->mapping[b[i].colorIndex] != SHAPE_COLOR_INDEX_AIR_BLOCK) {
+                            dst[i].colorIndex = src->mapping[b[i].colorIndex];
+                        }
+                    }
+                }
+                x += n;
+                dst += n;
+            }
+        }
+    }
+}
+
+void _shape_combine_free(ShapeCombine *c) {
+    for (size_t i = 0; i < c->nbJobs; ++i) {
+        ShapeCombineJob *j = c->jobs[i];
+        if (j->chunk != NULL) {
+            chunk_free(j->chunk, false);
+        }
+        free(j->colorsCount);
+        free(j->sources);
+        free(j);
+    }
+    free(c->jobs);
+    free(c->sources);
+    color_palette_release(c->palette);
+    free(c);
+}
+
+ShapeSlices *_shape_slices_new_copy(const ShapeSlices *src) {
+    ShapeSlices *slices = (ShapeSlices *)malloc(sizeof(ShapeSlices));
+    if (slices == NULL) {
+        return NULL;
+    }
+    for (int axis = 0; axis < 3; ++axis) {
+        if (src != NULL && src->size[axis] > 0) {
+            slices->origin[axis] = src->origin[axis];
+            slices->size[axis] = src->size[axis];
+            slices->counts[axis] = (uint32_t *)malloc(src->size[axis] * sizeof(uint32_t));
+            memcpy(slices->counts[axis], src->counts[axis], src->size[axis] * sizeof(uint32_t));
+        } else {
+            slices->origin[axis] = 0;
+            slices->size[axis] = 0;
+            slices->counts[axis] = NULL;
+        }
+    }
+    return slices;
+}
+
+void _shape_slices_build(Shape *s) {
+    _shape_slices_free(s);
+
+    s->slices = _shape_slices_new_copy(NULL);
+    if (s->slices == NULL) {
+        return;
+    }
+
+    Index3DIterator *it = index3d_iterator_new(s->chunks);
+    CHUNK_COORDS_INT3_T min, max;
+    while (index3d_iterator_pointer(it) != NULL) {
+        const Chunk *c = (const Chunk *)index3d_iterator_pointer(it);
+        if (chunk_get_nb_blocks(c) > 0) {
+            const SHAPE_COORDS_INT3_T origin = chunk_get_origin(c);
+            chunk_get_bounding_box_2(c, &min, &max);
+            for (CHUNK_COORDS_INT_T x = min.x; x < max.x; ++x) {
+                for (CHUNK_COORDS_INT_T y = min.y; y < max.y; ++y) {
+                    for (CHUNK_COORDS_INT_T z = min.z; z < max.z; ++z) {
+                        if (block_is_solid(chunk_get_block(c, x, y, z))) {
+                            _shape_slices_update(
+                                s,
+                                (SHAPE_COORDS_INT3_T){(SHAPE_COORDS_INT_T)(origin.x + x),
+                                                      (SHAPE_COORDS_INT_T)(origin.y + y),
+                                                      (SHAPE_COORDS_INT_T)(origin.z + z)},
+                                1);
+                        }
+                    }
+                }
+            }
+        }
+        index3d_iterator_next(it);
+    }
+    index3d_iterator_free(it);
+}
+
+void _shape_slices_free(Shape *s) {
+    if (s->slices == NULL) {
+        return;
+    }
+    for (int axis = 0; axis < 3; ++axis) {
+        free(s->slices->counts[axis]);
+    }
+    free(s->slices);
+    s->slices = NULL;
+}
+
+void _shape_slices_update(Shape *s, const SHAPE_COORDS_INT3_T coords, const int32_t delta) {
+    ShapeSlices *slices = s->slices;
+    if (slices == NULL) {
+        return;
+    }
+    const int32_t values[3] = {coords.x, coords.y, coords.z};
+    for (int axis = 0; axis < 3; ++axis) {
+        const int32_t v = values[axis];
+        int32_t origin = slices->origin[axis];
+        uint32_t size = slices->size[axis];
+
+        // grow range, at least doubling it to keep amortized cost low
+        if (v < origin || v >= origin + (int32_t)size) {
+            int32_t newOrigin = origin, newEnd = origin + (int32_t)size;
+            if (size == 0) {
+                newOrigin = v;
+                newEnd = v + 1;
+            } else if (v < origin) {
+                newOrigin = maximum(minimum(v, origin - (int32_t)size), INT16_MIN);
+            } else {
+                newEnd = minimum(maximum(v + 1, newEnd + (int32_t)size), INT16_MAX + 1);
+            }
+            const uint32_t newSize = (uint32_t)(newEnd - newOrigin);
+            uint32_t *counts = (uint32_t *)calloc(newSize, sizeof(uint32_t));
+            if (counts == NULL) {
+                _shape_slices_free(s);
+                return;
+            }
+            if (size > 0) {
+                memcpy(counts + (origin - newOrigin),
+                       slices->counts[axis],
+                       size * sizeof(uint32_t));
+            }
+            free(slices->counts[axis]);
+            slices->counts[axis] = counts;
+            slices->origin[axis] = origin = newOrigin;
+            slices->size[axis] = size = newSize;
+        }
+
+        slices->counts[axis][v - origin] = (uint32_t)((int32_t)slices->counts[axis][v - origin] +
+                                                      delta);
+    }
+}
+
+void _shape_slices_get_bounds(const Shape *s,
+                              const int axis,
+                              const int32_t min,
+                              const int32_t max,
+                              SHAPE_COORDS_INT_T *outMin,
+                              SHAPE_COORDS_INT_T *outMax) {
+    const ShapeSlices *slices = s->slices;
+    const uint32_t *counts = slices->counts[axis];
+    const int32_t origin = slices->origin[axis];
+
+    int32_t lo = maximum(min, origin);
+    int32_t hi = minimum(max, origin + (int32_t)slices->size[axis]) - 1;
+    while (lo <= hi && counts[lo - origin] == 0) {
+        ++lo;
+    }
+    while (hi >= lo && counts[hi - origin] == 0) {
+        --hi;
+    }
+    if (lo > hi) {
+        *outMin = *outMax = 0;
+    } else {
+        *outMin = (SHAPE_COORDS_INT_T)lo;
+        *outMax = (SHAPE_COORDS_INT_T)(hi + 1);
+    }
+}
@@ -22,6 +22,7 @@ extern "C" {
 #include "index3d.h"
 #include "map_string_float3.h"
 #include "matrix4x4.h"
+#include "occlusion_buffer.h"
 #include "octree.h"
 #include "quaternion.h"
 #include "ray.h"
@@ -70,6 +71,11 @@ typedef uint8_t ShapeDrawMode;
 Shape *shape_new(void);
 Shape *shape_new_2(const bool isMutable);
 Shape *shape_new_copy(Shape *const s);
+/// Creates a copy of `model` sharing its blocks and drawn w/ its vertex buffers & palette, until
+/// either of them gets modified. Transform, tint, draw mode & layers are per instance.
+/// Instancing an instance uses the same model. Refreshing an instance refreshes its model. A
+/// modified or freed model hands its instances over to the first of them, the only one re-meshed.
+Shape *shape_new_instance(Shape *const model);
 
 /// Returns false if retain fails
 bool shape_retain(Shape *const shape);
@@ -83,11 +89,30 @@ void shape_free(Shape *const shape);
 Weakptr *shape_get_weakptr(Shape *const s);
 Weakptr *shape_get_and_retain_weakptr(Shape *const s);
 
-uint16_t shape_get_id(const Shape *shape);
+uint32_t shape_get_id(const Shape *shape);
 
 // removes all blocks from shape and resets its transform(s)
 void shape_flush(Shape *shape);
 
+/// Merging shapes into a new one, `transforms` (optional, as well as each of its elements) going
+/// from each shape model space to the combined shape model space. Palettes are merged once, then
+/// each chunk of the combined shape is built in one pass: translations on the integer grid copy
+/// blocks, other transforms sample source blocks at each cell center. Later shapes overwrite
+/// blocks of previous ones.
+/// Jobs only read source shapes and can be processed on separate threads, as long as source
+/// shapes aren't modified in the meantime. Jobs not processed yet are processed when ending.
+typedef struct _ShapeCombine ShapeCombine;
+/// Returns NULL if there are no shapes or if jobs can't be allocated
+ShapeCombine *shape_combine_new(Shape **shapes,
+                                const Matrix4x4 **transforms,
+                                const size_t count);
+size_t shape_combine_get_nb_jobs(const ShapeCombine *c);
+void shape_combine_process(ShapeCombine *c, const size_t job);
+/// Returns the combined shape, freeing `c`
+Shape *shape_combine_end(ShapeCombine *c);
+/// Combines shapes processing all jobs on calling thread
+Shape *shape_combine(Shape **shapes, const Matrix4x4 **transforms, const size_t count);
+
 // access palette reference to get or set the colors
 ColorPalette *shape_get_palette(const Shape *shape);
 void shape_set_palette(Shape *shape, ColorPalette *palette, const bool retain);
@@ -99,10 +124,10 @@ const Block *shape_get_block(const Shape *const shape,
                              const SHAPE_COORDS_INT_T y,
                              const SHAPE_COORDS_INT_T z);
 /// Gets the block in model at the time of calling
-Block *shape_get_block_immediate(const Shape *const shape,
-                                 const SHAPE_COORDS_INT_T x,
-                                 const SHAPE_COORDS_INT_T y,
-                                 const SHAPE_COORDS_INT_T z);
+const Block *shape_get_block_immediate(const Shape *const shape,
+                                       const SHAPE_COORDS_INT_T x,
+                                       const SHAPE_COORDS_INT_T y,
+                                       const SHAPE_COORDS_INT_T z);
 
 /// Returns whether the block is considered added.
 /// (a block is not added if it is out of bounds of a fixed size shape, or if
@@ -143,6 +168,15 @@ bool shape_add_block(Shape *shape,
                      const SHAPE_COORDS_INT_T z,
                      bool useDefaultColor);
 
+/// Bulk version of shape_add_block for blocks sharing the same chunk, `coords` being in-chunk
+/// indexes (see chunk_add_blocks). Chunk, counters, box and neighbors are updated once, which makes
+/// it the preferred way to populate a shape from a file. Returns the number of blocks added.
+uint32_t shape_add_blocks_in_chunk(Shape *shape,
+                                   const SHAPE_COORDS_INT3_T chunkCoords,
+                                   const uint16_t *coords,
+                                   const SHAPE_COLOR_INDEX_INT_T *colors,
+                                   const uint32_t count);
+
 bool shape_remove_block(Shape *shape,
                         const SHAPE_COORDS_INT_T x,
                         const SHAPE_COORDS_INT_T y,
@@ -154,6 +188,30 @@ bool shape_paint_block(Shape *shape,
                        const SHAPE_COORDS_INT_T y,
                        const SHAPE_COORDS_INT_T z);
 
+/// Volume operations on the [min, max[ box, working chunk by chunk. Pending transaction is applied
+/// first, then each operation is applied right away and recorded as a single history entry.
+/// `scene` is optional, used to awake nearby physics. Return the number of changed blocks.
+uint32_t shape_fill_box(Shape *shape,
+                        Scene *scene,
+                        const SHAPE_COORDS_INT3_T min,
+                        const SHAPE_COORDS_INT3_T max,
+                        const SHAPE_COLOR_INDEX_INT_T colorIndex);
+uint32_t shape_clear_box(Shape *shape,
+                         Scene *scene,
+                         const SHAPE_COORDS_INT3_T min,
+                         const SHAPE_COORDS_INT3_T max);
+/// Copies blocks of `src` [srcMin, srcMax[ box into `dst` at `dstMin`, air leaving `dst` blocks
+/// unchanged. `remap` (of size SHAPE_COLOR_INDEX_MAX_COUNT) converts `src` palette entries into
+/// `dst` ones, otherwise colors are looked up or added in `dst` palette, skipping blocks that can't
+/// fit in it. `src` can be `dst`, regions can overlap.
+uint32_t shape_copy_region(Shape *dst,
+                           Scene *scene,
+                           const Shape *src,
+                           const SHAPE_COORDS_INT3_T srcMin,
+                           const SHAPE_COORDS_INT3_T srcMax,
+                           const SHAPE_COORDS_INT3_T dstMin,
+                           const SHAPE_COLOR_INDEX_INT_T *remap);
+
 void shape_get_bounding_box_size(const Shape *shape, int3 *size);
 // TODO: users of this function should probably use bounding box size and discard empty space at
 // origin
@@ -263,7 +321,17 @@ void shape_log_vertex_buffers(const Shape *shape, bool dirtyOnly, bool transpare
 VertexBuffer *shape_add_buffer(Shape *shape, bool transparency);
 void shape_refresh_vertices(Shape *shape);
 void shape_refresh_all_vertices(Shape *s);
+/// Removes chunks that are no longer dirty from the refresh queue, for chunks which vertices were
+/// written outside of shape_refresh_vertices (e.g. from a mesh cache)
+void shape_prune_dirty_chunks(Shape *s);
+/// Instances are drawn w/ their model's buffers
 VertexBuffer *shape_get_first_vertex_buffer(const Shape *shape, bool transparent);
+/// Returns the shape which vertex buffers are used to draw `s`, `s` itself if not an instance
+Shape *shape_get_model(Shape *s);
+bool shape_is_instance(const Shape *s);
+/// Instances currently drawn w/ `model` vertex buffers, can be used for instanced draws of the
+/// model's buffers w/ each instance transform & drawmodes. NULL if none, list of Shape pointers
+const DoublyLinkedList *shape_get_instances(const Shape *model);
 
 // MARK: - Physics -
 
@@ -289,7 +357,7 @@ float shape_box_cast(const Shape *s,
                      const bool withReplacement,
                      float3 *normal,
                      float3 *extraReplacement,
-                     Block **block,
+                     const Block **block,
                      SHAPE_COORDS_INT3_T *blockCoords);
 
 /// Casts a world ray against given shape. World distance, local impact, block & block octree
@@ -300,12 +368,24 @@ bool shape_ray_cast(const Transform *t,
                     const Ray *worldRay,
                     float *worldDistance,
                     float3 *localImpact,
-                    Block **block,
+                    const Block **block,
                     SHAPE_COORDS_INT3_T *coords);
 bool shape_point_overlap(const Shape *s, const float3 *world);
 /// Overlaps a box in shape's model space against its blocks
 /// @return true if there is an overlap
 bool shape_box_overlap(const Shape *s, const Box *modelBox, const float3 *modelEpsilon, Box *out);
+/// Stamp increased w/ every block addition or removal, see shape_blocks_changed_in_box
+uint32_t shape_get_blocks_stamp(const Shape *s);
+/// Whether blocks within `modelBox` may have been added or removed since `stamp` was read, only
+/// chunks overlapping the box are checked
+bool shape_blocks_changed_in_box(const Shape *s, const Box *modelBox, const uint32_t stamp);
+/// Gathers model coordinates of solid blocks colliding w/ `modelBox` (same test as in
+/// shape_box_cast), up to `max` blocks. Returns the number of blocks, or `max + 1` if there are
+/// more
+uint32_t shape_get_solid_blocks_in_box(const Shape *s,
+                                       const Box *modelBox,
+                                       SHAPE_COORDS_INT3_T *coords,
+                                       const uint32_t max);
 
 // MARK: - Graphics -
 
@@ -326,9 +406,41 @@ bool shape_has_shadow(const Shape *s);
 void shape_set_unlit(Shape *s, const bool value);
 bool shape_is_unlit(const Shape *s);
 
+/// Compact vertices use 12 bytes instead of 20 per vertex, halving vertex memory & upload size for
+/// large shapes. Shape coordinates must then fit in 16 bits, see VertexAttributesCompact
+void shape_set_compact_vertices(Shape *s, const bool value);
+bool shape_uses_compact_vertices(const Shape *s);
+
 void shape_set_layers(Shape *s, const uint16_t value);
 uint16_t shape_get_layers(const Shape *s);
 
+/// Culls shape chunks using its rtree, against the frustum of a view-projection matrix eg.
+/// camera_get_view_proj_matrix. Shape transform is expected to be refreshed.
+/// If an occlusion buffer is provided, full opaque chunks are added to it as occluders and chunks
+/// hidden behind them are culled as well. Buffer is not cleared, occluders added by previous
+/// queries in the same frame are taken into account.
+/// Visible chunks are pushed in `results`, their vertices are found by following the group chain
+/// of each chunk mem area (chunk_get_vbma, vertex_buffer_mem_area_get_group_next)
+/// @returns number of visible chunks
+size_t shape_query_visible_chunks(const Shape *s,
+                                  const Matrix4x4 *viewProj,
+                                  OcclusionBuffer *ob,
+                                  FifoList *results);
+
+// MARK: - LOD -
+
+/// Returns a coarser version of this shape where each block stands for 2^level blocks per axis
+/// (see chunk_downsample), level 0 being the shape itself, up to SHAPE_LOD_MAX_LEVEL. LODs are
+/// created on first request, then kept in sync w/ block changes on each request: only the chunks
+/// that changed are downsampled again.
+/// A LOD shares this shape's palette and has its own chunks & vertex buffers, to be refreshed like
+/// any shape. Its model space is this shape's model space divided by 2^level, its pivot & local
+/// scale are set to match this shape once added as its child.
+Shape *shape_get_lod(Shape *s, const uint8_t level);
+/// Picks a LOD level for this shape seen from `distance`, in world units, so that LOD blocks
+/// don't appear bigger than blocks at SHAPE_LOD_DISTANCE
+uint8_t shape_get_lod_level_for_distance(Shape *s, const float distance);
+
 // MARK: - POI -
 
 void shape_debug_points_of_interest(const Shape *s);
@@ -351,6 +463,13 @@ void shape_remove_point(Shape *s, const char *key);
 /// baked lighting
 void shape_compute_baked_lighting(Shape *s);
 
+/// Re-bakes lighting only in the area affected by given range of chunk coordinates, ie. the chunks
+/// themselves and their light-affected neighbors. Lighting outside of that area is expected to be
+/// up-to-date, it is used as a source for propagation
+void shape_compute_baked_lighting_in_chunks(Shape *s,
+                                            SHAPE_COORDS_INT3_T chunkMin,
+                                            SHAPE_COORDS_INT3_T chunkMax);
+
 void shape_toggle_baked_lighting(Shape *s, const bool toggle);
 bool shape_uses_baked_lighting(const Shape *s);
 VERTEX_LIGHT_STRUCT_T *shape_create_lighting_data_blob(const Shape *s, void **inout);
@@ -395,6 +514,8 @@ void shape_history_setEnabled(Shape *s, const bool enable);
 bool shape_history_getEnabled(Shape *s);
 void shape_history_setKeepTransactionPending(Shape *s, const bool b);
 bool shape_history_getKeepTransactionPending(Shape *s);
+/// Limits memory used by history, see history_set_byte_budget. No effect if history is disabled
+void shape_history_setByteBudget(Shape *s, const size_t budget);
 bool shape_history_canUndo(const Shape *const s);
 bool shape_history_canRedo(const Shape *const s);
 void shape_history_undo(Shape *const s);
@@ -74,7 +74,7 @@ void test_chunk_Block(void) {
     // chunk_get_block()
     // Check if the block is placed at the right spot in the chunk
     // Also check if the previous function of paint worked
-    Block *check = chunk_get_block(chunk, 4, 4, 4);
+    const Block *check = chunk_get_block(chunk, 4, 4, 4);
     TEST_CHECK(check->colorIndex == 1);
     check = chunk_get_block(chunk, 6, 6, 6);
     TEST_CHECK(check->colorIndex == 3);
@@ -131,6 +131,192 @@ void test_chunk_Block(void) {
     chunk_free(chunk, false);
 }
 
+// Add blocks in bulk, including an air block and a duplicate position, then check that only
+// solid blocks at free positions were added and that the bounding box covers all of them
+// --- chunk_add_blocks()
+/////
+void test_chunk_add_blocks(void) {
+    Chunk *chunk = chunk_new((SHAPE_COORDS_INT3_T){0, 0, 0});
+    TEST_CHECK(chunk_add_block(chunk, (Block){7}, 2, 3, 4));
+
+    const uint16_t coords[5] = {
+        1 * CHUNK_SIZE_SQR + 1 * CHUNK_SIZE + 1,
+        2 * CHUNK_SIZE_SQR + 3 * CHUNK_SIZE + 4, // already occupied
+        15 * CHUNK_SIZE_SQR + 0 * CHUNK_SIZE + 9,
+        5 * CHUNK_SIZE_SQR + 5 * CHUNK_SIZE + 5, // air
+        1 * CHUNK_SIZE_SQR + 1 * CHUNK_SIZE + 1, // duplicate
+    };
+    const SHAPE_COLOR_INDEX_INT_T colors[5] = {1, 2, 3, SHAPE_COLOR_INDEX_AIR_BLOCK, 4};
+    uint32_t colorsCount[SHAPE_COLOR_INDEX_MAX_COUNT] = {0};
+
+    TEST_CHECK(chunk_add_blocks(chunk, coords, colors, 5, colorsCount) == 2);
+    TEST_CHECK(chunk_get_nb_blocks(chunk) == 3);
+    TEST_CHECK(colorsCount[1] == 1 && colorsCount[3] == 1);
+    TEST_CHECK(colorsCount[2] == 0 && colorsCount[4] == 0);
+    TEST_CHECK(chunk_get_block(chunk, 1, 1, 1)->colorIndex == 1);
+    TEST_CHECK(chunk_get_block(chunk, 2, 3, 4)->colorIndex == 7);
+    TEST_CHECK(chunk_get_block(chunk, 15, 0, 9)->colorIndex == 3);
+    TEST_CHECK(chunk_get_block(chunk, 5, 5, 5)->colorIndex == SHAPE_COLOR_INDEX_AIR_BLOCK);
+
+    CHUNK_COORDS_INT3_T min, max;
+    chunk_get_bounding_box_2(chunk, &min, &max);
+    TEST_CHECK(min.x == 1 && min.y == 0 && min.z == 1);
+    TEST_CHECK(max.x == 16 && max.y == 4 && max.z == 10);
+
+    chunk_free(chunk, false);
+}
+
+// setting all blocks at once gives the same chunk as adding them one by one
+// --- chunk_set_blocks()
+// --- chunk_get_blocks()
+/////
+void test_chunk_set_blocks(void) {
+    Block blocks[CHUNK_SIZE_CUBE];
+    memset(blocks, SHAPE_COLOR_INDEX_AIR_BLOCK, sizeof(blocks));
+    Chunk *ref = chunk_new((SHAPE_COORDS_INT3_T){0, 0, 0});
+    for (CHUNK_COORDS_INT_T i = 0; i < CHUNK_SIZE; ++i) {
+        const CHUNK_COORDS_INT_T x = i, y = (CHUNK_COORDS_INT_T)(i * 7 % CHUNK_SIZE), z = 3;
+        blocks[(z * CHUNK_SIZE + y) * CHUNK_SIZE + x].colorIndex = (SHAPE_COLOR_INDEX_INT_T)(i % 4);
+        chunk_add_block(ref, (Block){(SHAPE_COLOR_INDEX_INT_T)(i % 4)}, x, y, z);
+    }
+
+    Chunk *chunk = chunk_new((SHAPE_COORDS_INT3_T){0, 0, 0});
+    chunk_add_block(chunk, (Block){9}, 1, 1, 1); // replaced
+    uint32_t colorsCount[SHAPE_COLOR_INDEX_MAX_COUNT] = {0};
+    TEST_CHECK(chunk_set_blocks(chunk, blocks, colorsCount) == CHUNK_SIZE);
+    TEST_CHECK(chunk_get_nb_blocks(chunk) == CHUNK_SIZE);
+    TEST_CHECK(colorsCount[0] == CHUNK_SIZE / 4 && colorsCount[9] == 0);
+    TEST_CHECK(chunk_get_block(chunk, 1, 7, 3)->colorIndex == 1);
+    TEST_CHECK(chunk_get_blocks(chunk)[(3 * CHUNK_SIZE + 7) * CHUNK_SIZE + 1].colorIndex == 1);
+
+    const Octree *o1 = chunk_get_octree(ref), *o2 = chunk_get_octree(chunk);
+    TEST_CHECK(memcmp(octree_get_nodes(o1), octree_get_nodes(o2), octree_get_nodes_size(o1)) == 0);
+    CHUNK_COORDS_INT3_T min1, max1, min2, max2;
+    chunk_get_bounding_box_2(ref, &min1, &max1);
+    chunk_get_bounding_box_2(chunk, &min2, &max2);
+    TEST_CHECK(min1.x == min2.x && min1.y == min2.y && min1.z == min2.z);
+    TEST_CHECK(max1.x == max2.x && max1.y == max2.y && max1.z == max2.z);
+
+    chunk_free(ref, false);
+    chunk_free(chunk, false);
+}
+
+// copies share blocks & lighting until modified, then only the modified chunk gets its own
+// --- chunk_new_copy()
+/////
+void test_chunk_new_copy(void) {
+    Chunk *chunk = chunk_new((SHAPE_COORDS_INT3_T){0, 0, 0});
+    chunk_add_block(chunk, (Block){1}, 1, 2, 3);
+    VERTEX_LIGHT_STRUCT_T light = {0};
+    light.red = 5;
+    chunk_set_light(chunk, (CHUNK_COORDS_INT3_T){4, 4, 4}, light, true);
+
+    Chunk *copy1 = chunk_new_copy(chunk);
+    Chunk *copy2 = chunk_new_copy(chunk);
+    TEST_CHECK(chunk_get_octree(copy1) == chunk_get_octree(chunk));
+    TEST_CHECK(chunk_get_lighting_data(copy2) == chunk_get_lighting_data(chunk));
+    TEST_CHECK(chunk_get_nb_blocks(copy1) == 1);
+
+    // no-op modifications keep data shared
+    TEST_CHECK(chunk_add_block(copy1, (Block){2}, 1, 2, 3) == false);
+    TEST_CHECK(chunk_remove_block(copy1, 0, 0, 0, NULL) == false);
+    TEST_CHECK(chunk_get_octree(copy1) == chunk_get_octree(chunk));
+
+    TEST_CHECK(chunk_paint_block(copy1, 1, 2, 3, 6, NULL));
+    TEST_CHECK(chunk_get_octree(copy1) != chunk_get_octree(chunk));
+    TEST_CHECK(chunk_get_block(copy1, 1, 2, 3)->colorIndex == 6);
+    TEST_CHECK(chunk_get_block(chunk, 1, 2, 3)->colorIndex == 1);
+    TEST_CHECK(chunk_get_block(copy2, 1, 2, 3)->colorIndex == 1);
+
+    light.red = 9;
+    chunk_set_light(copy2, (CHUNK_COORDS_INT3_T){4, 4, 4}, light, true);
+    TEST_CHECK(chunk_get_light_without_checking(copy2, (CHUNK_COORDS_INT3_T){4, 4, 4}).red == 9);
+    TEST_CHECK(chunk_get_light_without_checking(chunk, (CHUNK_COORDS_INT3_T){4, 4, 4}).red == 5);
+
+    // original can be freed before its copies
+    chunk_free(chunk, false);
+    TEST_CHECK(chunk_get_light_without_checking(copy1, (CHUNK_COORDS_INT3_T){4, 4, 4}).red == 5);
+    TEST_CHECK(chunk_remove_block(copy2, 1, 2, 3, NULL));
+    TEST_CHECK(chunk_get_block(copy1, 1, 2, 3)->colorIndex == 6);
+
+    chunk_free(copy1, false);
+    chunk_free(copy2, false);
+}
+
+// solid rows follow block additions & removals, and are used to find blocks within a range
+// --- chunk_get_solid_row()
+// --- chunk_get_first_solid_block_in_range()
+/////
+void test_chunk_solid_rows(void) {
+    Chunk *chunk = chunk_new((SHAPE_COORDS_INT3_T){0, 0, 0});
+    const CHUNK_COORDS_INT3_T zero = {0, 0, 0};
+    const CHUNK_COORDS_INT3_T all = {CHUNK_SIZE_MINUS_ONE,
+                                     CHUNK_SIZE_MINUS_ONE,
+                                     CHUNK_SIZE_MINUS_ONE};
+    CHUNK_COORDS_INT3_T coords;
+    TEST_CHECK(chunk_get_first_solid_block_in_range(chunk, zero, all, NULL) == false);
+
+    chunk_add_block(chunk, (Block){1}, 3, 4, 5);
+    chunk_add_block(chunk, (Block){1}, 15, 4, 5);
+    const uint16_t coordsIndex = 7 * CHUNK_SIZE_SQR + 2 * CHUNK_SIZE + 9;
+    const SHAPE_COLOR_INDEX_INT_T color = 2;
+    chunk_add_blocks(chunk, &coordsIndex, &color, 1, NULL);
+    TEST_CHECK(chunk_get_solid_row(chunk, 4, 5) == ((1 << 3) | (1 << 15)));
+    TEST_CHECK(chunk_get_solid_row(chunk, 2, 9) == (1 << 7));
+
+    const CHUNK_COORDS_INT3_T min = {4, 0, 0};
+    TEST_CHECK(chunk_get_first_solid_block_in_range(chunk, min, all, &coords));
+    TEST_CHECK(coords.x == 15 && coords.y == 4 && coords.z == 5);
+    const CHUNK_COORDS_INT3_T max = {14, CHUNK_SIZE_MINUS_ONE, 8};
+    TEST_CHECK(chunk_get_first_solid_block_in_range(chunk, min, max, NULL) == false);
+
+    Chunk *copy = chunk_new_copy(chunk);
+    chunk_remove_block(chunk, 15, 4, 5, NULL);
+    TEST_CHECK(chunk_get_solid_row(chunk, 4, 5) == (1 << 3));
+    TEST_CHECK(chunk_get_solid_row(copy, 4, 5) == ((1 << 3) | (1 << 15)));
+
+    Block blocks[CHUNK_SIZE_CUBE];
+    memset(blocks, SHAPE_COLOR_INDEX_AIR_BLOCK, sizeof(blocks));
+    blocks[(1 * CHUNK_SIZE + 2) * CHUNK_SIZE + 0].colorIndex = 1;
+    chunk_set_blocks(chunk, blocks, NULL);
+    TEST_CHECK(chunk_get_solid_row(chunk, 4, 5) == 0);
+    TEST_CHECK(chunk_get_solid_row(chunk, 2, 1) == 1);
+
+    chunk_free(chunk, false);
+    chunk_free(copy, false);
+}
+
+// cells keep thin walls and take their most used color, lowest index on ties
+void test_chunk_downsample(void) {
+    Chunk *chunk = chunk_new((SHAPE_COORDS_INT3_T){0, 0, 0});
+    for (CHUNK_COORDS_INT_T y = 0; y < CHUNK_SIZE; ++y) {
+        for (CHUNK_COORDS_INT_T z = 0; z < CHUNK_SIZE; ++z) {
+            chunk_add_block(chunk, (Block){1}, 0, y, z);
+        }
+    }
+    chunk_add_block(chunk, (Block){2}, 12, 12, 12);
+    chunk_add_block(chunk, (Block){2}, 13, 12, 12);
+    chunk_add_block(chunk, (Block){2}, 14, 12, 12);
+    chunk_add_block(chunk, (Block){3}, 15, 15, 15);
+    chunk_add_block(chunk, (Block){3}, 15, 14, 15);
+    chunk_add_block(chunk, (Block){5}, 8, 8, 8);
+    chunk_add_block(chunk, (Block){4}, 11, 11, 11);
+
+    // level 2: 4x4x4 cells of 4x4x4 blocks
+    SHAPE_COLOR_INDEX_INT_T cells[64];
+    TEST_CHECK(chunk_downsample(chunk, 2, cells) == 18);
+    TEST_CHECK(cells[(0 * 4 + 1) * 4 + 3] == 1);
+    TEST_CHECK(cells[(1 * 4 + 1) * 4 + 3] == SHAPE_COLOR_INDEX_AIR_BLOCK);
+    TEST_CHECK(cells[(3 * 4 + 3) * 4 + 3] == 2);
+    TEST_CHECK(cells[(2 * 4 + 2) * 4 + 2] == 4);
+
+    // level 4: whole chunk in one cell
+    TEST_CHECK(chunk_downsample(chunk, 4, cells) == 1);
+    TEST_CHECK(cells[0] == 1);
+
+    chunk_free(chunk, false);
+}
+
 // Create a chunk and set differents values on the "display bool" of this chunk.
 // Then check if the bool is set with the good values
 void test_chunk_needs_display(void) {
@@ -0,0 +1,94 @@
+// -------------------------------------------------------------
+//  Cubzh Core Unit Tests
+//  test_color_atlas.h
+//  Created by agent on October 19, 2026.
+// -------------------------------------------------------------
+
+#pragma once
+
+#include "color_atlas.h"
+
+// removed indices are reused before growing, arrays grow past initial capacity
+void test_color_atlas_check_and_add_color(void) {
+    ColorAtlas *a = color_atlas_new();
+    TEST_ASSERT(a != NULL);
+    TEST_CHECK(a->capacity == COLOR_ATLAS_INITIAL_CAPACITY);
+
+    const RGBAColor red = {255, 0, 0, 255};
+    for (uint32_t i = 0; i < COLOR_ATLAS_INITIAL_CAPACITY + 1; ++i) {
+        TEST_CHECK(color_atlas_check_and_add_color(a, red) == i);
+    }
+    TEST_CHECK(a->count == COLOR_ATLAS_INITIAL_CAPACITY + 1);
+    TEST_CHECK(a->capacity == COLOR_ATLAS_INITIAL_CAPACITY * 2);
+    TEST_CHECK(color_atlas_get_color(a, COLOR_ATLAS_INITIAL_CAPACITY)->r == 255);
+    TEST_CHECK(color_atlas_get_color(a, COLOR_ATLAS_INITIAL_CAPACITY + 1) == NULL);
+
+    color_atlas_remove_color(a, 3);
+    color_atlas_remove_color(a, 7);
+    // removing twice doesn't make an index available twice
+    color_atlas_remove_color(a, 7);
+    TEST_CHECK(a->nbAvailableIndices == 2);
+    const RGBAColor blue = {0, 0, 255, 255};
+    TEST_CHECK(color_atlas_check_and_add_color(a, blue) == 7);
+    TEST_CHECK(color_atlas_check_and_add_color(a, blue) == 3);
+    TEST_CHECK(color_atlas_check_and_add_color(a, blue) == COLOR_ATLAS_INITIAL_CAPACITY + 1);
+    TEST_CHECK(color_atlas_get_color(a, 3)->b == 255);
+
+    // reused indices can be removed again
+    color_atlas_remove_color(a, 7);
+    TEST_CHECK(a->nbAvailableIndices == 1);
+
+    color_atlas_free(a);
+}
+
+// distant changes are kept in separate slices, closest slices merged when running out
+void test_color_atlas_dirty_slices(void) {
+    ColorAtlas *a = color_atlas_new();
+    TEST_ASSERT(a != NULL);
+
+    const RGBAColor red = {255, 0, 0, 255};
+    for (uint32_t i = 0; i < 1000; ++i) {
+        color_atlas_check_and_add_color(a, red);
+    }
+    TEST_CHECK(a->nbDirtySlices == 1);
+    TEST_CHECK(a->dirty_slice_min == 0 && a->dirty_slice_max == 999);
+
+    color_atlas_flush_slice(a);
+    TEST_CHECK(a->nbDirtySlices == 0);
+    TEST_CHECK(a->dirty_slice_min == ATLAS_COLOR_INDEX_ERROR);
+
+    const RGBAColor blue = {0, 0, 255, 255};
+    color_atlas_set_color(a, 500, blue);
+    color_atlas_set_color(a, 10, blue);
+    color_atlas_set_color(a, 11, blue);
+    color_atlas_set_color(a, 12, red); // unchanged, not dirty
+    TEST_CHECK(a->nbDirtySlices == 2);
+    TEST_CHECK(a->dirtySlices[0].min == 10 && a->dirtySlices[0].max == 11);
+    TEST_CHECK(a->dirtySlices[1].min == 500 && a->dirtySlices[1].max == 500);
+
+    // filling the gap joins both slices
+    for (uint32_t i = 12; i < 500; ++i) {
+        color_atlas_set_color(a, i, blue);
+    }
+    TEST_CHECK(a->nbDirtySlices == 1);
+    TEST_CHECK(a->dirtySlices[0].min == 10 && a->dirtySlices[0].max == 500);
+    color_atlas_flush_slice(a);
+
+    // one more slice than tracked: 2 closest ones are merged
+    const RGBAColor green = {0, 255, 0, 255};
+    for (uint32_t i = 0; i < COLOR_ATLAS_MAX_DIRTY_SLICES; ++i) {
+        color_atlas_set_color(a, i * 100, green);
+    }
+    color_atlas_set_color(a, 950, green);
+    TEST_CHECK(a->nbDirtySlices == COLOR_ATLAS_MAX_DIRTY_SLICES);
+    TEST_CHECK(a->dirty_slice_min == 0 && a->dirty_slice_max == 950);
+    for (uint8_t i = 0; i + 1 < a->nbDirtySlices; ++i) {
+        TEST_CHECK(a->dirtySlices[i].max + 1 < a->dirtySlices[i + 1].min);
+    }
+
+    color_atlas_force_dirty_slice(a);
+    TEST_CHECK(a->nbDirtySlices == 1);
+    TEST_CHECK(a->dirtySlices[0].min == 0 && a->dirtySlices[0].max == 999);
+
+    color_atlas_free(a);
+}
@@ -579,3 +579,51 @@ void test_doubly_linked_list_sort_ascending(void) {
 
     doubly_linked_list_free(list);
 }
+
+// Insert and delete more nodes than kept for reuse by the list, checking that recycled nodes are
+// properly relinked.
+void test_doubly_linked_list_recycle_nodes(void) {
+    DoublyLinkedList *list = doubly_linked_list_new();
+    int values[40];
+
+    for (int round = 0; round < 3; ++round) {
+        for (int i = 0; i < 40; ++i) {
+            doubly_linked_list_push_last(list, &values[i]);
+        }
+        // delete even values
+        DoublyLinkedListNode *n = doubly_linked_list_first(list);
+        while (n != NULL) {
+            const int i = (int)((int *)doubly_linked_list_node_pointer(n) - values);
+            if (i % 2 == 0) {
+                n = doubly_linked_list_delete_node(list, n);
+            } else {
+                n = doubly_linked_list_node_next(n);
+            }
+        }
+        TEST_CHECK(doubly_linked_list_node_count(list) == 20);
+
+        // insert them back before their odd neighbour
+        n = doubly_linked_list_first(list);
+        while (n != NULL) {
+            const int i = (int)((int *)doubly_linked_list_node_pointer(n) - values);
+            doubly_linked_list_insert_node_previous(list, n, &values[i - 1]);
+            n = doubly_linked_list_node_next(n);
+        }
+        TEST_CHECK(doubly_linked_list_node_count(list) == 40);
+
+        n = doubly_linked_list_first(list);
+        for (int i = 0; i < 40; ++i) {
+            TEST_CHECK(doubly_linked_list_node_pointer(n) == &values[i]);
+            TEST_CHECK(doubly_linked_list_node_previous(n) ==
+                       (i == 0 ? NULL : doubly_linked_list_node_at_index(list, (size_t)(i - 1))));
+            n = doubly_linked_list_node_next(n);
+        }
+        TEST_CHECK(n == NULL);
+        TEST_CHECK(doubly_linked_list_last(list) == doubly_linked_list_node_at_index(list, 39));
+
+        doubly_linked_list_flush(list, NULL);
+        TEST_CHECK(doubly_linked_list_is_empty(list));
+    }
+
+    doubly_linked_list_free(list);
+}
@@ -147,3 +147,39 @@ void test_fifo_list_new_copy(void) {
     fifo_list_free(listCopy, NULL);
     fifo_list_free(list, NULL);
 }
+
+// Push and pop more values than nodes kept for reuse, several times and w/ different limits,
+// checking that recycled nodes keep the order of values.
+void test_fifo_list_recycle_nodes(void) {
+    FifoList *list = fifo_list_new();
+    int values[100];
+
+    for (int round = 0; round < 4; ++round) {
+        if (round == 1) {
+            fifo_list_set_recycled_max(list, 1000);
+        } else if (round == 3) {
+            // trims nodes kept by previous round
+            fifo_list_set_recycled_max(list, 0);
+        }
+        for (int i = 0; i < 100; ++i) {
+            fifo_list_push(list, &values[i]);
+        }
+        TEST_CHECK(fifo_list_get_size(list) == 100);
+        for (int i = 0; i < 50; ++i) {
+            TEST_CHECK(fifo_list_pop(list) == &values[i]);
+        }
+        for (int i = 0; i < 50; ++i) {
+            fifo_list_push(list, &values[i]);
+        }
+        for (int i = 50; i < 100; ++i) {
+            TEST_CHECK(fifo_list_pop(list) == &values[i]);
+        }
+        for (int i = 0; i < 50; ++i) {
+            TEST_CHECK(fifo_list_pop(list) == &values[i]);
+        }
+        TEST_CHECK(fifo_list_pop(list) == NULL);
+        TEST_CHECK(fifo_list_get_size(list) == 0);
+    }
+
+    fifo_list_free(list, NULL);
+}
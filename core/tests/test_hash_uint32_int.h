@@ -50,3 +50,69 @@ void test_hash_uint32_int(void) {
 
     hash_uint32_int_free(h);
 }
+
+// enough keys to grow several times, deleting some of them in between
+void test_hash_uint32_int_many(void) {
+    HashUInt32Int *h = hash_uint32_int_new();
+    int v = 0;
+
+    for (uint32_t i = 0; i < 5000; ++i) {
+        hash_uint32_int_set(h, i * 2654435761u, (int)i);
+    }
+    for (uint32_t i = 0; i < 5000; i += 3) {
+        hash_uint32_int_delete(h, i * 2654435761u);
+    }
+    for (uint32_t i = 0; i < 5000; ++i) {
+        const bool found = hash_uint32_int_get(h, i * 2654435761u, &v);
+        if (i % 3 == 0) {
+            TEST_CHECK(found == false);
+        } else {
+            TEST_CHECK(found && v == (int)i);
+        }
+    }
+
+    // RGBA colors only differing by alpha
+    hash_uint32_int_set(h, 0xFF0000FF, 1);
+    hash_uint32_int_set(h, 0xFF000080, 2);
+    TEST_CHECK(hash_uint32_int_get(h, 0xFF0000FF, &v) && v == 1);
+    TEST_CHECK(hash_uint32_int_get(h, 0xFF000080, &v) && v == 2);
+
+    hash_uint32_int_free(h);
+}
+
+// keys hashing to the same slot at any reasonable capacity, the ones beyond the maximum probe
+// distance are rejected w/o affecting other keys
+void test_hash_uint32_int_colliding(void) {
+    HashUInt32Int *h = hash_uint32_int_new();
+    int v = 0;
+
+    // multiplied by the hashing constant, those keys only differ by their lower bits
+    const uint32_t inverse = 0x144cbc89u;
+    for (uint32_t i = 0; i < 260; ++i) {
+        hash_uint32_int_set(h, i * inverse, (int)i);
+    }
+    for (uint32_t i = 0; i < 260; ++i) {
+        const bool found = hash_uint32_int_get(h, i * inverse, &v);
+        if (i < 255) {
+            TEST_CHECK(found && v == (int)i);
+        } else {
+            TEST_CHECK(found == false);
+        }
+    }
+
+    // other keys are unaffected
+    for (uint32_t i = 1; i <= 100; ++i) {
+        hash_uint32_int_set(h, i, (int)i);
+    }
+    for (uint32_t i = 1; i <= 100; ++i) {
+        TEST_CHECK(hash_uint32_int_get(h, i, &v) && v == (int)i);
+    }
+
+    // deleting colliding keys makes room for the rejected ones
+    hash_uint32_int_delete(h, 0);
+    hash_uint32_int_set(h, 255 * inverse, 255);
+    TEST_CHECK(hash_uint32_int_get(h, 255 * inverse, &v) && v == 255);
+    TEST_CHECK(hash_uint32_int_get(h, 254 * inverse, &v) && v == 254);
+
+    hash_uint32_int_free(h);
+}
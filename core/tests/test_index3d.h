@@ -0,0 +1,181 @@
+// -------------------------------------------------------------
+//  Cubzh Core Unit Tests
+//  test_index3d.h
+//  Created by agent on October 19, 2026.
+// -------------------------------------------------------------
+
+#pragma once
+
+#include "index3d.h"
+
+// check insertion, removal and iteration (insertion order, skipping removed entries)
+void test_index3d_insert_remove_iterate(void) {
+    Index3D *index = index3d_new();
+    int values[300];
+    Index3DIterator *it;
+    int i, n;
+
+    TEST_CHECK(index3d_is_empty(index));
+
+    for (i = 0; i < 300; ++i) {
+        values[i] = i;
+        index3d_insert(index, &values[i], i - 150, (i % 7) - 3, -i, NULL);
+    }
+    TEST_CHECK(index3d_is_empty(index) == false);
+    for (i = 0; i < 300; ++i) {
+        TEST_CHECK(index3d_get(index, i - 150, (i % 7) - 3, -i) == &values[i]);
+    }
+    TEST_CHECK(index3d_get(index, 0, 0, 1) == NULL);
+
+    // remove odd entries
+    for (i = 1; i < 300; i += 2) {
+        TEST_CHECK(index3d_remove(index, i - 150, (i % 7) - 3, -i, NULL) == &values[i]);
+    }
+    TEST_CHECK(index3d_remove(index, 1 - 150, 1 - 3, -1, NULL) == NULL);
+
+    it = index3d_iterator_new(index);
+    n = 0;
+    while (index3d_iterator_pointer(it) != NULL) {
+        TEST_CHECK(*(int *)index3d_iterator_pointer(it) == n * 2);
+        ++n;
+        TEST_CHECK(index3d_iterator_is_at_end(it) == (n == 150));
+        index3d_iterator_next(it);
+    }
+    TEST_CHECK(n == 150);
+
+    // entries inserted while iterating are visited
+    index3d_insert(index, &values[1], 1000, 1000, 1000, it);
+    TEST_CHECK(index3d_iterator_pointer(it) == &values[1]);
+    index3d_iterator_free(it);
+
+    // replacing an entry keeps its position
+    index3d_insert(index, &values[3], -150, -3, 0, NULL);
+    it = index3d_iterator_new(index);
+    TEST_CHECK(index3d_iterator_pointer(it) == &values[3]);
+    index3d_iterator_free(it);
+
+    // removing the current entry doesn't skip the next one
+    it = index3d_iterator_new(index);
+    index3d_remove(index, -150, -3, 0, it);
+    TEST_CHECK(index3d_iterator_pointer(it) == NULL);
+    index3d_iterator_next(it);
+    TEST_CHECK(index3d_iterator_pointer(it) == &values[2]);
+    index3d_iterator_free(it);
+
+    // inserting NULL removes
+    TEST_CHECK(index3d_count(index) == 150);
+    index3d_insert(index, NULL, 1000, 1000, 1000, NULL);
+    TEST_CHECK(index3d_get(index, 1000, 1000, 1000) == NULL);
+    TEST_CHECK(index3d_count(index) == 149);
+
+    // reinserting after removals reuses space
+    for (i = 1; i < 300; i += 2) {
+        index3d_insert(index, &values[i], i - 150, (i % 7) - 3, -i, NULL);
+    }
+    for (i = 1; i < 300; ++i) {
+        TEST_CHECK(index3d_get(index, i - 150, (i % 7) - 3, -i) == &values[i]);
+    }
+
+    index3d_flush(index, NULL);
+    TEST_CHECK(index3d_is_empty(index));
+    TEST_CHECK(index3d_get(index, 0, 0, 0) == NULL);
+    index3d_free(index);
+}
+
+// check all 27 neighbors are returned at expected offsets
+void test_index3d_get_neighborhood(void) {
+    Index3D *index = index3d_new();
+    int values[27];
+    void *out[INDEX3D_NEIGHBORHOOD_SIZE];
+
+    for (int dx = -1; dx <= 1; ++dx) {
+        for (int dy = -1; dy <= 1; ++dy) {
+            for (int dz = -1; dz <= 1; ++dz) {
+                if ((dx + dy + dz) % 2 == 0) {
+                    index3d_insert(index,
+                                   &values[INDEX3D_NEIGHBOR(dx, dy, dz)],
+                                   dx - 1,
+                                   dy,
+                                   dz + 1,
+                                   NULL);
+                }
+            }
+        }
+    }
+    // outside of the neighborhood
+    index3d_insert(index, &values[0], 1, 0, 0, NULL);
+
+    index3d_get_neighborhood(index, -1, 0, 1, out);
+    for (int dx = -1; dx <= 1; ++dx) {
+        for (int dy = -1; dy <= 1; ++dy) {
+            for (int dz = -1; dz <= 1; ++dz) {
+                const int i = INDEX3D_NEIGHBOR(dx, dy, dz);
+                TEST_CHECK(out[i] == ((dx + dy + dz) % 2 == 0 ? &values[i] : NULL));
+            }
+        }
+    }
+
+    index3d_flush(index, NULL);
+    index3d_get_neighborhood(index, -1, 0, 1, out);
+    for (int i = 0; i < INDEX3D_NEIGHBORHOOD_SIZE; ++i) {
+        TEST_CHECK(out[i] == NULL);
+    }
+    index3d_free(index);
+}
+
+// entries amended by removal & insertion while iterators are alive, as transactions do, are
+// compacted w/o losing track of iterators
+void test_index3d_compact_while_iterating(void) {
+    Index3D *index = index3d_new();
+    int values[16];
+    for (int i = 0; i < 16; ++i) {
+        values[i] = i;
+        index3d_insert(index, &values[i], i, 0, 0, NULL);
+    }
+
+    // one iterator at end, one on an entry removed right away
+    Index3DIterator *atEnd = index3d_iterator_new(index);
+    while (index3d_iterator_is_at_end(atEnd) == false) {
+        index3d_iterator_next(atEnd);
+    }
+    index3d_iterator_next(atEnd);
+    TEST_CHECK(index3d_iterator_pointer(atEnd) == NULL);
+    Index3DIterator *removed = index3d_iterator_new(index);
+    index3d_iterator_next(removed);
+    TEST_CHECK(index3d_iterator_pointer(removed) == &values[1]);
+    index3d_remove(index, 1, 0, 0, removed);
+
+    for (int n = 0; n < 1000; ++n) {
+        const int i = n % 16;
+        if (i == 1) {
+            continue;
+        }
+        TEST_CHECK(index3d_remove(index, i, 0, 0, atEnd) == &values[i]);
+        index3d_insert(index, &values[i], i, 0, 0, atEnd);
+    }
+    TEST_CHECK(index3d_count(index) == 15);
+
+    // the iterator at end moved to the first amendment, removed by a later one, then visits the
+    // last amendments in order
+    TEST_CHECK(index3d_iterator_pointer(atEnd) == NULL);
+    index3d_iterator_next(atEnd);
+    const int last[15] = {8, 9, 10, 11, 12, 13, 14, 15, 0, 2, 3, 4, 5, 6, 7};
+    int visited = 0;
+    while (index3d_iterator_pointer(atEnd) != NULL && visited < 15) {
+        TEST_CHECK(index3d_iterator_pointer(atEnd) == &values[last[visited]]);
+        ++visited;
+        index3d_iterator_next(atEnd);
+    }
+    TEST_CHECK(visited == 15);
+
+    // removed current entry is still left by next
+    TEST_CHECK(index3d_iterator_pointer(removed) == NULL);
+    index3d_iterator_next(removed);
+    TEST_CHECK(index3d_iterator_pointer(removed) != NULL);
+    TEST_CHECK(index3d_iterator_pointer(removed) != &values[1]);
+
+    index3d_iterator_free(removed);
+    index3d_iterator_free(atEnd);
+    index3d_flush(index, NULL);
+    index3d_free(index);
+}
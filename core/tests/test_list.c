@@ -16,6 +16,7 @@
 #include "test_blockChange.h"
 #include "test_box.h"
 #include "test_chunk.h"
+#include "test_color_atlas.h"
 #include "test_config.h"
 #include "test_doubly_linked_list.h"
 #include "test_doubly_linked_list_uint8.h"
@@ -29,12 +30,14 @@
 #include "test_float4.h"
 #include "test_flood_fill_lighting.h"
 #include "test_hash_uint32_int.h"
+#include "test_index3d.h"
 #include "test_inputs.h"
 #include "test_int3.h"
 #include "test_map_string_float3.h"
 #include "test_matrix4x4.h"
 #include "test_quaternion.h"
 #include "test_rtree.h"
+#include "test_serialization.h"
 #include "test_shape.h"
 #include "test_stream.h"
 #include "test_transaction.h"
@@ -84,8 +87,17 @@ TEST_LIST = {
     // chunk
     {"test_chunk_new", test_chunk_new},
     {"test_chunk_Block", test_chunk_Block},
+    {"test_chunk_add_blocks", test_chunk_add_blocks},
+    {"test_chunk_set_blocks", test_chunk_set_blocks},
+    {"test_chunk_new_copy", test_chunk_new_copy},
+    {"test_chunk_solid_rows", test_chunk_solid_rows},
+    {"test_chunk_downsample", test_chunk_downsample},
     {"test_chunk_needs_display", test_chunk_needs_display},
 
+    // color_atlas
+    {"color_atlas_check_and_add_color", test_color_atlas_check_and_add_color},
+    {"color_atlas_dirty_slices", test_color_atlas_dirty_slices},
+
     // config
     {"test_upper_power_of_two", test_upper_power_of_two},
 
@@ -131,6 +143,7 @@ TEST_LIST = {
     {"doubly_linked_list_delete_node", test_doubly_linked_list_delete_node},
     {"doubly_linked_list_node_at_index", test_doubly_linked_list_node_at_index},
     {"doubly_linked_list_sort_ascending", test_doubly_linked_list_sort_ascending},
+    {"doubly_linked_list_recycle_nodes", test_doubly_linked_list_recycle_nodes},
 
     // fifo_list
     {"fifo_list_new", test_fifo_list_new},
@@ -139,6 +152,7 @@ TEST_LIST = {
     {"fifo_list_pop", test_fifo_list_pop},
     {"fifo_list_push", test_fifo_list_push},
     {"fifo_list_new_copy", test_fifo_list_new_copy},
+    {"fifo_list_recycle_nodes", test_fifo_list_recycle_nodes},
 
     // filo_list
     {"filo_list_new", test_filo_list_new},
@@ -175,6 +189,13 @@ TEST_LIST = {
 
     // hash_uint32
     {"hash_uint32_int", test_hash_uint32_int},
+    {"hash_uint32_int_many", test_hash_uint32_int_many},
+    {"hash_uint32_int_colliding", test_hash_uint32_int_colliding},
+
+    // index3d
+    {"index3d_insert_remove_iterate", test_index3d_insert_remove_iterate},
+    {"index3d_get_neighborhood", test_index3d_get_neighborhood},
+    {"index3d_compact_while_iterating", test_index3d_compact_while_iterating},
 
     // inputs
     {"isTouchEventID", test_isTouchEventID},
@@ -239,6 +260,7 @@ TEST_LIST = {
     {"map_string_float3_value_for_key", test_map_string_float3_value_for_key},
     {"map_string_mutable_float3_value_for_key", test_map_string_mutable_float3_value_for_key},
     {"map_string_float3_remove_key", test_map_string_float3_remove_key},
+    {"map_string_float3_many_keys", test_map_string_float3_many_keys},
 
     // matrix4x4
     {"matrix4x4_new", test_matrix4x4_new},
@@ -312,6 +334,31 @@ TEST_LIST = {
     {"test_shape_addblock_1", test_shape_addblock_1},
     // {"test_shape_addblock_2", test_shape_addblock_2},
     {"test_shape_addblock_3", test_shape_addblock_3},
+    {"shape_compute_baked_lighting_in_chunks", test_shape_compute_baked_lighting_in_chunks},
+    {"shape_apply_transaction_baked_lighting", test_shape_apply_transaction_baked_lighting},
+    {"shape_fill_clear_box", test_shape_fill_clear_box},
+    {"shape_copy_region", test_shape_copy_region},
+    {"shape_region_runs", test_shape_region_runs},
+    {"shape_shrink_box", test_shape_shrink_box},
+    {"shape_history_byte_budget", test_shape_history_byte_budget},
+    {"shape_compact_vertices", test_shape_compact_vertices},
+    {"shape_fill_gaps_incremental", test_shape_fill_gaps_incremental},
+    {"shape_query_visible_chunks", test_shape_query_visible_chunks},
+    {"shape_get_lod", test_shape_get_lod},
+    {"shape_new_instance", test_shape_new_instance},
+    {"shape_instance_unrendered_model", test_shape_instance_unrendered_model},
+    {"shape_combine", test_shape_combine},
+    {"shape_box_cast_overlap", test_shape_box_cast_overlap},
+    {"shape_blocks_changed_in_box", test_shape_blocks_changed_in_box},
+    {"shape_cached_box_cast", test_shape_cached_box_cast},
+    {"shape_box_cast_long", test_shape_box_cast_long},
+
+    // serialization
+    {"serialization_payload_filters_plain", test_serialization_payload_filters_plain},
+    {"serialization_payload_filters_lit", test_serialization_payload_filters_lit},
+    {"serialization_payload_filters_noisy", test_serialization_payload_filters_noisy},
+    {"serialization_mesh_cache", test_serialization_mesh_cache},
+    {"serialization_baked_file_stale_chunks", test_serialization_baked_file_stale_chunks},
 
     // stream
     {"stream_new_buffer_read", test_stream_new_buffer_read},
@@ -334,6 +381,7 @@ TEST_LIST = {
     {"transaction_removeBlock", test_transaction_removeBlock},
     {"transaction_replaceBlock", test_transaction_replaceBlock},
     {"transaction_getIndex3DIterator", test_transaction_getIndex3DIterator},
+    {"transaction_pack", test_transaction_pack},
 
     // transform
     {"transform_rotation_position", test_transform_rotation_position},
@@ -341,6 +389,7 @@ TEST_LIST = {
     {"transform_children", test_transform_children},
     {"transform_retain", test_transform_retain},
     {"transform_flush", test_transform_flush},
+    {"transform_handle", test_transform_handle},
 
     // utils
     {"test_utils_float_isEqual", test_utils_float_isEqual},
@@ -366,6 +415,7 @@ TEST_LIST = {
     {"vertex_buffer_get_max_count", test_vertex_buffer_get_max_length},
     {"vertex_buffer_set_lighting_enabled", test_vertex_buffer_set_lighting_enabled},
     {"vertex_buffer_get_lighting_enabled", test_vertex_buffer_get_lighting_enabled},
+    {"vertex_buffer_add_draw_slice", test_vertex_buffer_add_draw_slice},
 
     // weakptr
     {"weakptr_new", test_weakptr_new},
@@ -273,3 +273,43 @@ void test_map_string_float3_remove_key(void) {
     map_string_float3_iterator_free(mapIterator);
     map_string_float3_free(map);
 }
+
+// Insert enough keys to grow the map several times, remove some of them and check that remaining
+// keys are still found and iterated from last to first inserted.
+void test_map_string_float3_many_keys(void) {
+    MapStringFloat3 *map = map_string_float3_new();
+    char key[16];
+
+    for (int i = 0; i < 200; ++i) {
+        snprintf(key, sizeof(key), "poi_%d", i);
+        map_string_float3_set_key_value(map, key, float3_new((float)i, 0, 0));
+    }
+    for (int i = 0; i < 200; i += 3) {
+        snprintf(key, sizeof(key), "poi_%d", i);
+        map_string_float3_remove_key(map, key);
+    }
+    for (int i = 0; i < 200; ++i) {
+        snprintf(key, sizeof(key), "poi_%d", i);
+        const float3 *f3 = map_string_float3_value_for_key(map, key);
+        if (i % 3 == 0) {
+            TEST_CHECK(f3 == NULL);
+        } else {
+            TEST_CHECK(f3 != NULL && f3->x == (float)i);
+        }
+    }
+
+    MapStringFloat3Iterator *mapIterator = map_string_float3_iterator_new(map);
+    int expected = 199;
+    while (map_string_float3_iterator_is_done(mapIterator) == false) {
+        if (expected % 3 == 0) {
+            --expected;
+        }
+        TEST_CHECK(map_string_float3_iterator_current_value(mapIterator)->x == (float)expected);
+        --expected;
+        map_string_float3_iterator_next(mapIterator);
+    }
+    TEST_CHECK(expected == 0); // 0 was removed
+
+    map_string_float3_iterator_free(mapIterator);
+    map_string_float3_free(map);
+}
@@ -0,0 +1,348 @@
+// -------------------------------------------------------------
+//  Cubzh Core Unit Tests
+//  test_serialization.h
+//  Created by agent on October 19, 2026.
+// -------------------------------------------------------------
+
+#pragma once
+
+#include "chunk.h"
+#include "color_atlas.h"
+#include "color_palette.h"
+#include "serialization.h"
+#include "serialization_v6.h"
+#include "shape.h"
+#include "stream.h"
+#include "vertextbuffer.h"
+
+// functions that are NOT tested:
+// serialization_save_shape
+// get_preview_data
+
+#define TEST_SERIALIZATION_SIZE 48
+
+static Shape *_test_serialization_load(const void *buffer,
+                                       const uint32_t size,
+                                       ColorAtlas *atlas,
+                                       const bool lighting) {
+    ShapeSettings settings = {.lighting = lighting, .isMutable = false};
+    Stream *s = stream_new_buffer_read((const char *)buffer, size);
+    return serialization_load_shape(s, "", atlas, &settings, false); // frees stream
+}
+
+static uint32_t _test_serialization_version(const void *buffer) {
+    uint32_t version;
+    memcpy(&version, (const uint8_t *)buffer + MAGIC_BYTES_SIZE, sizeof(uint32_t));
+    return version;
+}
+
+/// saves `s` w/ and w/o payload filters, checks that the filtered file is never bigger and that
+/// both are loaded back w/ the same blocks (and baked lighting if `lighting`)
+static void _test_serialization_round_trip(Shape *s, ColorAtlas *atlas, const bool lighting) {
+    void *raw = NULL, *filtered = NULL;
+    uint32_t rawSize = 0, filteredSize = 0;
+
+    serialization_v6_set_payload_filters_enabled(false);
+    TEST_ASSERT(serialization_save_shape_as_buffer(s, NULL, NULL, 0, &raw, &rawSize));
+    serialization_v6_set_payload_filters_enabled(true);
+    TEST_ASSERT(serialization_save_shape_as_buffer(s, NULL, NULL, 0, &filtered, &filteredSize));
+
+    TEST_CHECK(filteredSize <= rawSize);
+    TEST_CHECK(_test_serialization_version(raw) == 6);
+    // newer version only if a filter was kept
+    TEST_CHECK(_test_serialization_version(filtered) == (filteredSize < rawSize ? 7 : 6));
+
+    Shape *loadedRaw = _test_serialization_load(raw, rawSize, atlas, lighting);
+    Shape *loaded = _test_serialization_load(filtered, filteredSize, atlas, lighting);
+    TEST_ASSERT(loadedRaw != NULL && loaded != NULL);
+    TEST_CHECK(shape_get_nb_blocks(loaded) == shape_get_nb_blocks(s));
+    TEST_CHECK(shape_uses_baked_lighting(loaded) == lighting);
+
+    SHAPE_COORDS_INT3_T min, max;
+    shape_get_model_aabb_2(s, &min, &max);
+    bool sameBlocks = true, sameLighting = true;
+    for (SHAPE_COORDS_INT_T x = min.x; x < max.x; ++x) {
+        for (SHAPE_COORDS_INT_T y = min.y; y < max.y; ++y) {
+            for (SHAPE_COORDS_INT_T z = min.z; z < max.z; ++z) {
+                const Block *b = shape_get_block(s, x, y, z);
+                const Block *l = shape_get_block(loaded, x - min.x, y - min.y, z - min.z);
+                const Block *r = shape_get_block(loadedRaw, x - min.x, y - min.y, z - min.z);
+                if (block_is_solid(b) != block_is_solid(l) ||
+                    (block_is_solid(b) && (block_get_color_index(l) != block_get_color_index(r)))) {
+                    sameBlocks = false;
+                }
+                if (lighting) {
+                    const VERTEX_LIGHT_STRUCT_T expected = shape_get_light_or_default(s, x, y, z);
+                    const VERTEX_LIGHT_STRUCT_T light =
+                        shape_get_light_or_default(loaded, x - min.x, y - min.y, z - min.z);
+                    if (memcmp(&expected, &light, sizeof(VERTEX_LIGHT_STRUCT_T)) != 0) {
+                        sameLighting = false;
+                    }
+                }
+            }
+        }
+    }
+    TEST_CHECK(sameBlocks);
+    TEST_CHECK(sameLighting);
+
+    shape_release(loadedRaw);
+    shape_release(loaded);
+    free(raw);
+    free(filtered);
+}
+
+static Shape *_test_serialization_terrain(ColorAtlas *atlas, const bool noisy) {
+    Shape *s = shape_new_2(true);
+    const RGBAColor colors[4] = {{255, 0, 0, 255},
+                                 {0, 255, 0, 255},
+                                 {0, 0, 255, 255},
+                                 {255, 255, 0, 255}};
+    shape_set_palette(s, color_palette_new_from_data(atlas, 4, colors, NULL), false);
+    srand(1);
+    for (SHAPE_COORDS_INT_T x = 0; x < TEST_SERIALIZATION_SIZE; ++x) {
+        for (SHAPE_COORDS_INT_T z = 0; z < TEST_SERIALIZATION_SIZE; ++z) {
+            const SHAPE_COORDS_INT_T h = (SHAPE_COORDS_INT_T)(4 + (x * z) % 9);
+            for (SHAPE_COORDS_INT_T y = 0; y < h; ++y) {
+                if (noisy && rand() % 3 == 0) {
+                    continue;
+                }
+                const SHAPE_COLOR_INDEX_INT_T color = noisy ? (SHAPE_COLOR_INDEX_INT_T)(rand() % 4)
+                                                            : (y == h - 1 ? 1 : 0);
+                shape_add_block(s, color, x, y, z, false);
+            }
+        }
+    }
+    return s;
+}
+
+// blocks only, run-length encoding should be kept
+// --- serialization_save_shape_as_buffer()
+// --- serialization_load_shape()
+/////
+void test_serialization_payload_filters_plain(void) {
+    ColorAtlas *atlas = color_atlas_new();
+    TEST_ASSERT(atlas != NULL);
+    Shape *s = _test_serialization_terrain(atlas, false);
+
+    _test_serialization_round_trip(s, atlas, false);
+
+    shape_release(s);
+    color_atlas_free(atlas);
+}
+
+// blocks & baked lighting
+/////
+void test_serialization_payload_filters_lit(void) {
+    chunk_alloc_default_light();
+    ColorAtlas *atlas = color_atlas_new();
+    TEST_ASSERT(atlas != NULL);
+    Shape *s = _test_serialization_terrain(atlas, false);
+    shape_compute_baked_lighting(s);
+    TEST_ASSERT(shape_uses_baked_lighting(s));
+
+    _test_serialization_round_trip(s, atlas, true);
+
+    shape_release(s);
+    color_atlas_free(atlas);
+}
+
+// random colors & holes, filters not worth it mustn't make the file bigger
+/////
+void test_serialization_payload_filters_noisy(void) {
+    chunk_alloc_default_light();
+    ColorAtlas *atlas = color_atlas_new();
+    TEST_ASSERT(atlas != NULL);
+    Shape *s = _test_serialization_terrain(atlas, true);
+    shape_compute_baked_lighting(s);
+
+    _test_serialization_round_trip(s, atlas, true);
+
+    shape_release(s);
+    color_atlas_free(atlas);
+}
+
+/// reads all vertices of `chunk`, w/ colors converted back from atlas to palette indices
+static VertexAttributes *_test_serialization_chunk_vertices(const Chunk *chunk,
+                                                            const ColorPalette *palette,
+                                                            uint32_t *count) {
+    const uint32_t opaque = chunk_read_vertices(chunk, false, NULL);
+    *count = opaque + chunk_read_vertices(chunk, true, NULL);
+    VertexAttributes *vertices = (VertexAttributes *)malloc((*count + 1) *
+                                                            sizeof(VertexAttributes));
+    chunk_read_vertices(chunk, false, vertices);
+    chunk_read_vertices(chunk, true, vertices + opaque);
+    for (uint32_t i = 0; i < *count; ++i) {
+        for (SHAPE_COLOR_INDEX_INT_T c = 0; c < color_palette_get_count(palette); ++c) {
+            if ((float)color_palette_get_atlas_index(palette, c) == vertices[i].color) {
+                vertices[i].color = (float)c;
+                break;
+            }
+        }
+    }
+    return vertices;
+}
+
+// cached vertices must be the same as freshly meshed ones, changed chunks & their neighbors being
+// left dirty
+// --- serialization_save_mesh_cache_file()
+// --- serialization_load_mesh_cache_file()
+/////
+void test_serialization_mesh_cache(void) {
+    ColorAtlas *atlas = color_atlas_new();
+    TEST_ASSERT(atlas != NULL);
+    Shape *meshed = _test_serialization_terrain(atlas, false);
+    Shape *cached = _test_serialization_terrain(atlas, false);
+    shape_refresh_vertices(meshed);
+
+    FILE *fd = tmpfile();
+    TEST_ASSERT(fd != NULL);
+    TEST_ASSERT(serialization_save_mesh_cache_file(meshed, fd));
+    rewind(fd);
+
+    // one block added above the terrain, in the last chunk along x & z
+    const SHAPE_COORDS_INT_T edge = TEST_SERIALIZATION_SIZE - 1;
+    shape_add_block(cached, 2, edge, 20, edge, false);
+    TEST_ASSERT(serialization_load_mesh_cache_file(cached, fd));
+    fclose(fd);
+
+    const SHAPE_COORDS_INT3_T changed = chunk_utils_get_coords((SHAPE_COORDS_INT3_T){edge,
+                                                                                     20,
+                                                                                     edge});
+    bool same = true, dirtyAsExpected = true;
+    uint32_t nbCached = 0;
+    Index3DIterator *it = index3d_iterator_new(shape_get_chunks(cached));
+    while (index3d_iterator_pointer(it) != NULL) {
+        const Chunk *chunk = (const Chunk *)index3d_iterator_pointer(it);
+        index3d_iterator_next(it);
+
+        const SHAPE_COORDS_INT3_T coords = chunk_utils_get_coords(chunk_get_origin(chunk));
+        const bool nearChange = abs(coords.x - changed.x) <= 1 &&
+                                abs(coords.y - changed.y) <= 1 && abs(coords.z - changed.z) <= 1;
+        if (chunk_is_dirty(chunk) != nearChange) {
+            dirtyAsExpected = false;
+        }
+        if (nearChange) {
+            continue;
+        }
+
+        const Chunk *reference = (const Chunk *)index3d_get(shape_get_chunks(meshed),
+                                                            coords.x,
+                                                            coords.y,
+                                                            coords.z);
+        TEST_ASSERT(reference != NULL);
+        uint32_t count, expectedCount;
+        const ColorPalette *palette = shape_get_palette(cached);
+        const ColorPalette *expectedPalette = shape_get_palette(meshed);
+        VertexAttributes *vertices = _test_serialization_chunk_vertices(chunk, palette, &count);
+        VertexAttributes *expected = _test_serialization_chunk_vertices(reference,
+                                                                        expectedPalette,
+                                                                        &expectedCount);
+        if (count != expectedCount ||
+            memcmp(vertices, expected, count * sizeof(VertexAttributes)) != 0) {
+            same = false;
+        }
+        nbCached += count;
+        free(vertices);
+        free(expected);
+    }
+    index3d_iterator_free(it);
+    TEST_CHECK(nbCached > 0);
+    TEST_CHECK(same);
+    TEST_CHECK(dirtyAsExpected);
+
+    // a mismatched palette discards the whole file
+    fd = tmpfile();
+    TEST_ASSERT(fd != NULL);
+    TEST_ASSERT(serialization_save_mesh_cache_file(meshed, fd));
+    rewind(fd);
+    color_palette_set_emissive(shape_get_palette(cached), 0, true);
+    TEST_CHECK(serialization_load_mesh_cache_file(cached, fd) == false);
+    fclose(fd);
+
+    shape_release(meshed);
+    shape_release(cached);
+    color_atlas_free(atlas);
+
+    // release destroyed vertex buffer ids
+    uint32_t id;
+    while (vertex_buffer_pop_destroyed_id(&id)) {}
+}
+
+#define TEST_SERIALIZATION_BAKED_WIDTH (7 * CHUNK_SIZE)
+
+/// ground along a row of 7 chunks, w/ emissive blocks at given x coordinates (-1 for none)
+static Shape *_test_serialization_baked_shape(ColorAtlas *atlas,
+                                              const SHAPE_COORDS_INT_T emissive1,
+                                              const SHAPE_COORDS_INT_T emissive2) {
+    const RGBAColor colors[2] = {{100, 100, 100, 255}, {255, 128, 0, 255}};
+    const bool emissive[2] = {false, true};
+    Shape *s = shape_new_2(true);
+    shape_set_palette(s, color_palette_new_from_data(atlas, 2, colors, emissive), false);
+    for (SHAPE_COORDS_INT_T x = 0; x < TEST_SERIALIZATION_BAKED_WIDTH; ++x) {
+        for (SHAPE_COORDS_INT_T z = 0; z < CHUNK_SIZE; ++z) {
+            shape_add_block(s, 0, x, 0, z, false);
+        }
+    }
+    if (emissive1 >= 0) {
+        shape_add_block(s, 1, emissive1, 1, CHUNK_SIZE / 2, false);
+    }
+    if (emissive2 >= 0) {
+        shape_add_block(s, 1, emissive2, 1, CHUNK_SIZE / 2, false);
+    }
+    return s;
+}
+
+// chunks changed since the file was baked are re-baked, w/ emission propagating across chunk
+// borders, in areas far enough apart to be re-baked separately
+// --- serialization_save_baked_file()
+// --- serialization_load_baked_file()
+/////
+void test_serialization_baked_file_stale_chunks(void) {
+    chunk_alloc_default_light();
+    ColorAtlas *atlas = color_atlas_new();
+    TEST_ASSERT(atlas != NULL);
+
+    // baked w/ an emissive block at the start of the last chunk
+    const SHAPE_COORDS_INT_T last = TEST_SERIALIZATION_BAKED_WIDTH - CHUNK_SIZE;
+    Shape *baked = _test_serialization_baked_shape(atlas, -1, last);
+    shape_compute_baked_lighting(baked);
+    FILE *fd = tmpfile();
+    TEST_ASSERT(fd != NULL);
+    TEST_ASSERT(serialization_save_baked_file(baked, 1, fd));
+
+    // loaded into a shape where that block moved to the end of the first chunk
+    Shape *loaded = _test_serialization_baked_shape(atlas, CHUNK_SIZE - 1, -1);
+    rewind(fd);
+    TEST_CHECK(serialization_load_baked_file(loaded, 2, fd));
+    fclose(fd);
+    TEST_CHECK(shape_uses_baked_lighting(loaded));
+
+    // must match a full bake, including emission from the first chunk into the second one and
+    // old emission removed from the chunk before the last one
+    Shape *expected = _test_serialization_baked_shape(atlas, CHUNK_SIZE - 1, -1);
+    shape_compute_baked_lighting(expected);
+    const VERTEX_LIGHT_STRUCT_T across = shape_get_light_or_default(expected,
+                                                                    CHUNK_SIZE + 1,
+                                                                    1,
+                                                                    CHUNK_SIZE / 2);
+    TEST_CHECK(across.red > 0);
+
+    bool same = true;
+    for (SHAPE_COORDS_INT_T x = -1; x <= TEST_SERIALIZATION_BAKED_WIDTH; ++x) {
+        for (SHAPE_COORDS_INT_T y = 0; y < 3; ++y) {
+            for (SHAPE_COORDS_INT_T z = -1; z <= CHUNK_SIZE; ++z) {
+                const VERTEX_LIGHT_STRUCT_T l1 = shape_get_light_or_default(expected, x, y, z);
+                const VERTEX_LIGHT_STRUCT_T l2 = shape_get_light_or_default(loaded, x, y, z);
+                if (memcmp(&l1, &l2, sizeof(VERTEX_LIGHT_STRUCT_T)) != 0) {
+                    same = false;
+                }
+            }
+        }
+    }
+    TEST_CHECK(same);
+
+    shape_release(baked);
+    shape_release(loaded);
+    shape_release(expected);
+    color_atlas_free(atlas);
+}
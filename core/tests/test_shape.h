@@ -12,6 +12,7 @@
 #include "scene.h"
 #include "shape.h"
 #include "transform.h"
+#include "vertextbuffer.h"
 
 // functions that are NOT tested:
 // shape_add_buffer
@@ -140,6 +141,29 @@
 // shape_disableAnimations
 // shape_getIgnoreAnimations
 
+/// vertex buffers freed w/ meshed shapes leave their ids in a global queue, which must be emptied
+/// for vertex buffer tests not to depend on previous tests
+static void _test_shape_pop_destroyed_vertex_buffers(void) {
+    uint32_t id;
+    while (vertex_buffer_pop_destroyed_id(&id)) {}
+}
+
+/// creates a shape w/ a palette of given colors in `atlas`, or of the default colors if NULL.
+/// The atlas must be freed after the shapes using it
+static Shape *_test_shape_new(ColorAtlas *atlas,
+                              const bool isMutable,
+                              const RGBAColor *colors,
+                              const uint8_t count) {
+    TEST_ASSERT(atlas != NULL);
+    Shape *s = shape_new_2(isMutable);
+    TEST_ASSERT(s != NULL);
+    ColorPalette *palette = colors != NULL
+                                ? color_palette_new_from_data(atlas, count, colors, NULL)
+                                : color_palette_new(atlas);
+    shape_set_palette(s, palette, false);
+    return s;
+}
+
 // check default values
 void test_shape_make(void) {
     Shape *s = shape_new();
@@ -206,7 +230,7 @@ void test_shape_release(void) {
 // check for coherent id
 void test_shape_get_id(void) {
     const Shape *s = shape_new();
-    const uint16_t id = shape_get_id(s);
+    const uint32_t id = shape_get_id(s);
 
     TEST_CHECK(id < 1000);
 
@@ -551,3 +575,1126 @@ void test_shape_addblock_3(void) {
     shape_free((Shape *const)sh);
     scene_free(sc);
 }
+
+// check that re-baking lighting around edited chunks gives the same result as a full bake
+void test_shape_compute_baked_lighting_in_chunks(void) {
+    ColorAtlas *atlas = color_atlas_new();
+    Shape *full = _test_shape_new(atlas, true, NULL, 0);
+    Shape *partial = _test_shape_new(atlas, true, NULL, 0);
+
+    // ground spanning 3x3 chunks, with a roof over the middle one
+    for (SHAPE_COORDS_INT_T x = 0; x < 3 * CHUNK_SIZE; ++x) {
+        for (SHAPE_COORDS_INT_T z = 0; z < 3 * CHUNK_SIZE; ++z) {
+            shape_add_block(full, 1, x, 0, z, false);
+            shape_add_block(partial, 1, x, 0, z, false);
+        }
+    }
+    for (SHAPE_COORDS_INT_T x = CHUNK_SIZE; x < 2 * CHUNK_SIZE; ++x) {
+        for (SHAPE_COORDS_INT_T z = CHUNK_SIZE; z < 2 * CHUNK_SIZE; ++z) {
+            shape_add_block(full, 1, x, CHUNK_SIZE + 4, z, false);
+            shape_add_block(partial, 1, x, CHUNK_SIZE + 4, z, false);
+        }
+    }
+    shape_compute_baked_lighting(partial);
+
+    // open a hole in the roof without updating lighting, then re-bake only around that chunk
+    shape_toggle_baked_lighting(partial, false);
+    shape_remove_block(full, CHUNK_SIZE + 8, CHUNK_SIZE + 4, CHUNK_SIZE + 8);
+    shape_remove_block(partial, CHUNK_SIZE + 8, CHUNK_SIZE + 4, CHUNK_SIZE + 8);
+    shape_apply_current_transaction(full, true);
+    shape_apply_current_transaction(partial, true);
+    shape_compute_baked_lighting(full);
+    shape_compute_baked_lighting_in_chunks(partial,
+                                           (SHAPE_COORDS_INT3_T){1, 1, 1},
+                                           (SHAPE_COORDS_INT3_T){1, 1, 1});
+
+    int diff = 0;
+    for (SHAPE_COORDS_INT_T x = 0; x < 3 * CHUNK_SIZE; ++x) {
+        for (SHAPE_COORDS_INT_T y = 0; y < 2 * CHUNK_SIZE; ++y) {
+            for (SHAPE_COORDS_INT_T z = 0; z < 3 * CHUNK_SIZE; ++z) {
+                const VERTEX_LIGHT_STRUCT_T l1 = shape_get_light_or_default(full, x, y, z);
+                const VERTEX_LIGHT_STRUCT_T l2 = shape_get_light_or_default(partial, x, y, z);
+                if (l1.ambient != l2.ambient) {
+                    ++diff;
+                }
+            }
+        }
+    }
+    TEST_CHECK(diff == 0);
+
+    shape_free(full);
+    shape_free(partial);
+    color_atlas_free(atlas);
+}
+
+// check that applying a transaction, which batches lighting updates, gives the same lighting as
+// applying each block change on its own
+void test_shape_apply_transaction_baked_lighting(void) {
+    ColorAtlas *atlas = color_atlas_new();
+    Shape *batched = _test_shape_new(atlas, true, NULL, 0);
+    Shape *sequential = _test_shape_new(atlas, true, NULL, 0);
+    color_palette_set_emissive(shape_get_palette(batched), 2, true);
+    color_palette_set_emissive(shape_get_palette(sequential), 2, true);
+
+    // ground w/ a roof over part of it
+    for (SHAPE_COORDS_INT_T x = 0; x < 2 * CHUNK_SIZE; ++x) {
+        for (SHAPE_COORDS_INT_T z = 0; z < 2 * CHUNK_SIZE; ++z) {
+            shape_add_block(batched, 1, x, 0, z, false);
+            shape_add_block(sequential, 1, x, 0, z, false);
+            if (x >= 4 && z >= 4 && x < 2 * CHUNK_SIZE - 4 && z < 2 * CHUNK_SIZE - 4) {
+                shape_add_block(batched, 1, x, 8, z, false);
+                shape_add_block(sequential, 1, x, 8, z, false);
+            }
+        }
+    }
+    shape_compute_baked_lighting(batched);
+    shape_compute_baked_lighting(sequential);
+
+    // open a hole in the roof, add emissive blocks under it and a pillar
+    for (SHAPE_COORDS_INT_T x = 10; x < 14; ++x) {
+        for (SHAPE_COORDS_INT_T z = 10; z < 14; ++z) {
+            shape_remove_block_as_transaction(batched, NULL, x, 8, z);
+            shape_remove_block(sequential, x, 8, z);
+        }
+    }
+    for (SHAPE_COORDS_INT_T y = 1; y < 8; ++y) {
+        shape_add_block_as_transaction(batched, NULL, 1, 20, y, 20);
+        shape_add_block(sequential, 1, 20, y, 20, false);
+    }
+    shape_add_block_as_transaction(batched, NULL, 2, 6, 1, 6);
+    shape_add_block(sequential, 2, 6, 1, 6, false);
+    shape_add_block_as_transaction(batched, NULL, 2, 24, 1, 8);
+    shape_add_block(sequential, 2, 24, 1, 8, false);
+    shape_apply_current_transaction(batched, false);
+
+    int diff = 0;
+    for (SHAPE_COORDS_INT_T x = 0; x < 2 * CHUNK_SIZE; ++x) {
+        for (SHAPE_COORDS_INT_T y = 0; y < 10; ++y) {
+            for (SHAPE_COORDS_INT_T z = 0; z < 2 * CHUNK_SIZE; ++z) {
+                const VERTEX_LIGHT_STRUCT_T l1 = shape_get_light_or_default(batched, x, y, z);
+                const VERTEX_LIGHT_STRUCT_T l2 = shape_get_light_or_default(sequential, x, y, z);
+                if (l1.ambient != l2.ambient || l1.red != l2.red || l1.green != l2.green ||
+                    l1.blue != l2.blue) {
+                    ++diff;
+                }
+            }
+        }
+    }
+    TEST_CHECK(diff == 0);
+
+    shape_free(batched);
+    shape_free(sequential);
+    color_atlas_free(atlas);
+}
+
+// volume operations across chunks, w/ counters, box and a single history entry per operation
+void test_shape_fill_clear_box(void) {
+    const RGBAColor colors[4] = {{255, 0, 0, 255},
+                                 {0, 255, 0, 255},
+                                 {0, 0, 255, 255},
+                                 {9, 9, 9, 255}};
+    ColorAtlas *atlas = color_atlas_new();
+    Shape *s = _test_shape_new(atlas, true, colors, 4);
+    shape_history_setEnabled(s, true);
+    shape_add_block(s, 3, 0, 0, 31, false);
+
+    const SHAPE_COORDS_INT3_T min = {-4, 0, 30}, max = {40, 3, 34};
+    TEST_CHECK(shape_fill_box(s, NULL, min, max, 1) == 44 * 3 * 4);
+    TEST_CHECK(shape_get_nb_blocks(s) == 44 * 3 * 4);
+    TEST_CHECK(block_get_color_index(shape_get_block(s, 0, 0, 31)) == 1);
+    TEST_CHECK(color_palette_get_color_use_count(shape_get_palette(s), 1) == 44 * 3 * 4);
+    TEST_CHECK(color_palette_get_color_use_count(shape_get_palette(s), 3) == 0);
+
+    SHAPE_COORDS_INT3_T bbMin, bbMax;
+    shape_get_model_aabb_2(s, &bbMin, &bbMax);
+    TEST_CHECK(bbMin.x == -4 && bbMin.y == 0 && bbMin.z == 30);
+    TEST_CHECK(bbMax.x == 40 && bbMax.y == 3 && bbMax.z == 34);
+
+    // filling again w/ the same color changes nothing
+    TEST_CHECK(shape_fill_box(s, NULL, min, max, 1) == 0);
+
+    const SHAPE_COORDS_INT3_T clearMin = {-10, -10, 0}, clearMax = {10, 10, 32};
+    TEST_CHECK(shape_clear_box(s, NULL, clearMin, clearMax) == 14 * 3 * 2);
+    TEST_CHECK(shape_get_nb_blocks(s) == 44 * 3 * 4 - 14 * 3 * 2);
+    TEST_CHECK(block_is_solid(shape_get_block(s, 0, 0, 31)) == false);
+    shape_get_model_aabb_2(s, &bbMin, &bbMax);
+    TEST_CHECK(bbMin.x == -4 && bbMin.z == 30);
+
+    // one undo per operation
+    shape_history_undo(s);
+    TEST_CHECK(shape_get_nb_blocks(s) == 44 * 3 * 4);
+    shape_history_undo(s);
+    TEST_CHECK(shape_get_nb_blocks(s) == 1);
+    TEST_CHECK(block_get_color_index(shape_get_block(s, 0, 0, 31)) == 3);
+    TEST_CHECK(color_palette_get_color_use_count(shape_get_palette(s), 1) == 0);
+    shape_history_redo(s);
+    TEST_CHECK(shape_get_nb_blocks(s) == 44 * 3 * 4);
+    TEST_CHECK(block_get_color_index(shape_get_block(s, 0, 0, 31)) == 1);
+
+    shape_free(s);
+    color_atlas_free(atlas);
+}
+
+// copies between palettes, w/ and w/o remap, and within the same shape w/ overlap
+void test_shape_copy_region(void) {
+    const RGBAColor colors[7] = {{0, 0, 0, 255},
+                                 {1, 1, 1, 255},
+                                 {2, 2, 2, 255},
+                                 {3, 3, 3, 255},
+                                 {4, 4, 4, 255},
+                                 {5, 5, 5, 255},
+                                 {6, 6, 6, 255}};
+    ColorAtlas *atlas = color_atlas_new();
+    Shape *src = _test_shape_new(atlas, true, colors, 7);
+    Shape *dst = _test_shape_new(atlas, true, colors, 1);
+
+    for (SHAPE_COORDS_INT_T x = 0; x < 4; ++x) {
+        shape_add_block(src, (SHAPE_COLOR_INDEX_INT_T)(x % 2 + 5), x, 0, 0, false);
+    }
+
+    // palette lookup, air leaves destination blocks unchanged
+    shape_add_block(dst, 0, 100, 1, 0, false);
+    TEST_CHECK(shape_copy_region(dst, NULL, src, (SHAPE_COORDS_INT3_T){0, 0, 0},
+                                 (SHAPE_COORDS_INT3_T){4, 2, 1},
+                                 (SHAPE_COORDS_INT3_T){100, 0, 0}, NULL) == 4);
+    TEST_CHECK(shape_get_nb_blocks(dst) == 5);
+    const RGBAColor c5 = color_palette_get_color(shape_get_palette(src), 5);
+    const SHAPE_COLOR_INDEX_INT_T copied = block_get_color_index(shape_get_block(dst, 100, 0, 0));
+    const RGBAColor c6 = color_palette_get_color(shape_get_palette(dst), copied);
+    TEST_CHECK(c5.r == c6.r && c5.g == c6.g && c5.b == c6.b && c5.a == c6.a);
+    TEST_CHECK(block_is_solid(shape_get_block(dst, 100, 1, 0)));
+
+    // explicit remap
+    SHAPE_COLOR_INDEX_INT_T remap[SHAPE_COLOR_INDEX_MAX_COUNT] = {0};
+    remap[5] = 0;
+    remap[6] = SHAPE_COLOR_INDEX_AIR_BLOCK;
+    TEST_CHECK(shape_copy_region(dst, NULL, src, (SHAPE_COORDS_INT3_T){0, 0, 0},
+                                 (SHAPE_COORDS_INT3_T){4, 1, 1},
+                                 (SHAPE_COORDS_INT3_T){-2, 5, 5}, remap) == 2);
+    TEST_CHECK(block_get_color_index(shape_get_block(dst, -2, 5, 5)) == 0);
+    TEST_CHECK(block_is_solid(shape_get_block(dst, -1, 5, 5)) == false);
+
+    // overlapping copy within the same shape shifts the row by one
+    TEST_CHECK(shape_copy_region(src, NULL, src, (SHAPE_COORDS_INT3_T){0, 0, 0},
+                                 (SHAPE_COORDS_INT3_T){4, 1, 1},
+                                 (SHAPE_COORDS_INT3_T){1, 0, 0}, NULL) == 4);
+    for (SHAPE_COORDS_INT_T x = 1; x < 5; ++x) {
+        TEST_CHECK(block_get_color_index(shape_get_block(src, x, 0, 0)) == (x - 1) % 2 + 5);
+    }
+
+    shape_free(src);
+    shape_free(dst);
+    color_atlas_free(atlas);
+}
+
+// regions bigger than TRANSACTION_REGION_DENSE_MAX_VOLUME store colors as runs, undo & redo must
+// restore the exact same blocks
+void test_shape_region_runs(void) {
+    const RGBAColor colors[3] = {{255, 0, 0, 255}, {0, 255, 0, 255}, {0, 0, 255, 255}};
+    ColorAtlas *atlas = color_atlas_new();
+    Shape *s = _test_shape_new(atlas, true, colors, 3);
+    shape_history_setEnabled(s, true);
+
+    // scattered blocks, some of them in the filled box
+    const SHAPE_COORDS_INT3_T min = {0, 0, 0}, max = {64, 4, 64};
+    SHAPE_COORDS_INT3_T coords[40];
+    uint32_t inside = 0;
+    for (int i = 0; i < 40; ++i) {
+        coords[i] = (SHAPE_COORDS_INT3_T){(SHAPE_COORDS_INT_T)(i * 3 - 10),
+                                          (SHAPE_COORDS_INT_T)(i % 7),
+                                          (SHAPE_COORDS_INT_T)(i * 5 % 70)};
+        shape_add_block(s,
+                        (SHAPE_COLOR_INDEX_INT_T)(i % 2),
+                        coords[i].x,
+                        coords[i].y,
+                        coords[i].z,
+                        false);
+        if (coords[i].x >= min.x && coords[i].x < max.x && coords[i].y < max.y &&
+            coords[i].z < max.z) {
+            ++inside;
+        }
+    }
+    const size_t nbBlocks = shape_get_nb_blocks(s);
+    const size_t volume = 64 * 4 * 64;
+    TEST_ASSERT(volume > TRANSACTION_REGION_DENSE_MAX_VOLUME);
+
+    TEST_CHECK(shape_fill_box(s, NULL, min, max, 2) == volume);
+    TEST_CHECK(shape_get_nb_blocks(s) == nbBlocks - inside + volume);
+
+    shape_history_undo(s);
+    TEST_CHECK(shape_get_nb_blocks(s) == nbBlocks);
+    bool same = true;
+    for (int i = 0; i < 40; ++i) {
+        const Block *b = shape_get_block(s, coords[i].x, coords[i].y, coords[i].z);
+        if (block_get_color_index(b) != i % 2) {
+            same = false;
+        }
+    }
+    TEST_CHECK(same);
+    TEST_CHECK(color_palette_get_color_use_count(shape_get_palette(s), 2) == 0);
+
+    shape_history_redo(s);
+    TEST_CHECK(shape_get_nb_blocks(s) == nbBlocks - inside + volume);
+
+    // copying a big, mostly empty region only lists its solid blocks
+    shape_history_undo(s);
+    TEST_CHECK(shape_copy_region(s, NULL, s, (SHAPE_COORDS_INT3_T){-10, 0, 0},
+                                 (SHAPE_COORDS_INT3_T){110, 7, 70},
+                                 (SHAPE_COORDS_INT3_T){-10, 10, 0}, NULL) == nbBlocks);
+    TEST_CHECK(block_get_color_index(shape_get_block(s, -7, 11, 5)) == 1);
+    shape_history_undo(s);
+    TEST_CHECK(shape_get_nb_blocks(s) == nbBlocks);
+
+    shape_free(s);
+    color_atlas_free(atlas);
+}
+
+// box shrinks to the remaining blocks while removing the outermost ones, one at a time
+void test_shape_shrink_box(void) {
+    const RGBAColor color = {255, 0, 0, 255};
+    ColorAtlas *atlas = color_atlas_new();
+    Shape *s = _test_shape_new(atlas, true, &color, 1);
+
+    // scattered blocks across several chunks, pseudo-random
+    SHAPE_COORDS_INT3_T blocks[300];
+    int n = 0;
+    uint32_t seed = 12345;
+    while (n < 300) {
+        seed = seed * 1103515245 + 12345;
+        const SHAPE_COORDS_INT3_T b = {(SHAPE_COORDS_INT_T)((seed >> 8) % 80) - 40,
+                                       (SHAPE_COORDS_INT_T)((seed >> 16) % 50),
+                                       (SHAPE_COORDS_INT_T)((seed >> 4) % 70) - 10};
+        if (shape_add_block(s, 0, b.x, b.y, b.z, false)) {
+            blocks[n++] = b;
+        }
+    }
+
+    // remove blocks w/ the highest x first, then the lowest z
+    for (int i = 0; i < n; ++i) {
+        int best = i;
+        for (int j = i + 1; j < n; ++j) {
+            const bool higher = (i % 2 == 0) ? blocks[j].x > blocks[best].x
+                                             : blocks[j].z < blocks[best].z;
+            if (higher) {
+                best = j;
+            }
+        }
+        const SHAPE_COORDS_INT3_T b = blocks[best];
+        blocks[best] = blocks[i];
+        blocks[i] = b;
+
+        shape_remove_block(s, b.x, b.y, b.z);
+        shape_shrink_box(s, b);
+
+        SHAPE_COORDS_INT3_T expectedMin = {0, 0, 0}, expectedMax = {0, 0, 0};
+        for (int j = i + 1; j < n; ++j) {
+            if (j == i + 1) {
+                expectedMin = blocks[j];
+                expectedMax = blocks[j];
+            }
+            expectedMin.x = minimum(expectedMin.x, blocks[j].x);
+            expectedMin.y = minimum(expectedMin.y, blocks[j].y);
+            expectedMin.z = minimum(expectedMin.z, blocks[j].z);
+            expectedMax.x = maximum(expectedMax.x, blocks[j].x);
+            expectedMax.y = maximum(expectedMax.y, blocks[j].y);
+            expectedMax.z = maximum(expectedMax.z, blocks[j].z);
+        }
+        if (i + 1 < n) {
+            ++expectedMax.x;
+            ++expectedMax.y;
+            ++expectedMax.z;
+        }
+
+        SHAPE_COORDS_INT3_T bbMin, bbMax;
+        shape_get_model_aabb_2(s, &bbMin, &bbMax);
+        TEST_CHECK(bbMin.x == expectedMin.x && bbMin.y == expectedMin.y &&
+                   bbMin.z == expectedMin.z);
+        TEST_CHECK(bbMax.x == expectedMax.x && bbMax.y == expectedMax.y &&
+                   bbMax.z == expectedMax.z);
+        if (bbMax.x != expectedMax.x || bbMin.z != expectedMin.z) {
+            break;
+        }
+
+        // adding blocks back outside of the previous box grows slices
+        if (i == n / 2) {
+            TEST_CHECK(shape_add_block(s, 0, -200, 0, 0, false));
+            shape_remove_block(s, -200, 0, 0);
+            shape_shrink_box(s, (SHAPE_COORDS_INT3_T){-200, 0, 0});
+        }
+    }
+    TEST_CHECK(shape_get_nb_blocks(s) == 0);
+
+    shape_free(s);
+    color_atlas_free(atlas);
+}
+
+// history keeps its most recent transactions within the byte budget
+void test_shape_history_byte_budget(void) {
+    const RGBAColor colors[2] = {{255, 0, 0, 255}, {0, 255, 0, 255}};
+    ColorAtlas *atlas = color_atlas_new();
+    Shape *s = _test_shape_new(atlas, true, colors, 2);
+    shape_history_setEnabled(s, true);
+
+    for (SHAPE_COORDS_INT_T i = 0; i < 3; ++i) {
+        for (SHAPE_COORDS_INT_T z = 0; z < 100; ++z) {
+            shape_add_block_as_transaction(s, NULL, 1, i, 0, z);
+        }
+        shape_apply_current_transaction(s, false);
+    }
+    TEST_CHECK(shape_get_nb_blocks(s) == 300);
+
+    // nothing is discarded w/ the default budget
+    shape_history_undo(s);
+    shape_history_undo(s);
+    shape_history_undo(s);
+    TEST_CHECK(shape_get_nb_blocks(s) == 0);
+    TEST_CHECK(shape_history_canUndo(s) == false);
+    shape_history_redo(s);
+    shape_history_redo(s);
+    shape_history_redo(s);
+    TEST_CHECK(shape_get_nb_blocks(s) == 300);
+    TEST_CHECK(block_get_color_index(shape_get_block(s, 2, 0, 99)) == 1);
+
+    // only the latest transaction fits a tiny budget
+    shape_history_setByteBudget(s, 1);
+    shape_history_undo(s);
+    TEST_CHECK(shape_get_nb_blocks(s) == 200);
+    TEST_CHECK(shape_history_canUndo(s) == false);
+
+    // entries are capped, however small they are
+    shape_history_setByteBudget(s, HISTORY_DEFAULT_BYTE_BUDGET);
+    for (int i = 0; i < HISTORY_MAX_ENTRIES + 5; ++i) {
+        const SHAPE_COORDS_INT_T x = (SHAPE_COORDS_INT_T)(i % 1000);
+        shape_add_block_as_transaction(s, NULL, 1, x, 1, (SHAPE_COORDS_INT_T)(i / 1000));
+        shape_apply_current_transaction(s, false);
+    }
+    int nbUndos = 0;
+    while (shape_history_canUndo(s)) {
+        shape_history_undo(s);
+        ++nbUndos;
+    }
+    TEST_CHECK(nbUndos == HISTORY_MAX_ENTRIES);
+
+    shape_free(s);
+    color_atlas_free(atlas);
+}
+
+// the same model meshed w/ default and compact vertex buffers must give the same vertices once
+// decoded, compact buffers taking less memory
+void test_shape_compact_vertices(void) {
+    ColorAtlas *atlas = color_atlas_new();
+    Shape *s = _test_shape_new(atlas, false, NULL, 0);
+
+    for (SHAPE_COORDS_INT_T x = 0; x < CHUNK_SIZE + 4; ++x) {
+        for (SHAPE_COORDS_INT_T z = 0; z < CHUNK_SIZE + 4; ++z) {
+            for (SHAPE_COORDS_INT_T y = 0; y <= (x + z) % 5; ++y) {
+                shape_add_block(s, (SHAPE_COLOR_INDEX_INT_T)((x + y) % 3), x, y, z, true);
+            }
+        }
+    }
+    shape_refresh_vertices(s);
+
+    const VertexBuffer *vb = shape_get_first_vertex_buffer(s, false);
+    TEST_ASSERT(vb != NULL);
+    TEST_CHECK(vertex_buffer_get_format(vb) == VertexFormatDefault);
+    const size_t defaultSize = vertex_buffer_get_vertex_size(vb);
+
+    // chunk vertices in default format, in iteration order
+    uint32_t total = 0;
+    Index3DIterator *it = index3d_iterator_new(shape_get_chunks(s));
+    while (index3d_iterator_pointer(it) != NULL) {
+        total += chunk_read_vertices(index3d_iterator_pointer(it), false, NULL);
+        index3d_iterator_next(it);
+    }
+    VertexAttributes *ref = (VertexAttributes *)malloc(total * sizeof(VertexAttributes));
+    VertexAttributes *decoded = (VertexAttributes *)malloc(total * sizeof(VertexAttributes));
+    TEST_ASSERT(ref != NULL && decoded != NULL);
+    uint32_t count = 0;
+    index3d_iterator_free(it);
+    it = index3d_iterator_new(shape_get_chunks(s));
+    while (index3d_iterator_pointer(it) != NULL) {
+        count += chunk_read_vertices(index3d_iterator_pointer(it), false, ref + count);
+        index3d_iterator_next(it);
+    }
+
+    // switching format re-creates buffers
+    shape_set_compact_vertices(s, true);
+    TEST_CHECK(shape_uses_compact_vertices(s));
+    TEST_CHECK(shape_get_first_vertex_buffer(s, false) == NULL);
+    shape_refresh_vertices(s);
+    vb = shape_get_first_vertex_buffer(s, false);
+    TEST_ASSERT(vb != NULL);
+    TEST_CHECK(vertex_buffer_get_format(vb) == VertexFormatCompact);
+    TEST_CHECK(vertex_buffer_get_vertex_size(vb) == 12);
+    TEST_CHECK(vertex_buffer_get_vertex_size(vb) < defaultSize);
+
+    count = 0;
+    index3d_iterator_free(it);
+    it = index3d_iterator_new(shape_get_chunks(s));
+    while (index3d_iterator_pointer(it) != NULL) {
+        count += chunk_read_vertices(index3d_iterator_pointer(it), false, decoded + count);
+        index3d_iterator_next(it);
+    }
+    index3d_iterator_free(it);
+    TEST_CHECK(count == total);
+    TEST_CHECK(memcmp(ref, decoded, total * sizeof(VertexAttributes)) == 0);
+
+    free(ref);
+    free(decoded);
+    shape_free(s);
+    color_atlas_free(atlas);
+    _test_shape_pop_destroyed_vertex_buffers();
+}
+
+// emptying a chunk leaves a gap larger than refresh compaction budget, it is then filled over
+// several budgeted calls, stopping partway into gaps, w/o losing vertices
+void test_shape_fill_gaps_incremental(void) {
+    ColorAtlas *atlas = color_atlas_new();
+    Shape *s = _test_shape_new(atlas, true, NULL, 0);
+    SHAPE_COLOR_INDEX_INT_T a;
+    TEST_ASSERT(color_palette_check_and_add_color(shape_get_palette(s),
+                                                  (RGBAColor){255, 0, 0, 255},
+                                                  &a,
+                                                  false));
+
+    // isolated blocks, each w/ all its faces
+    for (SHAPE_COORDS_INT_T x = 0; x < CHUNK_SIZE * 4; ++x) {
+        for (SHAPE_COORDS_INT_T y = 0; y < CHUNK_SIZE; ++y) {
+            for (SHAPE_COORDS_INT_T z = 0; z < CHUNK_SIZE; ++z) {
+                if ((x + y + z) % 2 == 0) {
+                    shape_add_block(s, a, x, y, z, false);
+                }
+            }
+        }
+    }
+    shape_refresh_vertices(s);
+
+    // empty a chunk which vertices come first in a buffer, before vertices of other chunks
+    VertexBuffer *vb = shape_get_first_vertex_buffer(s, false);
+    VertexBufferMemArea *vbma = NULL;
+    while (vb != NULL) {
+        vbma = vertex_buffer_get_first_mem_area(vb);
+        if (vbma != NULL && vertex_buffer_mem_area_get_global_next(vbma) != NULL &&
+            vertex_buffer_mem_area_get_count(vbma) > SHAPE_BUFFER_COMPACTION_BUDGET) {
+            break;
+        }
+        vb = vertex_buffer_get_next(vb);
+    }
+    TEST_ASSERT(vb != NULL);
+    TEST_CHECK(vertex_buffer_is_fragmented(vb) == false);
+    const SHAPE_COORDS_INT3_T origin = chunk_get_origin(vertex_buffer_mem_area_get_chunk(vbma));
+    for (SHAPE_COORDS_INT_T x = origin.x; x < origin.x + CHUNK_SIZE; ++x) {
+        for (SHAPE_COORDS_INT_T y = origin.y; y < origin.y + CHUNK_SIZE; ++y) {
+            for (SHAPE_COORDS_INT_T z = origin.z; z < origin.z + CHUNK_SIZE; ++z) {
+                if ((x + y + z) % 2 == 0) {
+                    shape_remove_block(s, x, y, z);
+                }
+            }
+        }
+    }
+    shape_refresh_vertices(s);
+    TEST_ASSERT(vertex_buffer_is_fragmented(vb));
+
+    const size_t vertexSize = vertex_buffer_get_vertex_size(vb);
+    const uint8_t *data = (const uint8_t *)vertex_buffer_get_draw_buffer(vb);
+    uint32_t nbVertices = 0, gapStart, moved, nbCalls = 0;
+    vbma = vertex_buffer_get_first_mem_area(vb);
+    while (vbma != NULL) {
+        if (vertex_buffer_mem_area_get_chunk(vbma) != NULL) {
+            nbVertices += vertex_buffer_mem_area_get_count(vbma);
+        }
+        vbma = vertex_buffer_mem_area_get_global_next(vbma);
+    }
+
+    const uint32_t budget = 1000;
+    while (vertex_buffer_is_fragmented(vb) && nbCalls < 1000) {
+        ++nbCalls;
+        vertex_buffer_flush_draw_slices(vb);
+
+        vbma = vertex_buffer_get_first_mem_area(vb);
+        while (vertex_buffer_mem_area_get_chunk(vbma) != NULL) {
+            vbma = vertex_buffer_mem_area_get_global_next(vbma);
+        }
+        gapStart = vertex_buffer_mem_area_get_start_idx(vbma);
+
+        moved = vertex_buffer_fill_gaps_incremental(vb, budget);
+        TEST_CHECK(moved <= budget);
+        TEST_CHECK(moved == budget || vertex_buffer_is_fragmented(vb) == false);
+
+        // same vertices, remaining gaps are zeroed
+        uint32_t count = 0;
+        bool zeroed = true;
+        vbma = vertex_buffer_get_first_mem_area(vb);
+        while (vbma != NULL) {
+            const uint32_t vbmaCount = vertex_buffer_mem_area_get_count(vbma);
+            if (vertex_buffer_mem_area_get_chunk(vbma) != NULL) {
+                count += vbmaCount;
+            } else {
+                const uint8_t *start = data +
+                                       vertex_buffer_mem_area_get_start_idx(vbma) * vertexSize;
+                for (size_t i = 0; i < vbmaCount * vertexSize && zeroed; ++i) {
+                    zeroed = start[i] == 0;
+                }
+            }
+            vbma = vertex_buffer_mem_area_get_global_next(vbma);
+        }
+        TEST_CHECK(count == nbVertices);
+        TEST_CHECK(zeroed);
+
+        // moved vertices are uploaded, slices bounds are inclusive
+        vertex_buffer_fill_draw_slices(vb);
+        bool covered = moved == 0;
+        DoublyLinkedListNode *n = doubly_linked_list_first(vertex_buffer_get_draw_slices(vb));
+        while (n != NULL) {
+            const DrawBufferWriteSlice *ws = (const DrawBufferWriteSlice *)
+                doubly_linked_list_node_pointer(n);
+            covered = covered || (ws->from <= gapStart && ws->to >= gapStart + moved - 1);
+            n = doubly_linked_list_node_next(n);
+        }
+        TEST_CHECK(covered);
+    }
+    TEST_CHECK(vertex_buffer_is_fragmented(vb) == false);
+    TEST_CHECK(nbCalls > 1);
+    TEST_CHECK(vertex_buffer_get_count(vb) == nbVertices);
+
+    vertex_buffer_flush_draw_slices(vb);
+    shape_free(s);
+    color_atlas_free(atlas);
+    _test_shape_pop_destroyed_vertex_buffers();
+}
+
+// a wall of full chunks in front of a perspective camera hides chunks right behind it
+void test_shape_query_visible_chunks(void) {
+    ColorAtlas *atlas = color_atlas_new();
+    Shape *s = _test_shape_new(atlas, false, NULL, 0);
+    SHAPE_COLOR_INDEX_INT_T color;
+    TEST_ASSERT(color_palette_check_and_add_color(shape_get_palette(s),
+                                                  (RGBAColor){255, 0, 0, 255},
+                                                  &color,
+                                                  false));
+
+    // full chunks (0, 0, 0) & (1, 0, 0)
+    for (SHAPE_COORDS_INT_T x = 0; x < 2 * CHUNK_SIZE; ++x) {
+        for (SHAPE_COORDS_INT_T y = 0; y < CHUNK_SIZE; ++y) {
+            for (SHAPE_COORDS_INT_T z = 0; z < CHUNK_SIZE; ++z) {
+                shape_add_block(s, color, x, y, z, false);
+            }
+        }
+    }
+    shape_add_block(s, color, 8, 8, 40, false);  // behind the wall
+    shape_add_block(s, color, 16, 8, 40, false); // behind the wall, across the seam of its chunks
+    shape_add_block(s, color, 60, 8, 40, false); // next to the wall
+    shape_add_block(s, color, 120, 8, 8, false); // outside of frustum
+    shape_add_block(s, color, 8, 8, -72, false); // behind camera
+    TEST_CHECK(shape_get_nb_chunks(s) == 7);
+
+    // perspective camera facing the wall seam, looking toward +Z, 90° fov, near 1, far 1000
+    const float3 eye = {16.25f, 8.0f, -40.0f};
+    const float n = 1.0f, f = 1000.0f;
+    const float a = (f + n) / (f - n), b = -2.0f * f * n / (f - n);
+    Matrix4x4 viewProj = {1.0f, 0.0f, 0.0f, 0.0f,
+                          0.0f, 1.0f, 0.0f, 0.0f,
+                          0.0f, 0.0f, a,    1.0f,
+                          -eye.x, -eye.y, -a * eye.z + b, -eye.z};
+
+    FifoList *results = fifo_list_new();
+    TEST_CHECK(shape_query_visible_chunks(s, &viewProj, NULL, results) == 5);
+    fifo_list_flush(results, fifo_list_empty_freefunc);
+
+    OcclusionBuffer *ob = occlusion_buffer_new(64, 64);
+    TEST_ASSERT(ob != NULL);
+    TEST_CHECK(shape_query_visible_chunks(s, &viewProj, ob, results) == 3);
+    Chunk *c;
+    while ((c = (Chunk *)fifo_list_pop(results)) != NULL) {
+        const SHAPE_COORDS_INT3_T origin = chunk_get_origin(c);
+        TEST_CHECK(origin.z == 0 || origin.x == 3 * CHUNK_SIZE);
+    }
+
+    // a shape w/ transparent blocks is never used as occluder
+    occlusion_buffer_clear(ob);
+    color_palette_set_color(shape_get_palette(s), color, (RGBAColor){255, 0, 0, 128});
+    TEST_CHECK(shape_query_visible_chunks(s, &viewProj, ob, results) == 5);
+
+    fifo_list_free(results, NULL);
+    occlusion_buffer_free(ob);
+    shape_free(s);
+    color_atlas_free(atlas);
+}
+
+// LODs are downsampled on first request, then follow block changes
+void test_shape_get_lod(void) {
+    ColorAtlas *atlas = color_atlas_new();
+    Shape *s = _test_shape_new(atlas, false, NULL, 0);
+    SHAPE_COLOR_INDEX_INT_T a, b;
+    ColorPalette *palette = shape_get_palette(s);
+    TEST_ASSERT(color_palette_check_and_add_color(palette, (RGBAColor){255, 0, 0, 255}, &a, false));
+    TEST_ASSERT(color_palette_check_and_add_color(palette, (RGBAColor){0, 0, 255, 255}, &b, false));
+
+    for (SHAPE_COORDS_INT_T x = 0; x < 4; ++x) {
+        for (SHAPE_COORDS_INT_T y = 0; y < 4; ++y) {
+            for (SHAPE_COORDS_INT_T z = 0; z < 4; ++z) {
+                shape_add_block(s, x + y + z == 0 ? b : a, x, y, z, false);
+            }
+        }
+    }
+    shape_add_block(s, b, -5, 0, 0, false);
+
+    TEST_CHECK(shape_get_lod(s, 0) == s);
+    TEST_CHECK(shape_get_lod(s, SHAPE_LOD_MAX_LEVEL + 1) == NULL);
+
+    Shape *lod1 = shape_get_lod(s, 1);
+    Shape *lod2 = shape_get_lod(s, 2);
+    TEST_ASSERT(lod1 != NULL && lod2 != NULL);
+    TEST_CHECK(shape_get_palette(lod1) == palette);
+    TEST_CHECK(shape_get_nb_blocks(lod1) == 9);
+    TEST_CHECK(shape_get_nb_blocks(lod2) == 2);
+    TEST_CHECK(shape_get_block_immediate(lod1, 0, 0, 0)->colorIndex == a);
+    TEST_CHECK(shape_get_block_immediate(lod1, -3, 0, 0)->colorIndex == b);
+    TEST_CHECK(shape_get_block_immediate(lod2, -2, 0, 0)->colorIndex == b);
+
+    // cell (0, 0, 0) of level 1 becomes mostly b, block in negative chunk is removed
+    shape_paint_block(s, b, 1, 0, 0);
+    shape_paint_block(s, b, 0, 1, 0);
+    shape_paint_block(s, b, 0, 0, 1);
+    shape_paint_block(s, b, 1, 1, 0);
+    shape_remove_block(s, -5, 0, 0);
+    shape_refresh_vertices(s);
+
+    TEST_CHECK(shape_get_lod(s, 1) == lod1);
+    TEST_CHECK(shape_get_nb_blocks(lod1) == 8);
+    TEST_CHECK(shape_get_block_immediate(lod1, 0, 0, 0)->colorIndex == b);
+    TEST_CHECK(block_is_solid(shape_get_block_immediate(lod1, -3, 0, 0)) == false);
+    TEST_CHECK(shape_get_nb_blocks(lod2) == 1);
+    TEST_CHECK(shape_get_block_immediate(lod2, 0, 0, 0)->colorIndex == a);
+
+    // LOD is meshed like any shape
+    shape_refresh_vertices(lod1);
+    TEST_CHECK(shape_get_first_vertex_buffer(lod1, false) != NULL);
+
+    TEST_CHECK(shape_get_lod_level_for_distance(s, 10.0f) == 0);
+    TEST_CHECK(shape_get_lod_level_for_distance(s, SHAPE_LOD_DISTANCE) == 1);
+    TEST_CHECK(shape_get_lod_level_for_distance(s, SHAPE_LOD_DISTANCE * 3.0f) == 2);
+    TEST_CHECK(shape_get_lod_level_for_distance(s, SHAPE_LOD_DISTANCE * 100.0f) ==
+               SHAPE_LOD_MAX_LEVEL);
+
+    shape_free(s);
+    color_atlas_free(atlas);
+    _test_shape_pop_destroyed_vertex_buffers();
+}
+
+// instances are drawn w/ their model's buffers until either of them gets modified, then each
+// one refreshes its own
+void test_shape_new_instance(void) {
+    ColorAtlas *atlas = color_atlas_new();
+    Shape *model = _test_shape_new(atlas, true, NULL, 0);
+    SHAPE_COLOR_INDEX_INT_T a;
+    TEST_ASSERT(color_palette_check_and_add_color(shape_get_palette(model),
+                                                  (RGBAColor){255, 0, 0, 255},
+                                                  &a,
+                                                  false));
+    for (SHAPE_COORDS_INT_T x = 0; x < CHUNK_SIZE * 2; ++x) {
+        shape_add_block(model, a, x, 0, 0, false);
+    }
+    shape_refresh_vertices(model);
+    const VertexBuffer *vb = shape_get_first_vertex_buffer(model, false);
+    TEST_ASSERT(vb != NULL);
+
+    Shape *i1 = shape_new_instance(model);
+    Shape *i2 = shape_new_instance(i1);
+    TEST_CHECK(shape_is_instance(i1) && shape_is_instance(i2));
+    TEST_CHECK(shape_get_model(i2) == model);
+    TEST_CHECK(shape_get_palette(i1) == shape_get_palette(model));
+    TEST_CHECK(shape_get_nb_blocks(i1) == CHUNK_SIZE * 2);
+    TEST_CHECK(shape_get_first_vertex_buffer(i1, false) == vb);
+    const DoublyLinkedList *instances = shape_get_instances(model);
+    TEST_ASSERT(instances != NULL);
+    TEST_CHECK(doubly_linked_list_node_pointer(doubly_linked_list_first(instances)) == i1);
+    TEST_CHECK(doubly_linked_list_node_pointer(doubly_linked_list_last(instances)) == i2);
+
+    // nothing to refresh while attached
+    shape_refresh_vertices(i1);
+    TEST_CHECK(shape_get_first_vertex_buffer(i1, false) == vb);
+
+    // modified instance gets its own buffers, model & other instance are untouched
+    shape_remove_block(i1, 0, 0, 0);
+    TEST_CHECK(shape_is_instance(i1) == false);
+    shape_refresh_vertices(i1);
+    TEST_CHECK(shape_get_first_vertex_buffer(i1, false) != NULL);
+    TEST_CHECK(shape_get_first_vertex_buffer(i1, false) != vb);
+    TEST_CHECK(shape_get_block_immediate(model, 0, 0, 0)->colorIndex == a);
+    TEST_CHECK(shape_get_first_vertex_buffer(i2, false) == vb);
+
+    // modified model releases all its instances
+    shape_paint_block(model, a, 1, 0, 0);
+    shape_remove_block(model, 2, 0, 0);
+    TEST_CHECK(shape_get_instances(model) == NULL);
+    TEST_CHECK(shape_is_instance(i2) == false);
+    shape_refresh_vertices(i2);
+    TEST_CHECK(shape_get_first_vertex_buffer(i2, false) != NULL);
+    TEST_CHECK(shape_get_first_vertex_buffer(i2, false) != vb);
+    TEST_CHECK(shape_get_block_immediate(i2, 2, 0, 0)->colorIndex == a);
+
+    // past palette's maximum retain count, instances get a copy of it
+    ColorPalette *palette = shape_get_palette(model);
+    int nbRetains = 0;
+    while (color_palette_retain(palette)) {
+        ++nbRetains;
+    }
+    Shape *i4 = shape_new_instance(model);
+    TEST_CHECK(shape_is_instance(i4));
+    TEST_CHECK(shape_get_palette(i4) != palette);
+    TEST_CHECK(shape_get_block_immediate(i4, 1, 0, 0)->colorIndex == a);
+    shape_release(i4);
+    for (; nbRetains > 0; --nbRetains) {
+        color_palette_release(palette);
+    }
+
+    // freeing model detaches remaining instances
+    Shape *i3 = shape_new_instance(model);
+    shape_release(model);
+    TEST_CHECK(shape_is_instance(i3) == false);
+    shape_refresh_vertices(i3);
+    TEST_CHECK(shape_get_first_vertex_buffer(i3, false) != NULL);
+
+    shape_release(i1);
+    shape_release(i2);
+    shape_release(i3);
+    color_atlas_free(atlas);
+    _test_shape_pop_destroyed_vertex_buffers();
+}
+
+// refreshing an instance refreshes its model, and a modified model hands its instances over to
+// the first of them so that they share the same new buffers
+void test_shape_instance_unrendered_model(void) {
+    ColorAtlas *atlas = color_atlas_new();
+    Shape *model = _test_shape_new(atlas, true, NULL, 0);
+    SHAPE_COLOR_INDEX_INT_T a;
+    TEST_ASSERT(color_palette_check_and_add_color(shape_get_palette(model),
+                                                  (RGBAColor){255, 0, 0, 255},
+                                                  &a,
+                                                  false));
+    for (SHAPE_COORDS_INT_T x = 0; x < CHUNK_SIZE * 2; ++x) {
+        shape_add_block(model, a, x, 0, 0, false);
+    }
+
+    // model is never refreshed directly
+    Shape *i1 = shape_new_instance(model);
+    Shape *i2 = shape_new_instance(model);
+    Shape *i3 = shape_new_instance(model);
+    TEST_CHECK(shape_get_first_vertex_buffer(i1, false) == NULL);
+    shape_refresh_vertices(i1);
+    const VertexBuffer *vb = shape_get_first_vertex_buffer(model, false);
+    TEST_ASSERT(vb != NULL);
+    TEST_CHECK(vertex_buffer_get_count(vb) > 0);
+    TEST_CHECK(shape_get_first_vertex_buffer(i1, false) == vb);
+    TEST_CHECK(shape_get_first_vertex_buffer(i3, false) == vb);
+
+    // modified model: only the first instance gets new buffers, the others draw w/ them
+    shape_remove_block(model, 0, 0, 0);
+    TEST_CHECK(shape_get_instances(model) == NULL);
+    TEST_CHECK(shape_is_instance(i1) == false);
+    TEST_CHECK(shape_get_model(i2) == i1 && shape_get_model(i3) == i1);
+    TEST_CHECK(shape_get_palette(i2) == shape_get_palette(i1));
+    const DoublyLinkedList *instances = shape_get_instances(i1);
+    TEST_ASSERT(instances != NULL);
+    TEST_CHECK(doubly_linked_list_node_pointer(doubly_linked_list_first(instances)) == i2);
+    TEST_CHECK(doubly_linked_list_node_pointer(doubly_linked_list_last(instances)) == i3);
+    TEST_CHECK(shape_get_block_immediate(i2, 0, 0, 0)->colorIndex == a);
+
+    shape_refresh_vertices(i3);
+    const VertexBuffer *vb1 = shape_get_first_vertex_buffer(i1, false);
+    TEST_ASSERT(vb1 != NULL);
+    TEST_CHECK(vb1 != vb);
+    TEST_CHECK(vertex_buffer_get_count(vb1) > 0);
+    TEST_CHECK(shape_get_first_vertex_buffer(i2, false) == vb1);
+    TEST_CHECK(shape_get_first_vertex_buffer(i3, false) == vb1);
+
+    shape_release(i1);
+    TEST_CHECK(shape_get_model(i3) == i2);
+    shape_release(i2);
+    TEST_CHECK(shape_is_instance(i3) == false);
+    shape_release(i3);
+    shape_release(model);
+    color_atlas_free(atlas);
+    _test_shape_pop_destroyed_vertex_buffers();
+}
+
+// palettes are merged, translated shapes are copied & rotated ones are sampled, later shapes
+// overwriting previous ones
+void test_shape_combine(void) {
+    ColorAtlas *atlas = color_atlas_new();
+    const RGBAColor red = {255, 0, 0, 255}, green = {0, 255, 0, 255}, blue = {0, 0, 255, 255};
+    const RGBAColor colorsA[2] = {red, green}, colorsB[2] = {blue, red};
+
+    Shape *a = _test_shape_new(atlas, true, colorsA, 2);
+    for (SHAPE_COORDS_INT_T x = 0; x < CHUNK_SIZE + 2; ++x) {
+        shape_add_block(a, x == 0 ? 1 : 0, x, 0, 0, false);
+    }
+    Shape *b = _test_shape_new(atlas, true, colorsB, 2);
+    shape_add_block(b, 0, 0, 0, 0, false);
+    shape_add_block(b, 1, 1, 0, 0, false);
+
+    // b is put at x = 4 (overwriting a), and rotated by 90° around Y at z = 20
+    Matrix4x4 translate, rotate;
+    matrix4x4_set_translation(&translate, 4.0f, 0.0f, 0.0f);
+    matrix4x4_set_from_axis_rotation(&rotate, PI_2_F, 0.0f, 1.0f, 0.0f);
+    rotate.x4y3 = 20.0f;
+    Shape *shapes[3] = {a, b, b};
+    const Matrix4x4 *transforms[3] = {NULL, &translate, &rotate};
+
+    Shape *s = shape_combine(shapes, transforms, 3);
+    TEST_ASSERT(s != NULL);
+    const ColorPalette *p = shape_get_palette(s);
+    TEST_CHECK(color_palette_get_count(p) == 3);
+    TEST_CHECK(shape_get_nb_blocks(s) == CHUNK_SIZE + 2 + 2);
+    TEST_CHECK(shape_get_nb_chunks(s) == 3);
+
+    SHAPE_COLOR_INDEX_INT_T iRed, iGreen, iBlue;
+    TEST_ASSERT(color_palette_find(p, red, &iRed));
+    TEST_ASSERT(color_palette_find(p, green, &iGreen));
+    TEST_ASSERT(color_palette_find(p, blue, &iBlue));
+    TEST_CHECK(shape_get_block_immediate(s, 0, 0, 0)->colorIndex == iGreen);
+    TEST_CHECK(shape_get_block_immediate(s, 3, 0, 0)->colorIndex == iRed);
+    TEST_CHECK(shape_get_block_immediate(s, 4, 0, 0)->colorIndex == iBlue);
+    TEST_CHECK(shape_get_block_immediate(s, CHUNK_SIZE + 1, 0, 0)->colorIndex == iRed);
+    TEST_CHECK(color_palette_get_color_use_count(p, iRed) == CHUNK_SIZE + 1);
+
+    // rotated: (x, y, z) -> (z, y, -x), cell [-1, 0[ on z
+    TEST_CHECK(shape_get_block_immediate(s, 0, 0, 19)->colorIndex == iBlue);
+    TEST_CHECK(shape_get_block_immediate(s, 0, 0, 18)->colorIndex == iRed);
+
+    SHAPE_COORDS_INT3_T min, max;
+    shape_get_model_aabb_2(s, &min, &max);
+    TEST_CHECK(min.x == 0 && min.y == 0 && min.z == 0);
+    TEST_CHECK(max.x == CHUNK_SIZE + 2 && max.y == 1 && max.z == 20);
+
+    shape_release(s);
+    shape_release(a);
+    shape_release(b);
+    color_atlas_free(atlas);
+}
+
+// box casts & overlaps only consider solid blocks within the moving box range
+void test_shape_box_cast_overlap(void) {
+    const RGBAColor colors[1] = {{255, 0, 0, 255}};
+    ColorAtlas *atlas = color_atlas_new();
+    Shape *s = _test_shape_new(atlas, true, colors, 1);
+    for (SHAPE_COORDS_INT_T x = 0; x < CHUNK_SIZE * 2; ++x) {
+        for (SHAPE_COORDS_INT_T z = 0; z < CHUNK_SIZE; ++z) {
+            shape_add_block(s, 0, x, 0, z, false);
+        }
+    }
+    shape_add_block(s, 0, 20, 5, 3, false);
+
+    const float3 epsilon = {EPSILON_COLLISION, EPSILON_COLLISION, EPSILON_COLLISION};
+    float3 normal;
+    const Block *block = NULL;
+    SHAPE_COORDS_INT3_T coords;
+
+    // falling on the ground
+    Box box = {{2.2f, 2.0f, 2.2f}, {2.8f, 3.0f, 2.8f}};
+    float3 v = {0.0f, -2.0f, 0.0f};
+    float swept = shape_box_cast(s, &box, &v, &epsilon, false, &normal, NULL, &block, &coords);
+    TEST_CHECK(float_isEqual(swept, 0.5f, EPSILON_ZERO));
+    TEST_CHECK(normal.x == 0.0f && normal.y == 1.0f && normal.z == 0.0f);
+    TEST_CHECK(coords.x == 2 && coords.y == 0 && coords.z == 2);
+    TEST_CHECK(block == shape_get_block_immediate(s, 2, 0, 2));
+
+    // moving along +X in the next chunk
+    box = (Box){{16.2f, 5.2f, 3.2f}, {16.8f, 5.8f, 3.8f}};
+    v = (float3){5.0f, 0.0f, 0.0f};
+    swept = shape_box_cast(s, &box, &v, &epsilon, false, &normal, NULL, NULL, &coords);
+    TEST_CHECK(float_isEqual(swept, 0.64f, EPSILON_ZERO));
+    TEST_CHECK(normal.x == -1.0f);
+    TEST_CHECK(coords.x == 20 && coords.y == 5 && coords.z == 3);
+
+    // missing the block
+    box.min.y += 1.0f;
+    box.max.y += 1.0f;
+    TEST_CHECK(shape_box_cast(s, &box, &v, &epsilon, false, NULL, NULL, NULL, NULL) == 1.0f);
+
+    Box out;
+    box = (Box){{19.5f, 5.5f, 3.5f}, {20.5f, 5.9f, 3.9f}};
+    TEST_CHECK(shape_box_overlap(s, &box, &epsilon, &out));
+    TEST_CHECK(out.min.x == 20.0f && out.min.y == 5.0f && out.min.z == 3.0f);
+    TEST_CHECK(out.max.x == 21.0f && out.max.y == 6.0f && out.max.z == 4.0f);
+
+    // resting on the ground isn't an overlap
+    box = (Box){{5.0f, 1.0f, 5.0f}, {6.0f, 2.0f, 6.0f}};
+    TEST_CHECK(shape_box_overlap(s, &box, &epsilon, NULL) == false);
+    box.min.y -= 0.1f;
+    TEST_CHECK(shape_box_overlap(s, &box, &epsilon, NULL));
+
+    shape_release(s);
+    color_atlas_free(atlas);
+}
+
+// blocks stamp is only compared to chunks overlapping the given box
+// --- shape_blocks_changed_in_box()
+// --- shape_get_solid_blocks_in_box()
+/////
+void test_shape_blocks_changed_in_box(void) {
+    const RGBAColor colors[1] = {{255, 0, 0, 255}};
+    ColorAtlas *atlas = color_atlas_new();
+    Shape *s = _test_shape_new(atlas, true, colors, 1);
+    shape_add_block(s, 0, 1, 0, 1, false);
+    shape_add_block(s, 0, 2, 0, 1, false);
+    shape_add_block(s, 0, CHUNK_SIZE * 3, 0, 0, false);
+
+    const Box box = {{0.0f, 0.0f, 0.0f}, {3.0f, 2.0f, 3.0f}};
+    SHAPE_COORDS_INT3_T coords[2];
+    TEST_CHECK(shape_get_solid_blocks_in_box(s, &box, coords, 2) == 2);
+    TEST_CHECK(coords[0].x == 1 && coords[1].x == 2 && coords[1].z == 1);
+    TEST_CHECK(shape_get_solid_blocks_in_box(s, &box, coords, 1) == 2);
+
+    uint32_t stamp = shape_get_blocks_stamp(s);
+    TEST_CHECK(shape_blocks_changed_in_box(s, &box, stamp) == false);
+
+    // changes in other chunks are ignored
+    shape_add_block(s, 0, CHUNK_SIZE * 3 + 1, 0, 0, false);
+    TEST_CHECK(shape_get_blocks_stamp(s) != stamp);
+    TEST_CHECK(shape_blocks_changed_in_box(s, &box, stamp) == false);
+
+    // painting doesn't change blocks occupancy
+    shape_paint_block(s, 0, 1, 0, 1);
+    TEST_CHECK(shape_blocks_changed_in_box(s, &box, stamp) == false);
+
+    shape_remove_block(s, 2, 0, 1);
+    TEST_CHECK(shape_blocks_changed_in_box(s, &box, stamp));
+
+    // a new chunk may appear within the box
+    const Box tallBox = {{0.0f, 0.0f, 0.0f}, {3.0f, (float)CHUNK_SIZE + 2.0f, 3.0f}};
+    stamp = shape_get_blocks_stamp(s);
+    shape_add_block(s, 0, 0, CHUNK_SIZE, 0, false);
+    TEST_CHECK(shape_blocks_changed_in_box(s, &box, stamp) == false);
+    TEST_CHECK(shape_blocks_changed_in_box(s, &tallBox, stamp));
+
+    // or disappear, while other chunks appearing don't matter
+    stamp = shape_get_blocks_stamp(s);
+    shape_add_block(s, 0, CHUNK_SIZE * 5, 0, 0, false);
+    TEST_CHECK(shape_blocks_changed_in_box(s, &tallBox, stamp) == false);
+    shape_remove_block(s, 0, CHUNK_SIZE, 0);
+    shape_refresh_vertices(s); // frees the empty chunk
+    TEST_CHECK(shape_blocks_changed_in_box(s, &box, stamp) == false);
+    TEST_CHECK(shape_blocks_changed_in_box(s, &tallBox, stamp));
+
+    shape_release(s);
+    color_atlas_free(atlas);
+    _test_shape_pop_destroyed_vertex_buffers();
+}
+
+// rigidbodies cast against blocks cached around their trajectory, hits must be the same as w/ a
+// regular cast while blocks change in front of them
+// --- rigidbody_cached_box_cast()
+/////
+void test_shape_cached_box_cast(void) {
+    const RGBAColor colors[1] = {{255, 0, 0, 255}};
+    ColorAtlas *atlas = color_atlas_new();
+    Shape *s = _test_shape_new(atlas, true, colors, 1);
+    RigidBody *rb = rigidbody_new(RigidbodyMode_Dynamic, 1, 1);
+    TEST_ASSERT(rb != NULL);
+
+    // the only block of its chunk
+    shape_add_block(s, 0, CHUNK_SIZE + 2, 1, 1, false);
+
+    const float3 epsilon = {EPSILON_COLLISION, EPSILON_COLLISION, EPSILON_COLLISION};
+    const float3 v = {0.5f, 0.0f, 0.0f};
+    Box box = {{1.2f, 1.2f, 1.2f}, {1.8f, 1.8f, 1.8f}};
+    float3 cachedNormal, normal;
+    float cached, swept;
+    int hits = 0;
+    for (int i = 0; i < 64; ++i) {
+        if (i == 20) {
+            // unrelated chunk
+            shape_add_block(s, 0, -CHUNK_SIZE * 2, 1, 1, false);
+        } else if (i == 40) {
+            // removes the chunk the box is stopped against
+            shape_remove_block(s, CHUNK_SIZE + 2, 1, 1);
+            shape_refresh_vertices(s);
+        } else if (i == 44) {
+            // creates it again further ahead
+            shape_add_block(s, 0, CHUNK_SIZE + 6, 1, 1, false);
+        }
+
+        cached = rigidbody_cached_box_cast(rb, s, &box, &v, &epsilon, &cachedNormal);
+        swept = shape_box_cast(s, &box, &v, &epsilon, true, &normal, NULL, NULL, NULL);
+        TEST_CHECK(float_isEqual(cached, swept, EPSILON_ZERO));
+        TEST_CHECK(cachedNormal.x == normal.x && cachedNormal.y == normal.y &&
+                   cachedNormal.z == normal.z);
+        if (swept < 1.0f) {
+            ++hits;
+        }
+
+        // moves up to the contact
+        box.min.x += v.x * maximum(swept, 0.0f);
+        box.max.x += v.x * maximum(swept, 0.0f);
+    }
+    TEST_CHECK(hits > 0);
+    TEST_CHECK(float_isEqual(box.max.x, (float)(CHUNK_SIZE + 6), EPSILON_COLLISION));
+
+    rigidbody_free(rb);
+    shape_release(s);
+    color_atlas_free(atlas);
+    _test_shape_pop_destroyed_vertex_buffers();
+}
+
+// casts longer than SHAPE_CAST_ADVANCEMENT_DISTANCE skip empty space, hits must be the same
+// --- shape_box_cast()
+/////
+void test_shape_box_cast_long(void) {
+    const RGBAColor colors[1] = {{255, 0, 0, 255}};
+    ColorAtlas *atlas = color_atlas_new();
+    Shape *s = _test_shape_new(atlas, true, colors, 1);
+    for (SHAPE_COORDS_INT_T x = 0; x < CHUNK_SIZE * 2; ++x) {
+        for (SHAPE_COORDS_INT_T z = 0; z < CHUNK_SIZE * 2; ++z) {
+            shape_add_block(s, 0, x, 0, z, false);
+        }
+    }
+    shape_add_block(s, 0, 100, 3, 3, false);
+
+    const float3 epsilon = {EPSILON_COLLISION, EPSILON_COLLISION, EPSILON_COLLISION};
+    float3 normal;
+    const Block *block = NULL;
+    SHAPE_COORDS_INT3_T coords;
+
+    // falling on the ground from far above
+    Box box = {{2.2f, 40.0f, 2.2f}, {2.8f, 41.0f, 2.8f}};
+    float3 v = {10.0f, -45.0f, 5.0f};
+    float swept = shape_box_cast(s, &box, &v, &epsilon, false, &normal, NULL, &block, &coords);
+    TEST_CHECK(float_isEqual(swept, 39.0f / 45.0f, EPSILON_ZERO));
+    TEST_CHECK(normal.x == 0.0f && normal.y == 1.0f && normal.z == 0.0f);
+    TEST_CHECK(coords.y == 0 && (coords.x == 10 || coords.x == 11));
+    TEST_CHECK(block == shape_get_block_immediate(s, coords.x, 0, coords.z));
+
+    // same w/ replacement, as used by fast rigidbodies
+    float3 extra;
+    swept = shape_box_cast(s, &box, &v, &epsilon, true, &normal, &extra, NULL, &coords);
+    TEST_CHECK(float_isEqual(swept, 39.0f / 45.0f, EPSILON_ZERO));
+    TEST_CHECK(normal.x == 0.0f && normal.y == 1.0f && normal.z == 0.0f);
+    TEST_CHECK(coords.y == 0 && (coords.x == 10 || coords.x == 11));
+    TEST_CHECK(extra.x == 0.0f && extra.y == 0.0f && extra.z == 0.0f);
+
+    // block at the end of empty chunks, right above the ground
+    box = (Box){{1.2f, 1.0f, 3.2f}, {1.8f, 3.8f, 3.8f}};
+    v = (float3){150.0f, 0.0f, 0.0f};
+    swept = shape_box_cast(s, &box, &v, &epsilon, false, &normal, NULL, NULL, &coords);
+    TEST_CHECK(float_isEqual(swept, (100.0f - 1.8f) / 150.0f, EPSILON_ZERO));
+    TEST_CHECK(normal.x == -1.0f);
+    TEST_CHECK(coords.x == 100 && coords.y == 3 && coords.z == 3);
+    swept = shape_box_cast(s, &box, &v, &epsilon, true, &normal, NULL, NULL, &coords);
+    TEST_CHECK(float_isEqual(swept, (100.0f - 1.8f) / 150.0f, EPSILON_ZERO));
+    TEST_CHECK(coords.x == 100 && coords.y == 3 && coords.z == 3);
+
+    // sliding over the block
+    box.min.y += 3.0f;
+    box.max.y += 3.0f;
+    TEST_CHECK(shape_box_cast(s, &box, &v, &epsilon, false, NULL, NULL, NULL, NULL) == 1.0f);
+
+    // outside of the shape bounding box
+    box = (Box){{-10.0f, 50.0f, -10.0f}, {-9.0f, 51.0f, -9.0f}};
+    v = (float3){200.0f, 0.0f, 100.0f};
+    TEST_CHECK(shape_box_cast(s, &box, &v, &epsilon, false, NULL, NULL, NULL, NULL) == 1.0f);
+
+    shape_release(s);
+    color_atlas_free(atlas);
+}
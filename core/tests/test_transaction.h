@@ -85,3 +85,89 @@ void test_transaction_getIndex3DIterator(void) {
     TEST_CHECK(bc != NULL);
     transaction_free(t);
 }
+
+// packed transaction must give back the same block changes, previous colors and regions
+void test_transaction_pack(void) {
+    Transaction *t = transaction_new();
+    transaction_addBlock(t, 0, 0, 0, 1);
+    transaction_addBlock(t, -300, 12, 32767, 2);
+    transaction_removeBlock(t, -32768, -1, 5);
+    transaction_replaceBlock(t, 7, 7, -7, 3);
+
+    // as if applied, previous color is the x coordinate parity
+    Index3DIterator *it = transaction_getIndex3DIterator(t);
+    SHAPE_COORDS_INT_T x, y, z;
+    while (index3d_iterator_pointer(it) != NULL) {
+        BlockChange *bc = (BlockChange *)index3d_iterator_pointer(it);
+        blockChange_getXYZ(bc, &x, &y, &z);
+        blockChange_set_previous_color(bc, (SHAPE_COLOR_INDEX_INT_T)(x & 1));
+        index3d_iterator_next(it);
+    }
+
+    // small region w/ dense colors
+    TransactionColors after;
+    TEST_ASSERT(transaction_colors_init(&after, 8));
+    TEST_CHECK(after.dense != NULL);
+    for (uint32_t i = 0; i < 8; ++i) {
+        transaction_colors_set(&after, i, (SHAPE_COLOR_INDEX_INT_T)i);
+    }
+    transaction_addRegion(t, (SHAPE_COORDS_INT3_T){-1, -1, -1}, (SHAPE_COORDS_INT3_T){1, 1, 1},
+                          &after, 0);
+
+    // big region filled, w/ a few previous colors stored as runs
+    transaction_addRegion(t, (SHAPE_COORDS_INT3_T){0, 0, 0}, (SHAPE_COORDS_INT3_T){100, 100, 100},
+                          NULL, 4);
+    TransactionRegion *filled = transaction_getRegion(t, 1);
+    TEST_ASSERT(transaction_colors_init(&filled->before, 1000000));
+    TEST_CHECK(filled->before.dense == NULL);
+    transaction_colors_set(&filled->before, 500000, 5);
+    transaction_colors_set(&filled->before, 10, 6);
+    transaction_colors_set(&filled->before, 11, 6);
+    transaction_colors_seal(&filled->before);
+
+    uint32_t size = 0;
+    void *packed = transaction_pack(t, &size);
+    TEST_ASSERT(packed != NULL);
+    Transaction *u = transaction_new_from_packed(packed, size);
+    TEST_ASSERT(u != NULL);
+    free(packed);
+
+    TEST_CHECK(transaction_getCurrentBlockAt(u, 0, 0, 0)->colorIndex == 1);
+    TEST_CHECK(transaction_getCurrentBlockAt(u, -300, 12, 32767)->colorIndex == 2);
+    TEST_CHECK(transaction_getCurrentBlockAt(u, -32768, -1, 5)->colorIndex ==
+               SHAPE_COLOR_INDEX_AIR_BLOCK);
+    TEST_CHECK(transaction_getCurrentBlockAt(u, 7, 7, -7)->colorIndex == 3);
+
+    int count = 0;
+    it = transaction_getIndex3DIterator(u);
+    while (index3d_iterator_pointer(it) != NULL) {
+        const BlockChange *bc = (const BlockChange *)index3d_iterator_pointer(it);
+        blockChange_getXYZ(bc, &x, &y, &z);
+        TEST_CHECK(blockChange_get_previous_color(bc) == (x & 1));
+        ++count;
+        index3d_iterator_next(it);
+    }
+    TEST_CHECK(count == 4);
+
+    TEST_ASSERT(transaction_getRegionCount(u) == 2);
+    const TransactionRegion *r = transaction_getRegion(u, 0);
+    TEST_CHECK(r->min.x == -1 && r->max.z == 1);
+    TEST_CHECK(transaction_colors_is_set(&r->before) == false);
+    TEST_ASSERT(r->after.dense != NULL);
+    TEST_CHECK(r->after.dense[7] == 7);
+
+    r = transaction_getRegion(u, 1);
+    TEST_CHECK(r->fill == 4 && transaction_colors_is_set(&r->after) == false);
+    TEST_ASSERT(r->before.runs != NULL);
+    TEST_CHECK(r->before.nbRuns == 2);
+    uint32_t hint = 0;
+    SHAPE_COLOR_INDEX_INT_T color;
+    TEST_CHECK(transaction_colors_get(&r->before, 10, &hint, &color) && color == 6);
+    TEST_CHECK(transaction_colors_get(&r->before, 11, &hint, &color) && color == 6);
+    TEST_CHECK(transaction_colors_get(&r->before, 12, &hint, &color) == false);
+    TEST_CHECK(transaction_colors_get(&r->before, 500000, &hint, &color) && color == 5);
+    TEST_CHECK(transaction_colors_get(&r->before, 9, &hint, &color) == false);
+
+    transaction_free(t);
+    transaction_free(u);
+}
@@ -263,3 +263,56 @@ void test_transform_flush(void) {
     transform_release(c);
     transform_release(p);
 }
+
+// check handles resolve live transforms only, past the former 16-bit ID limit
+void test_transform_handle(void) {
+    const uint32_t n = 70000;
+    Transform **transforms = (Transform **)malloc(sizeof(Transform *) * n);
+    TransformHandle *handles = (TransformHandle *)malloc(sizeof(TransformHandle) * n);
+    bool unique = true, valid = true;
+
+    for (uint32_t i = 0; i < n; ++i) {
+        transforms[i] = transform_new(HierarchyTransform);
+        handles[i] = transform_get_handle(transforms[i]);
+        if (i > 0 && transform_get_id(transforms[i]) == transform_get_id(transforms[i - 1])) {
+            unique = false;
+        }
+    }
+    for (uint32_t i = 0; i < n; ++i) {
+        if (transform_get_from_handle(handles[i]) != transforms[i]) {
+            valid = false;
+        }
+    }
+    TEST_CHECK(unique);
+    TEST_CHECK(valid);
+    TEST_CHECK(transform_handle_is_valid(TRANSFORM_HANDLE_NONE) == false);
+
+    // a freed transform's handle can't alias the transform reusing its ID
+    const uint32_t id = transform_get_id(transforms[n - 1]);
+    transform_release(transforms[n - 1]);
+    TEST_CHECK(transform_handle_is_valid(handles[n - 1]) == false);
+    transforms[n - 1] = transform_new(HierarchyTransform);
+    TEST_CHECK(transform_get_id(transforms[n - 1]) == id);
+    TEST_CHECK(transform_get_handle(transforms[n - 1]) != handles[n - 1]);
+    TEST_CHECK(transform_get_from_handle(handles[n - 1]) == NULL);
+    TEST_CHECK(transform_get_from_handle(transform_get_handle(transforms[n - 1])) ==
+               transforms[n - 1]);
+
+    // still stale after the ID is reused many times, until the ID is retired
+    bool aliased = false;
+    for (uint32_t i = 0; i < 5000; ++i) {
+        transform_release(transforms[n - 1]);
+        transforms[n - 1] = transform_new(HierarchyTransform);
+        if (transform_get_from_handle(handles[n - 1]) != NULL) {
+            aliased = true;
+        }
+    }
+    TEST_CHECK(transform_get_id(transforms[n - 1]) != id);
+    TEST_CHECK(aliased == false);
+
+    for (uint32_t i = 0; i < n; ++i) {
+        transform_release(transforms[i]);
+    }
+    free(transforms);
+    free(handles);
+}
@@ -155,3 +155,28 @@ void test_vertex_buffer_get_lighting_enabled(void) {
 
     vertex_buffer_set_lighting_enabled(previous_value);
 }
+
+// draw slices overlapping or close to each other are merged
+void test_vertex_buffer_add_draw_slice(void) {
+    VertexBuffer *vb = vertex_buffer_new_with_max_count(4096, false);
+
+    vertex_buffer_add_draw_slice(vb, 0, 10);
+    vertex_buffer_add_draw_slice(vb, 1000, 10);
+    TEST_CHECK(vertex_buffer_get_nb_draw_slices(vb) == 2);
+
+    vertex_buffer_add_draw_slice(vb, 1020, 5);
+    TEST_CHECK(vertex_buffer_get_nb_draw_slices(vb) == 2);
+
+    vertex_buffer_add_draw_slice(vb, 10, 990);
+    TEST_CHECK(vertex_buffer_get_nb_draw_slices(vb) == 1);
+
+    const DrawBufferWriteSlice *ws = (const DrawBufferWriteSlice *)doubly_linked_list_node_pointer(
+        doubly_linked_list_first(vertex_buffer_get_draw_slices(vb)));
+    TEST_CHECK(ws->from == 0);
+    TEST_CHECK(ws->to == 1024);
+
+    vertex_buffer_flush_draw_slices(vb);
+    vertex_buffer_free(vb);
+    uint32_t id;
+    vertex_buffer_pop_destroyed_id(&id);
+}
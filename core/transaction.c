@@ -7,11 +7,14 @@
 #include "transaction.h"
 
 #include <stdlib.h>
+#include <string.h>
 
 #include "block.h"
 #include "blockChange.h"
 #include "box.h"
+#include "cclog.h"
 #include "index3d.h"
+#include "zlib.h"
 
 struct _Transaction {
 
@@ -23,9 +26,31 @@ struct _Transaction {
     // transactions are voluntarily kept pending
     Index3DIterator *iterator;
 
-    // no padding
+    // volume changes
+    TransactionRegion *regions;
+    uint32_t nbRegions;
+
+    char pad[4];
 };
 
+static uint64_t _transaction_morton_encode(const SHAPE_COORDS_INT_T x,
+                                           const SHAPE_COORDS_INT_T y,
+                                           const SHAPE_COORDS_INT_T z);
+static void _transaction_morton_decode(const uint64_t m,
+                                       SHAPE_COORDS_INT_T *x,
+                                       SHAPE_COORDS_INT_T *y,
+                                       SHAPE_COORDS_INT_T *z);
+static int _transaction_packed_change_compare(const void *a, const void *b);
+static int _transaction_run_compare(const void *a, const void *b);
+static size_t _transaction_colors_packed_size(const TransactionColors *c, const size_t volume);
+static uint8_t *_transaction_colors_pack(const TransactionColors *c,
+                                         const size_t volume,
+                                         uint8_t *cursor);
+static bool _transaction_colors_unpack(TransactionColors *c,
+                                       const bool runs,
+                                       const size_t volume,
+                                       const uint8_t **cursor);
+
 ///
 Transaction *transaction_new(void) {
     Index3D *index3D = index3d_new();
@@ -41,6 +66,8 @@ Transaction *transaction_new(void) {
 
     tr->index3D = index3D;
     tr->iterator = NULL;
+    tr->regions = NULL;
+    tr->nbRegions = 0;
 
     return tr;
 }
@@ -49,13 +76,18 @@ void transaction_free(Transaction *const tr) {
     if (tr == NULL) {
         return;
     }
-    index3d_flush(tr->index3D, blockChange_freeFunc);
-    index3d_free(tr->index3D);
-    tr->index3D = NULL;
     if (tr->iterator != NULL) {
         index3d_iterator_free(tr->iterator);
         tr->iterator = NULL;
     }
+    index3d_flush(tr->index3D, blockChange_freeFunc);
+    index3d_free(tr->index3D);
+    tr->index3D = NULL;
+    for (uint32_t i = 0; i < tr->nbRegions; ++i) {
+        transaction_colors_free(&tr->regions[i].after);
+        transaction_colors_free(&tr->regions[i].before);
+    }
+    free(tr->regions);
     free(tr);
 }
 
@@ -186,3 +218,500 @@ void transaction_resetIndex3DIterator(Transaction *const tr) {
         tr->iterator = NULL;
     }
 }
+
+bool transaction_addRegion(Transaction *const tr,
+                           const SHAPE_COORDS_INT3_T min,
+                           const SHAPE_COORDS_INT3_T max,
+                           TransactionColors *after,
+                           const SHAPE_COLOR_INDEX_INT_T fill) {
+    vx_assert(tr != NULL);
+
+    TransactionRegion *regions = (TransactionRegion *)
+        realloc(tr->regions, sizeof(TransactionRegion) * (tr->nbRegions + 1));
+    if (regions == NULL) {
+        return false;
+    }
+    tr->regions = regions;
+
+    TransactionRegion *r = &tr->regions[tr->nbRegions++];
+    if (after != NULL) {
+        r->after = *after;
+    } else {
+        r->after = (TransactionColors){NULL, NULL, 0, 0};
+    }
+    r->before = (TransactionColors){NULL, NULL, 0, 0};
+    r->min = min;
+    r->max = max;
+    r->fill = fill;
+    return true;
+}
+
+uint32_t transaction_getRegionCount(const Transaction *const tr) {
+    return tr->nbRegions;
+}
+
+TransactionRegion *transaction_getRegion(Transaction *const tr, const uint32_t i) {
+    vx_assert(i < tr->nbRegions);
+    return &tr->regions[i];
+}
+
+// MARK: - Region colors -
+
+bool transaction_colors_init(TransactionColors *c, const size_t volume) {
+    vx_assert(c != NULL);
+
+    *c = (TransactionColors){NULL, NULL, 0, 0};
+    if (volume <= TRANSACTION_REGION_DENSE_MAX_VOLUME) {
+        // unset entries are left uninitialized, dense colors are expected to be fully written
+        c->dense = (SHAPE_COLOR_INDEX_INT_T *)malloc(volume * sizeof(SHAPE_COLOR_INDEX_INT_T));
+        return c->dense != NULL;
+    }
+    c->runsCapacity = 16;
+    c->runs = (TransactionRun *)malloc(c->runsCapacity * sizeof(TransactionRun));
+    return c->runs != NULL;
+}
+
+void transaction_colors_free(TransactionColors *c) {
+    free(c->dense);
+    free(c->runs);
+    *c = (TransactionColors){NULL, NULL, 0, 0};
+}
+
+bool transaction_colors_is_set(const TransactionColors *c) {
+    return c->dense != NULL || c->runs != NULL;
+}
+
+bool transaction_colors_set(TransactionColors *c,
+                            const uint32_t i,
+                            const SHAPE_COLOR_INDEX_INT_T color) {
+    if (c->dense != NULL) {
+        c->dense[i] = color;
+        return true;
+    }
+
+    // extend last run when possible, which is always the case for a contiguous line of blocks
+    if (c->nbRuns > 0) {
+        TransactionRun *last = &c->runs[c->nbRuns - 1];
+        if (last->color == color && last->start + last->count == i) {
+            ++last->count;
+            return true;
+        }
+    }
+    if (c->nbRuns == c->runsCapacity) {
+        TransactionRun *runs = (TransactionRun *)realloc(c->runs,
+                                                         2 * c->runsCapacity *
+                                                             sizeof(TransactionRun));
+        if (runs == NULL) {
+            return false;
+        }
+        c->runs = runs;
+        c->runsCapacity *= 2;
+    }
+    c->runs[c->nbRuns++] = (TransactionRun){i, 1, color, {0}};
+    return true;
+}
+
+void transaction_colors_seal(TransactionColors *c) {
+    if (c->nbRuns < 2) {
+        return;
+    }
+    qsort(c->runs, c->nbRuns, sizeof(TransactionRun), _transaction_run_compare);
+
+    uint32_t n = 0;
+    for (uint32_t i = 1; i < c->nbRuns; ++i) {
+        TransactionRun *last = &c->runs[n];
+        if (last->color == c->runs[i].color && last->start + last->count == c->runs[i].start) {
+            last->count += c->runs[i].count;
+        } else {
+            c->runs[++n] = c->runs[i];
+        }
+    }
+    c->nbRuns = n + 1;
+}
+
+bool transaction_colors_get(const TransactionColors *c,
+                            const uint32_t i,
+                            uint32_t *hint,
+                            SHAPE_COLOR_INDEX_INT_T *color) {
+    if (c->dense != NULL) {
+        *color = c->dense[i];
+        return true;
+    }
+
+    // look for the first run ending after i, checking hint & next run before searching
+    const TransactionRun *runs = c->runs;
+    uint32_t h = *hint;
+    if (h < c->nbRuns && runs[h].start <= i && runs[h].start + runs[h].count <= i) {
+        ++h;
+    }
+    if (h >= c->nbRuns || runs[h].start + runs[h].count <= i ||
+        (h > 0 && runs[h - 1].start + runs[h - 1].count > i)) {
+        uint32_t lo = 0, hi = c->nbRuns;
+        while (lo < hi) {
+            const uint32_t mid = lo + (hi - lo) / 2;
+            if (runs[mid].start + runs[mid].count <= i) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        h = lo;
+    }
+    *hint = h;
+
+    if (h < c->nbRuns && runs[h].start <= i) {
+        *color = runs[h].color;
+        return true;
+    }
+    return false;
+}
+
+// MARK: - Packing -
+
+// packed buffer: uncompressed size (uint32) followed by zlib data (fastest level, as packing
+// happens on every history push), containing:
+// - nb block changes (uint32), Morton coordinate deltas (LEB128), previous colors, new colors
+// - nb regions (uint32), then for each: min, max (6 x int16), fill, flags, after?, before?
+//   colors are either dense (one byte per block), or nb runs (uint32) then start, count (uint32)
+//   and color of each run
+
+#define TRANSACTION_PACKED_REGION_AFTER 1
+#define TRANSACTION_PACKED_REGION_BEFORE 2
+#define TRANSACTION_PACKED_REGION_AFTER_RUNS 4
+#define TRANSACTION_PACKED_REGION_BEFORE_RUNS 8
+
+typedef struct {
+    uint64_t morton;
+    SHAPE_COLOR_INDEX_INT_T previous, color;
+    char pad[6];
+} PackedChange;
+
+void *transaction_pack(Transaction *const tr, uint32_t *size) {
+    vx_assert(tr != NULL);
+    vx_assert(size != NULL);
+
+    const size_t nbChanges = index3d_count(tr->index3D);
+    PackedChange *changes = NULL;
+    if (nbChanges > 0) {
+        changes = (PackedChange *)malloc(sizeof(PackedChange) * nbChanges);
+        if (changes == NULL) {
+            return NULL;
+        }
+    }
+
+    size_t n = 0;
+    SHAPE_COORDS_INT_T x, y, z;
+    Index3DIterator *it = index3d_iterator_new(tr->index3D);
+    while (index3d_iterator_pointer(it) != NULL && n < nbChanges) {
+        const BlockChange *bc = (const BlockChange *)index3d_iterator_pointer(it);
+        blockChange_getXYZ(bc, &x, &y, &z);
+        changes[n].morton = _transaction_morton_encode(x, y, z);
+        changes[n].previous = blockChange_get_previous_color(bc);
+        changes[n].color = blockChange_getBlock(bc)->colorIndex;
+        ++n;
+        index3d_iterator_next(it);
+    }
+    index3d_iterator_free(it);
+    if (n > 1) {
+        qsort(changes, n, sizeof(PackedChange), _transaction_packed_change_compare);
+    }
+
+    // upper bound: 48-bit deltas take at most 7 bytes
+    size_t rawSize = 2 * sizeof(uint32_t) + n * (7 + 2 * sizeof(SHAPE_COLOR_INDEX_INT_T));
+    for (uint32_t i = 0; i < tr->nbRegions; ++i) {
+        const TransactionRegion *r = &tr->regions[i];
+        const size_t volume = (size_t)(r->max.x - r->min.x) * (size_t)(r->max.y - r->min.y) *
+                              (size_t)(r->max.z - r->min.z);
+        rawSize += 6 * sizeof(int16_t) + 2 + _transaction_colors_packed_size(&r->after, volume) +
+                   _transaction_colors_packed_size(&r->before, volume);
+    }
+
+    uint8_t *raw = (uint8_t *)malloc(rawSize);
+    if (raw == NULL) {
+        free(changes);
+        return NULL;
+    }
+    uint8_t *cursor = raw;
+
+    const uint32_t n32 = (uint32_t)n;
+    memcpy(cursor, &n32, sizeof(uint32_t));
+    cursor += sizeof(uint32_t);
+    uint64_t previousMorton = 0;
+    for (size_t i = 0; i < n; ++i) {
+        uint64_t delta = changes[i].morton - previousMorton;
+        previousMorton = changes[i].morton;
+        while (delta >= 0x80) {
+            *cursor++ = (uint8_t)(delta | 0x80);
+            delta >>= 7;
+        }
+        *cursor++ = (uint8_t)delta;
+    }
+    for (size_t i = 0; i < n; ++i) {
+        *cursor++ = changes[i].previous;
+    }
+    for (size_t i = 0; i < n; ++i) {
+        *cursor++ = changes[i].color;
+    }
+    free(changes);
+
+    memcpy(cursor, &tr->nbRegions, sizeof(uint32_t));
+    cursor += sizeof(uint32_t);
+    for (uint32_t i = 0; i < tr->nbRegions; ++i) {
+        const TransactionRegion *r = &tr->regions[i];
+        const int16_t bounds[6] = {r->min.x, r->min.y, r->min.z, r->max.x, r->max.y, r->max.z};
+        memcpy(cursor, bounds, sizeof(bounds));
+        cursor += sizeof(bounds);
+        *cursor++ = r->fill;
+        const TransactionColors *after = &r->after, *before = &r->before;
+        uint8_t flags = 0;
+        if (transaction_colors_is_set(after)) {
+            flags |= after->runs != NULL ? TRANSACTION_PACKED_REGION_AFTER_RUNS
+                                         : TRANSACTION_PACKED_REGION_AFTER;
+        }
+        if (transaction_colors_is_set(before)) {
+            flags |= before->runs != NULL ? TRANSACTION_PACKED_REGION_BEFORE_RUNS
+                                          : TRANSACTION_PACKED_REGION_BEFORE;
+        }
+        *cursor++ = flags;
+
+        const size_t volume = (size_t)(r->max.x - r->min.x) * (size_t)(r->max.y - r->min.y) *
+                              (size_t)(r->max.z - r->min.z);
+        cursor = _transaction_colors_pack(after, volume, cursor);
+        cursor = _transaction_colors_pack(before, volume, cursor);
+    }
+
+    const uLong uncompressedSize = (uLong)(cursor - raw);
+    uLong compressedSize = compressBound(uncompressedSize);
+    uint8_t *packed = (uint8_t *)malloc(sizeof(uint32_t) + compressedSize);
+    if (packed == NULL ||
+        compress2(packed + sizeof(uint32_t),
+                  &compressedSize,
+                  raw,
+                  uncompressedSize,
+                  Z_BEST_SPEED) != Z_OK) {
+        cclog_error("transaction_pack: failed to compress");
+        free(packed);
+        free(raw);
+        return NULL;
+    }
+    free(raw);
+
+    const uint32_t uncompressedSize32 = (uint32_t)uncompressedSize;
+    memcpy(packed, &uncompressedSize32, sizeof(uint32_t));
+
+    // give back unused compression bound space
+    *size = (uint32_t)(sizeof(uint32_t) + compressedSize);
+    uint8_t *shrunk = (uint8_t *)realloc(packed, *size);
+    return shrunk != NULL ? shrunk : packed;
+}
+
+Transaction *transaction_new_from_packed(const void *data, const uint32_t size) {
+    if (data == NULL || size < sizeof(uint32_t)) {
+        return NULL;
+    }
+
+    uint32_t rawSize32;
+    memcpy(&rawSize32, data, sizeof(uint32_t));
+    uLong rawSize = rawSize32;
+    uint8_t *raw = (uint8_t *)malloc(rawSize);
+    if (raw == NULL || uncompress(raw,
+                                  &rawSize,
+                                  (const uint8_t *)data + sizeof(uint32_t),
+                                  size - sizeof(uint32_t)) != Z_OK) {
+        cclog_error("transaction_new_from_packed: failed to uncompress");
+        free(raw);
+        return NULL;
+    }
+
+    Transaction *tr = transaction_new();
+    if (tr == NULL) {
+        free(raw);
+        return NULL;
+    }
+
+    const uint8_t *cursor = raw;
+    uint32_t n;
+    memcpy(&n, cursor, sizeof(uint32_t));
+    cursor += sizeof(uint32_t);
+
+    // colors follow all the deltas, locate them first
+    const uint8_t *deltas = cursor;
+    for (uint32_t i = 0; i < n; ++i) {
+        while (*cursor & 0x80) {
+            ++cursor;
+        }
+        ++cursor;
+    }
+    const SHAPE_COLOR_INDEX_INT_T *previous = cursor;
+    const SHAPE_COLOR_INDEX_INT_T *colors = cursor + n;
+    cursor += 2 * (size_t)n;
+
+    uint64_t morton = 0;
+    SHAPE_COORDS_INT_T x, y, z;
+    for (uint32_t i = 0; i < n; ++i) {
+        uint64_t delta = 0;
+        uint8_t shift = 0;
+        do {
+            delta |= (uint64_t)(*deltas & 0x7F) << shift;
+            shift += 7;
+        } while (*deltas++ & 0x80);
+        morton += delta;
+
+        _transaction_morton_decode(morton, &x, &y, &z);
+        BlockChange *bc = blockChange_new(colors[i], x, y, z);
+        if (bc == NULL) {
+            cclog_error("transaction_new_from_packed: failed to allocate block change");
+            transaction_free(tr);
+            free(raw);
+            return NULL;
+        }
+        blockChange_set_previous_color(bc, previous[i]);
+        index3d_insert(tr->index3D, bc, x, y, z, NULL);
+    }
+
+    uint32_t nbRegions;
+    memcpy(&nbRegions, cursor, sizeof(uint32_t));
+    cursor += sizeof(uint32_t);
+    for (uint32_t i = 0; i < nbRegions; ++i) {
+        int16_t bounds[6];
+        memcpy(bounds, cursor, sizeof(bounds));
+        cursor += sizeof(bounds);
+        const SHAPE_COLOR_INDEX_INT_T fill = *cursor++;
+        const uint8_t flags = *cursor++;
+
+        const SHAPE_COORDS_INT3_T min = {bounds[0], bounds[1], bounds[2]};
+        const SHAPE_COORDS_INT3_T max = {bounds[3], bounds[4], bounds[5]};
+        const size_t volume = (size_t)(max.x - min.x) * (size_t)(max.y - min.y) *
+                              (size_t)(max.z - min.z);
+
+        TransactionColors after = {NULL, NULL, 0, 0}, before = {NULL, NULL, 0, 0};
+        bool ok = true;
+        if (flags & (TRANSACTION_PACKED_REGION_AFTER | TRANSACTION_PACKED_REGION_AFTER_RUNS)) {
+            ok = _transaction_colors_unpack(&after,
+                                            flags & TRANSACTION_PACKED_REGION_AFTER_RUNS,
+                                            volume,
+                                            &cursor);
+        }
+        if (ok &&
+            (flags & (TRANSACTION_PACKED_REGION_BEFORE | TRANSACTION_PACKED_REGION_BEFORE_RUNS))) {
+            ok = _transaction_colors_unpack(&before,
+                                            flags & TRANSACTION_PACKED_REGION_BEFORE_RUNS,
+                                            volume,
+                                            &cursor);
+        }
+        if (ok == false || transaction_addRegion(tr, min, max, &after, fill) == false) {
+            cclog_error("transaction_new_from_packed: failed to allocate region");
+            transaction_colors_free(&after);
+            transaction_colors_free(&before);
+            transaction_free(tr);
+            free(raw);
+            return NULL;
+        }
+        tr->regions[tr->nbRegions - 1].before = before;
+    }
+
+    free(raw);
+    return tr;
+}
+
+// coordinates are offset to be unsigned, then bits are interleaved (x, y, z from high to low)
+static uint64_t _transaction_morton_encode(const SHAPE_COORDS_INT_T x,
+                                           const SHAPE_COORDS_INT_T y,
+                                           const SHAPE_COORDS_INT_T z) {
+    const uint16_t ux = (uint16_t)(x + 32768), uy = (uint16_t)(y + 32768),
+                   uz = (uint16_t)(z + 32768);
+    uint64_t m = 0;
+    for (int i = 15; i >= 0; --i) {
+        m = (m << 3) | (uint64_t)(((ux >> i) & 1) << 2 | ((uy >> i) & 1) << 1 | ((uz >> i) & 1));
+    }
+    return m;
+}
+
+static void _transaction_morton_decode(const uint64_t m,
+                                       SHAPE_COORDS_INT_T *x,
+                                       SHAPE_COORDS_INT_T *y,
+                                       SHAPE_COORDS_INT_T *z) {
+    uint16_t ux = 0, uy = 0, uz = 0;
+    for (int i = 15; i >= 0; --i) {
+        const uint64_t bits = m >> (3 * i);
+        ux = (uint16_t)(ux << 1 | ((bits >> 2) & 1));
+        uy = (uint16_t)(uy << 1 | ((bits >> 1) & 1));
+        uz = (uint16_t)(uz << 1 | (bits & 1));
+    }
+    *x = (SHAPE_COORDS_INT_T)(ux - 32768);
+    *y = (SHAPE_COORDS_INT_T)(uy - 32768);
+    *z = (SHAPE_COORDS_INT_T)(uz - 32768);
+}
+
+static int _transaction_packed_change_compare(const void *a, const void *b) {
+    const uint64_t ma = ((const PackedChange *)a)->morton, mb = ((const PackedChange *)b)->morton;
+    return ma < mb ? -1 : (ma > mb ? 1 : 0);
+}
+
+static int _transaction_run_compare(const void *a, const void *b) {
+    const uint32_t sa = ((const TransactionRun *)a)->start;
+    const uint32_t sb = ((const TransactionRun *)b)->start;
+    return sa < sb ? -1 : (sa > sb ? 1 : 0);
+}
+
+static size_t _transaction_colors_packed_size(const TransactionColors *c, const size_t volume) {
+    if (c->dense != NULL) {
+        return volume;
+    } else if (c->runs != NULL) {
+        return sizeof(uint32_t) + c->nbRuns * (2 * sizeof(uint32_t) + 1);
+    }
+    return 0;
+}
+
+static uint8_t *_transaction_colors_pack(const TransactionColors *c,
+                                         const size_t volume,
+                                         uint8_t *cursor) {
+    if (c->dense != NULL) {
+        memcpy(cursor, c->dense, volume);
+        cursor += volume;
+    } else if (c->runs != NULL) {
+        memcpy(cursor, &c->nbRuns, sizeof(uint32_t));
+        cursor += sizeof(uint32_t);
+        for (uint32_t i = 0; i < c->nbRuns; ++i) {
+            memcpy(cursor, &c->runs[i].start, sizeof(uint32_t));
+            memcpy(cursor + sizeof(uint32_t), &c->runs[i].count, sizeof(uint32_t));
+            cursor += 2 * sizeof(uint32_t);
+            *cursor++ = c->runs[i].color;
+        }
+    }
+    return cursor;
+}
+
+static bool _transaction_colors_unpack(TransactionColors *c,
+                                       const bool runs,
+                                       const size_t volume,
+                                       const uint8_t **cursor) {
+    if (runs == false) {
+        c->dense = (SHAPE_COLOR_INDEX_INT_T *)malloc(volume);
+        if (c->dense == NULL) {
+            return false;
+        }
+        memcpy(c->dense, *cursor, volume);
+        *cursor += volume;
+        return true;
+    }
+
+    uint32_t nbRuns;
+    memcpy(&nbRuns, *cursor, sizeof(uint32_t));
+    *cursor += sizeof(uint32_t);
+    c->runsCapacity = nbRuns > 0 ? nbRuns : 1;
+    c->runs = (TransactionRun *)malloc(c->runsCapacity * sizeof(TransactionRun));
+    if (c->runs == NULL) {
+        c->runsCapacity = 0;
+        return false;
+    }
+    for (uint32_t i = 0; i < nbRuns; ++i) {
+        TransactionRun *run = &c->runs[i];
+        memcpy(&run->start, *cursor, sizeof(uint32_t));
+        memcpy(&run->count, *cursor + sizeof(uint32_t), sizeof(uint32_t));
+        *cursor += 2 * sizeof(uint32_t);
+        run->color = *(*cursor)++;
+    }
+    c->nbRuns = nbRuns;
+    return true;
+}
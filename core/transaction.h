@@ -6,6 +6,8 @@
 
 #pragma once
 
+#include <stddef.h>
+
 #include "colors.h"
 
 typedef struct _Block Block;
@@ -13,6 +15,36 @@ typedef struct _Index3D Index3D;
 typedef struct _Index3DIterator Index3DIterator;
 typedef struct _Transaction Transaction;
 
+/// Consecutive blocks of a region sharing the same color, `start` being the index of the first one
+typedef struct {
+    uint32_t start; /* 4 bytes */
+    uint32_t count; /* 4 bytes */
+    SHAPE_COLOR_INDEX_INT_T color; /* 1 byte */
+    char pad[3];
+} TransactionRun;
+
+/// Colors of a region's blocks, indexed x-major then y then z. Regions of up to
+/// TRANSACTION_REGION_DENSE_MAX_VOLUME blocks use a `dense` array with one entry per block,
+/// bigger ones only store `runs` of listed blocks, sorted by start, other blocks being unlisted.
+typedef struct {
+    SHAPE_COLOR_INDEX_INT_T *dense;
+    TransactionRun *runs;
+    uint32_t nbRuns;
+    uint32_t runsCapacity;
+} TransactionColors;
+
+/// Volume change recorded by shape volume operations (see shape_fill_box), min is inclusive and
+/// max exclusive. When `after` isn't set, the whole box is set to `fill`, otherwise air or
+/// unlisted entries leave blocks unchanged. `before` is filled when the change is applied, with
+/// the previous colors of the changed blocks only when stored as runs, and used to undo it.
+typedef struct {
+    TransactionColors after;
+    TransactionColors before;
+    SHAPE_COORDS_INT3_T min, max; /* 2 x 6 bytes */
+    SHAPE_COLOR_INDEX_INT_T fill; /* 1 byte */
+    char pad[3];
+} TransactionRegion;
+
 ///
 Transaction *transaction_new(void);
 
@@ -47,6 +79,42 @@ void transaction_replaceBlock(const Transaction *const tr,
                               const SHAPE_COORDS_INT_T z,
                               const SHAPE_COLOR_INDEX_INT_T colorIndex);
 
+/// Records a volume change, the transaction takes ownership of `after` (which can be NULL)
+bool transaction_addRegion(Transaction *const tr,
+                           const SHAPE_COORDS_INT3_T min,
+                           const SHAPE_COORDS_INT3_T max,
+                           TransactionColors *after,
+                           const SHAPE_COLOR_INDEX_INT_T fill);
+
+/// Volume changes are applied after block changes, in the order they were added
+uint32_t transaction_getRegionCount(const Transaction *const tr);
+TransactionRegion *transaction_getRegion(Transaction *const tr, const uint32_t i);
+
+/// Prepares empty colors for a region of `volume` blocks, returns false if allocation failed
+bool transaction_colors_init(TransactionColors *c, const size_t volume);
+
+/// Frees colors content, leaving them unset
+void transaction_colors_free(TransactionColors *c);
+
+/// Colors are set once initialized, and until freed
+bool transaction_colors_is_set(const TransactionColors *c);
+
+/// Lists block `i` with given color. Runs can be appended in any order as long as they don't
+/// overlap, but transaction_colors_seal must be called before reading them back
+bool transaction_colors_set(TransactionColors *c,
+                            const uint32_t i,
+                            const SHAPE_COLOR_INDEX_INT_T color);
+
+/// Sorts & merges runs
+void transaction_colors_seal(TransactionColors *c);
+
+/// Looks up color of block `i`, returns false if unlisted. `hint` (initialized to 0) speeds up
+/// successive lookups of increasing indices
+bool transaction_colors_get(const TransactionColors *c,
+                            const uint32_t i,
+                            uint32_t *hint,
+                            SHAPE_COLOR_INDEX_INT_T *color);
+
 /// Returns iterator at current position
 /// Creating a new one if needed, starting at first operation.
 /// The iterator is freed with its transaction.
@@ -55,3 +123,11 @@ Index3DIterator *transaction_getIndex3DIterator(Transaction *const tr);
 
 /// Resets transaction's Index3DIterator
 void transaction_resetIndex3DIterator(Transaction *const tr);
+
+/// Packs an applied transaction into a compressed buffer, for long term storage in history.
+/// Block changes are stored as a sorted array of delta-encoded Morton coordinates, w/ previous and
+/// new colors, followed by volume changes. Returns NULL on failure, `size` receives buffer size.
+void *transaction_pack(Transaction *const tr, uint32_t *size);
+
+/// Creates a transaction from a packed buffer, previous colors included so that it can be undone
+Transaction *transaction_new_from_packed(const void *data, const uint32_t size);
@@ -14,7 +14,7 @@
 
 #include "cclog.h"
 #include "config.h"
-#include "filo_list_uint16.h"
+#include "filo_list_uint32.h"
 #include "mutex.h"
 #include "quad.h"
 #include "scene.h"
@@ -54,6 +54,13 @@
 #define TRANSFORM_FLAG_DISPLAY_BOX 64
 #define TRANSFORM_FLAG_PRIVATE 128
 
+// handles are made of the transform ID (slot index) in low 22 bits and its generation in high
+// 10 bits, an ID reaching the max generation is retired instead of wrapping back to 1
+#define TRANSFORM_HANDLE_ID_BITS 22
+#define TRANSFORM_HANDLE_ID_MASK 0x003FFFFFu
+#define TRANSFORM_HANDLE_GENERATION_MAX 0x3FFu
+#define TRANSFORM_SLOTS_INITIAL_CAPACITY 1024
+
 #if DEBUG_TRANSFORM
 static int debug_transform_refresh_calls = 0;
 #endif
@@ -102,30 +109,42 @@ struct _Transform {
 
     float shadowDecalSize; /* 4 bytes */
 
+    // slot index, recycled when the transform is freed, see TransformHandle
+    uint32_t id; /* 4 bytes */
+
     // Transforms are managed with reference counting.
     uint16_t refCount; /* 2 bytes */
 
-    uint16_t id; /* 2 bytes */
-
     // dirty flag per transformation type, use the TRANSFORM_* defines
     // GET a dirty transformation will refresh what is necessary to compute it
     uint8_t dirty; /* 1 byte */
 
     uint8_t flags; /* 1 byte */
 
-    char pad[6];
+    // ID along with its slot generation, constant while the transform is alive
+    TransformHandle handle; /* 4 bytes */
 };
 
+// slot table, indexed by transform ID, generation is increased when the transform is freed
+typedef struct {
+    Transform *transform;
+    uint32_t generation;
+    char pad[4];
+} TransformSlot;
+
 static Mutex *_IDMutex = NULL;
-static uint16_t _nextID = 1;
-static FiloListUInt16 *_availableIDs = NULL;
+static uint32_t _nextID = 1;
+static FiloListUInt32 *_availableIDs = NULL;
+static TransformSlot *_slots = NULL;
+static uint32_t _slotsCapacity = 0;
 
 static pointer_transform_destroyed_func transform_destroyed_callback = NULL;
 
 // MARK: - Private functions' prototypes -
 
-static uint16_t _transform_get_valid_id(void);
-static void _transform_recycle_id(const uint16_t id);
+static bool _transform_get_valid_id(Transform *t);
+static void _transform_recycle_id(const uint32_t id);
+static void _transform_release_slot(const uint32_t id);
 static void _transform_set_dirty(Transform *const t, const uint8_t flag, bool keepCache);
 static void _transform_reset_dirty(Transform *const t, const uint8_t flag);
 static bool _transform_get_dirty(Transform *const t, const uint8_t flag);
@@ -180,7 +199,11 @@ Transform *transform_new(TransformType type) {
         return NULL;
     }
 
-    t->id = _transform_get_valid_id();
+    if (_transform_get_valid_id(t) == false) {
+        cclog_error("transform: can't get a valid ID");
+        free(t);
+        return NULL;
+    }
     t->refCount = 1;
     t->ltw = matrix4x4_new_identity();
     t->wtl = matrix4x4_new_identity();
@@ -266,10 +289,30 @@ void transform_init_ID_thread_safety(void) {
     }
 }
 
-uint16_t transform_get_id(const Transform *t) {
+uint32_t transform_get_id(const Transform *t) {
     return t->id;
 }
 
+TransformHandle transform_get_handle(const Transform *t) {
+    return t->handle;
+}
+
+Transform *transform_get_from_handle(const TransformHandle h) {
+    const uint32_t id = h & TRANSFORM_HANDLE_ID_MASK;
+    const uint32_t generation = h >> TRANSFORM_HANDLE_ID_BITS;
+    Transform *t = NULL;
+    mutex_lock(_IDMutex);
+    if (id < _slotsCapacity && _slots[id].generation == generation) {
+        t = _slots[id].transform;
+    }
+    mutex_unlock(_IDMutex);
+    return t;
+}
+
+bool transform_handle_is_valid(const TransformHandle h) {
+    return transform_get_from_handle(h) != NULL;
+}
+
 bool transform_retain(Transform *const t) {
     if (t->refCount < UINT16_MAX) {
         ++(t->refCount);
@@ -1349,7 +1392,7 @@ void transform_set_shadow_decal(Transform *t, float size) {
     t->shadowDecalSize = size;
 }
 
-void transform_recycle_id(const uint16_t id) {
+void transform_recycle_id(const uint32_t id) {
     // NOTE: We could probably expose a version that doesn't use the mutex lock
     // for managers that recycle IDs while clearly accounting for thread context.
     _transform_recycle_id(id);
@@ -1357,23 +1400,61 @@ void transform_recycle_id(const uint16_t id) {
 
 // MARK: - Private functions -
 
-static uint16_t _transform_get_valid_id(void) {
-    uint16_t resultId = 0;
+/// Assigns an ID and its slot to given transform, returns false if IDs are exhausted
+static bool _transform_get_valid_id(Transform *t) {
+    uint32_t resultId = 0;
     mutex_lock(_IDMutex);
-    if (_availableIDs == NULL || filo_list_uint16_pop(_availableIDs, &resultId) == false) {
+    if (_availableIDs == NULL || filo_list_uint32_pop(_availableIDs, &resultId) == false) {
+        if (_nextID > TRANSFORM_HANDLE_ID_MASK) {
+            mutex_unlock(_IDMutex);
+            return false;
+        }
+        if (_nextID >= _slotsCapacity) {
+            const uint32_t capacity = _slotsCapacity > 0 ? _slotsCapacity * 2
+                                                         : TRANSFORM_SLOTS_INITIAL_CAPACITY;
+            TransformSlot *slots = (TransformSlot *)realloc(_slots,
+                                                            sizeof(TransformSlot) * capacity);
+            if (slots == NULL) {
+                mutex_unlock(_IDMutex);
+                return false;
+            }
+            for (uint32_t i = _slotsCapacity; i < capacity; ++i) {
+                slots[i].transform = NULL;
+                slots[i].generation = 1;
+            }
+            _slots = slots;
+            _slotsCapacity = capacity;
+        }
         resultId = _nextID;
         _nextID += 1;
     }
+    _slots[resultId].transform = t;
+    t->id = resultId;
+    t->handle = (_slots[resultId].generation << TRANSFORM_HANDLE_ID_BITS) | resultId;
     mutex_unlock(_IDMutex);
-    return resultId;
+    return true;
 }
 
-static void _transform_recycle_id(const uint16_t id) {
+static void _transform_recycle_id(const uint32_t id) {
     mutex_lock(_IDMutex);
+    // retired ID, see _transform_release_slot
+    if (id < _slotsCapacity && _slots[id].generation == TRANSFORM_HANDLE_GENERATION_MAX) {
+        mutex_unlock(_IDMutex);
+        return;
+    }
     if (_availableIDs == NULL) {
-        _availableIDs = filo_list_uint16_new();
+        _availableIDs = filo_list_uint32_new();
     }
-    filo_list_uint16_push(_availableIDs, id);
+    filo_list_uint32_push(_availableIDs, id);
+    mutex_unlock(_IDMutex);
+}
+
+/// Invalidates all handles to the transform using this slot, the ID itself is recycled separately.
+/// Once the max generation is reached, the ID is never recycled
+static void _transform_release_slot(const uint32_t id) {
+    mutex_lock(_IDMutex);
+    _slots[id].transform = NULL;
+    _slots[id].generation += 1;
     mutex_unlock(_IDMutex);
 }
 
@@ -1794,6 +1875,8 @@ static void _transform_free(Transform *const t) {
         return;
     }
 
+    _transform_release_slot(t->id);
+
     if (t->managed != NULL && transform_destroyed_callback != NULL) {
         transform_destroyed_callback(t->id, t->managed);
     } else {
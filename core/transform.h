@@ -73,16 +73,28 @@ typedef enum {
 
 typedef bool (*pointer_transform_recurse_func)(Transform *t, void *ptr);
 typedef bool (*pointer_transform_recurse_depth_func)(Transform *t, void *ptr, uint32_t depth);
-typedef void (*pointer_transform_destroyed_func)(const uint16_t id, void *managed);
+typedef void (*pointer_transform_destroyed_func)(const uint32_t id, void *managed);
 typedef Transform **Transform_Array;
 
+/// Generational handle to a transform: its ID (22 bits) along with a generation (10 bits) increased
+/// each time the ID is freed. An ID is retired once its generation is maxed out, so stale handles
+/// never alias a transform reusing the same ID.
+typedef uint32_t TransformHandle;
+#define TRANSFORM_HANDLE_NONE 0
+
 /// MARK: - Lifecycle -
 Transform *transform_new(TransformType type);
 Transform *transform_new_with_ptr(TransformType type, void *ptr, pointer_free_function ptrFreeFn);
 Transform *transform_new_copy(const Transform *t);
 void transform_copy(Transform *dst, const Transform *src);
 void transform_init_ID_thread_safety(void);
-uint16_t transform_get_id(const Transform *t);
+uint32_t transform_get_id(const Transform *t);
+TransformHandle transform_get_handle(const Transform *t);
+/// Returns NULL if the transform has been freed. Resolving a handle takes the ID mutex once
+/// transform_init_ID_thread_safety was called, keep the pointer rather than resolving a handle in
+/// hot loops
+Transform *transform_get_from_handle(const TransformHandle h);
+bool transform_handle_is_valid(const TransformHandle h);
 /// Increases ref count and returns false if the retain count can't be increased
 bool transform_retain(Transform *const t);
 uint16_t transform_retain_count(const Transform *const t);
@@ -249,7 +261,7 @@ void transform_set_animations_enabled(Transform *const t, const bool enabled);
 bool transform_is_animations_enabled(Transform *const t);
 float transform_get_shadow_decal(Transform *t);
 void transform_set_shadow_decal(Transform *t, float size);
-void transform_recycle_id(const uint16_t id);
+void transform_recycle_id(const uint32_t id);
 
 /// MARK: - Debug -
 #if DEBUG_TRANSFORM
@@ -24,6 +24,9 @@
 // takes the 4 low bits of a and casts into uint8_t
 #define TO_UINT4(a) (uint8_t)((a) & 0x0F)
 
+// write slices closer than this amount of vertices are merged
+#define DRAWBUFFER_SLICE_MERGE_DISTANCE (16 * DRAWBUFFER_VERTICES_PER_FACE)
+
 // Vertex buffers are used from outside Cubzh Core
 // when implementing renderers (like Swift/Metal renderer)
 // Giving each vertex buffer a proper ID is useful to know when
@@ -50,7 +53,7 @@ bool vertex_buffer_pop_destroyed_id(uint32_t *id) {
 
 struct _VertexBufferMemArea {
     // where to start writing bytes
-    VertexAttributes *start; /* 8 bytes */
+    void *start; /* 8 bytes */
 
     // vertex buffer that owns the mem area
     VertexBuffer *vb; /* 8 bytes */
@@ -76,12 +79,15 @@ struct _VertexBufferMemArea {
     // Dirty vbma will be re-uploaded next render
     bool dirty; /* 1 byte */
 
+    // gap vertices have been cleared, it can be drawn safely until filled
+    bool cleared; /* 1 byte */
+
     // padding
-    char pad[7];
+    char pad[6];
 };
 
 VertexBufferMemArea *vertex_buffer_mem_area_new(VertexBuffer *vb,
-                                                VertexAttributes *start,
+                                                void *start,
                                                 uint32_t startIdx,
                                                 uint32_t count);
 void vertex_buffer_mem_area_free_all(VertexBufferMemArea *front);
@@ -101,11 +107,19 @@ bool vertex_buffer_mem_area_insert_after(VertexBufferMemArea *vbma1,
 void vertex_buffer_mem_area_leave_group_list(VertexBufferMemArea *vbma, bool transparent);
 void vertex_buffer_mem_area_leave_global_list(VertexBufferMemArea *vbma);
 
-void _vertex_buffer_memcpy(VertexAttributes *dst,
-                           VertexAttributes *src,
+void _vertex_buffer_memcpy(const VertexBuffer *vb,
+                           void *dst,
+                           void *src,
                            size_t count,
                            size_t offset);
-VertexAttributes *_vertex_buffer_data_add_ptr(VertexAttributes *ptr, size_t count);
+/// makes sure the writer has room for one more face, moving to another mem area if needed
+bool _vertex_buffer_mem_area_writer_reserve_face(VertexBufferMemAreaWriter *vbmaw);
+void *_vertex_buffer_data_add_ptr(const VertexBuffer *vb, void *ptr, size_t count);
+void _vertex_buffer_clear_remaining_gaps(VertexBuffer *vb);
+void _vertex_buffer_store_vertex(const VertexBuffer *vb,
+                                 void *dst,
+                                 size_t idx,
+                                 const VertexAttributes *v);
 
 // debug
 #if VERTEX_BUFFER_DEBUG == 1
@@ -119,7 +133,8 @@ void vertex_buffer_check_mem_area_chain(VertexBuffer *vb);
 // Only one buffer will be allocated for a small shape, but bigger ones
 // may need more, there will be one draw call per buffer
 struct _VertexBuffer {
-    VertexAttributes *data; /* 8 bytes */
+    // vertices, laid out according to format
+    void *data; /* 8 bytes */
     // draw write slices define data index ranges that need re-upload after a structural change
     // populated when updating chunks during shape_refresh_vertices()
     // flushed by renderer calling vertex_buffer_flush_draw_slices() after re-upload
@@ -150,7 +165,8 @@ struct _VertexBuffer {
 
     bool isTransparent; /* 1 byte */
 
-    char pad[1];
+    // VertexFormat
+    uint8_t format; /* 1 byte */
 };
 
 // vb optionally writes lighting data
@@ -252,6 +268,10 @@ VertexBuffer *vertex_buffer_new(bool transparent) {
 }
 
 VertexBuffer *vertex_buffer_new_with_max_count(uint32_t n, bool transparent) {
+    return vertex_buffer_new_with_format(n, transparent, VertexFormatDefault);
+}
+
+VertexBuffer *vertex_buffer_new_with_format(uint32_t n, bool transparent, VertexFormat format) {
     VertexBuffer *vb = (VertexBuffer *)malloc(sizeof(VertexBuffer));
     if (vb == NULL) {
         return NULL;
@@ -273,7 +293,8 @@ VertexBuffer *vertex_buffer_new_with_max_count(uint32_t n, bool transparent) {
     vb->next = NULL;
 
     // container for draw buffers pointer
-    vb->data = (VertexAttributes *)malloc(n * DRAWBUFFER_VERTICES_BYTES);
+    vb->format = (uint8_t)format;
+    vb->data = malloc(n * vertex_buffer_get_vertex_size(vb));
 
     vb->drawSlices = doubly_linked_list_new();
     vb->nbDrawSlices = 0;
@@ -351,10 +372,41 @@ uint32_t vertex_buffer_get_id(const VertexBuffer *vb) {
     return vb->id;
 }
 
-VertexAttributes *vertex_buffer_get_draw_buffer(const VertexBuffer *vb) {
+void *vertex_buffer_get_draw_buffer(const VertexBuffer *vb) {
     return vb->data;
 }
 
+VertexFormat vertex_buffer_get_format(const VertexBuffer *vb) {
+    return (VertexFormat)vb->format;
+}
+
+size_t vertex_buffer_get_vertex_size(const VertexBuffer *vb) {
+    return vb->format == VertexFormatCompact ? DRAWBUFFER_VERTICES_COMPACT_BYTES
+                                             : DRAWBUFFER_VERTICES_BYTES;
+}
+
+void vertex_buffer_read_vertices(const VertexBuffer *vb,
+                                 uint32_t startIdx,
+                                 uint32_t count,
+                                 VertexAttributes *out) {
+    if (vb->format == VertexFormatCompact) {
+        const VertexAttributesCompact *v = (const VertexAttributesCompact *)vb->data + startIdx;
+        for (uint32_t i = 0; i < count; ++i, ++v) {
+            const uint32_t color = v->color +
+                                   ((v->metadata >> VERTEX_COMPACT_COLOR_HIGH_BIT_SHIFT) << 16);
+            out[i] = (VertexAttributes){(float)v->x,
+                                        (float)v->y,
+                                        (float)v->z,
+                                        (float)color,
+                                        (float)(v->metadata & VERTEX_COMPACT_METADATA_MASK)};
+        }
+    } else {
+        memcpy(out,
+               (const VertexAttributes *)vb->data + startIdx,
+               count * DRAWBUFFER_VERTICES_BYTES);
+    }
+}
+
 DoublyLinkedList *vertex_buffer_get_draw_slices(const VertexBuffer *vb) {
     return vb->drawSlices;
 }
@@ -380,36 +432,30 @@ void vertex_buffer_add_draw_slice(VertexBuffer *vb, uint32_t start, uint32_t cou
     }
     DrawBufferWriteSlice value = {start, start + count - 1};
 
-    DrawBufferWriteSlice *leftMerged = NULL, *rightMerged = NULL;
-    DoublyLinkedListNode *rightMergedNode = NULL;
+    // absorb all slices overlapping or close enough, re-uploading a few clean vertices is cheaper
+    // than an additional upload
     DoublyLinkedListNode *itr = doubly_linked_list_first(vb->drawSlices);
+    DoublyLinkedListNode *next;
     DrawBufferWriteSlice *ws;
     while (itr != NULL) {
         ws = (DrawBufferWriteSlice *)doubly_linked_list_node_pointer(itr);
-        if (value.from == ws->to + 1) {
-            ws->to = value.to;
-            leftMerged = ws;
-        } else if (value.to == ws->from - 1) {
-            ws->from = value.from;
-            rightMerged = ws;
-            rightMergedNode = itr;
+        next = doubly_linked_list_node_next(itr);
+        if (ws->from <= value.to + DRAWBUFFER_SLICE_MERGE_DISTANCE + 1 &&
+            value.from <= ws->to + DRAWBUFFER_SLICE_MERGE_DISTANCE + 1) {
+            value.from = minimum(value.from, ws->from);
+            value.to = maximum(value.to, ws->to);
+            doubly_linked_list_delete_node(vb->drawSlices, itr);
+            free(ws);
+            vb->nbDrawSlices--;
         }
-        itr = doubly_linked_list_node_next(itr);
+        itr = next;
     }
-    // reduce if merged right & left, or insert if not merged at all
-    if (leftMerged != NULL && rightMerged != NULL) {
-        leftMerged->to = rightMerged->to;
-        doubly_linked_list_delete_node(vb->drawSlices, rightMergedNode);
-        free(rightMerged);
-        vb->nbDrawSlices--;
-    } else if (leftMerged == NULL && rightMerged == NULL) {
-        DrawBufferWriteSlice *node = (DrawBufferWriteSlice *)malloc(sizeof(DrawBufferWriteSlice));
-        if (node != NULL) {
-            node->from = value.from;
-            node->to = value.to;
-            doubly_linked_list_push_last(vb->drawSlices, node);
-            vb->nbDrawSlices++;
-        }
+
+    DrawBufferWriteSlice *node = (DrawBufferWriteSlice *)malloc(sizeof(DrawBufferWriteSlice));
+    if (node != NULL) {
+        *node = value;
+        doubly_linked_list_push_last(vb->drawSlices, node);
+        vb->nbDrawSlices++;
     }
 }
 
@@ -418,7 +464,8 @@ void vertex_buffer_fill_draw_slices(VertexBuffer *vb) {
     uint32_t idx = 0;
     while (vbma != NULL) {
         if (vbma->dirty) {
-            if (vertex_buffer_mem_area_is_gap(vbma) == false) {
+            // a dirty gap is a gap that was just cleared
+            if (vbma->count > 0) {
                 vertex_buffer_add_draw_slice(vb, idx, vbma->count);
             }
             vbma->dirty = false;
@@ -469,12 +516,19 @@ void vertex_buffer_remove_last_mem_area(VertexBuffer *vb) {
 
 // reorganizes data to fill the gaps
 void vertex_buffer_fill_gaps(VertexBuffer *vb) {
+    vertex_buffer_fill_gaps_incremental(vb, UINT32_MAX);
+}
+
+uint32_t vertex_buffer_fill_gaps_incremental(VertexBuffer *vb, uint32_t maxVertices) {
 #if VERTEX_BUFFER_DEBUG == 1
     vertex_buffer_check_mem_area_chain(vb);
 #endif
 
-    // no gap remaining at the end of this function
+    // no gap remaining at the end of this function, unless running out of budget
     vb->firstMemAreaGap = NULL;
+    vb->lastMemAreaGap = NULL;
+
+    uint32_t moved = 0;
 
     // here we know there are gaps, and none of them is at the end
     // of global mem area list
@@ -542,6 +596,9 @@ void vertex_buffer_fill_gaps(VertexBuffer *vb) {
             // vbma that will be destroyed
             vbma = cursor->_globalListNext;
             cursor->count += vbma->count; // can be 0
+            if (vbma->count > 0) {
+                cursor->cleared = cursor->cleared && vbma->cleared;
+            }
 
 #if VERTEX_BUFFER_DEBUG == 1
             if (cursor->_globalListNext->_globalListPrevious != cursor) {
@@ -594,6 +651,11 @@ void vertex_buffer_fill_gaps(VertexBuffer *vb) {
             break; // breaks main loop
         }
 
+        // gap is left for next call, gaps are merged beforehand so it remains in one piece
+        if (moved >= maxVertices) {
+            break;
+        }
+
         uint32_t written = 0;
 
         // loop until gap is filled with vertices
@@ -648,46 +710,75 @@ void vertex_buffer_fill_gaps(VertexBuffer *vb) {
                 }
                 break;
             }
-            // 2) rightVbma has exact amount of vertices:
+            // 2) not enough budget left to fill the gap or empty last vbma:
+            // -> memcpy what the budget allows from the end of last vbma, split both
+            // -> BREAK, end of the gap is left for next call
+            else if (maxVertices - moved < cursor->count &&
+                     maxVertices - moved < vb->lastMemArea->count) {
+                const uint32_t count = maxVertices - moved;
+                const uint32_t diff = vb->lastMemArea->count - count;
+
+                _vertex_buffer_memcpy(vb, cursor->start, vb->lastMemArea->start, count, diff);
+                cursor->dirty = true;
+
+                written += count;
+                moved += count;
+
+                vertex_buffer_mem_area_split_and_make_gap(cursor, written);
+                vertex_buffer_mem_area_split_and_make_gap(vb->lastMemArea, diff);
+
+                vertex_buffer_remove_last_mem_area(vb);
+                break;
+            }
+            // 3) rightVbma has exact amount of vertices:
             // -> memcpy all, remove last vbma
             // -> LOOP WILL EXIT
             else if (cursor->count == vb->lastMemArea->count) {
-                _vertex_buffer_memcpy(cursor->start,
+                _vertex_buffer_memcpy(vb,
+                                      cursor->start,
                                       vb->lastMemArea->start,
                                       vb->lastMemArea->count,
                                       0);
                 cursor->dirty = true;
 
                 written += vb->lastMemArea->count;
+                moved += vb->lastMemArea->count;
 
                 vertex_buffer_remove_last_mem_area(vb);
                 continue;
             }
-            // 3) last vbma has enough vertices:
+            // 4) last vbma has enough vertices:
             // -> memcpy end of rightVbma, split, remove last part
             // -> LOOP WILL EXIT
             else if (cursor->count < vb->lastMemArea->count) {
                 uint32_t diff = vb->lastMemArea->count - cursor->count;
 
-                _vertex_buffer_memcpy(cursor->start, vb->lastMemArea->start, cursor->count, diff);
+                _vertex_buffer_memcpy(vb,
+                                      cursor->start,
+                                      vb->lastMemArea->start,
+                                      cursor->count,
+                                      diff);
                 cursor->dirty = true;
 
                 written += cursor->count;
+                moved += cursor->count;
 
                 vertex_buffer_mem_area_split_and_make_gap(vb->lastMemArea, diff);
 
                 vertex_buffer_remove_last_mem_area(vb);
             }
-            // 4) last vbma has not enough vertices:
+            // 5) last vbma has not enough vertices:
             // -> memcpy all, split gap, remove last vbma
             else {
-                _vertex_buffer_memcpy(cursor->start,
+                _vertex_buffer_memcpy(vb,
+                                      cursor->start,
                                       vb->lastMemArea->start,
                                       vb->lastMemArea->count,
                                       0);
                 cursor->dirty = true;
 
                 written += vb->lastMemArea->count;
+                moved += vb->lastMemArea->count;
 
                 vertex_buffer_mem_area_split_and_make_gap(cursor, written);
 
@@ -704,25 +795,78 @@ void vertex_buffer_fill_gaps(VertexBuffer *vb) {
         cursor = cursor->_globalListNext;
 
     } // end of main loop: while (cursor != NULL)
+
+    // gaps may remain when out of budget, or when a gap had to be skipped
+    _vertex_buffer_clear_remaining_gaps(vb);
+
 #if VERTEX_BUFFER_DEBUG == 1
     vertex_buffer_check_mem_area_chain(vb);
 #endif
+
+    return moved;
+}
+
+// enlists remaining gaps again and clears their vertices, for them to be drawn as degenerate
+// triangles until filled
+void _vertex_buffer_clear_remaining_gaps(VertexBuffer *vb) {
+    vb->firstMemAreaGap = NULL;
+    vb->lastMemAreaGap = NULL;
+
+    VertexBufferMemArea *vbma = vb->firstMemArea;
+    while (vbma != NULL) {
+        if (vertex_buffer_mem_area_is_gap(vbma)) {
+            vbma->_groupListNext = NULL;
+            vbma->_groupListPrevious = vb->lastMemAreaGap;
+            if (vb->lastMemAreaGap != NULL) {
+                vb->lastMemAreaGap->_groupListNext = vbma;
+            } else {
+                vb->firstMemAreaGap = vbma;
+            }
+            vb->lastMemAreaGap = vbma;
+
+            if (vbma->cleared == false && vbma->count > 0) {
+                memset(vbma->start, 0, vbma->count * vertex_buffer_get_vertex_size(vb));
+                vbma->cleared = true;
+                vbma->dirty = true;
+            }
+        }
+        vbma = vbma->_globalListNext;
+    }
 }
 
 //---------------------
 // MARK: Draw buffers
 //---------------------
 
-void _vertex_buffer_memcpy(VertexAttributes *dst,
-                           VertexAttributes *src,
+void _vertex_buffer_memcpy(const VertexBuffer *vb,
+                           void *dst,
+                           void *src,
                            size_t count,
                            size_t offset) {
-    memcpy(dst, src + offset, count * DRAWBUFFER_VERTICES_BYTES);
+    memcpy(dst,
+           _vertex_buffer_data_add_ptr(vb, src, offset),
+           count * vertex_buffer_get_vertex_size(vb));
 }
 
-VertexAttributes *_vertex_buffer_data_add_ptr(VertexAttributes *ptr, size_t count) {
-    ptr += count;
-    return ptr;
+void *_vertex_buffer_data_add_ptr(const VertexBuffer *vb, void *ptr, size_t count) {
+    return (uint8_t *)ptr + count * vertex_buffer_get_vertex_size(vb);
+}
+
+void _vertex_buffer_store_vertex(const VertexBuffer *vb,
+                                 void *dst,
+                                 size_t idx,
+                                 const VertexAttributes *v) {
+    if (vb->format == VertexFormatCompact) {
+        const uint32_t color = (uint32_t)v->color;
+        ((VertexAttributesCompact *)dst)[idx] = (VertexAttributesCompact){
+            (int16_t)v->x,
+            (int16_t)v->y,
+            (int16_t)v->z,
+            (uint16_t)(color & 0xFFFF),
+            (uint32_t)v->metadata | ((color >> 16) << VERTEX_COMPACT_COLOR_HIGH_BIT_SHIFT)};
+    } else {
+        ((VertexAttributes *)dst)[idx] = *v;
+    }
 }
 
 //---------------------
@@ -739,7 +883,7 @@ bool vertex_buffer_mem_area_is_null_or_empty(const VertexBufferMemArea *vbma) {
 
 // creates new VertexBufferMemArea
 VertexBufferMemArea *vertex_buffer_mem_area_new(VertexBuffer *vb,
-                                                VertexAttributes *start,
+                                                void *start,
                                                 uint32_t startIdx,
                                                 uint32_t count) {
     VertexBufferMemArea *vbma = (VertexBufferMemArea *)malloc(sizeof(VertexBufferMemArea));
@@ -756,6 +900,7 @@ VertexBufferMemArea *vertex_buffer_mem_area_new(VertexBuffer *vb,
     vbma->count = count;
     vbma->start = start;
     vbma->dirty = false;
+    vbma->cleared = false;
     return vbma;
 }
 
@@ -829,11 +974,11 @@ void vertex_buffer_mem_area_leave_global_list(VertexBufferMemArea *vbma) {
 // vertices. This one would then become useless, empty forever until it
 // finally/eventually gets merged with another gap.
 void vertex_buffer_new_empty_gap_at_end(VertexBuffer *vb) {
-    VertexAttributes *start;
+    void *start;
     uint32_t startdIdx;
 
     if (vb->lastMemArea != NULL) {
-        start = _vertex_buffer_data_add_ptr(vb->lastMemArea->start, vb->lastMemArea->count);
+        start = _vertex_buffer_data_add_ptr(vb, vb->lastMemArea->start, vb->lastMemArea->count);
         startdIdx = vb->lastMemArea->startIdx + vb->lastMemArea->count;
     } else {
         // no lastMemArea means no mem area at all
@@ -933,7 +1078,7 @@ bool vertex_buffer_mem_area_insert_after(VertexBufferMemArea *vbma1,
 // - occasionally, a new vb can be created for the shape if it is at full capacity,
 // this is because vb capacity vs. chunk size can be set independently
 struct _VertexBufferMemAreaWriter {
-    VertexAttributes *cursor;  /* 8 bytes */
+    void *cursor;              /* 8 bytes */
     Shape *s;                  /* 8 bytes */
     Chunk *c;                  /* 8 bytes */
     VertexBufferMemArea *vbma; /* 8 bytes */
@@ -955,19 +1100,7 @@ void vertex_buffer_mem_area_writer_reset(VertexBufferMemAreaWriter *vbmaw,
     vbmaw->writtenCount = 0;
 }
 
-void vertex_buffer_mem_area_writer_write(VertexBufferMemAreaWriter *vbmaw,
-                                         float x,
-                                         float y,
-                                         float z,
-                                         ATLAS_COLOR_INDEX_INT_T color,
-                                         FACE_INDEX_INT_T faceIndex,
-                                         FACE_AMBIENT_OCCLUSION_STRUCT_T ao,
-                                         bool vLighting,
-                                         VERTEX_LIGHT_STRUCT_T vlight1,
-                                         VERTEX_LIGHT_STRUCT_T vlight2,
-                                         VERTEX_LIGHT_STRUCT_T vlight3,
-                                         VERTEX_LIGHT_STRUCT_T vlight4) {
-
+bool _vertex_buffer_mem_area_writer_reserve_face(VertexBufferMemAreaWriter *vbmaw) {
     // check if no vbma assigned or the end of the memory area has been reached
     if (vbmaw->vbma == NULL || vbmaw->writtenCount == vbmaw->vbma->count) {
         while (true) {
@@ -1059,6 +1192,25 @@ void vertex_buffer_mem_area_writer_write(VertexBufferMemAreaWriter *vbmaw,
 
     if (vbmaw->vbma == NULL) {
         cclog_error("⚠️⚠️⚠️ vertex_buffer_mem_area_writer_write: writer has no vbma");
+        return false;
+    }
+    return true;
+}
+
+void vertex_buffer_mem_area_writer_write(VertexBufferMemAreaWriter *vbmaw,
+                                         float x,
+                                         float y,
+                                         float z,
+                                         ATLAS_COLOR_INDEX_INT_T color,
+                                         FACE_INDEX_INT_T faceIndex,
+                                         FACE_AMBIENT_OCCLUSION_STRUCT_T ao,
+                                         bool vLighting,
+                                         VERTEX_LIGHT_STRUCT_T vlight1,
+                                         VERTEX_LIGHT_STRUCT_T vlight2,
+                                         VERTEX_LIGHT_STRUCT_T vlight3,
+                                         VERTEX_LIGHT_STRUCT_T vlight4) {
+
+    if (_vertex_buffer_mem_area_writer_reserve_face(vbmaw) == false) {
         return;
     }
 
@@ -1206,16 +1358,34 @@ void vertex_buffer_mem_area_writer_write(VertexBufferMemAreaWriter *vbmaw,
             break;
         }
     }
+    const VertexBuffer *vb = vbmaw->vbma->vb;
     if (aoShift) {
-        vbmaw->cursor[vbma_idxVertices] = v1;
-        vbmaw->cursor[vbma_idxVertices + 1] = v2;
-        vbmaw->cursor[vbma_idxVertices + 2] = v3;
-        vbmaw->cursor[vbma_idxVertices + 3] = v4;
+        _vertex_buffer_store_vertex(vb, vbmaw->cursor, vbma_idxVertices, &v1);
+        _vertex_buffer_store_vertex(vb, vbmaw->cursor, vbma_idxVertices + 1, &v2);
+        _vertex_buffer_store_vertex(vb, vbmaw->cursor, vbma_idxVertices + 2, &v3);
+        _vertex_buffer_store_vertex(vb, vbmaw->cursor, vbma_idxVertices + 3, &v4);
     } else {
-        vbmaw->cursor[vbma_idxVertices] = v4;
-        vbmaw->cursor[vbma_idxVertices + 1] = v1;
-        vbmaw->cursor[vbma_idxVertices + 2] = v2;
-        vbmaw->cursor[vbma_idxVertices + 3] = v3;
+        _vertex_buffer_store_vertex(vb, vbmaw->cursor, vbma_idxVertices, &v4);
+        _vertex_buffer_store_vertex(vb, vbmaw->cursor, vbma_idxVertices + 1, &v1);
+        _vertex_buffer_store_vertex(vb, vbmaw->cursor, vbma_idxVertices + 2, &v2);
+        _vertex_buffer_store_vertex(vb, vbmaw->cursor, vbma_idxVertices + 3, &v3);
+    }
+
+    vbmaw->writtenCount += DRAWBUFFER_VERTICES_PER_FACE;
+    vbmaw->vbma->dirty = true;
+}
+
+void vertex_buffer_mem_area_writer_write_face(VertexBufferMemAreaWriter *vbmaw,
+                                              const VertexAttributes *face) {
+    if (_vertex_buffer_mem_area_writer_reserve_face(vbmaw) == false) {
+        return;
+    }
+
+    for (uint32_t i = 0; i < DRAWBUFFER_VERTICES_PER_FACE; ++i) {
+        _vertex_buffer_store_vertex(vbmaw->vbma->vb,
+                                    vbmaw->cursor,
+                                    vbmaw->writtenCount + i,
+                                    face + i);
     }
 
     vbmaw->writtenCount += DRAWBUFFER_VERTICES_PER_FACE;
@@ -1305,6 +1475,7 @@ void vertex_buffer_mem_area_make_gap(VertexBufferMemArea *vbma, bool transparent
 
     vbma->chunk = NULL;
     vbma->dirty = false;
+    vbma->cleared = false;
 
     // enlist with other gaps if some exist already
     if (vbma->vb->firstMemAreaGap == NULL) {
@@ -1360,7 +1531,7 @@ VertexBufferMemArea *vertex_buffer_mem_area_split_and_make_gap(VertexBufferMemAr
 
     vbma->count = vbma_size;
 
-    VertexAttributes *start = _vertex_buffer_data_add_ptr(vbma->start, vbma_size);
+    void *start = _vertex_buffer_data_add_ptr(vbma->vb, vbma->start, vbma_size);
     VertexBufferMemArea *gap = vertex_buffer_mem_area_new(vbma->vb,
                                                           start,
                                                           vbma->startIdx + vbma_size,
@@ -1430,7 +1601,7 @@ void vertex_buffer_log_mem_areas(const VertexBuffer *vb) {
 
         if (previousVbma != NULL) {
             if (vbma->start ==
-                _vertex_buffer_data_add_ptr(previousVbma->start, previousVbma->count)) {
+                _vertex_buffer_data_add_ptr(vb, previousVbma->start, previousVbma->count)) {
                 check = "✅";
             } else {
                 check = "❌";
@@ -1477,7 +1648,7 @@ void vertex_buffer_check_mem_area_chain(VertexBuffer *vb) {
         if (previousVbma != NULL) {
 
             if (vbma->start !=
-                _vertex_buffer_data_add_ptr(previousVbma->start, previousVbma->count)) {
+                _vertex_buffer_data_add_ptr(vb, previousVbma->start, previousVbma->count)) {
                 cclog_warning("⚠️⚠️⚠️ mem area chain broken: start != previous->start + size");
             }
         }
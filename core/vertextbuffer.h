@@ -29,9 +29,30 @@ struct {
     float metadata;
 } typedef VertexAttributes;
 
+// Compact vertex layout, 12 bytes instead of 20:
+// - shape coordinates are integral and fit in 16 bits
+// - metadata uses the same packing as VertexAttributes (21 bits), the 17th bit of the atlas
+// color index is stored right after it, at bit 21
+struct {
+    int16_t x, y, z;
+    uint16_t color;
+    uint32_t metadata;
+} typedef VertexAttributesCompact;
+
 #define DRAWBUFFER_VERTICES_BYTES sizeof(VertexAttributes)
+#define DRAWBUFFER_VERTICES_COMPACT_BYTES sizeof(VertexAttributesCompact)
 #define DRAWBUFFER_VERTICES_PER_FACE 4
 
+#define VERTEX_COMPACT_METADATA_MASK 0x1FFFFF
+#define VERTEX_COMPACT_COLOR_HIGH_BIT_SHIFT 21
+
+// Layout of the vertices stored in a vertex buffer, renderers should check it using
+// vertex_buffer_get_format before uploading vertices
+typedef enum {
+    VertexFormatDefault, // VertexAttributes
+    VertexFormatCompact  // VertexAttributesCompact
+} VertexFormat;
+
 extern bool vertex_buffer_pop_destroyed_id(uint32_t *id);
 
 struct {
@@ -69,11 +90,16 @@ void vertex_buffer_mem_area_writer_write(VertexBufferMemAreaWriter *vbmaw,
                                          VERTEX_LIGHT_STRUCT_T vlight3,
                                          VERTEX_LIGHT_STRUCT_T vlight4);
 
+/// writes one face (DRAWBUFFER_VERTICES_PER_FACE vertices) of already computed vertex attributes
+void vertex_buffer_mem_area_writer_write_face(VertexBufferMemAreaWriter *vbmaw,
+                                              const VertexAttributes *face);
+
 void vertex_buffer_mem_area_writer_done(VertexBufferMemAreaWriter *vbmaw);
 
 // a vb may optionally write to a lighting buffer ie. if it belongs to the map shape w/ octree
 VertexBuffer *vertex_buffer_new(bool transparent);
 VertexBuffer *vertex_buffer_new_with_max_count(uint32_t n, bool transparent);
+VertexBuffer *vertex_buffer_new_with_format(uint32_t n, bool transparent, VertexFormat format);
 
 void vertex_buffer_free(VertexBuffer *vb);
 void vertex_buffer_free_all(VertexBuffer *front);
@@ -89,7 +115,16 @@ VertexBufferMemArea *vertex_buffer_get_first_mem_area(const VertexBuffer *vb);
 
 uint32_t vertex_buffer_get_id(const VertexBuffer *vb);
 
-VertexAttributes *vertex_buffer_get_draw_buffer(const VertexBuffer *vb);
+/// vertices layout depends on vertex buffer format, see vertex_buffer_get_format
+void *vertex_buffer_get_draw_buffer(const VertexBuffer *vb);
+VertexFormat vertex_buffer_get_format(const VertexBuffer *vb);
+/// size in bytes of one vertex in the draw buffer
+size_t vertex_buffer_get_vertex_size(const VertexBuffer *vb);
+/// copies `count` vertices starting at `startIdx` into `out`, decoding them if needed
+void vertex_buffer_read_vertices(const VertexBuffer *vb,
+                                 uint32_t startIdx,
+                                 uint32_t count,
+                                 VertexAttributes *out);
 DoublyLinkedList *vertex_buffer_get_draw_slices(const VertexBuffer *vb);
 
 void vertex_buffer_log_draw_slices(const VertexBuffer *vb);
@@ -105,6 +140,11 @@ uint32_t vertex_buffer_get_max_count(const VertexBuffer *vb);
 bool vertex_buffer_is_fragmented(const VertexBuffer *vb);
 
 void vertex_buffer_fill_gaps(VertexBuffer *vb);
+/// Fills gaps moving up to `maxVertices` vertices, gaps are merged beforehand. Remaining
+/// gaps are cleared and flagged for upload, so that the buffer can still be drawn whole, their
+/// vertices resulting in degenerate triangles until a next call fills them.
+/// Returns the number of vertices moved.
+uint32_t vertex_buffer_fill_gaps_incremental(VertexBuffer *vb, uint32_t maxVertices);
 
 void vertex_buffer_mem_area_make_gap(VertexBufferMemArea *vbma, bool transparent);
 void vertex_buffer_mem_area_flush(VertexBufferMemArea *vbma);